@@ -1,6 +1,32 @@
+import domain.entity.BackpressureAlert
+import domain.entity.BackpressureAlertKind
+import domain.entity.BackpressureStatus
+import domain.entity.BufferAggregates
+import domain.entity.BufferEvent
+import domain.entity.BufferEventCounts
+import domain.entity.BufferEventType
+import domain.entity.BufferGroupTotals
+import domain.entity.BufferMetricsSnapshot
+import domain.entity.CaptureStatus
+import domain.entity.ClassMemoryUsage
+import domain.entity.FullBuffer
+import domain.entity.GcPause
+import domain.entity.GcStatus
+import domain.entity.HistoryPoint
+import domain.entity.HistoryTier
+import domain.entity.LatencyHistogram
+import domain.entity.LatencyKind
+import domain.entity.OverheadCost
+import domain.entity.OverheadOperation
+import domain.entity.OverheadStatus
+import domain.entity.RetainedSizeStatus
+import domain.entity.SuspensionStackStatus
 import java.io.File
 import java.io.FileOutputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.nio.file.Paths
+import kotlin.math.roundToInt
 
 /**
  * Monitors native buffer operations and memory usage.
@@ -10,6 +36,62 @@ internal class NativeBufferMonitor {
     private companion object {
         private const val LIBRARY_NAME = "buffer-profiler-1.0.0"
 
+        // Native snapshot layout, see snapshot.h
+        private const val SNAPSHOT_MAGIC = 0x53534D42
+        private const val SNAPSHOT_VERSION = 1
+        private const val SNAPSHOT_HEADER_BYTES = 64
+        private const val SNAPSHOT_INITIAL_BYTES = 64 * 1024
+        private const val SNAPSHOT_MAX_ATTEMPTS = 3
+
+        // Native event timeline layout: type, timestamp, thread id, buffer id, size, capacity, value
+        private const val TIMELINE_FIELDS = 7
+        private const val DEFAULT_TIMELINE_EVENTS = 1000
+
+        // Native history layout: start, count, min/max/sum size, min/max/sum memory
+        private const val HISTORY_FIELDS = 8
+        private const val DEFAULT_HISTORY_POINTS = 1000
+
+        // Native class memory layout: instance count, total memory, last update time
+        private const val CLASS_STATS_FIELDS = 3
+
+        // Native retained size status layout, see retained_size.h
+        private const val RETAINED_STATUS_FIELDS = 7
+
+        // Native capture status layout, see capture.h
+        private const val CAPTURE_STATUS_FIELDS = 6
+
+        // Native group totals layout, see buffer_groups.h
+        private const val BUFFER_GROUP_TOTALS_FIELDS = 7
+
+        // Native overhead layouts, see overhead.h
+        private const val OVERHEAD_STATUS_FIELDS = 5
+        private const val OVERHEAD_COST_FIELDS = 3
+        private const val PPM_PER_PERCENT = 10_000.0
+
+        // Native suspension stack status layout, see suspension_stacks.h
+        private const val SUSPENSION_STACK_STATUS_FIELDS = 4
+
+        // Native ring channel send result for a closed channel, see ring_channel.h
+        private const val RING_CLOSED = -1L
+
+        // Native aggregate layout, see buffer_aggregates.h
+        private const val BUFFER_AGGREGATE_FIELDS = 9
+        private const val FULL_BUFFER_FIELDS = 4
+        private const val DEFAULT_FULLEST_BUFFERS = 10
+
+        // Native backpressure layouts, see backpressure.h
+        private const val BACKPRESSURE_ALERT_FIELDS = 8
+        private const val BACKPRESSURE_STATUS_FIELDS = 4
+        private const val DEFAULT_BACKPRESSURE_ALERTS = 256
+
+        // Id of the thread last registered natively from the current thread, 0 if none
+        private val registeredThreadId = ThreadLocal.withInitial { 0L }
+
+        // Native GC layouts, see gc_tracking.h
+        private const val GC_PAUSE_FIELDS = 4
+        private const val GC_STATUS_FIELDS = 9
+        private const val DEFAULT_GC_PAUSES = 1000
+
         // Native initialization method
         @JvmStatic
         private external fun initialize(): Boolean
@@ -18,6 +100,28 @@ internal class NativeBufferMonitor {
         @JvmStatic
         private external fun createBuffer(capacity: Int): Long
 
+        @JvmStatic
+        private external fun releaseBuffer(bufferId: Long): Boolean
+
+        @JvmStatic
+        private external fun createLabeledBuffer(capacity: Int, name: String, labels: Array<String>): Long
+
+        @JvmStatic
+        private external fun getBufferName(bufferId: Long): String?
+
+        // Buffer group methods
+        @JvmStatic
+        private external fun getBufferGroupOf(bufferId: Long): Int
+
+        @JvmStatic
+        private external fun findBufferGroup(path: String): Int
+
+        @JvmStatic
+        private external fun getBufferGroupPaths(): Array<String>?
+
+        @JvmStatic
+        private external fun getBufferGroupTotals(groupId: Int): LongArray?
+
         @JvmStatic
         private external fun updateBufferMetrics(bufferId: Long, size: Int, memoryUsage: Long)
 
@@ -31,6 +135,42 @@ internal class NativeBufferMonitor {
             bufferCapacity: Int
         )
 
+        @JvmStatic
+        private external fun registerThread(threadId: Long, threadName: String)
+
+        @JvmStatic
+        private external fun recordBufferSuspension(bufferId: Long, bufferSize: Int, bufferCapacity: Int)
+
+        // Fused per-item bookkeeping methods
+        @JvmStatic
+        private external fun onEmit(bufferId: Long, value: Any): Long
+
+        @JvmStatic
+        private external fun onConsume(bufferId: Long, entrySize: Long, residencyNanos: Long, value: Any?)
+
+        @JvmStatic
+        private external fun cancelEmit(bufferId: Long, entrySize: Long, value: Any?)
+
+        // Latency histogram methods
+        @JvmStatic
+        private external fun recordSuspensionDuration(bufferId: Long, nanos: Long)
+
+        @JvmStatic
+        private external fun getLatencyPercentile(bufferId: Long, kind: Int, percentile: Double): Long
+
+        @JvmStatic
+        private external fun exportLatencyHistogram(bufferId: Long, kind: Int): LongArray?
+
+        // Event timeline methods
+        @JvmStatic
+        private external fun getBufferEventTimeline(type: Int, bufferId: Long, sinceTimestamp: Long, maxEvents: Int): LongArray?
+
+        @JvmStatic
+        private external fun getEventThreadName(threadId: Long): String?
+
+        @JvmStatic
+        private external fun getEventCounts(): LongArray?
+
         // Statistics and reporting methods
         @JvmStatic
         private external fun getTotalSuspensions(): Int
@@ -69,6 +209,147 @@ internal class NativeBufferMonitor {
         @JvmStatic
         private external fun getTotalTrackedMemory(): Long
 
+        @JvmStatic
+        private external fun setObjectSizeSampling(arraySampleInterval: Int)
+
+        @JvmStatic
+        private external fun getTrackedClassNames(): Array<String>?
+
+        @JvmStatic
+        private external fun getClassMemoryStats(): LongArray?
+
+        // Retained size methods
+        @JvmStatic
+        private external fun setRetainedSizeTracking(enabled: Boolean)
+
+        @JvmStatic
+        private external fun startRetainedSizePass(budgetMillis: Int): Boolean
+
+        @JvmStatic
+        private external fun getRetainedSize(bufferId: Long): Long
+
+        @JvmStatic
+        private external fun getRetainedSizeStatus(): LongArray?
+
+        // GC and allocation methods
+        @JvmStatic
+        private external fun setGcTracking(enabled: Boolean): Boolean
+
+        @JvmStatic
+        private external fun setAllocationSampling(intervalBytes: Int): Boolean
+
+        @JvmStatic
+        private external fun getGcPauses(sinceTimestamp: Long, maxPauses: Int): LongArray?
+
+        @JvmStatic
+        private external fun getGcStatus(): LongArray?
+
+        // History methods
+        @JvmStatic
+        private external fun setBufferHistoryEnabled(enabled: Boolean)
+
+        @JvmStatic
+        private external fun getBufferHistory(
+            bufferId: Long,
+            tier: Int,
+            fromTime: Long,
+            toTime: Long,
+            maxPoints: Int
+        ): LongArray?
+
+        // Native ring channel methods
+        @JvmStatic
+        private external fun createRingChannel(capacity: Int): Long
+
+        @JvmStatic
+        private external fun ringChannelBufferId(channel: Long): Long
+
+        @JvmStatic
+        private external fun ringSendLong(channel: Long, value: Long, suspendedSince: Long): Long
+
+        @JvmStatic
+        private external fun ringSendBytes(channel: Long, value: ByteArray, suspendedSince: Long): Long
+
+        @JvmStatic
+        private external fun ringReceiveLong(channel: Long, result: LongArray): Boolean
+
+        @JvmStatic
+        private external fun ringReceiveBytes(channel: Long): ByteArray?
+
+        @JvmStatic
+        private external fun closeRingChannel(channel: Long)
+
+        @JvmStatic
+        private external fun destroyRingChannel(channel: Long)
+
+        // Backpressure detection methods
+        @JvmStatic
+        private external fun setBackpressureDetection(warningNanos: Long, smoothingNanos: Long)
+
+        @JvmStatic
+        private external fun pollBackpressureAlerts(maxAlerts: Int): LongArray?
+
+        @JvmStatic
+        private external fun getBackpressureStatus(bufferId: Long): LongArray?
+
+        @JvmStatic
+        private external fun getDroppedBackpressureAlerts(): Long
+
+        // Aggregate methods
+        @JvmStatic
+        private external fun getBufferAggregates(maxFullest: Int): LongArray?
+
+        // Bulk snapshot methods
+        @JvmStatic
+        private external fun snapshotAll(buffer: ByteBuffer): Long
+
+        // Shared-memory export methods
+        @JvmStatic
+        private external fun startSharedMemoryExport(intervalMillis: Int, maxBuffers: Int): String?
+
+        @JvmStatic
+        private external fun stopSharedMemoryExport()
+
+        // Capture file methods
+        @JvmStatic
+        private external fun startCapture(path: String, snapshotIntervalMillis: Int): Boolean
+
+        @JvmStatic
+        private external fun stopCapture()
+
+        @JvmStatic
+        private external fun getCaptureStatus(): LongArray?
+
+        // Overhead governor methods
+        @JvmStatic
+        private external fun setOverheadBudget(budgetPpm: Int)
+
+        @JvmStatic
+        private external fun getOverheadStatus(): LongArray?
+
+        @JvmStatic
+        private external fun getOverheadCosts(): LongArray?
+
+        @JvmStatic
+        private external fun getBufferSamplePeriod(bufferId: Long): Int
+
+        // OpenMetrics exporter methods
+        @JvmStatic
+        private external fun startMetricsExporter(address: String): String?
+
+        @JvmStatic
+        private external fun stopMetricsExporter()
+
+        // Suspension stack methods
+        @JvmStatic
+        private external fun setSuspensionStackSampling(sampleRate: Int, maxDepth: Int): Boolean
+
+        @JvmStatic
+        private external fun getSuspensionStackStatus(): LongArray?
+
+        @JvmStatic
+        private external fun getCollapsedSuspensionStacks(bufferId: Long): String?
+
         // Reset methods
         @JvmStatic
         private external fun clearTracking()
@@ -76,6 +357,7 @@ internal class NativeBufferMonitor {
 
     private var libraryLoaded = false
     private var memoryMonitoringEnabled = false
+    private var snapshotBuffer = allocateSnapshotBuffer(SNAPSHOT_INITIAL_BYTES)
 
     // Load the native library
     init {
@@ -240,12 +522,103 @@ internal class NativeBufferMonitor {
 
     /**
      * Creates a buffer with the specified capacity.
-     * @return Buffer ID or timestamp if native library is not available
+     * @return Generation-tagged buffer handle, or a timestamp if native library is not available
      */
     internal fun safeCreateBuffer(capacity: Int): Long {
         return withNativeLibrary(System.nanoTime()) { createBuffer(capacity) }
     }
 
+    /**
+     * Creates a named buffer in the group given by [labels]. The map's iteration order is the
+     * hierarchy, outermost first: {pipeline=ingest, stage=parse} puts the buffer in
+     * "pipeline=ingest/stage=parse", below "pipeline=ingest". Keys must not be empty and
+     * neither keys nor values may contain '/'.
+     * @return Generation-tagged buffer handle, 0 if the labels are invalid or the registry
+     * is full, or a timestamp if native library is not available
+     */
+    internal fun safeCreateLabeledBuffer(capacity: Int, name: String, labels: Map<String, String>): Long {
+        return withNativeLibrary(System.nanoTime()) {
+            createLabeledBuffer(capacity, name, labels.map { (key, value) -> "$key=$value" }.toTypedArray())
+        }
+    }
+
+    /**
+     * Gets the name a live buffer was created with, or null if it has none.
+     */
+    internal fun safeGetBufferName(bufferId: Long): String? {
+        return withNativeLibrary(null) { getBufferName(bufferId) }
+    }
+
+    /**
+     * Gets the id of the group a live buffer belongs to, or -1 if it has no labels.
+     */
+    internal fun safeGetBufferGroupOf(bufferId: Long): Int {
+        return withNativeLibrary(-1) { getBufferGroupOf(bufferId) }
+    }
+
+    /**
+     * Gets the id of the group for [labels], in hierarchy order, or -1 if no buffer was ever
+     * created with that label path or a longer one starting with it.
+     */
+    internal fun safeFindBufferGroup(labels: Map<String, String>): Int {
+        return withNativeLibrary(-1) {
+            findBufferGroup(labels.entries.joinToString("/") { (key, value) -> "$key=$value" })
+        }
+    }
+
+    /**
+     * Gets the running totals of a group, which include every group below it. The native
+     * side keeps them up to date on each buffer update, so this does not visit the buffers.
+     */
+    internal fun safeGetBufferGroupTotals(groupId: Int): BufferGroupTotals {
+        return withNativeLibrary(BufferGroupTotals.NONE) {
+            val paths = getBufferGroupPaths()
+            val fields = getBufferGroupTotals(groupId)
+            if (paths == null || groupId !in paths.indices || fields == null || fields.size < BUFFER_GROUP_TOTALS_FIELDS) {
+                BufferGroupTotals.NONE
+            } else {
+                groupTotals(groupId, paths[groupId], fields)
+            }
+        }
+    }
+
+    /**
+     * Gets the totals of every group, indexed by group id.
+     */
+    internal fun safeGetBufferGroups(): List<BufferGroupTotals> {
+        return withNativeLibrary(emptyList()) {
+            val paths = getBufferGroupPaths() ?: return@withNativeLibrary emptyList()
+            paths.mapIndexedNotNull { groupId, path ->
+                getBufferGroupTotals(groupId)
+                    ?.takeIf { it.size >= BUFFER_GROUP_TOTALS_FIELDS }
+                    ?.let { groupTotals(groupId, path, it) }
+            }
+        }
+    }
+
+    private fun groupTotals(groupId: Int, path: String, fields: LongArray): BufferGroupTotals {
+        return BufferGroupTotals(
+            groupId = groupId,
+            path = path,
+            bufferCount = fields[0],
+            capacity = fields[1],
+            size = fields[2],
+            memoryUsage = fields[3],
+            emissions = fields[4],
+            consumptions = fields[5],
+            suspensions = fields[6]
+        )
+    }
+
+    /**
+     * Releases a buffer so its native slot can be reused.
+     * The handle is stale afterwards and all lookups with it return defaults.
+     * @return true if the buffer was live and has been released
+     */
+    internal fun safeReleaseBuffer(bufferId: Long): Boolean {
+        return withNativeLibrary(false) { releaseBuffer(bufferId) }
+    }
+
     /**
      * Updates metrics for the specified buffer.
      */
@@ -280,6 +653,30 @@ internal class NativeBufferMonitor {
         }
     }
 
+    /**
+     * Interns the current thread's id and name natively, once per thread. Events the
+     * thread records afterwards carry its id without passing or converting the name.
+     */
+    internal fun safeRegisterThread() {
+        val thread = Thread.currentThread()
+        if (registeredThreadId.get() == thread.id) {
+            return
+        }
+        withNativeLibrary(Unit) {
+            registerThread(threadId = thread.id, threadName = thread.name)
+            registeredThreadId.set(thread.id)
+        }
+    }
+
+    /**
+     * Records a suspension event for the specified buffer on the current thread.
+     * Only primitives cross into native code; the thread is registered on first use.
+     */
+    internal fun safeRecordBufferSuspension(bufferId: Long, bufferSize: Int, bufferCapacity: Int) {
+        safeRegisterThread()
+        withNativeLibrary(Unit) { recordBufferSuspension(bufferId, bufferSize, bufferCapacity) }
+    }
+
     /**
      * Gets the total number of suspension events recorded across all buffers.
      */
@@ -301,6 +698,104 @@ internal class NativeBufferMonitor {
         withNativeLibrary(Unit) { recordConsumption(bufferId) }
     }
 
+    /**
+     * Records an emitted item in a single native call: measures its size, counts the
+     * emission and, if the buffer is already full, the suspension, and adds the item
+     * to the buffer's size and memory usage.
+     * @return The measured size of the value in bytes, 0 if it could not be measured
+     */
+    internal fun safeOnEmit(bufferId: Long, value: Any): Long {
+        return withNativeLibrary(0L) { onEmit(bufferId, value) }
+    }
+
+    /**
+     * Records a consumed item in a single native call: counts the consumption, removes
+     * the item from the buffer's size and memory usage and records how long it stayed
+     * in the buffer. A negative [residencyNanos] skips the residency sample. Passing the
+     * consumed [value] lets retained size tracking stop counting it.
+     */
+    internal fun safeOnConsume(bufferId: Long, entrySize: Long, residencyNanos: Long, value: Any? = null) {
+        withNativeLibrary(Unit) { onConsume(bufferId, entrySize, residencyNanos, value) }
+    }
+
+    /**
+     * Rolls back an emission recorded with [safeOnEmit] whose send never completed.
+     */
+    internal fun safeCancelEmit(bufferId: Long, entrySize: Long, value: Any? = null) {
+        withNativeLibrary(Unit) { cancelEmit(bufferId, entrySize, value) }
+    }
+
+    /**
+     * Records how long a producer was suspended on a full buffer.
+     */
+    internal fun safeRecordSuspensionDuration(bufferId: Long, nanos: Long) {
+        withNativeLibrary(Unit) { recordSuspensionDuration(bufferId, nanos) }
+    }
+
+    /**
+     * Gets a latency percentile (0-100) for the specified buffer, in nanoseconds.
+     */
+    internal fun safeGetLatencyPercentile(bufferId: Long, kind: LatencyKind, percentile: Double): Long {
+        return withNativeLibrary(0L) { getLatencyPercentile(bufferId, kind.nativeId, percentile) }
+    }
+
+    /**
+     * Exports the full latency histogram of the specified buffer, for percentile queries
+     * or for merging with other histograms.
+     */
+    internal fun safeGetLatencyHistogram(bufferId: Long, kind: LatencyKind): LatencyHistogram {
+        return withNativeLibrary(LatencyHistogram.EMPTY) {
+            exportLatencyHistogram(bufferId, kind.nativeId)?.let { LatencyHistogram.fromExport(it) }
+                ?: LatencyHistogram.EMPTY
+        }
+    }
+
+    /**
+     * Returns up to [maxEvents] of the most recent buffer events, oldest first, from the native
+     * per-thread event rings. A null [type] matches every event type and a [bufferId] of 0
+     * matches every buffer; only events at or after [sinceTimestamp] are returned.
+     */
+    internal fun safeGetEventTimeline(
+        type: BufferEventType? = null,
+        bufferId: Long = 0L,
+        sinceTimestamp: Long = 0L,
+        maxEvents: Int = DEFAULT_TIMELINE_EVENTS
+    ): List<BufferEvent> {
+        return withNativeLibrary(emptyList()) {
+            val flat = getBufferEventTimeline(type?.nativeId ?: -1, bufferId, sinceTimestamp, maxEvents)
+                ?: return@withNativeLibrary emptyList()
+
+            // Thread names are interned natively; look each thread up once
+            val names = HashMap<Long, String?>()
+            (0 until flat.size / TIMELINE_FIELDS).mapNotNull { row ->
+                val offset = row * TIMELINE_FIELDS
+                val eventType = BufferEventType.fromNativeId(flat[offset].toInt()) ?: return@mapNotNull null
+                val threadId = flat[offset + 2]
+                BufferEvent(
+                    type = eventType,
+                    timestamp = flat[offset + 1],
+                    threadId = threadId,
+                    threadName = names.getOrPut(threadId) { getEventThreadName(threadId) },
+                    bufferId = flat[offset + 3],
+                    bufferSize = flat[offset + 4].toInt(),
+                    bufferCapacity = flat[offset + 5].toInt(),
+                    durationNanos = flat[offset + 6]
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the event totals aggregated from the native event rings.
+     */
+    internal fun safeGetEventCounts(): BufferEventCounts {
+        val empty = BufferEventCounts(0L, 0L, 0L)
+        return withNativeLibrary(empty) {
+            val counts = getEventCounts()
+            if (counts == null || counts.size < 3) empty else BufferEventCounts(counts[0], counts[1], counts[2])
+        }
+    }
+
     /**
      * Gets the total number of emissions recorded.
      */
@@ -336,6 +831,380 @@ internal class NativeBufferMonitor {
         return withNativeLibrary(0) { getBufferSuspensionCount(bufferId) }
     }
 
+    /**
+     * Creates a native ring channel and its buffer; returns the channel handle, or 0
+     * if the library is unavailable, the capacity is above the native limit or the
+     * registry is full.
+     */
+    internal fun safeCreateRingChannel(capacity: Int): Long {
+        return withNativeLibrary(0L) { createRingChannel(capacity) }
+    }
+
+    /**
+     * Gets the buffer ID whose metrics a ring channel maintains.
+     */
+    internal fun safeGetRingChannelBufferId(channel: Long): Long {
+        return withNativeLibrary(0L) { ringChannelBufferId(channel) }
+    }
+
+    /**
+     * Sends a primitive, given as its 64-bit pattern. Returns 0 when sent, [RING_CLOSED],
+     * -2 once clearTracking has released the buffer, or, when the channel is full, a timestamp to pass back as [suspendedSince] on the
+     * retry; the first full attempt counts the suspension, the successful retry times it.
+     */
+    internal fun safeRingSendLong(channel: Long, value: Long, suspendedSince: Long): Long {
+        return withNativeLibrary(RING_CLOSED) { ringSendLong(channel, value, suspendedSince) }
+    }
+
+    /**
+     * Sends a copy of a byte array; results as for [safeRingSendLong].
+     */
+    internal fun safeRingSendBytes(channel: Long, value: ByteArray, suspendedSince: Long): Long {
+        return withNativeLibrary(RING_CLOSED) { ringSendBytes(channel, value, suspendedSince) }
+    }
+
+    /**
+     * Receives the oldest primitive into result[0]; false if the channel is empty.
+     */
+    internal fun safeRingReceiveLong(channel: Long, result: LongArray): Boolean {
+        return withNativeLibrary(false) { ringReceiveLong(channel, result) }
+    }
+
+    /**
+     * Receives the oldest byte array, or null if the channel is empty.
+     */
+    internal fun safeRingReceiveBytes(channel: Long): ByteArray? {
+        return withNativeLibrary(null) { ringReceiveBytes(channel) }
+    }
+
+    /**
+     * Rejects further sends and releases the channel's buffer; queued entries can still be received.
+     */
+    internal fun safeCloseRingChannel(channel: Long) {
+        withNativeLibrary(Unit) { closeRingChannel(channel) }
+    }
+
+    /**
+     * Frees a ring channel. Only safe once nothing can use the handle any more.
+     */
+    internal fun safeDestroyRingChannel(channel: Long) {
+        withNativeLibrary(Unit) { destroyRingChannel(channel) }
+    }
+
+    /**
+     * Starts predicting when buffers fill up from smoothed emission and consumption rates,
+     * queueing an alert once a buffer is predicted full within [warningNanos]. Rates are
+     * smoothed with a time constant of [smoothingNanos] (0 for the default of 100 ms).
+     * A [warningNanos] of 0 turns detection off.
+     */
+    internal fun safeSetBackpressureDetection(warningNanos: Long, smoothingNanos: Long = 0L) {
+        withNativeLibrary(Unit) { setBackpressureDetection(warningNanos, smoothingNanos) }
+    }
+
+    /**
+     * Takes up to [maxAlerts] queued backpressure alerts, oldest first.
+     */
+    internal fun safePollBackpressureAlerts(maxAlerts: Int = DEFAULT_BACKPRESSURE_ALERTS): List<BackpressureAlert> {
+        return withNativeLibrary(emptyList()) {
+            val flat = pollBackpressureAlerts(maxAlerts) ?: return@withNativeLibrary emptyList()
+            (0 until flat.size / BACKPRESSURE_ALERT_FIELDS).mapNotNull { row ->
+                val offset = row * BACKPRESSURE_ALERT_FIELDS
+                val kind = BackpressureAlertKind.fromNativeId(flat[offset + 2].toInt()) ?: return@mapNotNull null
+                BackpressureAlert(
+                    kind = kind,
+                    bufferId = flat[offset],
+                    time = flat[offset + 1],
+                    timeToFullNanos = flat[offset + 3],
+                    size = flat[offset + 4],
+                    capacity = flat[offset + 5],
+                    emitRate = flat[offset + 6],
+                    consumeRate = flat[offset + 7]
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the detector's latest estimate for a buffer, or null if detection is off
+     * or the buffer has not been sampled yet.
+     */
+    internal fun safeGetBackpressureStatus(bufferId: Long): BackpressureStatus? {
+        return withNativeLibrary(null) {
+            val fields = getBackpressureStatus(bufferId)
+            if (fields == null || fields.size < BACKPRESSURE_STATUS_FIELDS) {
+                null
+            } else {
+                BackpressureStatus(
+                    emitRate = fields[0],
+                    consumeRate = fields[1],
+                    timeToFullNanos = fields[2],
+                    alerting = fields[3] != 0L
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the number of alerts lost because the queue was not polled in time.
+     */
+    internal fun safeGetDroppedBackpressureAlerts(): Long {
+        return withNativeLibrary(0L) { getDroppedBackpressureAlerts() }
+    }
+
+    /**
+     * Gets the totals over every tracked buffer, the maximum utilization and up to
+     * [maxFullest] of the fullest buffers in a single native pass.
+     */
+    internal fun safeGetBufferAggregates(maxFullest: Int = DEFAULT_FULLEST_BUFFERS): BufferAggregates {
+        return withNativeLibrary(BufferAggregates.NONE) {
+            val flat = getBufferAggregates(maxFullest)
+            if (flat == null || flat.size < BUFFER_AGGREGATE_FIELDS) {
+                BufferAggregates.NONE
+            } else {
+                BufferAggregates(
+                    bufferCount = flat[0],
+                    totalEmissions = flat[1],
+                    totalConsumptions = flat[2],
+                    totalSuspensions = flat[3],
+                    totalMemoryUsage = flat[4],
+                    totalSize = flat[5],
+                    totalCapacity = flat[6],
+                    maxUtilizationPermille = flat[7],
+                    fullestBufferId = flat[8],
+                    fullest = (0 until (flat.size - BUFFER_AGGREGATE_FIELDS) / FULL_BUFFER_FIELDS).map { row ->
+                        val offset = BUFFER_AGGREGATE_FIELDS + row * FULL_BUFFER_FIELDS
+                        FullBuffer(
+                            bufferId = flat[offset],
+                            size = flat[offset + 1],
+                            capacity = flat[offset + 2],
+                            utilizationPermille = flat[offset + 3]
+                        )
+                    }
+                )
+            }
+        }
+    }
+
+    /**
+     * Takes a snapshot of every tracked buffer and the global totals in a single native call.
+     * The native side fills a reused direct buffer, which grows when the number of buffers
+     * outgrows it.
+     */
+    @Synchronized
+    internal fun safeSnapshotAll(): BufferMetricsSnapshot {
+        return withNativeLibrary(BufferMetricsSnapshot.EMPTY) {
+            var snapshot = BufferMetricsSnapshot.EMPTY
+            for (attempt in 1..SNAPSHOT_MAX_ATTEMPTS) {
+                val written = snapshotAll(snapshotBuffer)
+                if (written >= 0) {
+                    if (written > 0) snapshot = decodeSnapshot(snapshotBuffer)
+                    break
+                }
+                // Leave headroom for buffers created before the next attempt
+                val required = (-written * 2).coerceAtMost(Int.MAX_VALUE.toLong()).toInt()
+                snapshotBuffer = allocateSnapshotBuffer(required)
+            }
+            snapshot
+        }
+    }
+
+    private fun allocateSnapshotBuffer(capacity: Int): ByteBuffer {
+        return ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder())
+    }
+
+    private fun decodeSnapshot(buffer: ByteBuffer): BufferMetricsSnapshot {
+        if (buffer.getInt(0) != SNAPSHOT_MAGIC || buffer.getInt(4) != SNAPSHOT_VERSION) {
+            println("Unsupported native snapshot layout")
+            return BufferMetricsSnapshot.EMPTY
+        }
+
+        val count = buffer.getInt(8)
+        val stride = buffer.getInt(12)
+
+        fun longColumn(column: Int): LongArray {
+            val offset = SNAPSHOT_HEADER_BYTES + column * Long.SIZE_BYTES * stride
+            return LongArray(count) { buffer.getLong(offset + it * Long.SIZE_BYTES) }
+        }
+
+        fun intColumn(column: Int): IntArray {
+            val offset = SNAPSHOT_HEADER_BYTES + 6 * Long.SIZE_BYTES * stride + column * Int.SIZE_BYTES * stride
+            return IntArray(count) { buffer.getInt(offset + it * Int.SIZE_BYTES) }
+        }
+
+        return BufferMetricsSnapshot(
+            timestamp = buffer.getLong(16),
+            totalEmissions = buffer.getLong(24),
+            totalConsumptions = buffer.getLong(32),
+            totalSuspensions = buffer.getLong(40),
+            totalMemoryUsage = buffer.getLong(48),
+            totalSize = buffer.getLong(56),
+            bufferIds = longColumn(0),
+            memoryUsage = longColumn(1),
+            emissions = longColumn(2),
+            consumptions = longColumn(3),
+            suspensions = longColumn(4),
+            lastUpdateTimes = longColumn(5),
+            capacities = intColumn(0),
+            sizes = intColumn(1)
+        )
+    }
+
+    /**
+     * Starts publishing the buffer metrics to a shared-memory segment that tools outside the
+     * JVM can sample, and returns the segment path, or null if it could not be created.
+     * A [maxBuffers] of 0 uses the native default.
+     */
+    internal fun safeStartSharedMemoryExport(intervalMillis: Int, maxBuffers: Int): String? {
+        return withNativeLibrary(null) { startSharedMemoryExport(intervalMillis, maxBuffers) }
+    }
+
+    /**
+     * Stops publishing to shared memory and removes the segment.
+     */
+    internal fun safeStopSharedMemoryExport() {
+        withNativeLibrary(Unit) { stopSharedMemoryExport() }
+    }
+
+    /**
+     * Starts capturing buffer events and a snapshot of every buffer each
+     * [snapshotIntervalMillis] (1000 if 0) to [path], for replay with bufferprof-replay
+     * after the process is gone. Returns false if the file could not be created.
+     */
+    internal fun safeStartCapture(path: String, snapshotIntervalMillis: Int = 0): Boolean {
+        return withNativeLibrary(false) { startCapture(path, snapshotIntervalMillis) }
+    }
+
+    /**
+     * Writes the events still queued, a final snapshot and the index, and closes the capture file.
+     */
+    internal fun safeStopCapture() {
+        withNativeLibrary(Unit) { stopCapture() }
+    }
+
+    /**
+     * Gets the progress of the running capture, or the totals of the last one.
+     */
+    internal fun safeGetCaptureStatus(): CaptureStatus {
+        return withNativeLibrary(CaptureStatus.NONE) {
+            val fields = getCaptureStatus()
+            if (fields == null || fields.size < CAPTURE_STATUS_FIELDS) {
+                CaptureStatus.NONE
+            } else {
+                CaptureStatus(
+                    active = fields[0] != 0L,
+                    bytesWritten = fields[1],
+                    chunkCount = fields[2],
+                    eventCount = fields[3],
+                    snapshotCount = fields[4],
+                    droppedEvents = fields[5]
+                )
+            }
+        }
+    }
+
+    /**
+     * Lets the native agent keep its own cost within [budgetPercent] of the time of the
+     * threads that call into it, by moving the hottest buffers to sampled tracking while the
+     * measured share is over the budget and back once it is under half of it. In sampled
+     * mode only one call in the buffer's sample period measures the value and records
+     * counters, history and latency, scaled by the period so totals stay unbiased; size
+     * and memory stay exact. A budget of 0 stops the governor and returns every buffer to
+     * exact tracking.
+     */
+    internal fun safeSetOverheadBudget(budgetPercent: Double) {
+        withNativeLibrary(Unit) {
+            setOverheadBudget((budgetPercent * PPM_PER_PERCENT).roundToInt().coerceAtLeast(0))
+        }
+    }
+
+    /**
+     * Gets the measured cost of the native agent and the state of the overhead governor.
+     */
+    internal fun safeGetOverheadStatus(): OverheadStatus {
+        return withNativeLibrary(OverheadStatus.NONE) {
+            val fields = getOverheadStatus()
+            val costFields = getOverheadCosts()
+            if (fields == null || fields.size < OVERHEAD_STATUS_FIELDS || costFields == null) {
+                OverheadStatus.NONE
+            } else {
+                OverheadStatus(
+                    budgetPercent = fields[0] / PPM_PER_PERCENT,
+                    overheadPercent = fields[1] / PPM_PER_PERCENT,
+                    activeThreads = fields[2].toInt(),
+                    sampledBuffers = fields[3].toInt(),
+                    totalNanos = fields[4],
+                    costs = OverheadOperation.values()
+                        .filter { (it.nativeId + 1) * OVERHEAD_COST_FIELDS <= costFields.size }
+                        .associateWith {
+                            val offset = it.nativeId * OVERHEAD_COST_FIELDS
+                            OverheadCost(costFields[offset], costFields[offset + 1], costFields[offset + 2])
+                        }
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the sample period of a buffer: 1 while it is tracked exactly, otherwise only
+     * about one call in this many records its counts.
+     */
+    internal fun safeGetBufferSamplePeriod(bufferId: Long): Int {
+        return withNativeLibrary(1) { getBufferSamplePeriod(bufferId) }
+    }
+
+    /**
+     * Starts serving every buffer's metrics in the OpenMetrics text format at /metrics on
+     * [address]: "host:port" (port 0 picks a free one) or "unix:/path/to/socket".
+     * Returns the bound address, or null if the socket could not be opened.
+     */
+    internal fun safeStartMetricsExporter(address: String = "127.0.0.1:0"): String? {
+        return withNativeLibrary(null) { startMetricsExporter(address) }
+    }
+
+    /**
+     * Stops serving /metrics and closes the socket.
+     */
+    internal fun safeStopMetricsExporter() {
+        withNativeLibrary(Unit) { stopMetricsExporter() }
+    }
+
+    /**
+     * Takes the stack of one suspension in [sampleRate] of each thread with JVMTI and counts
+     * it per distinct stack, keeping up to [maxDepth] innermost frames (64 if 0). A rate of 0
+     * turns sampling off. Returns false if JVMTI is not available.
+     */
+    internal fun safeSetSuspensionStackSampling(sampleRate: Int, maxDepth: Int = 0): Boolean {
+        return withNativeLibrary(false) { setSuspensionStackSampling(sampleRate, maxDepth) }
+    }
+
+    /**
+     * Gets the sample rate and the sampled, dropped and interned stack counts.
+     */
+    internal fun safeGetSuspensionStackStatus(): SuspensionStackStatus {
+        return withNativeLibrary(SuspensionStackStatus.NONE) {
+            val fields = getSuspensionStackStatus()
+            if (fields == null || fields.size < SUSPENSION_STACK_STATUS_FIELDS) {
+                SuspensionStackStatus.NONE
+            } else {
+                SuspensionStackStatus(
+                    sampleRate = fields[0],
+                    samples = fields[1],
+                    droppedSamples = fields[2],
+                    nodes = fields[3]
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the sampled suspension stacks of [bufferId], or of every buffer for 0, in the
+     * collapsed format read by flamegraph.pl and speedscope: one line per distinct stack,
+     * from the buffer to the innermost frame, followed by its sample count.
+     */
+    internal fun safeGetCollapsedSuspensionStacks(bufferId: Long = 0L): String {
+        return withNativeLibrary("") { getCollapsedSuspensionStacks(bufferId) ?: "" }
+    }
+
     /**
      * Clears all tracking data in the native library.
      */
@@ -363,6 +1232,47 @@ internal class NativeBufferMonitor {
         }
     }
 
+    /**
+     * Turns history sampling on or off for every buffer. Each buffer's history takes
+     * a fixed ~42 KB once sampled, so applications with very many buffers may opt out.
+     */
+    internal fun safeSetBufferHistoryEnabled(enabled: Boolean) {
+        withNativeLibrary(Unit) { setBufferHistoryEnabled(enabled) }
+    }
+
+    /**
+     * Gets a buffer's size and memory history at one resolution: the most recent
+     * [maxPoints] points starting in [fromTime, toTime), oldest first. The bucket
+     * still being filled is included, so polling with the previous poll's time as
+     * [fromTime] misses no sample.
+     */
+    internal fun safeGetBufferHistory(
+        bufferId: Long,
+        tier: HistoryTier = HistoryTier.SECOND,
+        fromTime: Long = 0L,
+        toTime: Long = Long.MAX_VALUE,
+        maxPoints: Int = DEFAULT_HISTORY_POINTS
+    ): List<HistoryPoint> {
+        return withNativeLibrary(emptyList()) {
+            val flat = getBufferHistory(bufferId, tier.nativeId, fromTime, toTime, maxPoints)
+                ?: return@withNativeLibrary emptyList()
+            (0 until flat.size / HISTORY_FIELDS).map { row ->
+                val offset = row * HISTORY_FIELDS
+                val count = flat[offset + 1]
+                HistoryPoint(
+                    start = flat[offset],
+                    count = count,
+                    minSize = flat[offset + 2].toInt(),
+                    maxSize = flat[offset + 3].toInt(),
+                    avgSize = if (count > 0) flat[offset + 4].toDouble() / count else 0.0,
+                    minMemory = flat[offset + 5],
+                    maxMemory = flat[offset + 6],
+                    avgMemory = if (count > 0) flat[offset + 7].toDouble() / count else 0.0
+                )
+            }
+        }
+    }
+
     /**
      * Gets the total memory being tracked by the native library.
      */
@@ -370,6 +1280,140 @@ internal class NativeBufferMonitor {
         return withNativeLibrary(0L) { getTotalTrackedMemory() }
     }
 
+    /**
+     * Sets how often arrays are measured: 1 in [arraySampleInterval] arrays of a class
+     * is measured, the others are estimated from the measured ones. 1 measures every array.
+     */
+    internal fun safeSetObjectSizeSampling(arraySampleInterval: Int) {
+        withNativeLibrary(Unit) { setObjectSizeSampling(arraySampleInterval) }
+    }
+
+    /**
+     * Starts or stops tagging emitted values for retained size passes.
+     * Stopping waits for a running pass and removes every tag.
+     */
+    internal fun safeSetRetainedSizeTracking(enabled: Boolean) {
+        withNativeLibrary(Unit) { setRetainedSizeTracking(enabled) }
+    }
+
+    /**
+     * Starts a heap walk on a background thread that measures the memory retained by
+     * the values in each buffer, giving up after [budgetMillis]. Returns false if
+     * tracking is disabled, JVMTI is unavailable or a pass is already running.
+     */
+    internal fun safeStartRetainedSizePass(budgetMillis: Int = 0): Boolean {
+        return withNativeLibrary(false) { startRetainedSizePass(budgetMillis) }
+    }
+
+    /**
+     * Gets the bytes retained by a buffer's values in the last pass, or -1 if unknown.
+     */
+    internal fun safeGetRetainedSize(bufferId: Long): Long {
+        return withNativeLibrary(-1L) { getRetainedSize(bufferId) }
+    }
+
+    /**
+     * Gets the outcome of the last retained size pass.
+     */
+    internal fun safeGetRetainedSizeStatus(): RetainedSizeStatus {
+        return withNativeLibrary(RetainedSizeStatus.NONE) {
+            val fields = getRetainedSizeStatus()
+            if (fields == null || fields.size < RETAINED_STATUS_FIELDS) {
+                RetainedSizeStatus.NONE
+            } else {
+                RetainedSizeStatus(
+                    passes = fields[0],
+                    lastPassTime = fields[1],
+                    lastPassNanos = fields[2],
+                    lastPassComplete = fields[3] != 0L,
+                    running = fields[4] != 0L,
+                    totalRetainedBytes = fields[5],
+                    totalObjects = fields[6]
+                )
+            }
+        }
+    }
+
+    /**
+     * Starts or stops recording GC pauses through JVMTI GC events.
+     * Returns false if the VM cannot send them.
+     */
+    internal fun safeSetGcTracking(enabled: Boolean): Boolean {
+        return withNativeLibrary(false) { setGcTracking(enabled) }
+    }
+
+    /**
+     * Samples about one allocation per [intervalBytes] allocated bytes, or stops
+     * sampling when [intervalBytes] is 0. Returns false if the VM cannot sample allocations.
+     */
+    internal fun safeSetAllocationSampling(intervalBytes: Int): Boolean {
+        return withNativeLibrary(false) { setAllocationSampling(intervalBytes) }
+    }
+
+    /**
+     * Gets up to [maxPauses] of the most recent GC pauses that started after
+     * [sinceTimestamp], oldest first.
+     */
+    internal fun safeGetGcPauses(sinceTimestamp: Long = 0L, maxPauses: Int = DEFAULT_GC_PAUSES): List<GcPause> {
+        return withNativeLibrary(emptyList()) {
+            val flat = getGcPauses(sinceTimestamp, maxPauses) ?: return@withNativeLibrary emptyList()
+            (0 until flat.size / GC_PAUSE_FIELDS).map { row ->
+                val offset = row * GC_PAUSE_FIELDS
+                GcPause(
+                    start = flat[offset],
+                    durationNanos = flat[offset + 1],
+                    allocatedBytes = flat[offset + 2],
+                    cycleNanos = flat[offset + 3]
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the GC pause and allocation totals.
+     */
+    internal fun safeGetGcStatus(): GcStatus {
+        return withNativeLibrary(GcStatus.NONE) {
+            val fields = getGcStatus()
+            if (fields == null || fields.size < GC_STATUS_FIELDS) {
+                GcStatus.NONE
+            } else {
+                GcStatus(
+                    collections = fields[0],
+                    totalPauseNanos = fields[1],
+                    maxPauseNanos = fields[2],
+                    lastPauseTime = fields[3],
+                    allocationSamples = fields[4],
+                    sampledBytes = fields[5],
+                    estimatedAllocatedBytes = fields[6],
+                    samplingInterval = fields[7],
+                    gcTrackingEnabled = fields[8] != 0L
+                )
+            }
+        }
+    }
+
+    /**
+     * Gets the instances and bytes measured so far per class, keyed by class name.
+     */
+    internal fun safeGetMemoryByClass(): Map<String, ClassMemoryUsage> {
+        return withNativeLibrary(emptyMap()) {
+            // Classes are only appended, so names fetched first never outnumber the stats
+            val names = getTrackedClassNames() ?: return@withNativeLibrary emptyMap()
+            val stats = getClassMemoryStats() ?: return@withNativeLibrary emptyMap()
+            val count = minOf(names.size, stats.size / CLASS_STATS_FIELDS)
+            (0 until count).associate { index ->
+                val offset = index * CLASS_STATS_FIELDS
+                names[index] to ClassMemoryUsage(
+                    className = names[index],
+                    instanceCount = stats[offset],
+                    totalMemory = stats[offset + 1],
+                    lastUpdateTime = stats[offset + 2]
+                )
+            }
+        }
+    }
+
     /**
      * Gets the size of a specific buffer.
      */
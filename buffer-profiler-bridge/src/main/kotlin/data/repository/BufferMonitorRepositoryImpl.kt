@@ -1,5 +1,24 @@
 package data.repository
 
+import domain.entity.BackpressureAlert
+import domain.entity.BackpressureStatus
+import domain.entity.BufferAggregates
+import domain.entity.BufferEvent
+import domain.entity.BufferEventCounts
+import domain.entity.BufferEventType
+import domain.entity.BufferGroupTotals
+import domain.entity.BufferMetricsSnapshot
+import domain.entity.CaptureStatus
+import domain.entity.ClassMemoryUsage
+import domain.entity.GcPause
+import domain.entity.GcStatus
+import domain.entity.HistoryPoint
+import domain.entity.HistoryTier
+import domain.entity.LatencyHistogram
+import domain.entity.LatencyKind
+import domain.entity.OverheadStatus
+import domain.entity.RetainedSizeStatus
+import domain.entity.SuspensionStackStatus
 import domain.repository.BufferMonitorRepository
 import NativeBufferMonitor
 
@@ -11,6 +30,18 @@ internal class BufferMonitorRepositoryImpl(
         return nativeBufferMonitor.safeCreateBuffer(capacity)
     }
 
+    override fun releaseBuffer(bufferId: Long): Boolean {
+        return nativeBufferMonitor.safeReleaseBuffer(bufferId)
+    }
+
+    override fun createLabeledBuffer(capacity: Int, name: String, labels: Map<String, String>): Long {
+        return nativeBufferMonitor.safeCreateLabeledBuffer(capacity, name, labels)
+    }
+
+    override fun getBufferName(bufferId: Long): String? {
+        return nativeBufferMonitor.safeGetBufferName(bufferId)
+    }
+
     override fun updateBufferMetrics(bufferId: Long, size: Int, memoryUsage: Long) {
         nativeBufferMonitor.safeUpdateBufferMetrics(bufferId, size, memoryUsage)
     }
@@ -19,6 +50,14 @@ internal class BufferMonitorRepositoryImpl(
         nativeBufferMonitor.safeRecordSuspension(threadId, threadName, bufferId, bufferSize, bufferCapacity)
     }
 
+    override fun registerThread() {
+        nativeBufferMonitor.safeRegisterThread()
+    }
+
+    override fun recordSuspension(bufferId: Long, bufferSize: Int, bufferCapacity: Int) {
+        nativeBufferMonitor.safeRecordBufferSuspension(bufferId, bufferSize, bufferCapacity)
+    }
+
     override fun getObjectSize(obj: Any): Long {
         return nativeBufferMonitor.safeGetObjectSize(obj)
     }
@@ -35,6 +74,46 @@ internal class BufferMonitorRepositoryImpl(
         return nativeBufferMonitor.safeGetTotalTrackedMemory()
     }
 
+    override fun setObjectSizeSampling(arraySampleInterval: Int) {
+        nativeBufferMonitor.safeSetObjectSizeSampling(arraySampleInterval)
+    }
+
+    override fun getMemoryByClass(): Map<String, ClassMemoryUsage> {
+        return nativeBufferMonitor.safeGetMemoryByClass()
+    }
+
+    override fun setRetainedSizeTracking(enabled: Boolean) {
+        nativeBufferMonitor.safeSetRetainedSizeTracking(enabled)
+    }
+
+    override fun startRetainedSizePass(budgetMillis: Int): Boolean {
+        return nativeBufferMonitor.safeStartRetainedSizePass(budgetMillis)
+    }
+
+    override fun getRetainedSize(bufferId: Long): Long {
+        return nativeBufferMonitor.safeGetRetainedSize(bufferId)
+    }
+
+    override fun getRetainedSizeStatus(): RetainedSizeStatus {
+        return nativeBufferMonitor.safeGetRetainedSizeStatus()
+    }
+
+    override fun setGcTracking(enabled: Boolean): Boolean {
+        return nativeBufferMonitor.safeSetGcTracking(enabled)
+    }
+
+    override fun setAllocationSampling(intervalBytes: Int): Boolean {
+        return nativeBufferMonitor.safeSetAllocationSampling(intervalBytes)
+    }
+
+    override fun getGcPauses(sinceTimestamp: Long, maxPauses: Int): List<GcPause> {
+        return nativeBufferMonitor.safeGetGcPauses(sinceTimestamp, maxPauses)
+    }
+
+    override fun getGcStatus(): GcStatus {
+        return nativeBufferMonitor.safeGetGcStatus()
+    }
+
     override fun getTotalSuspensions(): Int {
         return nativeBufferMonitor.safeGetTotalSuspensions()
     }
@@ -47,6 +126,30 @@ internal class BufferMonitorRepositoryImpl(
         nativeBufferMonitor.safeRecordConsumption(bufferId)
     }
 
+    override fun onEmit(bufferId: Long, value: Any): Long {
+        return nativeBufferMonitor.safeOnEmit(bufferId, value)
+    }
+
+    override fun onConsume(bufferId: Long, entrySize: Long, residencyNanos: Long, value: Any?) {
+        nativeBufferMonitor.safeOnConsume(bufferId, entrySize, residencyNanos, value)
+    }
+
+    override fun cancelEmit(bufferId: Long, entrySize: Long, value: Any?) {
+        nativeBufferMonitor.safeCancelEmit(bufferId, entrySize, value)
+    }
+
+    override fun recordSuspensionDuration(bufferId: Long, nanos: Long) {
+        nativeBufferMonitor.safeRecordSuspensionDuration(bufferId, nanos)
+    }
+
+    override fun getLatencyPercentile(bufferId: Long, kind: LatencyKind, percentile: Double): Long {
+        return nativeBufferMonitor.safeGetLatencyPercentile(bufferId, kind, percentile)
+    }
+
+    override fun getLatencyHistogram(bufferId: Long, kind: LatencyKind): LatencyHistogram {
+        return nativeBufferMonitor.safeGetLatencyHistogram(bufferId, kind)
+    }
+
     override fun getTotalEmissions(): Int {
         return nativeBufferMonitor.safeGetTotalEmissions()
     }
@@ -55,6 +158,125 @@ internal class BufferMonitorRepositoryImpl(
         return nativeBufferMonitor.safeGetTotalConsumptions()
     }
 
+    override fun snapshotAll(): BufferMetricsSnapshot {
+        return nativeBufferMonitor.safeSnapshotAll()
+    }
+
+    override fun getBufferAggregates(maxFullest: Int): BufferAggregates {
+        return nativeBufferMonitor.safeGetBufferAggregates(maxFullest)
+    }
+
+    override fun setBackpressureDetection(warningNanos: Long, smoothingNanos: Long) {
+        nativeBufferMonitor.safeSetBackpressureDetection(warningNanos, smoothingNanos)
+    }
+
+    override fun pollBackpressureAlerts(maxAlerts: Int): List<BackpressureAlert> {
+        return nativeBufferMonitor.safePollBackpressureAlerts(maxAlerts)
+    }
+
+    override fun getBackpressureStatus(bufferId: Long): BackpressureStatus? {
+        return nativeBufferMonitor.safeGetBackpressureStatus(bufferId)
+    }
+
+    override fun getDroppedBackpressureAlerts(): Long {
+        return nativeBufferMonitor.safeGetDroppedBackpressureAlerts()
+    }
+
+    override fun createRingChannel(capacity: Int): Long {
+        return nativeBufferMonitor.safeCreateRingChannel(capacity)
+    }
+
+    override fun getRingChannelBufferId(channel: Long): Long {
+        return nativeBufferMonitor.safeGetRingChannelBufferId(channel)
+    }
+
+    override fun ringSendLong(channel: Long, value: Long, suspendedSince: Long): Long {
+        return nativeBufferMonitor.safeRingSendLong(channel, value, suspendedSince)
+    }
+
+    override fun ringSendBytes(channel: Long, value: ByteArray, suspendedSince: Long): Long {
+        return nativeBufferMonitor.safeRingSendBytes(channel, value, suspendedSince)
+    }
+
+    override fun ringReceiveLong(channel: Long, result: LongArray): Boolean {
+        return nativeBufferMonitor.safeRingReceiveLong(channel, result)
+    }
+
+    override fun ringReceiveBytes(channel: Long): ByteArray? {
+        return nativeBufferMonitor.safeRingReceiveBytes(channel)
+    }
+
+    override fun closeRingChannel(channel: Long) {
+        nativeBufferMonitor.safeCloseRingChannel(channel)
+    }
+
+    override fun destroyRingChannel(channel: Long) {
+        nativeBufferMonitor.safeDestroyRingChannel(channel)
+    }
+
+    override fun setBufferHistoryEnabled(enabled: Boolean) {
+        nativeBufferMonitor.safeSetBufferHistoryEnabled(enabled)
+    }
+
+    override fun getBufferHistory(
+        bufferId: Long,
+        tier: HistoryTier,
+        fromTime: Long,
+        toTime: Long,
+        maxPoints: Int
+    ): List<HistoryPoint> {
+        return nativeBufferMonitor.safeGetBufferHistory(bufferId, tier, fromTime, toTime, maxPoints)
+    }
+
+    override fun getEventTimeline(
+        type: BufferEventType?,
+        bufferId: Long,
+        sinceTimestamp: Long,
+        maxEvents: Int
+    ): List<BufferEvent> {
+        return nativeBufferMonitor.safeGetEventTimeline(type, bufferId, sinceTimestamp, maxEvents)
+    }
+
+    override fun getEventCounts(): BufferEventCounts {
+        return nativeBufferMonitor.safeGetEventCounts()
+    }
+
+    override fun startSharedMemoryExport(intervalMillis: Int, maxBuffers: Int): String? {
+        return nativeBufferMonitor.safeStartSharedMemoryExport(intervalMillis, maxBuffers)
+    }
+
+    override fun stopSharedMemoryExport() {
+        nativeBufferMonitor.safeStopSharedMemoryExport()
+    }
+
+    override fun getBufferGroupOf(bufferId: Long): Int {
+        return nativeBufferMonitor.safeGetBufferGroupOf(bufferId)
+    }
+
+    override fun findBufferGroup(labels: Map<String, String>): Int {
+        return nativeBufferMonitor.safeFindBufferGroup(labels)
+    }
+
+    override fun getBufferGroupTotals(groupId: Int): BufferGroupTotals {
+        return nativeBufferMonitor.safeGetBufferGroupTotals(groupId)
+    }
+
+    override fun getBufferGroups(): List<BufferGroupTotals> {
+        return nativeBufferMonitor.safeGetBufferGroups()
+    }
+
+    override fun startCapture(path: String, snapshotIntervalMillis: Int): Boolean {
+        return nativeBufferMonitor.safeStartCapture(path, snapshotIntervalMillis)
+    }
+
+    override fun stopCapture() {
+        nativeBufferMonitor.safeStopCapture()
+    }
+
+    override fun getCaptureStatus(): CaptureStatus {
+        return nativeBufferMonitor.safeGetCaptureStatus()
+    }
+
     override fun getBufferEmissions(bufferId: Long): Int {
         return nativeBufferMonitor.safeGetBufferEmissions(bufferId)
     }
@@ -67,6 +289,38 @@ internal class BufferMonitorRepositoryImpl(
         return nativeBufferMonitor.safeGetBufferSuspensionCount(bufferId)
     }
 
+    override fun setOverheadBudget(budgetPercent: Double) {
+        nativeBufferMonitor.safeSetOverheadBudget(budgetPercent)
+    }
+
+    override fun getOverheadStatus(): OverheadStatus {
+        return nativeBufferMonitor.safeGetOverheadStatus()
+    }
+
+    override fun getBufferSamplePeriod(bufferId: Long): Int {
+        return nativeBufferMonitor.safeGetBufferSamplePeriod(bufferId)
+    }
+
+    override fun startMetricsExporter(address: String): String? {
+        return nativeBufferMonitor.safeStartMetricsExporter(address)
+    }
+
+    override fun stopMetricsExporter() {
+        nativeBufferMonitor.safeStopMetricsExporter()
+    }
+
+    override fun setSuspensionStackSampling(sampleRate: Int, maxDepth: Int): Boolean {
+        return nativeBufferMonitor.safeSetSuspensionStackSampling(sampleRate, maxDepth)
+    }
+
+    override fun getSuspensionStackStatus(): SuspensionStackStatus {
+        return nativeBufferMonitor.safeGetSuspensionStackStatus()
+    }
+
+    override fun getCollapsedSuspensionStacks(bufferId: Long): String {
+        return nativeBufferMonitor.safeGetCollapsedSuspensionStacks(bufferId)
+    }
+
     override fun clearTracking() {
         nativeBufferMonitor.safeClearTracking()
     }
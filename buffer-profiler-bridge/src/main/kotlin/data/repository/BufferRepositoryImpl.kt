@@ -1,7 +1,9 @@
 package data.repository
 
 import domain.entity.Buffer
+import domain.entity.NativePayload
 import domain.repository.BufferRepository
+import data.source.NativeRingBuffer
 import data.source.TrackedBuffer
 import domain.repository.BufferMonitorRepository
 
@@ -12,4 +14,17 @@ internal class BufferRepositoryImpl(
     override fun <T : Any> createBuffer(capacity: Int): Buffer<T> {
         return TrackedBuffer(capacity, bufferMonitorRepository)
     }
+
+    override fun <T : Any> createBuffer(capacity: Int, name: String, labels: Map<String, String>): Buffer<T> {
+        return TrackedBuffer(capacity, bufferMonitorRepository, name, labels)
+    }
+
+    override fun <T : Any> createNativeBuffer(capacity: Int, payload: NativePayload<T>): Buffer<T> {
+        // Without the native library or a free registry slot, fall back to a channel-backed buffer
+        val channel = bufferMonitorRepository.createRingChannel(capacity)
+        if (channel == 0L) {
+            return TrackedBuffer(capacity, bufferMonitorRepository)
+        }
+        return NativeRingBuffer(capacity, payload, channel, bufferMonitorRepository)
+    }
 }
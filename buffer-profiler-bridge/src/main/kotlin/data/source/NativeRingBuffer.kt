@@ -0,0 +1,132 @@
+package data.source
+
+import domain.entity.Buffer
+import domain.entity.NativePayload
+import domain.repository.BufferMonitorRepository
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.ClosedSendChannelException
+import java.lang.ref.Cleaner
+
+/**
+ * A buffer whose entries live in a native ring channel.
+ * Occupancy is the native buffer size itself, so every emit and consume updates size,
+ * memory, counters, suspensions and residency in the same native call that moves the
+ * entry, with nothing mirrored from a JVM channel. Producers that find it full suspend
+ * on [spaceAvailable] until a consume frees a slot; closing the buffer closes
+ * [spaceAvailable] too, so every waiting producer wakes up and fails.
+ */
+internal class NativeRingBuffer<T : Any>(
+    override val capacity: Int,
+    private val payload: NativePayload<T>,
+    private val channel: Long,
+    private val bufferMonitor: BufferMonitorRepository
+) : Buffer<T> {
+    private val bufferId = bufferMonitor.getRingChannelBufferId(channel)
+    private val spaceAvailable = Channel<Unit>(Channel.CONFLATED)
+
+    init {
+        // The action only captures the handle, so it cannot keep this buffer reachable
+        val monitor = bufferMonitor
+        val handle = channel
+        cleaner.register(this) { monitor.destroyRingChannel(handle) }
+    }
+
+    override suspend fun emit(value: T) {
+        var suspendedSince = 0L
+        while (true) {
+            val result = send(value, suspendedSince)
+            when {
+                result == 0L -> {
+                    // Another producer may be waiting on the same token
+                    if (suspendedSince != 0L) {
+                        spaceAvailable.trySend(Unit)
+                    }
+                    return
+                }
+                result == RING_CLOSED -> {
+                    spaceAvailable.close()
+                    throw ClosedSendChannelException("Buffer is closed")
+                }
+                result == RING_UNTRACKED -> {
+                    // No send can succeed again, so no waiting producer should stay suspended
+                    spaceAvailable.close()
+                    throw IllegalStateException("Buffer $bufferId is no longer tracked; clearTracking released it")
+                }
+                else -> {
+                    suspendedSince = result
+                    // A closed signal means retry: the send then reports why
+                    spaceAvailable.receiveCatching()
+                }
+            }
+        }
+    }
+
+    override suspend fun consume(): T? {
+        val value = receive() ?: return null
+        spaceAvailable.trySend(Unit)
+        return value
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    private fun send(value: T, suspendedSince: Long): Long {
+        return when (payload) {
+            NativePayload.Longs -> bufferMonitor.ringSendLong(channel, value as Long, suspendedSince)
+            NativePayload.Ints -> bufferMonitor.ringSendLong(channel, (value as Int).toLong(), suspendedSince)
+            NativePayload.Doubles -> bufferMonitor.ringSendLong(channel, (value as Double).toRawBits(), suspendedSince)
+            NativePayload.Bytes -> bufferMonitor.ringSendBytes(channel, value as ByteArray, suspendedSince)
+        }
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    private fun receive(): T? {
+        if (payload == NativePayload.Bytes) {
+            return bufferMonitor.ringReceiveBytes(channel) as T?
+        }
+        val result = scratch.get()
+        if (!bufferMonitor.ringReceiveLong(channel, result)) {
+            return null
+        }
+        return when (payload) {
+            NativePayload.Ints -> result[0].toInt()
+            NativePayload.Doubles -> Double.fromBits(result[0])
+            else -> result[0]
+        } as T
+    }
+
+    override fun getCurrentSize(): Int {
+        return bufferMonitor.getBufferSize(bufferId)
+    }
+
+    override fun getId(): Long {
+        return bufferId
+    }
+
+    override fun getEmissions(): Int {
+        return bufferMonitor.getBufferEmissions(bufferId)
+    }
+
+    override fun getConsumptions(): Int {
+        return bufferMonitor.getBufferConsumptions(bufferId)
+    }
+
+    override fun getSuspensions(): Int {
+        return bufferMonitor.getBufferSuspensionCount(bufferId)
+    }
+
+    override fun close() {
+        // Queued entries stay receivable; every waiting producer wakes up and sees the closed channel
+        bufferMonitor.closeRingChannel(channel)
+        spaceAvailable.close()
+    }
+
+    private companion object {
+        // Send result for a closed channel; positive results are the time it was found full
+        const val RING_CLOSED = -1L
+
+        // Send result once clearTracking has released the buffer
+        const val RING_UNTRACKED = -2L
+
+        val cleaner: Cleaner = Cleaner.create()
+        val scratch: ThreadLocal<LongArray> = ThreadLocal.withInitial { LongArray(1) }
+    }
+}
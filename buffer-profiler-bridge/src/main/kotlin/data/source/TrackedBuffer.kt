@@ -3,85 +3,116 @@ package data.source
 import domain.entity.Buffer
 import domain.entity.BufferEntry
 import domain.repository.BufferMonitorRepository
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.DelicateCoroutinesApi
 import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.channels.ClosedReceiveChannelException
 import kotlinx.coroutines.channels.ClosedSendChannelException
+import java.util.concurrent.atomic.AtomicInteger
 
 /**
  * A buffer that tracks its operations and memory usage.
  * It uses a Channel to manage the buffer's contents and a BufferMonitor to track its operations.
+ * With a [name] or [labels] the native buffer is created in the labeled group hierarchy.
+ * Closing only stops new emits: the native handle is released once the channel has been
+ * drained and no call is still using it, so consumers draining the last entries keep
+ * updating live metrics instead of a stale handle. A closed buffer that is never drained
+ * keeps its handle until clearTracking.
  */
 internal class TrackedBuffer<T : Any>(
     override val capacity: Int,
-    private val bufferMonitor: BufferMonitorRepository
+    private val bufferMonitor: BufferMonitorRepository,
+    name: String = "",
+    labels: Map<String, String> = emptyMap()
 ) : Buffer<T> {
     private val channel = Channel<BufferEntry<T>>(capacity)
-    private val bufferId = bufferMonitor.createBuffer(capacity)
+    private val bufferId = if (name.isEmpty() && labels.isEmpty()) {
+        bufferMonitor.createBuffer(capacity)
+    } else {
+        bufferMonitor.createLabeledBuffer(capacity, name, labels)
+    }
 
-    override suspend fun emit(value: T) {
-        val threadId = Thread.currentThread().id
-        val threadName = Thread.currentThread().name
+    // Native calls in flight, or RELEASED once the handle is gone
+    private val operations = AtomicInteger(0)
 
+    override suspend fun emit(value: T) {
+        if (!beginOperation()) {
+            throw ClosedSendChannelException("Buffer is closed")
+        }
         try {
-            val size = bufferMonitor.getObjectSize(value)
-            val entry = BufferEntry(value, System.nanoTime(), size)
-
-            val currentSize = bufferMonitor.getBufferSize(bufferId)
-            if (currentSize >= capacity) {
-                bufferMonitor.recordSuspension(
-                    threadId = threadId,
-                    threadName = threadName,
-                    bufferId = bufferId,
-                    bufferSize = currentSize,
-                    bufferCapacity = capacity
-                )
-            }
-
-            // Record emission in native code
-            bufferMonitor.recordEmission(bufferId)
-
-            channel.send(entry)
-
-            val currentBufferSize = bufferMonitor.getBufferSize(bufferId)
-            val currentMemoryUsage = bufferMonitor.getBufferMemoryUsage(bufferId)
+            send(value)
+        } finally {
+            endOperation()
+        }
+    }
 
-            val newSize = currentBufferSize + 1
-            val newMemoryUsage = currentMemoryUsage + size
+    private suspend fun send(value: T) {
+        // A single native call measures the value, counts the emission (and the
+        // suspension if the buffer is already full) and reserves its size and memory
+        val size = bufferMonitor.onEmit(bufferId, value)
+        val entry = BufferEntry(value, System.nanoTime(), size)
 
-            bufferMonitor.updateBufferMetrics(
-                bufferId = bufferId,
-                size = newSize,
-                memoryUsage = newMemoryUsage
-            )
+        try {
+            // Only a send that cannot complete right away suspends; time it for the suspension histogram
+            if (!channel.trySend(entry).isSuccess) {
+                val suspendedAt = System.nanoTime()
+                channel.send(entry)
+                bufferMonitor.recordSuspensionDuration(bufferId, System.nanoTime() - suspendedAt)
+            }
         } catch (e: ClosedSendChannelException) {
+            bufferMonitor.cancelEmit(bufferId, size, value)
+            throw e
+        } catch (e: CancellationException) {
+            bufferMonitor.cancelEmit(bufferId, size, value)
             throw e
         }
     }
 
     override suspend fun consume(): T? {
+        if (!beginOperation()) {
+            return null
+        }
         return try {
             channel.tryReceive().getOrNull()?.also { entry ->
-                // Record consumption in native code
-                bufferMonitor.recordConsumption(bufferId)
-                val currentBufferSize = bufferMonitor.getBufferSize(bufferId)
-                val currentMemoryUsage = bufferMonitor.getBufferMemoryUsage(bufferId)
-
-                val newSize = currentBufferSize - 1
-                val newMemoryUsage = currentMemoryUsage - entry.size
-
-                bufferMonitor.updateBufferMetrics(
-                    bufferId = bufferId,
-                    size = newSize,
-                    memoryUsage = newMemoryUsage
-                )
+                // Record consumption, size and memory release and time in buffer in one native call
+                bufferMonitor.onConsume(bufferId, entry.size, System.nanoTime() - entry.entryId, entry.value)
             }?.value
         } catch (e: ClosedReceiveChannelException) {
             null
+        } finally {
+            endOperation()
+        }
+    }
+
+    private fun beginOperation(): Boolean {
+        while (true) {
+            val current = operations.get()
+            if (current == RELEASED) {
+                return false
+            }
+            if (operations.compareAndSet(current, current + 1)) {
+                return true
+            }
+        }
+    }
+
+    private fun endOperation() {
+        operations.decrementAndGet()
+        releaseIfDrained()
+    }
+
+    // Only a closed, empty channel with no call in flight gives up the handle, and only once.
+    // close() checks after closing and every call checks after finishing, so the last one sees it.
+    @OptIn(DelicateCoroutinesApi::class)
+    private fun releaseIfDrained() {
+        if (channel.isClosedForReceive && operations.compareAndSet(0, RELEASED)) {
+            bufferMonitor.releaseBuffer(bufferId)
         }
     }
 
     override fun getCurrentSize(): Int {
-        return bufferMonitor.getBufferSize(bufferId).takeIf { it > 0 } ?: 0
+        // Producers suspended in send() are already counted natively, so clamp to the channel capacity
+        return bufferMonitor.getBufferSize(bufferId).coerceIn(0, capacity)
     }
 
     override fun getId(): Long {
@@ -102,5 +133,10 @@ internal class TrackedBuffer<T : Any>(
 
     override fun close() {
         channel.close()
+        releaseIfDrained()
+    }
+
+    private companion object {
+        const val RELEASED = Int.MIN_VALUE
     }
 }
@@ -1,6 +1,7 @@
 package data.usecase
 
 import domain.entity.Buffer
+import domain.entity.NativePayload
 import domain.repository.BufferRepository
 import domain.usecase.CreateBufferUseCase
 
@@ -11,4 +12,12 @@ internal class CreateBufferUseCaseImpl(
     override fun <T : Any> invoke(capacity: Int): Buffer<T> {
         return bufferRepository.createBuffer(capacity)
     }
+
+    override fun <T : Any> invoke(capacity: Int, name: String, labels: Map<String, String>): Buffer<T> {
+        return bufferRepository.createBuffer(capacity, name, labels)
+    }
+
+    override fun <T : Any> invoke(capacity: Int, payload: NativePayload<T>): Buffer<T> {
+        return bufferRepository.createNativeBuffer(capacity, payload)
+    }
 }
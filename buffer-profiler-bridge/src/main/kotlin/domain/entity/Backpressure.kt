@@ -0,0 +1,42 @@
+package domain.entity
+
+/**
+ * Kinds of alerts queued by the native backpressure detector.
+ */
+enum class BackpressureAlertKind(val nativeId: Int) {
+    /** The buffer is predicted to be full within the warning horizon. */
+    FILLING(0),
+
+    /** The prediction moved beyond twice the horizon, or the buffer stopped filling. */
+    CLEARED(1);
+
+    companion object {
+        fun fromNativeId(id: Int): BackpressureAlertKind? = values().firstOrNull { it.nativeId == id }
+    }
+}
+
+/**
+ * An alert raised from the smoothed emission and consumption rates of a buffer.
+ * [time] uses the same clock as the buffer metrics; [timeToFullNanos] is -1 when
+ * the buffer is not filling. Rates are items per second.
+ */
+data class BackpressureAlert(
+    val kind: BackpressureAlertKind,
+    val bufferId: Long,
+    val time: Long,
+    val timeToFullNanos: Long,
+    val size: Long,
+    val capacity: Long,
+    val emitRate: Long,
+    val consumeRate: Long
+)
+
+/**
+ * The detector's latest estimate for one buffer.
+ */
+data class BackpressureStatus(
+    val emitRate: Long,
+    val consumeRate: Long,
+    val timeToFullNanos: Long,
+    val alerting: Boolean
+)
@@ -0,0 +1,33 @@
+package domain.entity
+
+/**
+ * One of the fullest buffers. [utilizationPermille] is size over capacity in
+ * thousandths and can exceed 1000 while producers wait on a full buffer.
+ */
+data class FullBuffer(
+    val bufferId: Long,
+    val size: Long,
+    val capacity: Long,
+    val utilizationPermille: Long
+)
+
+/**
+ * Totals over every tracked buffer, the maximum utilization and the fullest
+ * buffers, fullest first, all computed in a single native pass.
+ */
+data class BufferAggregates(
+    val bufferCount: Long,
+    val totalEmissions: Long,
+    val totalConsumptions: Long,
+    val totalSuspensions: Long,
+    val totalMemoryUsage: Long,
+    val totalSize: Long,
+    val totalCapacity: Long,
+    val maxUtilizationPermille: Long,
+    val fullestBufferId: Long,
+    val fullest: List<FullBuffer>
+) {
+    companion object {
+        val NONE = BufferAggregates(0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, emptyList())
+    }
+}
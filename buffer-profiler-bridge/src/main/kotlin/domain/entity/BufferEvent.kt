@@ -0,0 +1,40 @@
+package domain.entity
+
+/**
+ * Kinds of events recorded in the native per-thread event rings.
+ */
+enum class BufferEventType(val nativeId: Int) {
+    /** A producer found the buffer full and suspended. */
+    SUSPEND(0),
+
+    /** A suspended producer resumed; [BufferEvent.durationNanos] holds how long it waited. */
+    RESUME(1);
+
+    companion object {
+        fun fromNativeId(id: Int): BufferEventType? = values().firstOrNull { it.nativeId == id }
+    }
+}
+
+/**
+ * A single entry of the native suspension timeline.
+ * Timestamps use the same monotonic nanosecond clock as the buffer metrics.
+ */
+data class BufferEvent(
+    val type: BufferEventType,
+    val timestamp: Long,
+    val threadId: Long,
+    val threadName: String?,
+    val bufferId: Long,
+    val bufferSize: Int,
+    val bufferCapacity: Int,
+    val durationNanos: Long
+)
+
+/**
+ * Totals aggregated from the native event rings, plus events lost because a ring was full.
+ */
+data class BufferEventCounts(
+    val suspensions: Long,
+    val resumptions: Long,
+    val dropped: Long
+)
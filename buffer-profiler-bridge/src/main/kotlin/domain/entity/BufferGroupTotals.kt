@@ -0,0 +1,21 @@
+package domain.entity
+
+/**
+ * Running totals of a labeled buffer group, including every group below it.
+ * [path] lists the group's labels outermost first, for example "pipeline=ingest/stage=parse".
+ */
+data class BufferGroupTotals(
+    val groupId: Int,
+    val path: String,
+    val bufferCount: Long,
+    val capacity: Long,
+    val size: Long,
+    val memoryUsage: Long,
+    val emissions: Long,
+    val consumptions: Long,
+    val suspensions: Long
+) {
+    companion object {
+        val NONE = BufferGroupTotals(-1, "", 0L, 0L, 0L, 0L, 0L, 0L, 0L)
+    }
+}
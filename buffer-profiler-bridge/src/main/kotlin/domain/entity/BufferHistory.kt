@@ -0,0 +1,29 @@
+package domain.entity
+
+/**
+ * Resolutions of the native per-buffer history. [RAW] holds individual samples,
+ * the others hold buckets of [widthMillis] with the min, max and average of every
+ * sample that fell into them.
+ */
+enum class HistoryTier(val nativeId: Int, val widthMillis: Long) {
+    RAW(0, 0L),
+    SECOND(1, 1_000L),
+    TEN_SECONDS(2, 10_000L),
+    MINUTE(3, 60_000L)
+}
+
+/**
+ * One point of a buffer's size and memory history.
+ * [start] is the sample time or bucket start, on the same monotonic nanosecond
+ * clock as the buffer metrics; a raw sample has a [count] of 1.
+ */
+data class HistoryPoint(
+    val start: Long,
+    val count: Long,
+    val minSize: Int,
+    val maxSize: Int,
+    val avgSize: Double,
+    val minMemory: Long,
+    val maxMemory: Long,
+    val avgMemory: Double
+)
@@ -0,0 +1,54 @@
+package domain.entity
+
+/**
+ * A consistent point-in-time view of every tracked buffer, taken in a single native call.
+ * Per-buffer values are stored column-wise in primitive arrays; row `i` of every column
+ * describes the buffer whose handle is `bufferIds[i]`. The totals are summed from exactly
+ * these rows.
+ */
+class BufferMetricsSnapshot(
+    val timestamp: Long,
+    val totalEmissions: Long,
+    val totalConsumptions: Long,
+    val totalSuspensions: Long,
+    val totalMemoryUsage: Long,
+    val totalSize: Long,
+    val bufferIds: LongArray,
+    val memoryUsage: LongArray,
+    val emissions: LongArray,
+    val consumptions: LongArray,
+    val suspensions: LongArray,
+    val lastUpdateTimes: LongArray,
+    val capacities: IntArray,
+    val sizes: IntArray
+) {
+    /**
+     * The number of buffers in this snapshot.
+     */
+    val bufferCount: Int
+        get() = bufferIds.size
+
+    /**
+     * Returns the row of the given buffer, or -1 if it was not live when the snapshot was taken.
+     */
+    fun indexOf(bufferId: Long): Int = bufferIds.indexOf(bufferId)
+
+    companion object {
+        val EMPTY = BufferMetricsSnapshot(
+            timestamp = 0L,
+            totalEmissions = 0L,
+            totalConsumptions = 0L,
+            totalSuspensions = 0L,
+            totalMemoryUsage = 0L,
+            totalSize = 0L,
+            bufferIds = LongArray(0),
+            memoryUsage = LongArray(0),
+            emissions = LongArray(0),
+            consumptions = LongArray(0),
+            suspensions = LongArray(0),
+            lastUpdateTimes = LongArray(0),
+            capacities = IntArray(0),
+            sizes = IntArray(0)
+        )
+    }
+}
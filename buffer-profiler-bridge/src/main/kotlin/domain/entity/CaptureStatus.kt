@@ -0,0 +1,18 @@
+package domain.entity
+
+/**
+ * Progress of the native capture file. After the capture stops, [active] is false
+ * and the other fields describe the finished file.
+ */
+data class CaptureStatus(
+    val active: Boolean,
+    val bytesWritten: Long,
+    val chunkCount: Long,
+    val eventCount: Long,
+    val snapshotCount: Long,
+    val droppedEvents: Long
+) {
+    companion object {
+        val NONE = CaptureStatus(false, 0L, 0L, 0L, 0L, 0L)
+    }
+}
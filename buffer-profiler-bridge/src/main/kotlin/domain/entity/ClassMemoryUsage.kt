@@ -0,0 +1,12 @@
+package domain.entity
+
+/**
+ * Instances and bytes attributed to one class by the native object size cache.
+ * Array sizes may be estimated from sampled measurements.
+ */
+data class ClassMemoryUsage(
+    val className: String,
+    val instanceCount: Long,
+    val totalMemory: Long,
+    val lastUpdateTime: Long
+)
@@ -0,0 +1,39 @@
+package domain.entity
+
+/**
+ * One garbage collection seen through JVMTI GC events.
+ * [start] uses the same clock as the buffer history and event timeline, so a pause
+ * can be matched against buffer fill directly. [allocatedBytes] is the estimated
+ * allocation since the previous collection ended, over [cycleNanos].
+ */
+data class GcPause(
+    val start: Long,
+    val durationNanos: Long,
+    val allocatedBytes: Long,
+    val cycleNanos: Long
+) {
+    /** Allocation rate that led up to this collection, 0 when unknown. */
+    val allocationBytesPerSecond: Double
+        get() = if (cycleNanos > 0) allocatedBytes * 1_000_000_000.0 / cycleNanos else 0.0
+}
+
+/**
+ * Totals of GC pauses and sampled allocations since tracking started or was last cleared.
+ * [estimatedAllocatedBytes] weights each allocation sample by the sampling interval
+ * in effect when it was taken; [samplingInterval] is 0 while sampling is off.
+ */
+data class GcStatus(
+    val collections: Long,
+    val totalPauseNanos: Long,
+    val maxPauseNanos: Long,
+    val lastPauseTime: Long,
+    val allocationSamples: Long,
+    val sampledBytes: Long,
+    val estimatedAllocatedBytes: Long,
+    val samplingInterval: Long,
+    val gcTrackingEnabled: Boolean
+) {
+    companion object {
+        val NONE = GcStatus(0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, false)
+    }
+}
@@ -0,0 +1,108 @@
+package domain.entity
+
+/**
+ * The latencies tracked per buffer.
+ */
+enum class LatencyKind(val nativeId: Int) {
+    /** Time an entry spent in the buffer, from emit to consume. */
+    RESIDENCY(0),
+
+    /** Time a producer spent suspended because the buffer was full. */
+    SUSPENSION(1)
+}
+
+/**
+ * An exported native latency histogram, in nanoseconds.
+ * Buckets are log-linear: values below `2^subBucketBits` get a bucket each and every
+ * higher power of two is split into `2^subBucketBits` equal sub-buckets, so a value is
+ * reported within about 3% of what was recorded. Histograms with the same geometry can be
+ * merged, e.g. to combine buffers or processes.
+ */
+class LatencyHistogram(
+    val subBucketBits: Int,
+    val count: Long,
+    val sum: Long,
+    val min: Long,
+    val max: Long,
+    private val counts: LongArray
+) {
+    val mean: Double
+        get() = if (count == 0L) 0.0 else sum.toDouble() / count
+
+    /**
+     * Returns the highest value equivalent to the given percentile (0-100), or 0 if empty.
+     */
+    fun valueAtPercentile(percentile: Double): Long {
+        if (count == 0L) return 0L
+
+        val target = Math.ceil(percentile.coerceIn(0.0, 100.0) / 100.0 * count).toLong().coerceAtLeast(1L)
+        var seen = 0L
+        for (index in counts.indices) {
+            seen += counts[index]
+            if (seen >= target) {
+                return minOf(highestEquivalentValue(index), max)
+            }
+        }
+        return max
+    }
+
+    val p50: Long get() = valueAtPercentile(50.0)
+    val p99: Long get() = valueAtPercentile(99.0)
+    val p999: Long get() = valueAtPercentile(99.9)
+
+    /**
+     * Returns a histogram holding the samples of both histograms.
+     */
+    fun merge(other: LatencyHistogram): LatencyHistogram {
+        if (other.count == 0L) return this
+        if (count == 0L) return other
+        require(subBucketBits == other.subBucketBits && counts.size == other.counts.size) {
+            "Cannot merge histograms with different bucket layouts"
+        }
+
+        return LatencyHistogram(
+            subBucketBits = subBucketBits,
+            count = count + other.count,
+            sum = sum + other.sum,
+            min = minOf(min, other.min),
+            max = maxOf(max, other.max),
+            counts = LongArray(counts.size) { counts[it] + other.counts[it] }
+        )
+    }
+
+    private fun highestEquivalentValue(index: Int): Long {
+        val subBucketCount = 1 shl subBucketBits
+        if (index < subBucketCount) return index.toLong()
+
+        val shift = index / subBucketCount - 1
+        val lowest = (subBucketCount + index % subBucketCount).toLong() shl shift
+        return lowest + (1L shl shift) - 1
+    }
+
+    companion object {
+        private const val EXPORT_VERSION = 1L
+        private const val EXPORT_HEADER_LENGTH = 7
+
+        val EMPTY = LatencyHistogram(5, 0L, 0L, 0L, 0L, LongArray(0))
+
+        /**
+         * Decodes the array produced by the native export: version, sub-bucket bits,
+         * bucket count, count, sum, min and max, followed by the bucket counts.
+         */
+        fun fromExport(exported: LongArray): LatencyHistogram {
+            if (exported.size < EXPORT_HEADER_LENGTH || exported[0] != EXPORT_VERSION ||
+                exported.size != EXPORT_HEADER_LENGTH + exported[2].toInt()
+            ) {
+                return EMPTY
+            }
+            return LatencyHistogram(
+                subBucketBits = exported[1].toInt(),
+                count = exported[3],
+                sum = exported[4],
+                min = exported[5],
+                max = exported[6],
+                counts = exported.copyOfRange(EXPORT_HEADER_LENGTH, exported.size)
+            )
+        }
+    }
+}
@@ -0,0 +1,12 @@
+package domain.entity
+
+/**
+ * Element types a native ring buffer can hold without any JVM object per entry.
+ * Primitives travel as their 64-bit pattern; byte arrays are copied into native memory.
+ */
+sealed class NativePayload<T : Any> {
+    data object Longs : NativePayload<Long>()
+    data object Ints : NativePayload<Int>()
+    data object Doubles : NativePayload<Double>()
+    data object Bytes : NativePayload<ByteArray>()
+}
@@ -0,0 +1,46 @@
+package domain.entity
+
+/**
+ * Per-item entry points whose cost the native agent measures.
+ */
+enum class OverheadOperation(val nativeId: Int) {
+    /** onEmit, including the object size. */
+    EMIT(0),
+
+    /** onConsume. */
+    CONSUME(1),
+
+    /** recordEmission and recordConsumption. */
+    COUNTER(2),
+
+    /** updateBufferMetrics. */
+    UPDATE(3)
+}
+
+/**
+ * Cost of one operation, extrapolated from the calls the agent timed.
+ */
+data class OverheadCost(
+    val calls: Long,
+    val totalNanos: Long,
+    val meanNanos: Long
+)
+
+/**
+ * Self-measured overhead of the native agent. [overheadPercent] is the share of the calling
+ * threads' time spent in the agent during the last governor interval; it is only measured
+ * while a budget is set. [sampledBuffers] buffers are tracked in sampled mode, where their
+ * counts are unbiased estimates.
+ */
+data class OverheadStatus(
+    val budgetPercent: Double,
+    val overheadPercent: Double,
+    val activeThreads: Int,
+    val sampledBuffers: Int,
+    val totalNanos: Long,
+    val costs: Map<OverheadOperation, OverheadCost>
+) {
+    companion object {
+        val NONE = OverheadStatus(0.0, 0.0, 0, 0, 0L, emptyMap())
+    }
+}
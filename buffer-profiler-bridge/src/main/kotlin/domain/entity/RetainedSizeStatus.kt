@@ -0,0 +1,20 @@
+package domain.entity
+
+/**
+ * Outcome of the last native retained size pass.
+ * A pass that ran out of its time budget reports what it had counted so far,
+ * with [lastPassComplete] set to false.
+ */
+data class RetainedSizeStatus(
+    val passes: Long,
+    val lastPassTime: Long,
+    val lastPassNanos: Long,
+    val lastPassComplete: Boolean,
+    val running: Boolean,
+    val totalRetainedBytes: Long,
+    val totalObjects: Long
+) {
+    companion object {
+        val NONE = RetainedSizeStatus(0L, 0L, 0L, false, false, 0L, 0L)
+    }
+}
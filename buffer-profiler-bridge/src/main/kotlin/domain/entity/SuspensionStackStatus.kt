@@ -0,0 +1,17 @@
+package domain.entity
+
+/**
+ * State of stack sampling at suspension points. [sampleRate] is 0 while sampling is off;
+ * otherwise one suspension in [sampleRate] of each thread is counted in [samples], or in
+ * [droppedSamples] when the stack trie is full or the stack could not be taken.
+ */
+data class SuspensionStackStatus(
+    val sampleRate: Long,
+    val samples: Long,
+    val droppedSamples: Long,
+    val nodes: Long
+) {
+    companion object {
+        val NONE = SuspensionStackStatus(0L, 0L, 0L, 0L)
+    }
+}
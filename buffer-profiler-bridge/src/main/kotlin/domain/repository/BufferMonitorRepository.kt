@@ -1,24 +1,127 @@
 package domain.repository
 
+import domain.entity.BackpressureAlert
+import domain.entity.BackpressureStatus
+import domain.entity.BufferAggregates
+import domain.entity.BufferEvent
+import domain.entity.BufferEventCounts
+import domain.entity.BufferEventType
+import domain.entity.BufferGroupTotals
+import domain.entity.BufferMetricsSnapshot
+import domain.entity.CaptureStatus
+import domain.entity.ClassMemoryUsage
+import domain.entity.GcPause
+import domain.entity.GcStatus
+import domain.entity.HistoryPoint
+import domain.entity.HistoryTier
+import domain.entity.LatencyHistogram
+import domain.entity.LatencyKind
+import domain.entity.OverheadStatus
+import domain.entity.RetainedSizeStatus
+import domain.entity.SuspensionStackStatus
+
 interface BufferMonitorRepository {
     fun createBuffer(capacity: Int): Long
+    fun releaseBuffer(bufferId: Long): Boolean
+    fun createLabeledBuffer(capacity: Int, name: String, labels: Map<String, String>): Long
+    fun getBufferName(bufferId: Long): String?
     fun getObjectSize(obj: Any): Long
     fun getBufferSize(bufferId: Long): Int
     fun getBufferMemoryUsage(bufferId: Long): Long
     fun updateBufferMetrics(bufferId: Long, size: Int, memoryUsage: Long)
 
     fun recordSuspension(threadId: Long, threadName: String, bufferId: Long, bufferSize: Int, bufferCapacity: Int)
+    fun registerThread()
+    fun recordSuspension(bufferId: Long, bufferSize: Int, bufferCapacity: Int)
     fun recordEmission(bufferId: Long)
     fun recordConsumption(bufferId: Long)
 
+    fun onEmit(bufferId: Long, value: Any): Long
+    fun onConsume(bufferId: Long, entrySize: Long, residencyNanos: Long, value: Any? = null)
+    fun cancelEmit(bufferId: Long, entrySize: Long, value: Any? = null)
+
+    fun recordSuspensionDuration(bufferId: Long, nanos: Long)
+    fun getLatencyPercentile(bufferId: Long, kind: LatencyKind, percentile: Double): Long
+    fun getLatencyHistogram(bufferId: Long, kind: LatencyKind): LatencyHistogram
+
     fun getBufferEmissions(bufferId: Long): Int
     fun getBufferConsumptions(bufferId: Long): Int
     fun getBufferSuspensionCount(bufferId: Long): Int
 
     fun getTotalTrackedMemory(): Long
+    fun setObjectSizeSampling(arraySampleInterval: Int)
+    fun getMemoryByClass(): Map<String, ClassMemoryUsage>
+
+    fun setRetainedSizeTracking(enabled: Boolean)
+    fun startRetainedSizePass(budgetMillis: Int = 0): Boolean
+    fun getRetainedSize(bufferId: Long): Long
+    fun getRetainedSizeStatus(): RetainedSizeStatus
+
+    fun setGcTracking(enabled: Boolean): Boolean
+    fun setAllocationSampling(intervalBytes: Int): Boolean
+    fun getGcPauses(sinceTimestamp: Long = 0L, maxPauses: Int = 1000): List<GcPause>
+    fun getGcStatus(): GcStatus
+
     fun getTotalSuspensions(): Int
     fun getTotalEmissions(): Int
     fun getTotalConsumptions(): Int
 
+    fun snapshotAll(): BufferMetricsSnapshot
+    fun getBufferAggregates(maxFullest: Int = 10): BufferAggregates
+
+    fun setBackpressureDetection(warningNanos: Long, smoothingNanos: Long = 0L)
+    fun pollBackpressureAlerts(maxAlerts: Int = 256): List<BackpressureAlert>
+    fun getBackpressureStatus(bufferId: Long): BackpressureStatus?
+    fun getDroppedBackpressureAlerts(): Long
+
+    fun createRingChannel(capacity: Int): Long
+    fun getRingChannelBufferId(channel: Long): Long
+    fun ringSendLong(channel: Long, value: Long, suspendedSince: Long): Long
+    fun ringSendBytes(channel: Long, value: ByteArray, suspendedSince: Long): Long
+    fun ringReceiveLong(channel: Long, result: LongArray): Boolean
+    fun ringReceiveBytes(channel: Long): ByteArray?
+    fun closeRingChannel(channel: Long)
+    fun destroyRingChannel(channel: Long)
+
+    fun setBufferHistoryEnabled(enabled: Boolean)
+    fun getBufferHistory(
+        bufferId: Long,
+        tier: HistoryTier = HistoryTier.SECOND,
+        fromTime: Long = 0L,
+        toTime: Long = Long.MAX_VALUE,
+        maxPoints: Int = 1000
+    ): List<HistoryPoint>
+
+    fun getEventTimeline(
+        type: BufferEventType? = null,
+        bufferId: Long = 0L,
+        sinceTimestamp: Long = 0L,
+        maxEvents: Int = 1000
+    ): List<BufferEvent>
+    fun getEventCounts(): BufferEventCounts
+
+    fun startSharedMemoryExport(intervalMillis: Int, maxBuffers: Int = 0): String?
+    fun stopSharedMemoryExport()
+
+    fun getBufferGroupOf(bufferId: Long): Int
+    fun findBufferGroup(labels: Map<String, String>): Int
+    fun getBufferGroupTotals(groupId: Int): BufferGroupTotals
+    fun getBufferGroups(): List<BufferGroupTotals>
+
+    fun startCapture(path: String, snapshotIntervalMillis: Int = 0): Boolean
+    fun stopCapture()
+    fun getCaptureStatus(): CaptureStatus
+
+    fun setOverheadBudget(budgetPercent: Double)
+    fun getOverheadStatus(): OverheadStatus
+    fun getBufferSamplePeriod(bufferId: Long): Int
+
+    fun startMetricsExporter(address: String = "127.0.0.1:0"): String?
+    fun stopMetricsExporter()
+
+    fun setSuspensionStackSampling(sampleRate: Int, maxDepth: Int = 0): Boolean
+    fun getSuspensionStackStatus(): SuspensionStackStatus
+    fun getCollapsedSuspensionStacks(bufferId: Long = 0L): String
+
     fun clearTracking()
 }
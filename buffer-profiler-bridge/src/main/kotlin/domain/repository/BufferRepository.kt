@@ -1,7 +1,10 @@
 package domain.repository
 
 import domain.entity.Buffer
+import domain.entity.NativePayload
 
 interface BufferRepository {
     fun <T : Any> createBuffer(capacity: Int): Buffer<T>
+    fun <T : Any> createBuffer(capacity: Int, name: String, labels: Map<String, String>): Buffer<T>
+    fun <T : Any> createNativeBuffer(capacity: Int, payload: NativePayload<T>): Buffer<T>
 }
@@ -1,7 +1,10 @@
 package domain.usecase
 
 import domain.entity.Buffer
+import domain.entity.NativePayload
 
 interface CreateBufferUseCase {
     operator fun <T : Any> invoke(capacity: Int): Buffer<T>
+    operator fun <T : Any> invoke(capacity: Int, name: String, labels: Map<String, String>): Buffer<T>
+    operator fun <T : Any> invoke(capacity: Int, payload: NativePayload<T>): Buffer<T>
 }
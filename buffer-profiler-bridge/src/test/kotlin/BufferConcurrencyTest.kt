@@ -1,4 +1,8 @@
+import data.repository.BufferMonitorRepositoryImpl
+import data.repository.BufferRepositoryImpl
+import domain.entity.NativePayload
 import kotlinx.coroutines.*
+import kotlinx.coroutines.channels.ClosedSendChannelException
 import org.junit.jupiter.api.*
 import org.junit.jupiter.api.Assertions.*
 import java.util.concurrent.ConcurrentHashMap
@@ -149,4 +153,105 @@ class BufferConcurrencyTest {
         assertTrue(totalSuspensions >= expected, "Expected at least $expected total suspensions, got $totalSuspensions")
         assertEquals(expected, bufferSuspensions, "Expected $expected buffer suspensions, got $bufferSuspensions")
     }
+
+    @Test
+    @DisplayName("A native ring buffer should keep exact metrics under concurrent producers")
+    fun `test native ring buffer concurrent emission and consumption`() = runBlocking {
+        val bufferRepository = BufferRepositoryImpl(BufferMonitorRepositoryImpl(monitor))
+        val buffer = bufferRepository.createNativeBuffer(8, NativePayload.Longs)
+        val producerCount = 4
+        val itemsPerProducer = 500
+        val consumed = AtomicInteger(0)
+        var sum = 0L
+
+        coroutineScope {
+            repeat(producerCount) { producer ->
+                launch(Dispatchers.Default) {
+                    repeat(itemsPerProducer) { item -> buffer.emit((producer * itemsPerProducer + item).toLong()) }
+                }
+            }
+            launch(Dispatchers.Default) {
+                while (consumed.get() < producerCount * itemsPerProducer) {
+                    val value = buffer.consume()
+                    if (value == null) {
+                        yield()
+                    } else {
+                        sum += value
+                        consumed.incrementAndGet()
+                    }
+                }
+            }
+        }
+
+        val total = producerCount * itemsPerProducer
+        assertEquals(total.toLong() * (total - 1) / 2, sum, "Every value should arrive exactly once")
+        assertEquals(0, buffer.getCurrentSize(), "Drained buffer should be empty")
+        assertEquals(0L, monitor.safeGetBufferMemoryUsage(buffer.getId()), "Drained buffer should hold no memory")
+        assertEquals(total, buffer.getEmissions())
+        assertEquals(total, buffer.getConsumptions())
+        assertTrue(buffer.getSuspensions() > 0, "Producers should have found the small buffer full")
+        buffer.close()
+    }
+
+    @Test
+    @DisplayName("Closing a full native ring buffer should wake every waiting producer")
+    fun `test native ring buffer close wakes all blocked producers`() = runBlocking {
+        val bufferRepository = BufferRepositoryImpl(BufferMonitorRepositoryImpl(monitor))
+        val buffer = bufferRepository.createNativeBuffer(1, NativePayload.Longs)
+        buffer.emit(0L)
+        val producerCount = 4
+        val closedProducers = AtomicInteger(0)
+
+        val producers = List(producerCount) { producer ->
+            launch(Dispatchers.Default) {
+                try {
+                    buffer.emit(producer + 1L)
+                } catch (e: ClosedSendChannelException) {
+                    closedProducers.incrementAndGet()
+                }
+            }
+        }
+        while (buffer.getSuspensions() < producerCount) {
+            delay(10)
+        }
+
+        buffer.close()
+        withTimeout(5_000) { producers.joinAll() }
+
+        assertEquals(producerCount, closedProducers.get(), "Every blocked producer should see the closed buffer")
+        assertEquals(0L, buffer.consume(), "The queued entry should stay receivable")
+    }
+
+    @Test
+    @DisplayName("A native ring buffer should report clearTracking instead of acting closed")
+    fun `test native ring buffer emit after clear tracking`() = runBlocking {
+        val bufferRepository = BufferRepositoryImpl(BufferMonitorRepositoryImpl(monitor))
+        val buffer = bufferRepository.createNativeBuffer(4, NativePayload.Longs)
+        buffer.emit(1L)
+
+        monitor.safeClearTracking()
+
+        assertThrows<IllegalStateException> { runBlocking { buffer.emit(2L) } }
+        assertEquals(1L, buffer.consume(), "Entries queued before clearTracking should stay receivable")
+        buffer.close()
+    }
+
+    @Test
+    @DisplayName("A closed buffer should keep its native handle until it has been drained")
+    fun `test closed buffer releases its handle after draining`() = runBlocking {
+        val bufferRepository = BufferRepositoryImpl(BufferMonitorRepositoryImpl(monitor))
+        val buffer = bufferRepository.createBuffer<Int>(4)
+        repeat(3) { buffer.emit(it) }
+
+        buffer.close()
+        val drained = listOf(buffer.consume(), buffer.consume())
+
+        assertEquals(listOf(0, 1), drained, "Queued entries should stay receivable after close")
+        assertEquals(2, buffer.getConsumptions(), "Draining consumers should still update the live buffer")
+        assertTrue(buffer.getId() in monitor.safeSnapshotAll().bufferIds, "The handle should outlive close")
+
+        assertEquals(2, buffer.consume(), "The last entry should be received")
+        assertNull(buffer.consume(), "A drained buffer should be empty")
+        assertFalse(buffer.getId() in monitor.safeSnapshotAll().bufferIds, "Draining should release the handle")
+    }
 }
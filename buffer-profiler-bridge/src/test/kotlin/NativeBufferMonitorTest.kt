@@ -1,6 +1,15 @@
+import domain.entity.BackpressureAlertKind
+import domain.entity.BufferEventType
+import domain.entity.HistoryTier
+import domain.entity.LatencyKind
+import domain.entity.OverheadOperation
 import org.junit.jupiter.api.*
 import org.junit.jupiter.api.Assertions.*
 import java.io.File
+import java.net.HttpURLConnection
+import java.net.URL
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.nio.file.Files
 import java.nio.file.Paths
 
@@ -109,6 +118,209 @@ class NativeBufferMonitorTest {
         }
     }
 
+    @Test
+    fun `test suspension timeline records thread and buffer`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(10)
+        val thread = Thread.currentThread()
+
+        // Act
+        repeat(3) {
+            monitor.safeRecordSuspension(thread.id, thread.name, bufferId, 10, 10)
+        }
+        monitor.safeRecordSuspensionDuration(bufferId, 1_000L)
+        val timeline = monitor.safeGetEventTimeline(bufferId = bufferId)
+
+        // Assert
+        assertEquals(4, timeline.size, "Should have recorded 3 suspensions and 1 resume")
+        assertEquals(3, timeline.count { it.type == BufferEventType.SUSPEND }, "Should have 3 suspend events")
+        assertTrue(timeline.zipWithNext().all { (a, b) -> a.timestamp <= b.timestamp }, "Timeline should be ordered")
+        assertTrue(timeline.all { it.threadId == thread.id }, "Events should carry the Java thread id")
+        assertEquals(thread.name, timeline.first().threadName, "Thread name should be interned")
+        assertEquals(1_000L, timeline.last { it.type == BufferEventType.RESUME }.durationNanos, "Resume should carry the duration")
+    }
+
+    @Test
+    fun `test registered thread records suspensions with primitives only`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(10)
+        val worker = Thread({
+            monitor.safeRegisterThread()
+            repeat(2) { monitor.safeRecordBufferSuspension(bufferId, 10, 10) }
+        }, "registered-producer")
+
+        // Act
+        worker.start()
+        worker.join()
+        val timeline = monitor.safeGetEventTimeline(bufferId = bufferId)
+
+        // Assert
+        assertEquals(2, monitor.safeGetBufferSuspensionCount(bufferId), "Should have counted 2 suspensions")
+        assertEquals(2, timeline.size, "Should have recorded 2 suspend events")
+        assertTrue(timeline.all { it.threadId == worker.id }, "Events should carry the registered thread id")
+        assertEquals("registered-producer", timeline.first().threadName, "Registered name should be interned")
+    }
+
+    @Test
+    fun `test fused emit and consume bookkeeping`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(2)
+
+        // Act
+        val sizes = List(3) { monitor.safeOnEmit(bufferId, "item-$it") }
+        val sizeAfterEmit = monitor.safeGetBufferSize(bufferId)
+        val suspensions = monitor.safeGetBufferSuspensionCount(bufferId)
+        monitor.safeOnConsume(bufferId, sizes[0], -1L)
+        monitor.safeOnConsume(bufferId, sizes[1], -1L)
+
+        // Assert
+        assertEquals(3, monitor.safeGetBufferEmissions(bufferId), "Should have recorded 3 emissions")
+        assertEquals(3, sizeAfterEmit, "Each emit should reserve one entry")
+        assertEquals(1, suspensions, "The emit into a full buffer should count as a suspension")
+        assertEquals(2, monitor.safeGetBufferConsumptions(bufferId), "Should have recorded 2 consumptions")
+        assertEquals(1, monitor.safeGetBufferSize(bufferId), "Each consume should release one entry")
+        assertEquals(sizes[2], monitor.safeGetBufferMemoryUsage(bufferId), "Only the remaining entry should be counted")
+    }
+
+    @Test
+    fun `test residency latency percentiles`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(1000)
+        val otherId = monitor.safeCreateBuffer(1000)
+
+        // Act: residencies of 1..1000 microseconds
+        for (micros in 1..1000) {
+            val size = monitor.safeOnEmit(bufferId, micros)
+            monitor.safeOnConsume(bufferId, size, micros * 1_000L)
+        }
+        monitor.safeOnConsume(otherId, monitor.safeOnEmit(otherId, 0), 5_000_000L)
+        val histogram = monitor.safeGetLatencyHistogram(bufferId, LatencyKind.RESIDENCY)
+        val merged = histogram.merge(monitor.safeGetLatencyHistogram(otherId, LatencyKind.RESIDENCY))
+
+        // Assert
+        assertEquals(1000L, histogram.count, "Every consume should be sampled")
+        assertEquals(500_000.0, histogram.p50.toDouble(), 500_000 * 0.04, "p50 should be within bucket precision")
+        assertEquals(990_000.0, histogram.p99.toDouble(), 990_000 * 0.04, "p99 should be within bucket precision")
+        assertEquals(histogram.p99, monitor.safeGetLatencyPercentile(bufferId, LatencyKind.RESIDENCY, 99.0),
+            "Native and exported percentiles should agree")
+        assertEquals(0L, monitor.safeGetLatencyPercentile(bufferId, LatencyKind.SUSPENSION, 99.0),
+            "No suspension should have been timed")
+        assertEquals(1001L, merged.count, "Merged histogram should hold both buffers' samples")
+        assertEquals(5_000_000L, merged.max, "Merged histogram should keep the largest sample")
+    }
+
+    @Test
+    fun `test history keeps spikes between polls`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(100)
+
+        // Act: fill to 50 and drain again, as if between two dashboard polls
+        val sizes = List(50) { monitor.safeOnEmit(bufferId, it) }
+        sizes.forEach { monitor.safeOnConsume(bufferId, it, -1L) }
+        val raw = monitor.safeGetBufferHistory(bufferId, HistoryTier.RAW)
+        val seconds = monitor.safeGetBufferHistory(bufferId, HistoryTier.SECOND)
+        val minutes = monitor.safeGetBufferHistory(bufferId, HistoryTier.MINUTE)
+
+        // Assert
+        assertTrue(raw.size in 1..100, "At most one sample per change should be taken")
+        assertEquals(0, monitor.safeGetBufferSize(bufferId), "The buffer should be empty again")
+        assertEquals(50, seconds.maxOf { it.maxSize }, "The peak should survive in the 1 s tier")
+        assertEquals(raw.size.toLong(), seconds.sumOf { it.count }, "The 1 s tier should count every sample")
+        assertEquals(50, minutes.maxOf { it.maxSize }, "The peak should survive in the 1 min tier")
+        assertTrue(raw.zipWithNext().all { (a, b) -> a.start <= b.start }, "Raw samples should be ordered")
+    }
+
+    @Test
+    fun `test snapshot contains every live buffer`() {
+        // Arrange
+        val firstId = monitor.safeCreateBuffer(4)
+        val secondId = monitor.safeCreateBuffer(8)
+        monitor.safeOnEmit(firstId, "first")
+        monitor.safeOnEmit(secondId, "second")
+        monitor.safeOnEmit(secondId, "third")
+
+        // Act
+        val snapshot = monitor.safeSnapshotAll()
+
+        // Assert
+        val first = snapshot.indexOf(firstId)
+        val second = snapshot.indexOf(secondId)
+        assertTrue(first >= 0 && second >= 0, "Both buffers should be in the snapshot")
+        assertEquals(4, snapshot.capacities[first], "Should report the first buffer's capacity")
+        assertEquals(1, snapshot.sizes[first], "Should report the first buffer's size")
+        assertEquals(2L, snapshot.emissions[second], "Should report the second buffer's emissions")
+        assertEquals(snapshot.emissions.sum(), snapshot.totalEmissions, "Totals should match the rows")
+    }
+
+    @Test
+    fun `test backpressure detector warns before the buffer is full`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(1000)
+        monitor.safeSetBackpressureDetection(warningNanos = 10_000_000_000L, smoothingNanos = 10_000_000L)
+
+        try {
+            // Act: two emits per consume fill the buffer at a steady rate
+            repeat(200) {
+                val first = monitor.safeOnEmit(bufferId, "first-$it")
+                monitor.safeOnEmit(bufferId, "second-$it")
+                monitor.safeOnConsume(bufferId, first, -1L)
+                Thread.sleep(1)
+            }
+            val alerts = monitor.safePollBackpressureAlerts()
+            val status = monitor.safeGetBackpressureStatus(bufferId)
+
+            // Assert
+            val filling = alerts.firstOrNull { it.bufferId == bufferId && it.kind == BackpressureAlertKind.FILLING }
+            assertNotNull(filling, "A steadily filling buffer should raise an alert")
+            assertTrue(filling!!.size < 1000, "The alert should come before the buffer is full")
+            assertTrue(filling.timeToFullNanos >= 0, "The alert should carry the predicted time to full")
+            assertNotNull(status, "The buffer should have a current estimate")
+            assertTrue(status!!.emitRate > status.consumeRate, "Emissions should outpace consumptions")
+        } finally {
+            monitor.safeSetBackpressureDetection(0L)
+        }
+    }
+
+    @Test
+    fun `test aggregates match the snapshot and rank the fullest buffers`() {
+        // Arrange
+        val bufferIds = (0 until 20).map { monitor.safeCreateBuffer(20) }
+        bufferIds.forEachIndexed { index, bufferId ->
+            monitor.safeUpdateBufferMetrics(bufferId, index, index * 100L)
+            monitor.safeRecordEmission(bufferId)
+        }
+
+        // Act
+        val aggregates = monitor.safeGetBufferAggregates(3)
+        val snapshot = monitor.safeSnapshotAll()
+
+        // Assert
+        assertEquals(snapshot.bufferCount.toLong(), aggregates.bufferCount, "Should count every live buffer")
+        assertEquals(snapshot.totalEmissions, aggregates.totalEmissions, "Totals should match the snapshot")
+        assertEquals(snapshot.totalMemoryUsage, aggregates.totalMemoryUsage, "Totals should match the snapshot")
+        assertEquals(listOf(19L, 18L, 17L), aggregates.fullest.map { it.size }, "Fullest buffers should come first")
+        assertEquals(bufferIds[19], aggregates.fullestBufferId, "Should report the fullest buffer")
+        assertEquals(950L, aggregates.maxUtilizationPermille, "19 of 20 slots is 95%")
+    }
+
+    @Test
+    fun `test fullest buffers keep the earlier of tied buffers`() {
+        // Arrange: three tied buffers, then a fuller one that must evict exactly one of them
+        val bufferIds = (0 until 4).map { monitor.safeCreateBuffer(20) }
+        val rowOrder = monitor.safeSnapshotAll().bufferIds.filter { it in bufferIds }
+        rowOrder.forEachIndexed { row, bufferId ->
+            monitor.safeUpdateBufferMetrics(bufferId, if (row == 3) 15 else 10, 0L)
+        }
+
+        // Act
+        val aggregates = monitor.safeGetBufferAggregates(3)
+
+        // Assert
+        assertEquals(listOf(rowOrder[3], rowOrder[0], rowOrder[1]), aggregates.fullest.map { it.bufferId },
+            "Ties should keep the buffers that come first in the registry")
+        assertEquals(listOf(750L, 500L, 500L), aggregates.fullest.map { it.utilizationPermille })
+    }
+
     @Test
     fun `test memory tracking`() {
         // Arrange
@@ -120,6 +332,275 @@ class NativeBufferMonitorTest {
         assertEquals(0L, monitor.safeGetObjectSize(null), "Size of null object should be 0")
     }
 
+    @Test
+    fun `test memory by class uses cached and sampled sizes`() {
+        // Arrange
+        monitor.safeSetObjectSizeSampling(4)
+        val first = monitor.safeGetObjectSize(StringBuilder("first"))
+        Assumptions.assumeTrue(first > 0, "Requires JVMTI object sizes")
+
+        // Act
+        val second = monitor.safeGetObjectSize(StringBuilder("second"))
+        val arraySizes = List(8) { monitor.safeGetObjectSize(ByteArray(1024)) }
+        val byClass = monitor.safeGetMemoryByClass()
+        monitor.safeSetObjectSizeSampling(1)
+
+        // Assert
+        val builders = byClass["java.lang.StringBuilder"]
+        val arrays = byClass["byte[]"]
+        assertEquals(first, second, "Instances of a class should share the cached size")
+        assertTrue(arraySizes.all { it == arraySizes[0] }, "Estimated arrays should match the measured ones")
+        assertEquals(2L, builders?.instanceCount, "Both builders should be attributed to their class")
+        assertEquals(first * 2, builders?.totalMemory, "Class memory should add up the instance sizes")
+        assertEquals(arraySizes.sum(), arrays?.totalMemory, "Array memory should include estimated arrays")
+    }
+
+    @Test
+    fun `test retained size pass counts backing arrays`() {
+        // Arrange
+        monitor.safeSetRetainedSizeTracking(true)
+        val bufferId = monitor.safeCreateBuffer(10)
+        val values = List(4) { "entry-$it-" + "x".repeat(1024) }
+        val shallow = values.sumOf { monitor.safeOnEmit(bufferId, it) }
+
+        try {
+            // Act
+            Assumptions.assumeTrue(monitor.safeStartRetainedSizePass(5_000), "Requires JVMTI heap walks")
+            var status = monitor.safeGetRetainedSizeStatus()
+            val deadline = System.currentTimeMillis() + 10_000
+            while ((status.running || status.passes == 0L) && System.currentTimeMillis() < deadline) {
+                Thread.sleep(10)
+                status = monitor.safeGetRetainedSizeStatus()
+            }
+            val retained = monitor.safeGetRetainedSize(bufferId)
+
+            // Assert
+            assertEquals(1L, status.passes, "The pass should have finished")
+            assertTrue(status.lastPassComplete, "The pass should fit in its budget")
+            assertTrue(retained >= shallow + 4 * 1024, "Retained size should include the strings' backing arrays")
+        } finally {
+            values.forEach { monitor.safeOnConsume(bufferId, 0L, -1L, it) }
+            monitor.safeSetRetainedSizeTracking(false)
+        }
+    }
+
+    @Test
+    fun `test gc pauses and allocation samples are recorded`() {
+        // Arrange
+        Assumptions.assumeTrue(monitor.safeSetGcTracking(true), "Requires JVMTI GC events")
+        Assumptions.assumeTrue(monitor.safeSetAllocationSampling(16 * 1024), "Requires JVMTI allocation sampling")
+        var sink = 0
+
+        try {
+            // Act
+            repeat(10_000) { sink += ByteArray(1024).size }
+            System.gc()
+            val pauses = monitor.safeGetGcPauses()
+            val status = monitor.safeGetGcStatus()
+
+            // Assert
+            assertTrue(sink > 0)
+            assertTrue(pauses.isNotEmpty(), "System.gc() should be recorded as a pause")
+            assertTrue(pauses.all { it.durationNanos >= 0 }, "Pause durations should not be negative")
+            assertTrue(status.collections >= pauses.size, "Every pause should be counted")
+            assertTrue(status.allocationSamples > 0, "About 10 MB allocated should be sampled")
+            assertTrue(pauses.sumOf { it.allocatedBytes } > 0, "Pauses should carry the allocation leading up to them")
+        } finally {
+            monitor.safeSetAllocationSampling(0)
+            monitor.safeSetGcTracking(false)
+        }
+    }
+
+    @Test
+    fun `test shared memory export creates and removes the segment`() {
+        Assumptions.assumeTrue(File("/dev/shm").isDirectory, "Requires /dev/shm")
+
+        // Act
+        val path = monitor.safeStartSharedMemoryExport(10, 16)
+        val createdFile = path?.let { File(it) }
+        val existedWhileRunning = createdFile?.exists() ?: false
+        monitor.safeStopSharedMemoryExport()
+
+        // Assert
+        assertNotNull(path, "Export should report the segment path")
+        assertTrue(existedWhileRunning, "Segment should exist while exporting")
+        assertFalse(createdFile!!.exists(), "Segment should be removed when export stops")
+    }
+
+    @Test
+    fun `test capture writes events and snapshots with an index footer`() {
+        // Arrange
+        val file = Files.createTempFile("buffermonitor", ".capture").toFile()
+        val bufferId = monitor.safeCreateBuffer(10)
+        val captureMagic = 0x50434D42 // "BMCP", see capture_format.h
+        val footerMagic = 0x46434D42  // "BMCF"
+        val footerBytes = 32
+
+        try {
+            // Act
+            monitor.safeGetEventCounts() // Drains events left by earlier tests, so they stay out of the file
+            assertTrue(monitor.safeStartCapture(file.path, 10), "Capture should start")
+            repeat(5) { monitor.safeRecordBufferSuspension(bufferId, 10, 10) }
+            monitor.safeStopCapture()
+            val status = monitor.safeGetCaptureStatus()
+            val bytes = ByteBuffer.wrap(file.readBytes()).order(ByteOrder.nativeOrder())
+
+            // Assert
+            assertFalse(status.active, "Capture should be stopped")
+            assertEquals(5L, status.eventCount, "Every suspension should be captured")
+            assertTrue(status.snapshotCount >= 1, "Stopping should write a final snapshot")
+            assertEquals(file.length(), status.bytesWritten, "Status should report the file size")
+            assertEquals(captureMagic, bytes.getInt(0), "File should start with the capture header")
+            assertEquals(footerMagic, bytes.getInt(bytes.limit() - footerBytes), "File should end with the index footer")
+        } finally {
+            monitor.safeStopCapture()
+            file.delete()
+        }
+    }
+
+    @Test
+    fun `test labeled buffers roll up into their group and its parents`() {
+        // Arrange
+        val parse = monitor.safeCreateLabeledBuffer(10, "parse", mapOf("pipeline" to "ingest", "stage" to "parse"))
+        val write = monitor.safeCreateLabeledBuffer(20, "write", mapOf("pipeline" to "ingest", "stage" to "write"))
+
+        // Act
+        repeat(3) { monitor.safeRecordEmission(parse) }
+        monitor.safeRecordEmission(write)
+        monitor.safeUpdateBufferMetrics(parse, 3, 300L)
+        monitor.safeUpdateBufferMetrics(write, 1, 50L)
+        val pipelineGroup = monitor.safeFindBufferGroup(mapOf("pipeline" to "ingest"))
+        val pipeline = monitor.safeGetBufferGroupTotals(pipelineGroup)
+        monitor.safeReleaseBuffer(write)
+        val afterRelease = monitor.safeGetBufferGroupTotals(pipelineGroup)
+
+        // Assert
+        assertEquals("parse", monitor.safeGetBufferName(parse))
+        assertEquals("pipeline=ingest/stage=parse", monitor.safeGetBufferGroupTotals(monitor.safeGetBufferGroupOf(parse)).path)
+        assertEquals(2L, pipeline.bufferCount, "Parent group should count both buffers")
+        assertEquals(30L, pipeline.capacity)
+        assertEquals(4L, pipeline.size)
+        assertEquals(350L, pipeline.memoryUsage)
+        assertEquals(4L, pipeline.emissions)
+        assertEquals(1L, afterRelease.bufferCount, "Released buffer should leave its groups")
+        assertEquals(3L, afterRelease.emissions)
+        assertEquals(300L, afterRelease.memoryUsage)
+        assertEquals(0L, monitor.safeCreateLabeledBuffer(10, "bad", mapOf("" to "value")), "Empty label key should be rejected")
+    }
+
+    @Test
+    fun `test overhead governor samples a hot buffer and restores exact tracking`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(1000)
+        val value = "item"
+        val deadline = System.nanoTime() + 5_000_000_000L
+        var items = 0L
+
+        try {
+            // Act
+            monitor.safeSetOverheadBudget(0.0001)
+            while (monitor.safeGetBufferSamplePeriod(bufferId) == 1 && System.nanoTime() < deadline) {
+                repeat(10_000) {
+                    val size = monitor.safeOnEmit(bufferId, value)
+                    monitor.safeOnConsume(bufferId, size, 0L, value)
+                }
+                items += 10_000
+            }
+            val sampledPeriod = monitor.safeGetBufferSamplePeriod(bufferId)
+            val status = monitor.safeGetOverheadStatus()
+            monitor.safeSetOverheadBudget(0.0)
+
+            // Assert
+            assertTrue(sampledPeriod > 1, "A hot buffer over the budget should be sampled")
+            assertTrue(status.overheadPercent > 0.0001, "The measured overhead should exceed the budget")
+            assertTrue(status.costs.getValue(OverheadOperation.EMIT).calls > 0, "Emits should be timed")
+            assertEquals(0, monitor.safeGetBufferSize(bufferId), "Size should stay exact in sampled mode")
+            assertEquals(0L, monitor.safeGetBufferMemoryUsage(bufferId), "Memory should balance in sampled mode")
+            assertTrue(monitor.safeGetBufferEmissions(bufferId) > items / 2, "Scaled emissions should track the item count")
+            assertEquals(1, monitor.safeGetBufferSamplePeriod(bufferId), "Disabling the governor should restore exact tracking")
+        } finally {
+            monitor.safeSetOverheadBudget(0.0)
+        }
+    }
+
+    @Test
+    fun `test metrics exporter serves every buffer in OpenMetrics format`() {
+        // Arrange
+        val bufferId = monitor.safeCreateBuffer(10)
+        monitor.safeOnEmit(bufferId, "item")
+
+        try {
+            // Act
+            val address = monitor.safeStartMetricsExporter("127.0.0.1:0")
+            assertNotNull(address, "Exporter should report the bound address")
+            val connection = URL("http://$address/metrics").openConnection() as HttpURLConnection
+            val status = connection.responseCode
+            val contentType = connection.contentType
+            val body = connection.inputStream.bufferedReader().readText()
+
+            // Assert
+            assertEquals(200, status, "Scrape should succeed")
+            assertTrue(contentType.startsWith("application/openmetrics-text"), "Response should be OpenMetrics")
+            assertTrue(
+                body.contains("buffermonitor_buffer_emissions_total{buffer=\"$bufferId\"} 1"),
+                "Every buffer should have its own sample"
+            )
+            assertTrue(body.endsWith("# EOF\n"), "Exposition should end with the EOF marker")
+        } finally {
+            monitor.safeStopMetricsExporter()
+        }
+    }
+
+    @Test
+    fun `test suspension stacks are counted once per distinct stack`() {
+        // Arrange
+        val bufferId = monitor.safeCreateLabeledBuffer(1, "stacks", emptyMap())
+        Assumptions.assumeTrue(monitor.safeSetSuspensionStackSampling(1), "Requires JVMTI")
+
+        try {
+            // Act
+            repeat(3) { monitor.safeRecordBufferSuspension(bufferId, 1, 1) }
+            val collapsed = monitor.safeGetCollapsedSuspensionStacks(bufferId).lines().filter { it.isNotEmpty() }
+            val status = monitor.safeGetSuspensionStackStatus()
+
+            // Assert
+            assertEquals(1, collapsed.size, "The same call site should intern a single stack")
+            assertTrue(collapsed[0].startsWith("buffer:stacks;"), "Stacks should start at the buffer")
+            assertTrue(collapsed[0].contains("NativeBufferMonitorTest."), "Stack should include the caller")
+            assertTrue(collapsed[0].endsWith(" 3"), "Every suspension should be counted")
+            assertEquals(0L, status.droppedSamples, "No stack should be dropped")
+        } finally {
+            monitor.safeSetSuspensionStackSampling(0)
+        }
+    }
+
+    @Test
+    fun `test suspension stacks stay bounded under buffer churn`() {
+        // Arrange
+        Assumptions.assumeTrue(monitor.safeSetSuspensionStackSampling(1), "Requires JVMTI")
+        val nodeLimit = 32768 // kMaxSuspensionStackNodes, see suspension_stacks.h
+
+        try {
+            // Act
+            repeat(nodeLimit + 1000) {
+                val bufferId = monitor.safeCreateLabeledBuffer(1, "churn", emptyMap())
+                monitor.safeOnEmit(bufferId, "first")
+                monitor.safeOnEmit(bufferId, "suspends")
+                monitor.safeReleaseBuffer(bufferId)
+            }
+            val status = monitor.safeGetSuspensionStackStatus()
+            val collapsed = monitor.safeGetCollapsedSuspensionStacks().lines().filter { it.startsWith("buffer:churn;") }
+
+            // Assert
+            assertEquals(0L, status.droppedSamples, "Released buffers should not use up the trie")
+            assertTrue(status.nodes < nodeLimit, "Buffers with the same name should share their nodes")
+            assertEquals((nodeLimit + 1000).toLong(), collapsed.sumOf { it.substringAfterLast(' ').toLong() },
+                "Every suspension of the churned buffers should be counted")
+        } finally {
+            monitor.safeSetSuspensionStackSampling(0)
+        }
+    }
+
     @Test
     fun `test clear tracking`() {
         // Arrange
@@ -66,4 +66,25 @@ class TimestampPrecisionTest {
         assertEquals(threadCount * buffersPerThread, bufferIds.size,
             "All ${threadCount * buffersPerThread} buffer IDs should be unique, but only ${bufferIds.size} were unique")
     }
+
+    @Test
+    fun `test released buffer handles are never reissued`() {
+        // Arrange
+        val bufferIds = mutableSetOf<Long>()
+
+        // Act
+        repeat(1000) {
+            val bufferId = monitor.safeCreateBuffer(10)
+            bufferIds.add(bufferId)
+            monitor.safeRecordEmission(bufferId)
+            monitor.safeReleaseBuffer(bufferId)
+        }
+        val staleId = bufferIds.first()
+
+        // Assert
+        assertEquals(1000, bufferIds.size,
+            "Recycled slots should get a new generation, but only ${bufferIds.size} handles were unique")
+        assertFalse(monitor.safeReleaseBuffer(staleId), "Releasing a stale handle should fail")
+        assertEquals(0, monitor.safeGetBufferEmissions(staleId), "Stale handles should not resolve to a live buffer")
+    }
 }
@@ -0,0 +1,243 @@
+#include "backpressure.h"
+#include "buffer_tracking.h"
+#include "mpmc_queue.h"
+#include "utils.h"
+#include "logging.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <new>
+
+namespace {
+
+const jlong kSampleIntervalNanos = 1000000;        // At most one rate update per buffer per ms
+const jlong kDefaultSmoothingNanos = 100000000;    // Rate time constant
+
+std::atomic<jlong> warningHorizon(0); // 0 while detection is off
+std::atomic<jlong> smoothing(kDefaultSmoothingNanos);
+std::atomic<jlong> droppedAlerts(0);
+
+// One buffer's detector. The fast path only reads bufferId and lastSampleTime;
+// everything else is written by the caller that holds busy.
+struct alignas(kCacheLineSize) DetectorState {
+    std::atomic<jlong> bufferId;       // Handle the state belongs to, 0 before first use
+    std::atomic<jlong> lastSampleTime;
+    std::atomic<jlong> lastEmissions;
+    std::atomic<jlong> lastConsumptions;
+    std::atomic<double> emitRate;      // Items per second
+    std::atomic<double> consumeRate;   // Items per second
+    std::atomic<jlong> timeToFull;     // Nanoseconds, -1 when not filling
+    std::atomic<jint> alerting;
+    std::atomic<jint> busy;
+};
+
+static_assert(sizeof(DetectorState) == kCacheLineSize, "DetectorState should fill exactly one cache line");
+
+// States per registry slot, in chunks that mirror the registry's and are never freed
+std::atomic<DetectorState*> tables[BufferRegistry::kMaxChunks];
+
+MpmcQueue<BackpressureAlert>& alertQueue() {
+    // Never destroyed, so an event during unload cannot touch a freed queue
+    static MpmcQueue<BackpressureAlert>* queue = new MpmcQueue<BackpressureAlert>(kBackpressureAlertCapacity);
+    return *queue;
+}
+
+DetectorState* stateFor(jlong bufferId, bool create) {
+    jint index = BufferRegistry::indexOf(bufferId);
+    if (index < 0 || index >= BufferRegistry::kMaxSlots) {
+        return nullptr;
+    }
+    std::atomic<DetectorState*>& slot = tables[index / BufferRegistry::kSlotsPerChunk];
+    DetectorState* table = slot.load(std::memory_order_acquire);
+    if (table == nullptr && create) {
+        void* block = allocateCacheAligned(sizeof(DetectorState) * BufferRegistry::kSlotsPerChunk);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        DetectorState* fresh = static_cast<DetectorState*>(block);
+        for (jint i = 0; i < BufferRegistry::kSlotsPerChunk; i++) {
+            new (&fresh[i]) DetectorState();
+        }
+        if (slot.compare_exchange_strong(table, fresh, std::memory_order_acq_rel)) {
+            table = fresh;
+        } else {
+            freeCacheAligned(block);
+        }
+    }
+    return table != nullptr ? &table[index % BufferRegistry::kSlotsPerChunk] : nullptr;
+}
+
+void resetState(DetectorState& state, jlong bufferId, jlong now, BufferMetrics* metrics) {
+    state.lastSampleTime.store(now, std::memory_order_relaxed);
+    state.lastEmissions.store(metrics->count(COUNTER_EMISSIONS), std::memory_order_relaxed);
+    state.lastConsumptions.store(metrics->count(COUNTER_CONSUMPTIONS), std::memory_order_relaxed);
+    state.emitRate.store(0.0, std::memory_order_relaxed);
+    state.consumeRate.store(0.0, std::memory_order_relaxed);
+    state.timeToFull.store(-1, std::memory_order_relaxed);
+    state.alerting.store(0, std::memory_order_relaxed);
+    state.bufferId.store(bufferId, std::memory_order_release);
+}
+
+void queueAlert(BackpressureAlertKind kind, jlong bufferId, jlong now, jlong timeToFull, jint size,
+                jint capacity, double emitRate, double consumeRate) {
+    BackpressureAlert alert;
+    alert.bufferId = bufferId;
+    alert.time = now;
+    alert.kind = kind;
+    alert.timeToFullNanos = timeToFull;
+    alert.size = size;
+    alert.capacity = capacity;
+    alert.emitRate = static_cast<jlong>(emitRate);
+    alert.consumeRate = static_cast<jlong>(consumeRate);
+    if (!alertQueue().tryPush(alert)) {
+        droppedAlerts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Folds the counts since the last sample into the rates and re-evaluates the alert
+void sample(DetectorState& state, jlong bufferId, jlong now, BufferMetrics* metrics, jlong horizon) {
+    jlong elapsed = now - state.lastSampleTime.load(std::memory_order_relaxed);
+    if (elapsed < kSampleIntervalNanos) {
+        return; // Another caller sampled in the meantime
+    }
+
+    jlong emissions = metrics->count(COUNTER_EMISSIONS);
+    jlong consumptions = metrics->count(COUNTER_CONSUMPTIONS);
+    double seconds = static_cast<double>(elapsed) / 1e9;
+    double emitted = static_cast<double>(emissions - state.lastEmissions.load(std::memory_order_relaxed));
+    double consumed = static_cast<double>(consumptions - state.lastConsumptions.load(std::memory_order_relaxed));
+
+    // Time-based weight, so rates do not depend on how often the buffer is sampled
+    double weight = 1.0 - std::exp(-static_cast<double>(elapsed) /
+                                   static_cast<double>(smoothing.load(std::memory_order_relaxed)));
+    double emitRate = state.emitRate.load(std::memory_order_relaxed);
+    double consumeRate = state.consumeRate.load(std::memory_order_relaxed);
+    emitRate += weight * (emitted / seconds - emitRate);
+    consumeRate += weight * (consumed / seconds - consumeRate);
+
+    jint size = metrics->size.load(std::memory_order_relaxed);
+    jint capacity = metrics->capacity.load(std::memory_order_relaxed);
+    double fillRate = emitRate - consumeRate;
+    jlong timeToFull = -1;
+    if (size >= capacity) {
+        timeToFull = 0;
+    } else if (fillRate > 0.0) {
+        double nanos = static_cast<double>(capacity - size) / fillRate * 1e9;
+        timeToFull = nanos < static_cast<double>(std::numeric_limits<jlong>::max())
+                         ? static_cast<jlong>(nanos)
+                         : std::numeric_limits<jlong>::max();
+    }
+
+    state.lastSampleTime.store(now, std::memory_order_relaxed);
+    state.lastEmissions.store(emissions, std::memory_order_relaxed);
+    state.lastConsumptions.store(consumptions, std::memory_order_relaxed);
+    state.emitRate.store(emitRate, std::memory_order_relaxed);
+    state.consumeRate.store(consumeRate, std::memory_order_relaxed);
+    state.timeToFull.store(timeToFull, std::memory_order_relaxed);
+
+    // Clearing needs twice the horizon, so a prediction hovering at the horizon does not flap
+    bool alerting = state.alerting.load(std::memory_order_relaxed) != 0;
+    if (!alerting && timeToFull >= 0 && timeToFull <= horizon) {
+        state.alerting.store(1, std::memory_order_relaxed);
+        queueAlert(ALERT_FILLING, bufferId, now, timeToFull, size, capacity, emitRate, consumeRate);
+        LOG_DEBUG("Buffer %lld predicted full in %lld ns (%d/%d)", static_cast<long long>(bufferId),
+                  static_cast<long long>(timeToFull), size, capacity);
+    } else if (alerting && (timeToFull < 0 || timeToFull / 2 > horizon)) {
+        state.alerting.store(0, std::memory_order_relaxed);
+        queueAlert(ALERT_CLEARED, bufferId, now, timeToFull, size, capacity, emitRate, consumeRate);
+    }
+}
+
+void resetAllStates() {
+    for (jint chunk = 0; chunk < BufferRegistry::kMaxChunks; chunk++) {
+        DetectorState* table = tables[chunk].load(std::memory_order_acquire);
+        if (table == nullptr) {
+            continue;
+        }
+        for (jint slot = 0; slot < BufferRegistry::kSlotsPerChunk; slot++) {
+            // A zero handle never matches, so the next event starts the state over
+            table[slot].bufferId.store(0, std::memory_order_release);
+        }
+    }
+}
+
+} // namespace
+
+void setBackpressureDetection(jlong warningNanos, jlong smoothingNanos) {
+    smoothing.store(smoothingNanos > 0 ? smoothingNanos : kDefaultSmoothingNanos, std::memory_order_relaxed);
+    resetAllStates();
+    warningHorizon.store(warningNanos > 0 ? warningNanos : 0, std::memory_order_relaxed);
+    if (warningNanos > 0) {
+        LOG_INFO("Backpressure detection warns %lld ns before a buffer fills", static_cast<long long>(warningNanos));
+    } else {
+        LOG_INFO("Backpressure detection disabled");
+    }
+}
+
+void observeBackpressure(jlong bufferId, BufferMetrics* metrics, jlong now) {
+    jlong horizon = warningHorizon.load(std::memory_order_relaxed);
+    if (horizon == 0 || metrics == nullptr) {
+        return;
+    }
+    if (now == 0) {
+        now = getCurrentTimeMs();
+    }
+
+    DetectorState* state = stateFor(bufferId, true);
+    if (state == nullptr) {
+        return;
+    }
+    bool owned = state->bufferId.load(std::memory_order_acquire) == bufferId;
+    if (owned && now - state->lastSampleTime.load(std::memory_order_relaxed) < kSampleIntervalNanos) {
+        return;
+    }
+
+    // Whoever finds the state busy skips: its events are in the counters for the next sample
+    if (state->busy.exchange(1, std::memory_order_acquire) != 0) {
+        return;
+    }
+    if (state->bufferId.load(std::memory_order_relaxed) != bufferId) {
+        resetState(*state, bufferId, now, metrics);
+    } else {
+        sample(*state, bufferId, now, metrics, horizon);
+    }
+    state->busy.store(0, std::memory_order_release);
+}
+
+jint pollBackpressureAlerts(BackpressureAlert* destination, jint maxAlerts) {
+    if (destination == nullptr) {
+        return 0;
+    }
+    jint count = 0;
+    while (count < maxAlerts && alertQueue().tryPop(destination[count])) {
+        count++;
+    }
+    return count;
+}
+
+bool getBackpressureStatus(jlong bufferId, BackpressureStatus& status) {
+    if (warningHorizon.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    DetectorState* state = stateFor(bufferId, false);
+    if (state == nullptr || state->bufferId.load(std::memory_order_acquire) != bufferId) {
+        return false;
+    }
+    status.emitRate = static_cast<jlong>(state->emitRate.load(std::memory_order_relaxed));
+    status.consumeRate = static_cast<jlong>(state->consumeRate.load(std::memory_order_relaxed));
+    status.timeToFullNanos = state->timeToFull.load(std::memory_order_relaxed);
+    status.alerting = state->alerting.load(std::memory_order_relaxed);
+    return true;
+}
+
+jlong getDroppedBackpressureAlerts() {
+    return droppedAlerts.load(std::memory_order_relaxed);
+}
+
+void clearBackpressure() {
+    resetAllStates();
+    BackpressureAlert discarded;
+    while (alertQueue().tryPop(discarded)) {
+    }
+    droppedAlerts.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#ifndef BACKPRESSURE_H
+#define BACKPRESSURE_H
+
+#include <jni.h>
+
+struct BufferMetrics;
+
+// Early warning for buffers that are about to fill up.
+// Every emit and consume offers the buffer to the detector. At most once per
+// sample interval one caller per buffer wins a CAS and folds the emission and
+// consumption counts since the previous sample into exponentially weighted
+// rates; every other call is a clock compare and returns. From the net fill
+// rate and the free slots the detector predicts the time until the buffer is
+// full. When that drops to the warning horizon an ALERT_FILLING is queued, and
+// when the prediction moves beyond twice the horizon (or the buffer drains) an
+// ALERT_CLEARED follows. Off by default.
+//
+// The per-buffer state lives in its own table indexed by registry slot, so
+// BufferMetrics keeps its single cache line; a reused slot is detected by its
+// handle and starts from fresh rates.
+
+enum BackpressureAlertKind {
+    ALERT_FILLING = 0,
+    ALERT_CLEARED = 1
+};
+
+struct BackpressureAlert {
+    jlong bufferId;
+    jlong time;            // Same clock as the buffer metrics
+    jlong kind;            // BackpressureAlertKind
+    jlong timeToFullNanos; // -1 when the buffer is not filling
+    jlong size;
+    jlong capacity;
+    jlong emitRate;        // Items per second
+    jlong consumeRate;     // Items per second
+};
+
+static const jint kBackpressureAlertFields = 8;
+static const jint kBackpressureAlertCapacity = 1024; // Alerts queued until polled; later ones are dropped
+
+struct BackpressureStatus {
+    jlong emitRate;        // Items per second
+    jlong consumeRate;     // Items per second
+    jlong timeToFullNanos; // -1 when the buffer is not filling
+    jlong alerting;        // 1 between ALERT_FILLING and ALERT_CLEARED
+};
+
+static const jint kBackpressureStatusFields = 4;
+
+// Enables detection with the given warning horizon and rate smoothing time
+// constant, or disables it when warningNanos <= 0. Rates restart from zero.
+void setBackpressureDetection(jlong warningNanos, jlong smoothingNanos);
+
+// Feeds one emit or consume of the buffer; now may be 0 if the caller has no timestamp
+void observeBackpressure(jlong bufferId, BufferMetrics* metrics, jlong now);
+
+// Copies up to maxAlerts queued alerts, oldest first, and removes them; returns the
+// number copied, never more than kBackpressureAlertCapacity
+jint pollBackpressureAlerts(BackpressureAlert* destination, jint maxAlerts);
+
+// Latest estimate for a buffer; false if detection is off or the buffer has no sample yet
+bool getBackpressureStatus(jlong bufferId, BackpressureStatus& status);
+
+// Alerts lost because nobody polled the queue
+jlong getDroppedBackpressureAlerts();
+
+// Forgets rates, alert states and queued alerts; detection stays configured
+void clearBackpressure();
+
+#endif /* BACKPRESSURE_H */
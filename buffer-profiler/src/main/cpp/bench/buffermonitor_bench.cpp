@@ -0,0 +1,324 @@
+// Microbenchmarks for the native record and query paths, without a JVM.
+//
+//   buffermonitor_bench [--threads N] [--buffers 1,100,10000,100000] [--millis 200]
+//                       [--op NAME] [--history on|off] [--out FILE]
+//
+// Every operation is run for each thread count (1, 2, 4, ... up to N) and each
+// buffer count; threads pick a random buffer per operation. Throughput counts
+// every operation, latency is sampled on every 64th. Results are written as
+// JSON so runs can be compared mechanically.
+
+#include "stub_jvm.h"
+#include "buffer_tracking.h"
+#include "buffer_history.h"
+#include "memory_tracking.h"
+#include "snapshot.h"
+#include "buffer_aggregates.h"
+#include "main.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const uint64_t kLatencySampleInterval = 64;
+const jint kBenchCapacity = 1 << 30; // Large enough that no emit counts as a suspension
+const size_t kBenchFullest = 10;
+
+struct Options {
+    Options() : maxThreads(0), millis(200), history(false), out(nullptr) {}
+
+    unsigned maxThreads;
+    std::vector<jint> bufferCounts;
+    int millis;
+    std::string op;
+    bool history;
+    const char* out;
+};
+
+struct Result {
+    std::string op;
+    unsigned threads;
+    jint buffers;
+    uint64_t operations;
+    double seconds;
+    jlong p50;
+    jlong p99;
+    jlong max;
+};
+
+// Per-thread state handed to an operation
+struct Worker {
+    Worker() : rng(0), env(nullptr), item(nullptr) {}
+
+    uint64_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    }
+
+    uint64_t rng;
+    JNIEnv* env;
+    StubObject* item;
+    std::vector<char> snapshot;
+    std::vector<FullBuffer> fullest;
+};
+
+typedef void (*Operation)(Worker& worker, jlong bufferId);
+
+void benchRecordEmission(Worker&, jlong bufferId) {
+    recordEmission(bufferId);
+}
+
+void benchRecordConsumption(Worker&, jlong bufferId) {
+    recordConsumption(bufferId);
+}
+
+void benchUpdateBufferMetrics(Worker& worker, jlong bufferId) {
+    updateBufferMetrics(bufferId, static_cast<jint>(worker.rng & 0xFF), static_cast<jlong>(worker.rng & 0xFFFF));
+}
+
+// The path a TrackedBuffer takes per item: one emit and one consume crossing
+void benchEmitConsume(Worker& worker, jlong bufferId) {
+    jlong size = Java_NativeBufferMonitor_onEmit(worker.env, nullptr, bufferId, toJObject(worker.item));
+    Java_NativeBufferMonitor_onConsume(worker.env, nullptr, bufferId, size, 1000, nullptr);
+}
+
+void benchSnapshotAll(Worker& worker, jlong) {
+    snapshotAll(&worker.snapshot[0], static_cast<jlong>(worker.snapshot.size()));
+}
+
+void benchAggregateBuffers(Worker& worker, jlong) {
+    BufferAggregates aggregates;
+    aggregateBuffers(aggregates, &worker.fullest[0], static_cast<jint>(worker.fullest.size()));
+}
+
+struct NamedOperation {
+    const char* name;
+    Operation operation;
+};
+
+const NamedOperation kOperations[] = {
+    {"recordEmission", benchRecordEmission},
+    {"recordConsumption", benchRecordConsumption},
+    {"updateBufferMetrics", benchUpdateBufferMetrics},
+    {"onEmit+onConsume", benchEmitConsume},
+    {"snapshotAll", benchSnapshotAll},
+    {"aggregateBuffers", benchAggregateBuffers},
+};
+
+jlong percentile(const std::vector<jlong>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+Result run(const NamedOperation& named, unsigned threads, jint bufferCount, const Options& options,
+           StubJvm& jvm, StubObject* item) {
+    clearTracking();
+    std::vector<jlong> bufferIds;
+    bufferIds.reserve(bufferCount);
+    for (jint i = 0; i < bufferCount; i++) {
+        bufferIds.push_back(createBuffer(kBenchCapacity));
+    }
+
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::vector<uint64_t> counts(threads, 0);
+    std::vector<std::vector<jlong> > latencies(threads);
+    std::vector<std::thread> pool;
+
+    for (unsigned t = 0; t < threads; t++) {
+        pool.push_back(std::thread([&, t]() {
+            Worker worker;
+            worker.rng = 0x9E3779B97F4A7C15ULL * (t + 1);
+            worker.env = jvm.jniEnv();
+            worker.item = item;
+            worker.snapshot.resize(static_cast<size_t>(snapshotRequiredBytes(bufferCount)));
+            worker.fullest.resize(kBenchFullest);
+            std::vector<jlong>& samples = latencies[t];
+            samples.reserve(1 << 16);
+
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                jlong bufferId = bufferIds[worker.nextRandom() % bufferIds.size()];
+                if (count % kLatencySampleInterval == 0) {
+                    Clock::time_point before = Clock::now();
+                    named.operation(worker, bufferId);
+                    samples.push_back(static_cast<jlong>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count()));
+                } else {
+                    named.operation(worker, bufferId);
+                }
+                count++;
+            }
+            counts[t] = count;
+        }));
+    }
+
+    Clock::time_point began = Clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.millis));
+    stop.store(true, std::memory_order_relaxed);
+    for (size_t t = 0; t < pool.size(); t++) {
+        pool[t].join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - began).count();
+
+    std::vector<jlong> merged;
+    Result result;
+    result.op = named.name;
+    result.threads = threads;
+    result.buffers = bufferCount;
+    result.operations = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        result.operations += counts[t];
+        merged.insert(merged.end(), latencies[t].begin(), latencies[t].end());
+    }
+    std::sort(merged.begin(), merged.end());
+    result.seconds = seconds;
+    result.p50 = percentile(merged, 0.50);
+    result.p99 = percentile(merged, 0.99);
+    result.max = merged.empty() ? 0 : merged.back();
+    return result;
+}
+
+std::vector<jint> parseCounts(const char* list) {
+    std::vector<jint> counts;
+    const char* cursor = list;
+    while (*cursor != '\0') {
+        char* end;
+        long value = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        if (value > 0 && value <= BufferRegistry::kMaxSlots) {
+            counts.push_back(static_cast<jint>(value));
+        }
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return counts;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--threads") {
+            options.maxThreads = static_cast<unsigned>(atoi(value));
+        } else if (arg == "--buffers") {
+            options.bufferCounts = parseCounts(value);
+        } else if (arg == "--millis") {
+            options.millis = atoi(value);
+        } else if (arg == "--op") {
+            options.op = value;
+        } else if (arg == "--history") {
+            options.history = std::string(value) == "on";
+        } else if (arg == "--out") {
+            options.out = value;
+        } else {
+            return false;
+        }
+    }
+    if (options.maxThreads == 0) {
+        options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.bufferCounts.empty()) {
+        options.bufferCounts = parseCounts("1,100,10000,100000");
+    }
+    return options.millis > 0;
+}
+
+void writeJson(FILE* out, const Options& options, const std::vector<Result>& results) {
+    fprintf(out, "{\n  \"benchmark\": \"buffermonitor\",\n  \"millis\": %d,\n  \"history\": %s,\n"
+                 "  \"aggregationKernel\": \"%s\",\n",
+            options.millis, options.history ? "true" : "false", aggregationKernelName());
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        double perSecond = r.seconds > 0 ? static_cast<double>(r.operations) / r.seconds : 0.0;
+        fprintf(out,
+                "    {\"op\": \"%s\", \"threads\": %u, \"buffers\": %d, \"operations\": %llu, "
+                "\"ops_per_sec\": %.0f, \"p50_ns\": %lld, \"p99_ns\": %lld, \"max_ns\": %lld}%s\n",
+                r.op.c_str(), r.threads, r.buffers, static_cast<unsigned long long>(r.operations), perSecond,
+                static_cast<long long>(r.p50), static_cast<long long>(r.p99), static_cast<long long>(r.max),
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr,
+                "usage: %s [--threads N] [--buffers 1,100,10000,100000] [--millis 200] [--op NAME]\n"
+                "          [--history on|off] [--out FILE]\n",
+                argv[0]);
+        return 2;
+    }
+
+    StubJvm jvm;
+    initializeBufferTracking();
+    initializeMemoryTrackingWithJvm(jvm.javaVm());
+    setBufferHistoryEnabled(options.history);
+
+    // One class with a fixed size, so onEmit takes the cached-size path after the first item
+    StubObject itemClass;
+    itemClass.signature = "Lbench/Item;";
+    StubObject item;
+    item.size = 24;
+    item.klass = &itemClass;
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < options.maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(options.maxThreads);
+
+    std::vector<Result> results;
+    for (size_t o = 0; o < sizeof(kOperations) / sizeof(kOperations[0]); o++) {
+        if (!options.op.empty() && options.op != kOperations[o].name) {
+            continue;
+        }
+        for (size_t b = 0; b < options.bufferCounts.size(); b++) {
+            for (size_t t = 0; t < threadCounts.size(); t++) {
+                results.push_back(run(kOperations[o], threadCounts[t], options.bufferCounts[b], options, jvm, &item));
+                fprintf(stderr, "%s threads=%u buffers=%d done\n", kOperations[o].name, threadCounts[t],
+                        options.bufferCounts[b]);
+            }
+        }
+    }
+    clearTracking();
+
+    FILE* out = stdout;
+    if (options.out != nullptr) {
+        out = fopen(options.out, "w");
+        if (out == nullptr) {
+            perror(options.out);
+            return 1;
+        }
+    }
+    writeJson(out, options, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#ifndef BUFFERMONITOR_BENCH_STUB_JVM_H
+#define BUFFERMONITOR_BENCH_STUB_JVM_H
+
+#include <jni.h>
+#include <jvmti.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+// Just enough of a JVM to drive the tracking code without one.
+// Objects are StubObjects whose jobject is their address. JNI and JVMTI calls the
+// record paths make are answered from the object itself; every other function
+// pointer is null, so a code path that starts using a new call crashes loudly
+// here instead of measuring something else.
+
+struct StubObject {
+    StubObject() : tag(0), size(0), klass(nullptr), signature(nullptr) {}
+
+    std::atomic<jlong> tag;
+    jlong size;
+    StubObject* klass;     // nullptr for class objects
+    const char* signature; // Class objects only
+};
+
+inline StubObject* stubObject(jobject object) {
+    return reinterpret_cast<StubObject*>(object);
+}
+
+inline jobject toJObject(StubObject* object) {
+    return reinterpret_cast<jobject>(object);
+}
+
+// JNIEnv
+
+inline jclass JNICALL stubFindClass(JNIEnv*, const char*) {
+    return nullptr;
+}
+
+inline jclass JNICALL stubGetObjectClass(JNIEnv*, jobject object) {
+    return reinterpret_cast<jclass>(stubObject(object)->klass);
+}
+
+inline jboolean JNICALL stubIsSameObject(JNIEnv*, jobject left, jobject right) {
+    return left == right ? JNI_TRUE : JNI_FALSE;
+}
+
+inline jweak JNICALL stubNewWeakGlobalRef(JNIEnv*, jobject object) {
+    return object;
+}
+
+inline void JNICALL stubDeleteRef(JNIEnv*, jobject) {}
+
+inline jboolean JNICALL stubExceptionCheck(JNIEnv*) {
+    return JNI_FALSE;
+}
+
+inline void JNICALL stubExceptionClear(JNIEnv*) {}
+
+// jvmtiEnv
+
+inline jvmtiError JNICALL stubGetObjectSize(jvmtiEnv*, jobject object, jlong* size) {
+    *size = stubObject(object)->size;
+    return JVMTI_ERROR_NONE;
+}
+
+inline jvmtiError JNICALL stubAddCapabilities(jvmtiEnv*, const jvmtiCapabilities*) {
+    return JVMTI_ERROR_NONE;
+}
+
+// No optional capabilities, so GC and allocation events stay unavailable
+inline jvmtiError JNICALL stubGetPotentialCapabilities(jvmtiEnv*, jvmtiCapabilities* capabilities) {
+    memset(capabilities, 0, sizeof(*capabilities));
+    return JVMTI_ERROR_NONE;
+}
+
+inline jvmtiError JNICALL stubGetTag(jvmtiEnv*, jobject object, jlong* tag) {
+    *tag = stubObject(object)->tag.load(std::memory_order_acquire);
+    return JVMTI_ERROR_NONE;
+}
+
+inline jvmtiError JNICALL stubSetTag(jvmtiEnv*, jobject object, jlong tag) {
+    stubObject(object)->tag.store(tag, std::memory_order_release);
+    return JVMTI_ERROR_NONE;
+}
+
+inline jvmtiError JNICALL stubGetClassSignature(jvmtiEnv*, jclass klass, char** signature, char** generic) {
+    const char* source = reinterpret_cast<StubObject*>(klass)->signature;
+    size_t length = strlen(source) + 1;
+    *signature = static_cast<char*>(malloc(length));
+    memcpy(*signature, source, length);
+    if (generic != nullptr) {
+        *generic = nullptr;
+    }
+    return JVMTI_ERROR_NONE;
+}
+
+inline jvmtiError JNICALL stubDeallocate(jvmtiEnv*, unsigned char* memory) {
+    free(memory);
+    return JVMTI_ERROR_NONE;
+}
+
+// JavaVM
+
+class StubJvm {
+public:
+    StubJvm() {
+        memset(&nativeInterface, 0, sizeof(nativeInterface));
+        nativeInterface.FindClass = stubFindClass;
+        nativeInterface.GetObjectClass = stubGetObjectClass;
+        nativeInterface.IsSameObject = stubIsSameObject;
+        nativeInterface.NewWeakGlobalRef = stubNewWeakGlobalRef;
+        nativeInterface.DeleteWeakGlobalRef = stubDeleteRef;
+        nativeInterface.DeleteLocalRef = stubDeleteRef;
+        nativeInterface.ExceptionCheck = stubExceptionCheck;
+        nativeInterface.ExceptionClear = stubExceptionClear;
+        env.functions = &nativeInterface;
+
+        memset(&jvmtiInterface, 0, sizeof(jvmtiInterface));
+        jvmtiInterface.GetObjectSize = stubGetObjectSize;
+        jvmtiInterface.AddCapabilities = stubAddCapabilities;
+        jvmtiInterface.GetPotentialCapabilities = stubGetPotentialCapabilities;
+        jvmtiInterface.GetTag = stubGetTag;
+        jvmtiInterface.SetTag = stubSetTag;
+        jvmtiInterface.GetClassSignature = stubGetClassSignature;
+        jvmtiInterface.Deallocate = stubDeallocate;
+        jvmti.functions = &jvmtiInterface;
+
+        memset(&invokeInterface, 0, sizeof(invokeInterface));
+        invokeInterface.GetEnv = getEnv;
+        vm.functions = &invokeInterface;
+        instance() = this;
+    }
+
+    // The env is stateless, so every bench thread can share it
+    JNIEnv* jniEnv() {
+        return &env;
+    }
+
+    JavaVM* javaVm() {
+        return &vm;
+    }
+
+private:
+    // The tracking code only ever sees one VM
+    static StubJvm*& instance() {
+        static StubJvm* current = nullptr;
+        return current;
+    }
+
+    static jint JNICALL getEnv(JavaVM*, void** result, jint) {
+        *result = &instance()->jvmti;
+        return JNI_OK;
+    }
+
+    JNINativeInterface_ nativeInterface;
+    JNIEnv env;
+    jvmtiInterface_1_ jvmtiInterface;
+    jvmtiEnv jvmti;
+    JNIInvokeInterface_ invokeInterface;
+    JavaVM vm;
+};
+
+#endif /* BUFFERMONITOR_BENCH_STUB_JVM_H */
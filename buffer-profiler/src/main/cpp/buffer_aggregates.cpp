@@ -0,0 +1,301 @@
+#include "buffer_aggregates.h"
+#include "buffer_tracking.h"
+#include "logging.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BUFFER_AGGREGATES_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Registry contents gathered into columns, reused between calls under columnsMutex
+struct Columns {
+    std::vector<jlong> handles;
+    std::vector<jlong> memoryUsage;
+    std::vector<jlong> emissions;
+    std::vector<jlong> consumptions;
+    std::vector<jlong> suspensions;
+    std::vector<jint> sizes;
+    std::vector<jint> capacities;
+};
+
+struct ColumnSums {
+    jlong emissions;
+    jlong consumptions;
+    jlong suspensions;
+    jlong memoryUsage;
+    jlong size;
+    jlong capacity;
+};
+
+typedef std::pair<float, jint> RankedRow; // Utilization, row
+
+// Fuller first; of two equally full rows the earlier one ranks first
+inline bool ranksBefore(const RankedRow& a, const RankedRow& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+// Tracks the fullest row and a bounded heap of the limit fullest rows, whose
+// front is the row ranked last. Rows must be offered in row order; ties keep
+// the earlier row, both when a tied row is offered and when a fuller row
+// evicts one of several tied rows.
+class FullestRows {
+public:
+    explicit FullestRows(jint limit)
+        : limit(limit), maxUtilization(-std::numeric_limits<float>::infinity()), maxRow(-1) {
+        heap.reserve(static_cast<size_t>(limit));
+    }
+
+    // A row at or below this utilization cannot change the result. It only
+    // rises, so a threshold read before a batch of offers is conservative.
+    float threshold() const {
+        float heapMinimum = std::numeric_limits<float>::infinity();
+        if (limit > 0) {
+            heapMinimum = static_cast<jint>(heap.size()) < limit ? -std::numeric_limits<float>::infinity()
+                                                                 : heap.front().first;
+        }
+        return heapMinimum < maxUtilization ? heapMinimum : maxUtilization;
+    }
+
+    void offer(float utilization, jint row) {
+        if (utilization > maxUtilization) {
+            maxUtilization = utilization;
+            maxRow = row;
+        }
+        if (limit == 0) {
+            return;
+        }
+        if (static_cast<jint>(heap.size()) < limit) {
+            heap.push_back(RankedRow(utilization, row));
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        } else if (utilization > heap.front().first) {
+            // A later row needs to be strictly fuller; the row evicted is the latest of the emptiest
+            std::pop_heap(heap.begin(), heap.end(), ranksBefore);
+            heap.back() = RankedRow(utilization, row);
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        }
+    }
+
+    // Kept rows, fullest first
+    std::vector<RankedRow> sorted() const {
+        std::vector<RankedRow> rows(heap);
+        std::sort(rows.begin(), rows.end(), ranksBefore);
+        return rows;
+    }
+
+    jint fullestRow() const {
+        return maxRow;
+    }
+
+private:
+    jint limit;
+    float maxUtilization;
+    jint maxRow;
+    std::vector<RankedRow> heap;
+};
+
+// Used for ranking only; reported utilization is computed exactly from size and capacity
+inline float utilizationOf(jint size, jint capacity) {
+    return capacity > 0 ? static_cast<float>(size) / static_cast<float>(capacity) : 0.0f;
+}
+
+inline jlong permille(jlong size, jlong capacity) {
+    return capacity > 0 ? size * 1000 / capacity : 0;
+}
+
+void reduceRange(const Columns& columns, jint begin, jint end, ColumnSums& sums, FullestRows& fullest) {
+    for (jint row = begin; row < end; row++) {
+        sums.emissions += columns.emissions[row];
+        sums.consumptions += columns.consumptions[row];
+        sums.suspensions += columns.suspensions[row];
+        sums.memoryUsage += columns.memoryUsage[row];
+        sums.size += columns.sizes[row];
+        sums.capacity += columns.capacities[row];
+        fullest.offer(utilizationOf(columns.sizes[row], columns.capacities[row]), row);
+    }
+}
+
+void reduceScalar(const Columns& columns, jint count, ColumnSums& sums, FullestRows& fullest) {
+    reduceRange(columns, 0, count, sums, fullest);
+}
+
+#ifdef BUFFER_AGGREGATES_AVX2
+
+__attribute__((target("avx2"))) inline jlong horizontalSum(__m256i lanes) {
+    alignas(32) jlong values[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(values), lanes);
+    return values[0] + values[1] + values[2] + values[3];
+}
+
+__attribute__((target("avx2"))) inline __m256i addColumn(__m256i sum, const jlong* column) {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + 4));
+    return _mm256_add_epi64(sum, _mm256_add_epi64(low, high));
+}
+
+__attribute__((target("avx2"))) inline __m256i addWidened(__m256i sum, __m256i values) {
+    __m256i low = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values));
+    __m256i high = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1));
+    return _mm256_add_epi64(sum, _mm256_add_epi64(low, high));
+}
+
+// Eight rows per step. Utilization is computed with the same float division as
+// utilizationOf, so both kernels rank identically; only lanes above the current
+// threshold are handed to the scalar top-K update.
+__attribute__((target("avx2"))) void reduceAvx2(const Columns& columns, jint count, ColumnSums& sums,
+                                                 FullestRows& fullest) {
+    const jlong* emissions = columns.emissions.data();
+    const jlong* consumptions = columns.consumptions.data();
+    const jlong* suspensions = columns.suspensions.data();
+    const jlong* memoryUsage = columns.memoryUsage.data();
+    const jint* sizes = columns.sizes.data();
+    const jint* capacities = columns.capacities.data();
+
+    __m256i emissionSum = _mm256_setzero_si256();
+    __m256i consumptionSum = _mm256_setzero_si256();
+    __m256i suspensionSum = _mm256_setzero_si256();
+    __m256i memorySum = _mm256_setzero_si256();
+    __m256i sizeSum = _mm256_setzero_si256();
+    __m256i capacitySum = _mm256_setzero_si256();
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+
+    jint row = 0;
+    for (; row + 8 <= count; row += 8) {
+        emissionSum = addColumn(emissionSum, emissions + row);
+        consumptionSum = addColumn(consumptionSum, consumptions + row);
+        suspensionSum = addColumn(suspensionSum, suspensions + row);
+        memorySum = addColumn(memorySum, memoryUsage + row);
+
+        __m256i size = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sizes + row));
+        __m256i capacity = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(capacities + row));
+        sizeSum = addWidened(sizeSum, size);
+        capacitySum = addWidened(capacitySum, capacity);
+
+        __m256 utilization = _mm256_div_ps(_mm256_cvtepi32_ps(size), _mm256_cvtepi32_ps(_mm256_max_epi32(capacity, one)));
+        utilization = _mm256_and_ps(utilization, _mm256_castsi256_ps(_mm256_cmpgt_epi32(capacity, zero)));
+        int candidates = _mm256_movemask_ps(_mm256_cmp_ps(utilization, _mm256_set1_ps(fullest.threshold()), _CMP_GT_OQ));
+        if (candidates != 0) {
+            alignas(32) float lanes[8];
+            _mm256_store_ps(lanes, utilization);
+            for (int lane = 0; lane < 8; lane++) {
+                if ((candidates & (1 << lane)) != 0) {
+                    fullest.offer(lanes[lane], row + lane);
+                }
+            }
+        }
+    }
+
+    sums.emissions += horizontalSum(emissionSum);
+    sums.consumptions += horizontalSum(consumptionSum);
+    sums.suspensions += horizontalSum(suspensionSum);
+    sums.memoryUsage += horizontalSum(memorySum);
+    sums.size += horizontalSum(sizeSum);
+    sums.capacity += horizontalSum(capacitySum);
+    reduceRange(columns, row, count, sums, fullest);
+}
+
+#endif
+
+typedef void (*ReduceKernel)(const Columns& columns, jint count, ColumnSums& sums, FullestRows& fullest);
+
+struct Kernel {
+    const char* name;
+    ReduceKernel reduce;
+};
+
+Kernel selectKernel() {
+#ifdef BUFFER_AGGREGATES_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        Kernel avx2 = {"avx2", reduceAvx2};
+        return avx2;
+    }
+#endif
+    Kernel scalar = {"scalar", reduceScalar};
+    return scalar;
+}
+
+const Kernel& kernel() {
+    static const Kernel selected = selectKernel();
+    return selected;
+}
+
+std::mutex columnsMutex;
+
+Columns& sharedColumns() {
+    // Never destroyed, so a late caller during unload cannot touch freed vectors
+    static Columns* columns = new Columns();
+    return *columns;
+}
+
+jint gather(Columns& columns) {
+    columns.handles.clear();
+    columns.memoryUsage.clear();
+    columns.emissions.clear();
+    columns.consumptions.clear();
+    columns.suspensions.clear();
+    columns.sizes.clear();
+    columns.capacities.clear();
+
+    bufferMetrics.forEach([&columns](jlong bufferId, const BufferMetrics& metrics) {
+        columns.handles.push_back(bufferId);
+        columns.memoryUsage.push_back(metrics.totalMemoryUsage.load(std::memory_order_relaxed));
+        columns.emissions.push_back(metrics.count(COUNTER_EMISSIONS));
+        columns.consumptions.push_back(metrics.count(COUNTER_CONSUMPTIONS));
+        columns.suspensions.push_back(metrics.count(COUNTER_SUSPENSIONS));
+        columns.sizes.push_back(metrics.size.load(std::memory_order_relaxed));
+        columns.capacities.push_back(metrics.capacity.load(std::memory_order_relaxed));
+    });
+    return static_cast<jint>(columns.handles.size());
+}
+
+} // namespace
+
+jint aggregateBuffers(BufferAggregates& aggregates, FullBuffer* fullest, jint maxFullest) {
+    if (fullest == nullptr || maxFullest < 0) {
+        maxFullest = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(columnsMutex);
+    Columns& columns = sharedColumns();
+    jint count = gather(columns);
+
+    ColumnSums sums = {0, 0, 0, 0, 0, 0};
+    FullestRows rows(maxFullest);
+    kernel().reduce(columns, count, sums, rows);
+
+    aggregates.bufferCount = count;
+    aggregates.totalEmissions = sums.emissions;
+    aggregates.totalConsumptions = sums.consumptions;
+    aggregates.totalSuspensions = sums.suspensions;
+    aggregates.totalMemoryUsage = sums.memoryUsage;
+    aggregates.totalSize = sums.size;
+    aggregates.totalCapacity = sums.capacity;
+    jint fullestRow = rows.fullestRow();
+    aggregates.maxUtilizationPermille =
+        fullestRow >= 0 ? permille(columns.sizes[fullestRow], columns.capacities[fullestRow]) : 0;
+    aggregates.fullestBufferId = fullestRow >= 0 ? columns.handles[fullestRow] : 0;
+
+    std::vector<RankedRow> ranked = rows.sorted();
+    for (size_t i = 0; i < ranked.size(); i++) {
+        jint row = ranked[i].second;
+        fullest[i].bufferId = columns.handles[row];
+        fullest[i].size = columns.sizes[row];
+        fullest[i].capacity = columns.capacities[row];
+        fullest[i].utilizationPermille = permille(columns.sizes[row], columns.capacities[row]);
+    }
+
+    LOG_DEBUG("Aggregated %d buffers with the %s kernel", count, kernel().name);
+    return static_cast<jint>(ranked.size());
+}
+
+const char* aggregationKernelName() {
+    return kernel().name;
+}
@@ -0,0 +1,49 @@
+#ifndef BUFFER_AGGREGATES_H
+#define BUFFER_AGGREGATES_H
+
+#include <jni.h>
+
+// Totals, maximum utilization and the fullest buffers.
+// Every call first gathers the registry into contiguous columns (struct of
+// arrays) with one scalar walk over the live slots, the same walk snapshotAll
+// does; the columns are rebuilt on each call, not maintained as buffers change.
+// A single reduction over those columns then sums the counters and scans the
+// utilization (size / capacity) of every buffer. On x86 with AVX2 the reduction
+// handles eight buffers per step and only looks at the lanes that can beat the
+// current top-K threshold; elsewhere an equivalent scalar loop is used. The
+// kernel is chosen once, at the first call. Only the reduction is vectorized,
+// so the gather, which reads every buffer's striped counters, dominates the
+// cost of a call.
+
+struct BufferAggregates {
+    jlong bufferCount;
+    jlong totalEmissions;
+    jlong totalConsumptions;
+    jlong totalSuspensions;
+    jlong totalMemoryUsage;
+    jlong totalSize;
+    jlong totalCapacity;
+    jlong maxUtilizationPermille; // Size over capacity of the fullest buffer, 0 without buffers
+    jlong fullestBufferId;        // 0 without buffers
+};
+
+static const jint kBufferAggregateFields = 9;
+
+// One of the fullest buffers, fullest first; equally full buffers keep registry order
+struct FullBuffer {
+    jlong bufferId;
+    jlong size;
+    jlong capacity;
+    jlong utilizationPermille; // Can exceed 1000 while producers wait on a full TrackedBuffer
+};
+
+static const jint kFullBufferFields = 4;
+
+// Computes the aggregates and copies up to maxFullest of the fullest buffers,
+// fullest first; returns the number copied
+jint aggregateBuffers(BufferAggregates& aggregates, FullBuffer* fullest, jint maxFullest);
+
+// "avx2" or "scalar"
+const char* aggregationKernelName();
+
+#endif /* BUFFER_AGGREGATES_H */
@@ -0,0 +1,244 @@
+#include "buffer_groups.h"
+#include "buffer_tracking.h"
+#include "utils.h"
+#include "logging.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+// Lives outside the anonymous namespace because CounterCell refers to it
+struct alignas(kCacheLineSize) GroupCell {
+    std::atomic<jlong> values[kGroupFields]; // Indexed by GroupField
+};
+
+struct BufferGroup {
+    GroupCell cells[kCounterStripes];
+    std::atomic<jlong> bufferCount;
+    std::atomic<jlong> capacity;
+    BufferGroup* parent; // nullptr for a top-level group
+    jint id;
+    std::string path;
+};
+
+namespace {
+
+// Groups by id; published once and never freed, so readers need no lock
+std::atomic<BufferGroup*> groups[kMaxBufferGroups];
+std::atomic<jint> groupCount(0);
+
+// Guards group creation and the buffer names
+std::mutex groupsMutex;
+
+std::unordered_map<std::string, jint>& groupIds() {
+    static std::unordered_map<std::string, jint>* ids = new std::unordered_map<std::string, jint>();
+    return *ids;
+}
+
+std::unordered_map<jlong, std::string>& bufferNames() {
+    static std::unordered_map<jlong, std::string>* names = new std::unordered_map<jlong, std::string>();
+    return *names;
+}
+
+// Lets release skip the lock while no buffer has a name
+std::atomic<jint> namedBuffers(0);
+
+bool isValidLabel(const std::string& label) {
+    size_t separator = label.find('=');
+    return separator != std::string::npos && separator > 0 && label.find('/') == std::string::npos;
+}
+
+// Caller holds groupsMutex
+BufferGroup* groupForPath(const std::string& path, BufferGroup* parent) {
+    std::unordered_map<std::string, jint>::const_iterator existing = groupIds().find(path);
+    if (existing != groupIds().end()) {
+        return groups[existing->second].load(std::memory_order_relaxed);
+    }
+
+    jint id = groupCount.load(std::memory_order_relaxed);
+    if (id >= kMaxBufferGroups) {
+        return nullptr;
+    }
+    void* block = allocateCacheAligned(sizeof(BufferGroup));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    BufferGroup* group = new (block) BufferGroup();
+    group->parent = parent;
+    group->id = id;
+    group->path = path;
+
+    groupIds()[path] = id;
+    groups[id].store(group, std::memory_order_release);
+    groupCount.store(id + 1, std::memory_order_release);
+    return group;
+}
+
+// Adds delta to a per-buffer total that has no stripe (buffer count, capacity)
+void addToChain(BufferGroup* group, std::atomic<jlong> BufferGroup::*field, jlong delta) {
+    for (; group != nullptr; group = group->parent) {
+        (group->*field).fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void addToGroupTotals(BufferGroup* group, jint field, jlong delta, jint stripe) {
+    for (; group != nullptr; group = group->parent) {
+        group->cells[stripe].values[field].fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
+jlong createLabeledBuffer(jint capacity, const std::string& name, const std::vector<std::string>& labels) {
+    if (static_cast<jint>(labels.size()) > kMaxGroupDepth) {
+        LOG_WARN("Warning: Buffer %s has more than %d labels", name.c_str(), kMaxGroupDepth);
+        return 0;
+    }
+    for (size_t i = 0; i < labels.size(); i++) {
+        if (!isValidLabel(labels[i])) {
+            LOG_WARN("Warning: Label '%s' of buffer %s is not key=value", labels[i].c_str(), name.c_str());
+            return 0;
+        }
+    }
+
+    BufferGroup* group = nullptr;
+    if (!labels.empty()) {
+        std::lock_guard<std::mutex> lock(groupsMutex);
+        std::string path;
+        for (size_t i = 0; i < labels.size() && (i == 0 || group != nullptr); i++) {
+            path += (i == 0 ? "" : "/") + labels[i];
+            group = groupForPath(path, group);
+        }
+        if (group == nullptr) {
+            LOG_WARN("Warning: No buffer group left for %s", path.c_str());
+            return 0;
+        }
+    }
+
+    jlong bufferId = createBuffer(capacity);
+    BufferMetrics* metrics = bufferId != 0 ? bufferMetrics.find(bufferId) : nullptr;
+    if (metrics == nullptr) {
+        return 0;
+    }
+
+    // The handle has not been returned yet, so nothing else updates the buffer
+    // and its totals are still zero
+    if (group != nullptr) {
+        for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+            metrics->counters[stripe].group.store(group, std::memory_order_release);
+        }
+        addToChain(group, &BufferGroup::bufferCount, 1);
+        addToChain(group, &BufferGroup::capacity, capacity);
+    }
+    if (!name.empty()) {
+        std::lock_guard<std::mutex> lock(groupsMutex);
+        bufferNames()[bufferId] = name;
+        namedBuffers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LOG_DEBUG("Created buffer %s (%lld) in group %d", name.c_str(), static_cast<long long>(bufferId),
+              group != nullptr ? group->id : -1);
+    return bufferId;
+}
+
+jint findBufferGroup(const std::string& path) {
+    std::lock_guard<std::mutex> lock(groupsMutex);
+    std::unordered_map<std::string, jint>::const_iterator existing = groupIds().find(path);
+    return existing != groupIds().end() ? existing->second : -1;
+}
+
+jint getBufferGroupOf(jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        return -1;
+    }
+    BufferGroup* group = metrics->counters[0].group.load(std::memory_order_acquire);
+    return group != nullptr ? group->id : -1;
+}
+
+std::string getBufferGroupPath(jint groupId) {
+    if (groupId < 0 || groupId >= groupCount.load(std::memory_order_acquire)) {
+        return std::string();
+    }
+    return groups[groupId].load(std::memory_order_acquire)->path;
+}
+
+std::vector<std::string> getBufferGroupPaths() {
+    std::lock_guard<std::mutex> lock(groupsMutex);
+    jint count = groupCount.load(std::memory_order_relaxed);
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (jint id = 0; id < count; id++) {
+        paths.push_back(groups[id].load(std::memory_order_relaxed)->path);
+    }
+    return paths;
+}
+
+bool getBufferGroupTotals(jint groupId, BufferGroupTotals& totals) {
+    if (groupId < 0 || groupId >= groupCount.load(std::memory_order_acquire)) {
+        return false;
+    }
+    BufferGroup* group = groups[groupId].load(std::memory_order_acquire);
+
+    jlong sums[kGroupFields] = {0, 0, 0, 0, 0};
+    for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+        for (jint field = 0; field < kGroupFields; field++) {
+            sums[field] += group->cells[stripe].values[field].load(std::memory_order_relaxed);
+        }
+    }
+    totals.bufferCount = group->bufferCount.load(std::memory_order_relaxed);
+    totals.capacity = group->capacity.load(std::memory_order_relaxed);
+    totals.size = sums[GROUP_SIZE];
+    totals.memoryUsage = sums[GROUP_MEMORY];
+    totals.emissions = sums[GROUP_EMISSIONS];
+    totals.consumptions = sums[GROUP_CONSUMPTIONS];
+    totals.suspensions = sums[GROUP_SUSPENSIONS];
+    return true;
+}
+
+std::string getBufferName(jlong bufferId) {
+    if (namedBuffers.load(std::memory_order_relaxed) == 0 || bufferMetrics.find(bufferId) == nullptr) {
+        return std::string();
+    }
+    std::lock_guard<std::mutex> lock(groupsMutex);
+    std::unordered_map<jlong, std::string>::const_iterator name = bufferNames().find(bufferId);
+    return name != bufferNames().end() ? name->second : std::string();
+}
+
+void detachBufferGroup(jlong bufferId, BufferMetrics* metrics) {
+    BufferGroup* group = nullptr;
+    for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+        group = metrics->counters[stripe].group.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    if (group != nullptr) {
+        jint stripe = currentCounterStripe();
+        addToGroupTotals(group, GROUP_EMISSIONS, -metrics->count(COUNTER_EMISSIONS), stripe);
+        addToGroupTotals(group, GROUP_CONSUMPTIONS, -metrics->count(COUNTER_CONSUMPTIONS), stripe);
+        addToGroupTotals(group, GROUP_SUSPENSIONS, -metrics->count(COUNTER_SUSPENSIONS), stripe);
+        addToGroupTotals(group, GROUP_SIZE, -metrics->size.load(std::memory_order_relaxed), stripe);
+        addToGroupTotals(group, GROUP_MEMORY, -metrics->totalMemoryUsage.load(std::memory_order_relaxed), stripe);
+        addToChain(group, &BufferGroup::bufferCount, -1);
+        addToChain(group, &BufferGroup::capacity, -metrics->capacity.load(std::memory_order_relaxed));
+    }
+
+    if (namedBuffers.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(groupsMutex);
+        if (bufferNames().erase(bufferId) > 0) {
+            namedBuffers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void clearBufferGroups() {
+    jint count = groupCount.load(std::memory_order_acquire);
+    for (jint id = 0; id < count; id++) {
+        BufferGroup* group = groups[id].load(std::memory_order_acquire);
+        for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+            for (jint field = 0; field < kGroupFields; field++) {
+                group->cells[stripe].values[field].store(0, std::memory_order_relaxed);
+            }
+        }
+        group->bufferCount.store(0, std::memory_order_relaxed);
+        group->capacity.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef BUFFER_GROUPS_H
+#define BUFFER_GROUPS_H
+
+#include <jni.h>
+#include <string>
+#include <vector>
+
+struct BufferMetrics;
+
+// Labeled buffers and hierarchical group totals.
+// A buffer created with labels such as {"pipeline=ingest", "stage=parse"}
+// joins the group "pipeline=ingest/stage=parse", which is a child of
+// "pipeline=ingest". Every group keeps its buffers' count, capacity, size,
+// memory usage and counters as running totals: the buffer's counter cells
+// point at its group, and each update that changes the buffer also adds the
+// same delta to the group and its ancestors. Reading a group is a sum over
+// its stripes, independent of how many buffers it holds. Releasing a buffer
+// takes what it still holds out of its groups again. Groups are never
+// removed; clearTracking zeroes their totals.
+//
+// Group totals follow buffer updates, not snapshots: a record call racing
+// with the release of its buffer can leave its delta in the group until the
+// next clearTracking.
+
+struct BufferGroupTotals {
+    jlong bufferCount;
+    jlong capacity;
+    jlong size;
+    jlong memoryUsage;
+    jlong emissions;
+    jlong consumptions;
+    jlong suspensions;
+};
+
+static const jint kBufferGroupTotalsFields = 7;
+static const jint kMaxGroupDepth = 8;
+static const jint kMaxBufferGroups = 4096;
+
+// Creates a buffer with a name and a label path ("key=value" entries, outermost
+// first); no labels leaves it ungrouped. Returns 0 if a label is malformed,
+// the path is deeper than kMaxGroupDepth, no group is left or the registry is full.
+jlong createLabeledBuffer(jint capacity, const std::string& name, const std::vector<std::string>& labels);
+
+// Group id of a label path such as "pipeline=ingest/stage=parse", -1 if it does not exist
+jint findBufferGroup(const std::string& path);
+
+// Group id of a live buffer, -1 if it is ungrouped or unknown
+jint getBufferGroupOf(jlong bufferId);
+
+// Path of one group, empty for an unknown id
+std::string getBufferGroupPath(jint groupId);
+
+// Paths of all groups, indexed by group id
+std::vector<std::string> getBufferGroupPaths();
+
+// Totals of a group including all groups below it; false for an unknown id
+bool getBufferGroupTotals(jint groupId, BufferGroupTotals& totals);
+
+// Name given to a live buffer at creation, empty if it has none
+std::string getBufferName(jlong bufferId);
+
+// Takes a released buffer out of its group and forgets its name; called by the registry
+void detachBufferGroup(jlong bufferId, BufferMetrics* metrics);
+
+// Zeroes every group's totals once all buffers are released; groups and ids stay
+void clearBufferGroups();
+
+#endif /* BUFFER_GROUPS_H */
@@ -0,0 +1,289 @@
+#include "buffer_history.h"
+#include "buffer_tracking.h"
+#include "logging.h"
+#include <climits>
+#include <thread>
+
+namespace {
+
+const jlong kNanosPerSecond = 1000000000LL;
+const jint kNoMinSize = INT_MAX;
+const jint kNoMaxSize = INT_MIN;
+const jlong kNoMinMemory = LLONG_MAX;
+const jlong kNoMaxMemory = LLONG_MIN;
+
+std::atomic<bool> historyEnabled(true);
+
+BufferHistory* historyOf(BufferMetrics* metrics) {
+    BufferHistory* history = metrics->history.load(std::memory_order_acquire);
+    if (history != nullptr) {
+        return history;
+    }
+
+    BufferHistory* fresh = new BufferHistory();
+    if (metrics->history.compare_exchange_strong(history, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    delete fresh;
+    return history;
+}
+
+// Usually a single load: a CAS only when the value is a new extreme
+template <typename T>
+void lowerTo(std::atomic<T>& extreme, T value) {
+    T current = extreme.load(std::memory_order_relaxed);
+    while (value < current && !extreme.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+template <typename T>
+void raiseTo(std::atomic<T>& extreme, T value) {
+    T current = extreme.load(std::memory_order_relaxed);
+    while (value > current && !extreme.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+BufferHistory::BufferHistory() : sampledTick(-1), pendingMinSize(kNoMinSize), pendingMaxSize(kNoMaxSize),
+                                 pendingMinMemory(kNoMinMemory), pendingMaxMemory(kNoMaxMemory) {
+    busy.clear();
+    tiers[HISTORY_SECOND].width = kNanosPerSecond;
+    tiers[HISTORY_SECOND].buckets = secondBuckets;
+    tiers[HISTORY_SECOND].capacity = kSecondBuckets;
+    tiers[HISTORY_TEN_SECONDS].width = 10 * kNanosPerSecond;
+    tiers[HISTORY_TEN_SECONDS].buckets = tenSecondBuckets;
+    tiers[HISTORY_TEN_SECONDS].capacity = kTenSecondBuckets;
+    tiers[HISTORY_MINUTE].width = 60 * kNanosPerSecond;
+    tiers[HISTORY_MINUTE].buckets = minuteBuckets;
+    tiers[HISTORY_MINUTE].capacity = kMinuteBuckets;
+    tiers[HISTORY_RAW].width = 0;
+    tiers[HISTORY_RAW].buckets = nullptr;
+    tiers[HISTORY_RAW].capacity = 0;
+    reset();
+}
+
+void BufferHistory::lock() {
+    while (busy.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void BufferHistory::unlock() {
+    busy.clear(std::memory_order_release);
+}
+
+void BufferHistory::addTo(Bucket& bucket, jint size, jlong memory) {
+    if (bucket.count == 0) {
+        bucket.minSize = size;
+        bucket.maxSize = size;
+        bucket.minMemory = memory;
+        bucket.maxMemory = memory;
+    } else {
+        if (size < bucket.minSize) bucket.minSize = size;
+        if (size > bucket.maxSize) bucket.maxSize = size;
+        if (memory < bucket.minMemory) bucket.minMemory = memory;
+        if (memory > bucket.maxMemory) bucket.maxMemory = memory;
+    }
+    bucket.count++;
+    bucket.sumSize += size;
+    bucket.sumMemory += memory;
+}
+
+void BufferHistory::noteExtremes(jint size, jlong memory) {
+    lowerTo(pendingMinSize, size);
+    raiseTo(pendingMaxSize, size);
+    lowerTo(pendingMinMemory, memory);
+    raiseTo(pendingMaxMemory, memory);
+}
+
+// Widens the open buckets by the extremes of the unsampled changes; they happened
+// after the open buckets' last sample, so they belong there
+void BufferHistory::foldExtremes() {
+    jint minSize = pendingMinSize.exchange(kNoMinSize, std::memory_order_relaxed);
+    jint maxSize = pendingMaxSize.exchange(kNoMaxSize, std::memory_order_relaxed);
+    jlong minMemory = pendingMinMemory.exchange(kNoMinMemory, std::memory_order_relaxed);
+    jlong maxMemory = pendingMaxMemory.exchange(kNoMaxMemory, std::memory_order_relaxed);
+    if (minSize > maxSize) {
+        return; // Nothing pending
+    }
+    for (jint index = HISTORY_SECOND; index < HISTORY_TIER_COUNT; index++) {
+        Bucket& open = tiers[index].open;
+        if (open.count == 0) {
+            continue;
+        }
+        if (minSize < open.minSize) open.minSize = minSize;
+        if (maxSize > open.maxSize) open.maxSize = maxSize;
+        if (minMemory < open.minMemory) open.minMemory = minMemory;
+        if (maxMemory > open.maxMemory) open.maxMemory = maxMemory;
+    }
+}
+
+void BufferHistory::record(jlong timestamp, jint size, jlong memory) {
+    // Only the first change of a tick samples; the others never touch the lock
+    jlong tick = timestamp / kSampleTickNanos;
+    jlong last = sampledTick.load(std::memory_order_relaxed);
+    if (tick <= last || !sampledTick.compare_exchange_strong(last, tick, std::memory_order_relaxed)) {
+        noteExtremes(size, memory);
+        return;
+    }
+
+    lock();
+    foldExtremes();
+
+    Sample& sample = raw[rawNext];
+    sample.timestamp = timestamp;
+    sample.memory = memory;
+    sample.size = size;
+    sample.reserved = 0;
+    rawNext = (rawNext + 1) % kRawCapacity;
+    if (rawCount < kRawCapacity) {
+        rawCount++;
+    }
+
+    for (jint index = HISTORY_SECOND; index < HISTORY_TIER_COUNT; index++) {
+        Tier& tier = tiers[index];
+        jlong start = timestamp - timestamp % tier.width;
+        // A sample stamped just before the open bucket's start (taken before the lock
+        // by a racing thread) still belongs to the open bucket
+        if (tier.open.count > 0 && start > tier.open.start) {
+            tier.buckets[tier.next] = tier.open;
+            tier.next = (tier.next + 1) % tier.capacity;
+            if (tier.count < tier.capacity) {
+                tier.count++;
+            }
+            tier.open.count = 0;
+        }
+        if (tier.open.count == 0) {
+            tier.open.start = start;
+            tier.open.sumSize = 0;
+            tier.open.sumMemory = 0;
+        }
+        addTo(tier.open, size, memory);
+    }
+
+    unlock();
+}
+
+HistoryPoint BufferHistory::toPoint(const Bucket& bucket) {
+    HistoryPoint point;
+    point.start = bucket.start;
+    point.count = bucket.count;
+    point.minSize = bucket.minSize;
+    point.maxSize = bucket.maxSize;
+    point.sumSize = bucket.sumSize;
+    point.minMemory = bucket.minMemory;
+    point.maxMemory = bucket.maxMemory;
+    point.sumMemory = bucket.sumMemory;
+    return point;
+}
+
+jint BufferHistory::tierCapacity(jint tier) {
+    switch (tier) {
+        case HISTORY_RAW: return kRawCapacity;
+        case HISTORY_SECOND: return kSecondBuckets + 1;
+        case HISTORY_TEN_SECONDS: return kTenSecondBuckets + 1;
+        case HISTORY_MINUTE: return kMinuteBuckets + 1;
+        default: return 0;
+    }
+}
+
+// Points of a tier, oldest first; callers hold the lock
+jint BufferHistory::pointCount(jint tier) const {
+    if (tier == HISTORY_RAW) {
+        return rawCount;
+    }
+    return tiers[tier].count + (tiers[tier].open.count > 0 ? 1 : 0);
+}
+
+HistoryPoint BufferHistory::pointAt(jint tier, jint position) const {
+    if (tier == HISTORY_RAW) {
+        const Sample& sample = raw[(rawNext + kRawCapacity - rawCount + position) % kRawCapacity];
+        HistoryPoint point;
+        point.start = sample.timestamp;
+        point.count = 1;
+        point.minSize = point.maxSize = point.sumSize = sample.size;
+        point.minMemory = point.maxMemory = point.sumMemory = sample.memory;
+        return point;
+    }
+
+    const Tier& bucketTier = tiers[tier];
+    if (position == bucketTier.count) {
+        return toPoint(bucketTier.open);
+    }
+    return toPoint(bucketTier.buckets[(bucketTier.next + bucketTier.capacity - bucketTier.count + position) %
+                                      bucketTier.capacity]);
+}
+
+jint BufferHistory::query(jint tier, jlong fromTime, jlong toTime, HistoryPoint* destination, jint maxPoints) {
+    if (tier < 0 || tier >= HISTORY_TIER_COUNT || destination == nullptr || maxPoints <= 0) {
+        return 0;
+    }
+
+    lock();
+    foldExtremes();
+    // Points are in time order, so the window is a contiguous range; keep its newest maxPoints
+    jint total = pointCount(tier);
+    jint first = 0;
+    while (first < total && pointAt(tier, first).start < fromTime) {
+        first++;
+    }
+    jint last = first;
+    while (last < total && pointAt(tier, last).start < toTime) {
+        last++;
+    }
+    if (last - first > maxPoints) {
+        first = last - maxPoints;
+    }
+    for (jint position = first; position < last; position++) {
+        destination[position - first] = pointAt(tier, position);
+    }
+    unlock();
+    return last - first;
+}
+
+void BufferHistory::reset() {
+    lock();
+    sampledTick.store(-1, std::memory_order_relaxed);
+    pendingMinSize.store(kNoMinSize, std::memory_order_relaxed);
+    pendingMaxSize.store(kNoMaxSize, std::memory_order_relaxed);
+    pendingMinMemory.store(kNoMinMemory, std::memory_order_relaxed);
+    pendingMaxMemory.store(kNoMaxMemory, std::memory_order_relaxed);
+    rawNext = 0;
+    rawCount = 0;
+    for (jint index = HISTORY_SECOND; index < HISTORY_TIER_COUNT; index++) {
+        tiers[index].next = 0;
+        tiers[index].count = 0;
+        tiers[index].open.start = 0;
+        tiers[index].open.count = 0;
+        tiers[index].open.sumSize = 0;
+        tiers[index].open.sumMemory = 0;
+    }
+    unlock();
+}
+
+void setBufferHistoryEnabled(bool enabled) {
+    historyEnabled.store(enabled, std::memory_order_relaxed);
+    LOG_INFO("Buffer history %s", enabled ? "enabled" : "disabled");
+}
+
+void recordHistorySample(BufferMetrics* metrics, jlong timestamp, jint size, jlong memory) {
+    if (!historyEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    historyOf(metrics)->record(timestamp, size, memory);
+}
+
+jint getBufferHistory(jlong bufferId, jint tier, jlong fromTime, jlong toTime, HistoryPoint* destination,
+                      jint maxPoints) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getBufferHistory", static_cast<long long>(bufferId));
+        return 0;
+    }
+    BufferHistory* history = metrics->history.load(std::memory_order_acquire);
+    if (history == nullptr) {
+        return 0;
+    }
+    return history->query(tier, fromTime, toTime, destination, maxPoints);
+}
@@ -0,0 +1,135 @@
+#ifndef BUFFER_HISTORY_H
+#define BUFFER_HISTORY_H
+
+#include <jni.h>
+#include <atomic>
+
+struct BufferMetrics;
+
+// Per-buffer time series of size and memory usage.
+// Size changes (emit, consume, cancel, updateBufferMetrics) are sampled at most
+// once per kSampleTickNanos per buffer: the first change in a tick takes the lock,
+// appends a raw sample and folds it into 1 s, 10 s and 1 min buckets that keep the
+// count and the min, max and sum of both values. Later changes in the same tick
+// take no lock; they only widen lock-free min/max extremes, which the next sample
+// or query folds into the open buckets, so a spike between two polls still shows
+// up as a bucket maximum. Bucket counts and sums cover the samples taken. Raw
+// samples and each tier live in fixed-size rings, so a buffer's history never
+// takes more than sizeof(BufferHistory); the oldest data is overwritten first.
+// The history is allocated on a buffer's first sample.
+
+enum HistoryTier {
+    HISTORY_RAW = 0,
+    HISTORY_SECOND = 1,
+    HISTORY_TEN_SECONDS = 2,
+    HISTORY_MINUTE = 3,
+    HISTORY_TIER_COUNT = 4
+};
+
+// One exported point. A raw sample is a point with count 1.
+struct HistoryPoint {
+    jlong start;      // Sample time, or bucket start; same clock as the buffer metrics
+    jlong count;
+    jlong minSize;
+    jlong maxSize;
+    jlong sumSize;
+    jlong minMemory;
+    jlong maxMemory;
+    jlong sumMemory;
+};
+
+static const jint kHistoryPointFields = 8;
+
+class BufferHistory {
+public:
+    static const jint kRawCapacity = 512;
+    static const jint kSecondBuckets = 120;     // 2 minutes
+    static const jint kTenSecondBuckets = 180;  // 30 minutes
+    static const jint kMinuteBuckets = 240;     // 4 hours
+    static const jlong kSampleTickNanos = 1000000; // At most one sample per millisecond
+
+    BufferHistory();
+
+    // Samples the change if it is the first in its tick, else only notes its extremes
+    void record(jlong timestamp, jint size, jlong memory);
+
+    // Copies the most recent points of a tier whose start lies in [fromTime, toTime),
+    // oldest first, including the bucket still being filled. Returns the number copied.
+    jint query(jint tier, jlong fromTime, jlong toTime, HistoryPoint* destination, jint maxPoints);
+
+    // Most points a query of the tier can return, the open bucket included; 0 for an unknown tier
+    static jint tierCapacity(jint tier);
+
+    void reset();
+
+private:
+    struct Sample {
+        jlong timestamp;
+        jlong memory;
+        jint size;
+        jint reserved;
+    };
+
+    struct Bucket {
+        jlong start;
+        jlong count;
+        jlong sumSize;
+        jlong sumMemory;
+        jlong minMemory;
+        jlong maxMemory;
+        jint minSize;
+        jint maxSize;
+    };
+
+    struct Tier {
+        jlong width;
+        Bucket* buckets;
+        jint capacity;
+        jint next;
+        jint count;
+        Bucket open; // Bucket being filled, count 0 until the first sample
+    };
+
+    void lock();
+    void unlock();
+    void noteExtremes(jint size, jlong memory);
+    void foldExtremes(); // Callers hold the lock
+    static void addTo(Bucket& bucket, jint size, jlong memory);
+    static HistoryPoint toPoint(const Bucket& bucket);
+    jint pointCount(jint tier) const;
+    HistoryPoint pointAt(jint tier, jint position) const;
+
+    BufferHistory(const BufferHistory&);
+    BufferHistory& operator=(const BufferHistory&);
+
+    std::atomic_flag busy; // Writers are short, so a spinlock beats parking on a mutex
+    std::atomic<jlong> sampledTick; // Tick of the last sample, -1 before the first
+
+    // Extremes of the changes since the last sample that were not sampled themselves
+    std::atomic<jint> pendingMinSize;
+    std::atomic<jint> pendingMaxSize;
+    std::atomic<jlong> pendingMinMemory;
+    std::atomic<jlong> pendingMaxMemory;
+
+    Sample raw[kRawCapacity];
+    jint rawNext;
+    jint rawCount;
+    Bucket secondBuckets[kSecondBuckets];
+    Bucket tenSecondBuckets[kTenSecondBuckets];
+    Bucket minuteBuckets[kMinuteBuckets];
+    Tier tiers[HISTORY_TIER_COUNT]; // Index 0 unused; raw samples have their own ring
+};
+
+// Turns sampling on or off for every buffer; on by default. Histories already
+// allocated keep their data. With many buffers this bounds total memory, since
+// each buffer's history is allocated on its first sample.
+void setBufferHistoryEnabled(bool enabled);
+
+// Appends a sample to the buffer's history, allocating it on first use; no-op while disabled
+void recordHistorySample(BufferMetrics* metrics, jlong timestamp, jint size, jlong memory);
+
+// Copies history points of a live buffer, see BufferHistory::query; 0 if unknown
+jint getBufferHistory(jlong bufferId, jint tier, jlong fromTime, jlong toTime, HistoryPoint* destination,
+                      jint maxPoints);
+
+#endif /* BUFFER_HISTORY_H */
@@ -1,53 +1,253 @@
 #include "buffer_tracking.h"
+#include "latency_histogram.h"
+#include "buffer_history.h"
+#include "event_tracking.h"
+#include "backpressure.h"
+#include "buffer_groups.h"
+#include "suspension_stacks.h"
 #include "utils.h"
-#include <iostream>
-#include <sstream>
+#include "logging.h"
 #include <chrono>
+#include <new>
 
-// Global map to store buffer metrics
-std::unordered_map<jlong, BufferMetrics> bufferMetrics;
+// Global registry to store buffer metrics
+BufferRegistry bufferMetrics;
+
+namespace {
+
+std::atomic<jint> nextCounterStripe(0);
+std::atomic<uint32_t> nextSampleSeed(0x9E3779B9u);
+
+} // namespace
+
+jint currentCounterStripe() {
+    static thread_local jint stripe = -1;
+    if (stripe < 0) {
+        stripe = nextCounterStripe.fetch_add(1, std::memory_order_relaxed) % kCounterStripes;
+    }
+    return stripe;
+}
+
+bool drawSample(jint period) {
+    // xorshift32, seeded per thread so threads do not draw in lockstep
+    static thread_local uint32_t state = 0;
+    if (state == 0) {
+        state = nextSampleSeed.fetch_add(0x9E3779B9u, std::memory_order_relaxed) | 1u;
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state & static_cast<uint32_t>(period - 1)) == 0;
+}
+
+BufferRegistry::BufferRegistry() : nextIndex(0), freeHead(0) {
+    for (jint i = 0; i < kMaxChunks; i++) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// Returns the slot for an index, or nullptr if its chunk was never allocated
+BufferMetrics* BufferRegistry::slotAt(jint index) const {
+    SlotChunk* chunk = chunks[index / kSlotsPerChunk].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    return &chunk->slots[index % kSlotsPerChunk];
+}
+
+// Allocates a chunk on first use; concurrent creators race with a CAS and the loser frees its copy.
+// Published chunks are never freed. Returns nullptr if the allocation fails.
+BufferMetrics* BufferRegistry::ensureChunk(jint chunkIndex) {
+    SlotChunk* chunk = chunks[chunkIndex].load(std::memory_order_acquire);
+    if (chunk != nullptr) {
+        return chunk->slots;
+    }
+
+    void* block = allocateCacheAligned(sizeof(SlotChunk));
+    if (block == nullptr) {
+        LOG_ERROR("Failed to allocate %u bytes for buffer registry chunk %d",
+                  static_cast<unsigned>(sizeof(SlotChunk)), chunkIndex);
+        return nullptr;
+    }
+    SlotChunk* fresh = new (block) SlotChunk();
+    for (jint slot = 0; slot < kSlotsPerChunk; slot++) {
+        fresh->slots[slot].counters = &fresh->cells[slot * kCounterStripes];
+    }
+
+    if (chunks[chunkIndex].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+        return fresh->slots;
+    }
+    freeCacheAligned(block);
+    return chunk->slots;
+}
+
+// Pops a recycled slot index, or returns -1 if the free list is empty
+jint BufferRegistry::popFree() {
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    while (true) {
+        jint top = static_cast<jint>(head & 0xFFFFFFFFu);
+        if (top == 0) {
+            return -1;
+        }
+        // Slots are never freed, so reading a link that is concurrently being
+        // rewritten is harmless: the tagged CAS below rejects the stale value
+        jint next = slotAt(top - 1)->nextFree.load(std::memory_order_relaxed);
+        uint64_t tag = (head >> 32) + 1;
+        uint64_t replacement = (tag << 32) | static_cast<uint32_t>(next);
+        if (freeHead.compare_exchange_weak(head, replacement, std::memory_order_acq_rel)) {
+            return top - 1;
+        }
+    }
+}
+
+void BufferRegistry::pushFree(jint index) {
+    BufferMetrics* metrics = slotAt(index);
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    while (true) {
+        metrics->nextFree.store(static_cast<jint>(head & 0xFFFFFFFFu), std::memory_order_relaxed);
+        uint64_t tag = (head >> 32) + 1;
+        uint64_t replacement = (tag << 32) | static_cast<uint32_t>(index + 1);
+        if (freeHead.compare_exchange_weak(head, replacement, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+}
+
+jlong BufferRegistry::create(jint capacity, jlong now) {
+    BufferMetrics* metrics = nullptr;
+    jint index = popFree();
+    if (index >= 0) {
+        metrics = slotAt(index);
+    } else {
+        index = nextIndex.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= kMaxSlots) {
+            return 0;
+        }
+        BufferMetrics* slots = ensureChunk(index / kSlotsPerChunk);
+        if (slots == nullptr) {
+            // Give the index back unless a later creator already took the next one;
+            // then the slot just stays unused, and find and forEach skip its missing chunk
+            jint taken = index + 1;
+            nextIndex.compare_exchange_strong(taken, index, std::memory_order_acq_rel);
+            return 0;
+        }
+        metrics = &slots[index % kSlotsPerChunk];
+    }
+
+    metrics->capacity.store(capacity, std::memory_order_relaxed);
+    metrics->size.store(0, std::memory_order_relaxed);
+    metrics->totalMemoryUsage.store(0, std::memory_order_relaxed);
+    metrics->creationTime.store(now, std::memory_order_relaxed);
+    metrics->lastUpdateTime.store(now, std::memory_order_relaxed);
+    metrics->resetCount(COUNTER_EMISSIONS);
+    metrics->resetCount(COUNTER_CONSUMPTIONS);
+    metrics->resetCount(COUNTER_SUSPENSIONS);
+    metrics->setSamplePeriod(0);
+    for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+        metrics->counters[stripe].entrySizeEstimate.store(0, std::memory_order_relaxed);
+    }
+    BufferLatency* latency = metrics->latency.load(std::memory_order_acquire);
+    if (latency != nullptr) {
+        latency->reset();
+    }
+    BufferHistory* history = metrics->history.load(std::memory_order_acquire);
+    if (history != nullptr) {
+        history->reset();
+    }
+
+    // A free slot carries an even generation; bumping it to odd publishes the buffer
+    uint32_t generation = metrics->generation.load(std::memory_order_relaxed) + 1;
+    metrics->generation.store(generation, std::memory_order_release);
+
+    return makeHandle(index, generation);
+}
+
+BufferMetrics* BufferRegistry::find(jlong bufferId) const {
+    jint index = indexOf(bufferId);
+    uint32_t generation = generationOf(bufferId);
+    if ((generation & 1u) == 0 || index < 0 || index >= kMaxSlots ||
+        index >= nextIndex.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    BufferMetrics* metrics = slotAt(index);
+    if (metrics == nullptr || metrics->generation.load(std::memory_order_acquire) != generation) {
+        return nullptr;
+    }
+    return metrics;
+}
+
+bool BufferRegistry::release(jlong bufferId) {
+    BufferMetrics* metrics = find(bufferId);
+    if (metrics == nullptr) {
+        return false;
+    }
+
+    // Only the caller that moves the generation from odd to even owns the slot,
+    // so a double release cannot push the same index twice. This does not make
+    // late updates harmless: a record call that looked the handle up just before
+    // this point still lands its update on the slot, and on the buffer that reuses
+    // it if create() republished the slot in between. Callers must release a
+    // handle only once nothing can use it, as TrackedBuffer does after draining.
+    uint32_t generation = generationOf(bufferId);
+    if (!metrics->generation.compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    detachBufferGroup(bufferId, metrics);
+    pushFree(indexOf(bufferId));
+    return true;
+}
+
+void BufferRegistry::clear() {
+    forEach([this](jlong bufferId, BufferMetrics&) {
+        release(bufferId);
+    });
+}
 
 // Initialize buffer tracking system
 void initializeBufferTracking() {
     bufferMetrics.clear();
-    std::cout << "[Native] Buffer tracking initialized" << std::endl;
+    LOG_INFO("Buffer tracking initialized");
 }
 
 // Create a new buffer with the specified capacity
 jlong createBuffer(jint capacity) {
     jlong now = getCurrentTimeMs();
-    jlong bufferId = now; // Use current time as buffer ID
-
-    // Initialize buffer metrics
-    BufferMetrics metrics;
-    metrics.capacity = capacity;
-    metrics.size = 0;
-    metrics.totalMemoryUsage = 0;
-    metrics.creationTime = now;
-    metrics.lastUpdateTime = now;
-    metrics.totalEmissions = 0;
-    metrics.totalConsumptions = 0;
-    metrics.totalSuspensions = 0;
-
-    // Store in global map
-    bufferMetrics[bufferId] = metrics;
-
-    std::cout << "[Native] Created buffer with id " << bufferId << " and capacity " << capacity << std::endl;
+    jlong bufferId = bufferMetrics.create(capacity, now);
+
+    if (bufferId == 0) {
+        LOG_WARN("Warning: Buffer registry is full or out of memory, cannot create buffer");
+        return 0;
+    }
+
+    LOG_DEBUG("Created buffer with id %lld and capacity %d", static_cast<long long>(bufferId), capacity);
     return bufferId;
 }
 
+// Release a buffer so its slot can be reused; the handle becomes stale immediately
+bool releaseBuffer(jlong bufferId) {
+    if (!bufferMetrics.release(bufferId)) {
+        LOG_WARN("Warning: Buffer %lld not found in releaseBuffer", static_cast<long long>(bufferId));
+        return false;
+    }
+
+    LOG_DEBUG("Released buffer %lld", static_cast<long long>(bufferId));
+    return true;
+}
+
 // Get the total memory usage for a specific buffer
 jlong getBufferMemoryUsage(jlong bufferId) {
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in getBufferMemoryUsage" << std::endl;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getBufferMemoryUsage", static_cast<long long>(bufferId));
         return 0;
     }
 
-    jlong totalMemory = it->second.totalMemoryUsage;
+    jlong totalMemory = metrics->totalMemoryUsage.load(std::memory_order_relaxed);
 
-    std::cout << "[Native] Buffer " << bufferId << " memory usage: "
-              << totalMemory << " bytes" << std::endl;
+    LOG_DEBUG("Buffer %lld memory usage: %lld bytes",
+              static_cast<long long>(bufferId), static_cast<long long>(totalMemory));
 
     return totalMemory;
 }
@@ -55,17 +255,16 @@ jlong getBufferMemoryUsage(jlong bufferId) {
 // Get the current size (number of entries) for a specific buffer
 jint getBufferSize(jlong bufferId) {
     // Check if the buffer exists
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in getBufferSize" << std::endl;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getBufferSize", static_cast<long long>(bufferId));
         return 0;
     }
 
     // Return the size from metrics
-    jint size = it->second.size;
+    jint size = metrics->size.load(std::memory_order_relaxed);
 
-    std::cout << "[Native] Buffer " << bufferId << " size: "
-              << size << " entries" << std::endl;
+    LOG_DEBUG("Buffer %lld size: %d entries", static_cast<long long>(bufferId), size);
 
     return size;
 }
@@ -75,106 +274,221 @@ void updateBufferMetrics(jlong bufferId, jint size, jlong memoryUsage) {
     jlong now = getCurrentTimeMs();
 
     // Check if the buffer exists
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in updateBufferMetrics, creating it" << std::endl;
-        // Create a new buffer with default capacity
-        BufferMetrics metrics;
-        metrics.capacity = 20; // Default capacity
-        metrics.size = size;
-        metrics.totalMemoryUsage = memoryUsage;
-        metrics.creationTime = now;
-        metrics.lastUpdateTime = now;
-        metrics.totalEmissions = 0;
-        metrics.totalConsumptions = 0;
-        metrics.totalSuspensions = 0;
-        bufferMetrics[bufferId] = metrics;
-    } else {
-        // Update existing buffer metrics
-        BufferMetrics& metrics = it->second;
-        metrics.size = size;
-        metrics.totalMemoryUsage = memoryUsage;
-        metrics.lastUpdateTime = now;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in updateBufferMetrics", static_cast<long long>(bufferId));
+        return;
+    }
+
+    // Update existing buffer metrics
+    jint previousSize = metrics->size.exchange(size, std::memory_order_relaxed);
+    jlong previousMemory = metrics->totalMemoryUsage.exchange(memoryUsage, std::memory_order_relaxed);
+    metrics->addToGroups(GROUP_SIZE, size - previousSize);
+    metrics->addToGroups(GROUP_MEMORY, memoryUsage - previousMemory);
+    if (metrics->trackingWeight() == 0) {
+        return;
     }
+    metrics->lastUpdateTime.store(now, std::memory_order_relaxed);
+    recordHistorySample(metrics, now, size, memoryUsage);
 
-    std::cout << "[Native] Updated metrics for buffer " << bufferId
-              << ", size: " << size << " entries"
-              << ", memory: " << memoryUsage << " bytes" << std::endl;
+    LOG_DEBUG("Updated metrics for buffer %lld, size: %d entries, memory: %lld bytes",
+              static_cast<long long>(bufferId), size, static_cast<long long>(memoryUsage));
 }
 
 // Record an emission event for a specific buffer
 void recordEmission(jlong bufferId) {
     // Check if the buffer exists
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in recordEmission" << std::endl;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in recordEmission", static_cast<long long>(bufferId));
         return;
     }
 
     // Increment emission counter
-    BufferMetrics& metrics = it->second;
-    metrics.totalEmissions++;
+    jint weight = metrics->trackingWeight();
+    if (weight == 0) {
+        return;
+    }
+    metrics->addCount(COUNTER_EMISSIONS, weight);
+    observeBackpressure(bufferId, metrics, 0);
 
-    std::cout << "[Native] Recorded emission for buffer " << bufferId
-              << ", total emissions: " << metrics.totalEmissions << std::endl;
+    LOG_DEBUG("Recorded emission for buffer %lld", static_cast<long long>(bufferId));
 }
 
 // Record a consumption event for a specific buffer
 void recordConsumption(jlong bufferId) {
     // Check if the buffer exists
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in recordConsumption" << std::endl;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in recordConsumption", static_cast<long long>(bufferId));
         return;
     }
 
     // Increment consumption counter
-    BufferMetrics& metrics = it->second;
-    metrics.totalConsumptions++;
+    jint weight = metrics->trackingWeight();
+    if (weight == 0) {
+        return;
+    }
+    metrics->addCount(COUNTER_CONSUMPTIONS, weight);
+    observeBackpressure(bufferId, metrics, 0);
 
-    std::cout << "[Native] Recorded consumption for buffer " << bufferId
-              << ", total consumptions: " << metrics.totalConsumptions << std::endl;
+    LOG_DEBUG("Recorded consumption for buffer %lld", static_cast<long long>(bufferId));
 }
 
-// Get the total number of emissions across all buffers
-jint getTotalEmissions() {
-    jint total = 0;
-    for (const auto& pair : bufferMetrics) {
-        total += pair.second.totalEmissions;
+// Fused emission bookkeeping: counts the emission, reserves the entry's slot and
+// memory, and counts a suspension when the buffer was already full. Returns
+// true if the producer is expected to suspend. A weight above 1 comes from a
+// sampled call in sampled mode and counts the emission that many times.
+bool recordEmit(jlong bufferId, jlong entrySize, jint weight) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in recordEmit", static_cast<long long>(bufferId));
+        return false;
     }
+
+    jint previousSize = metrics->size.fetch_add(1, std::memory_order_relaxed);
+    jint capacity = metrics->capacity.load(std::memory_order_relaxed);
+    bool suspends = previousSize >= capacity;
+    if (suspends) {
+        metrics->addCount(COUNTER_SUSPENSIONS, 1);
+        recordBufferEvent(EVENT_SUSPEND, bufferId, previousSize, capacity, 0);
+        sampleSuspensionStack(bufferId);
+    }
+    metrics->addCount(COUNTER_EMISSIONS, weight);
+    metrics->counters[currentCounterStripe()].entrySizeEstimate.store(entrySize, std::memory_order_relaxed);
+    jlong memoryUsage = metrics->totalMemoryUsage.fetch_add(entrySize, std::memory_order_relaxed) + entrySize;
+    metrics->addToGroups(GROUP_SIZE, 1);
+    metrics->addToGroups(GROUP_MEMORY, entrySize);
+    jlong now = getCurrentTimeMs();
+    metrics->lastUpdateTime.store(now, std::memory_order_relaxed);
+    recordHistorySample(metrics, now, previousSize + 1, memoryUsage);
+    observeBackpressure(bufferId, metrics, now);
+
+    LOG_DEBUG("Recorded emit for buffer %lld, size: %d/%d, entry: %lld bytes%s",
+              static_cast<long long>(bufferId), previousSize + 1, capacity,
+              static_cast<long long>(entrySize), suspends ? ", producer suspends" : "");
+    return suspends;
+}
+
+// Emission bookkeeping for a call that getTrackingWeight skipped in sampled
+// mode: the slot is still reserved and a suspension still counted, but the
+// entry is charged the size last measured on this stripe instead of being
+// measured, which the caller must pass back on consume. Returns that size.
+jlong recordSkippedEmit(jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        return 0;
+    }
+
+    jint previousSize = metrics->size.fetch_add(1, std::memory_order_relaxed);
+    jint capacity = metrics->capacity.load(std::memory_order_relaxed);
+    if (previousSize >= capacity) {
+        metrics->addCount(COUNTER_SUSPENSIONS, 1);
+        recordBufferEvent(EVENT_SUSPEND, bufferId, previousSize, capacity, 0);
+        sampleSuspensionStack(bufferId);
+    }
+    jlong entrySize = metrics->counters[currentCounterStripe()].entrySizeEstimate.load(std::memory_order_relaxed);
+    metrics->totalMemoryUsage.fetch_add(entrySize, std::memory_order_relaxed);
+    metrics->addToGroups(GROUP_SIZE, 1);
+    metrics->addToGroups(GROUP_MEMORY, entrySize);
+    return entrySize;
+}
+
+// Weight of the next emit on a buffer, see BufferMetrics::trackingWeight; 1 for unknown buffers
+jint getTrackingWeight(jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    return metrics != nullptr ? metrics->trackingWeight() : 1;
+}
+
+// Fused consumption bookkeeping: counts the consumption, releases the entry's slot
+// and memory, and records how long the entry stayed in the buffer (skipped if negative)
+void recordConsume(jlong bufferId, jlong entrySize, jlong residencyNanos) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in recordConsume", static_cast<long long>(bufferId));
+        return;
+    }
+
+    // In sampled mode a skipped call only releases the slot and memory
+    jint weight = metrics->trackingWeight();
+    jint previousSize = metrics->size.fetch_sub(1, std::memory_order_relaxed);
+    jlong memoryUsage = metrics->totalMemoryUsage.fetch_sub(entrySize, std::memory_order_relaxed) - entrySize;
+    metrics->addToGroups(GROUP_SIZE, -1);
+    metrics->addToGroups(GROUP_MEMORY, -entrySize);
+    if (weight == 0) {
+        return;
+    }
+    metrics->addCount(COUNTER_CONSUMPTIONS, weight);
+    jlong now = getCurrentTimeMs();
+    metrics->lastUpdateTime.store(now, std::memory_order_relaxed);
+    recordHistorySample(metrics, now, previousSize - 1, memoryUsage);
+    observeBackpressure(bufferId, metrics, now);
+    if (residencyNanos >= 0) {
+        recordLatencySample(metrics, LATENCY_RESIDENCY, residencyNanos);
+    }
+
+    LOG_DEBUG("Recorded consume for buffer %lld, size: %d, entry: %lld bytes",
+              static_cast<long long>(bufferId), previousSize - 1, static_cast<long long>(entrySize));
+}
+
+// Rolls back a recordEmit whose send never completed (cancelled or closed channel)
+void cancelEmit(jlong bufferId, jlong entrySize) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        return;
+    }
+
+    // Drawn like the emit it undoes, so scaled counts stay unbiased in sampled mode
+    metrics->addCount(COUNTER_EMISSIONS, -metrics->trackingWeight());
+    jint previousSize = metrics->size.fetch_sub(1, std::memory_order_relaxed);
+    jlong memoryUsage = metrics->totalMemoryUsage.fetch_sub(entrySize, std::memory_order_relaxed) - entrySize;
+    metrics->addToGroups(GROUP_SIZE, -1);
+    metrics->addToGroups(GROUP_MEMORY, -entrySize);
+    recordHistorySample(metrics, getCurrentTimeMs(), previousSize - 1, memoryUsage);
+
+    LOG_DEBUG("Cancelled emit for buffer %lld", static_cast<long long>(bufferId));
+}
+
+// Get the total number of emissions across all buffers
+jlong getTotalEmissions() {
+    jlong total = 0;
+    bufferMetrics.forEach([&total](jlong, const BufferMetrics& metrics) {
+        total += metrics.count(COUNTER_EMISSIONS);
+    });
     return total;
 }
 
 // Get the total number of consumptions across all buffers
-jint getTotalConsumptions() {
-    jint total = 0;
-    for (const auto& pair : bufferMetrics) {
-        total += pair.second.totalConsumptions;
-    }
+jlong getTotalConsumptions() {
+    jlong total = 0;
+    bufferMetrics.forEach([&total](jlong, const BufferMetrics& metrics) {
+        total += metrics.count(COUNTER_CONSUMPTIONS);
+    });
     return total;
 }
 
 // Get the number of emissions for a specific buffer
-jint getBufferEmissions(jlong bufferId) {
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in getBufferEmissions" << std::endl;
+jlong getBufferEmissions(jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getBufferEmissions", static_cast<long long>(bufferId));
         return 0;
     }
-    return it->second.totalEmissions;
+    return metrics->count(COUNTER_EMISSIONS);
 }
 
 // Get the number of consumptions for a specific buffer
-jint getBufferConsumptions(jlong bufferId) {
-    auto it = bufferMetrics.find(bufferId);
-    if (it == bufferMetrics.end()) {
-        std::cout << "[Native] Warning: Buffer " << bufferId << " not found in getBufferConsumptions" << std::endl;
+jlong getBufferConsumptions(jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getBufferConsumptions", static_cast<long long>(bufferId));
         return 0;
     }
-    return it->second.totalConsumptions;
+    return metrics->count(COUNTER_CONSUMPTIONS);
 }
 
 // Clear all buffer tracking data
 void clearTracking() {
     bufferMetrics.clear();
+    clearBufferGroups();
 }
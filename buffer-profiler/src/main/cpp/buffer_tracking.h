@@ -2,37 +2,238 @@
 #define BUFFER_TRACKING_H
 
 #include <jni.h>
-#include <vector>
-#include <unordered_map>
-#include <mutex>
-
-// Data structures for buffer tracking
-struct BufferMetrics {
-    jint capacity;          // Maximum capacity of the buffer
-    jint size;              // Current number of entries
-    jlong totalMemoryUsage; // Total memory usage of all entries
-    jlong creationTime;     // When the buffer was created
-    jlong lastUpdateTime;   // Last time the buffer was updated
-    jint totalEmissions;    // Total number of items emitted
-    jint totalConsumptions; // Total number of items consumed
-    jint totalSuspensions;  // Total number of suspensions
+#include <atomic>
+#include <cstdint>
+
+struct BufferLatency;
+class BufferHistory;
+struct BufferGroup;
+
+static const jint kCacheLineSize = 64;
+
+// Event counters of a buffer, kept off the metrics line
+enum CounterKind {
+    COUNTER_EMISSIONS = 0,
+    COUNTER_CONSUMPTIONS = 1,
+    COUNTER_SUSPENSIONS = 2
+};
+
+static const jint kCounterKinds = 3;
+
+// Each buffer spreads its counters over kCounterStripes cells, one cache line each.
+// A thread always increments the same stripe, so producers and consumers on
+// different cores stop bouncing a shared line; reads sum the stripes.
+static const jint kCounterStripes = 8;
+
+// Totals a buffer group keeps for its buffers; the counter fields match CounterKind
+enum GroupField {
+    GROUP_EMISSIONS = COUNTER_EMISSIONS,
+    GROUP_CONSUMPTIONS = COUNTER_CONSUMPTIONS,
+    GROUP_SUSPENSIONS = COUNTER_SUSPENSIONS,
+    GROUP_SIZE = 3,
+    GROUP_MEMORY = 4
+};
+
+static const jint kGroupFields = 5;
+
+// Longest sample period of a buffer in sampled mode, see overhead.h
+static const jint kMaxSamplePeriod = 1024;
+
+struct alignas(kCacheLineSize) CounterCell {
+    std::atomic<jlong> values[kCounterKinds];
+    std::atomic<BufferGroup*> group;       // Same in every stripe, so an update reads it from the line it writes
+    std::atomic<jlong> entrySizeEstimate;  // Last entry size measured on this stripe, charged by skipped emits
+    std::atomic<jint> samplePeriod;        // Same in every stripe; 0 or 1 while the buffer is tracked exactly
+};
+
+// Stripe of the calling thread, assigned round-robin on its first increment
+jint currentCounterStripe();
+
+// True for about one call in period (a power of two), drawn from a per-thread generator
+bool drawSample(jint period);
+
+// Adds delta to a group and every ancestor on the given stripe, see buffer_groups.h
+void addToGroupTotals(BufferGroup* group, jint field, jlong delta, jint stripe);
+
+// Data structures for buffer tracking.
+// Every field is atomic so producers, consumers and readers can touch a buffer
+// concurrently without a global lock. The struct fills exactly one cache line,
+// so neighbouring slots never share one and a registry walk reads one line per buffer.
+struct alignas(kCacheLineSize) BufferMetrics {
+    std::atomic<jint> capacity;          // Maximum capacity of the buffer
+    std::atomic<jint> size;              // Current number of entries
+    std::atomic<jlong> totalMemoryUsage; // Total memory usage of all entries
+    std::atomic<jlong> creationTime;     // When the buffer was created
+    std::atomic<jlong> lastUpdateTime;   // Last time the buffer was updated
+    std::atomic<uint32_t> generation;    // Odd while the slot holds a live buffer, even while free
+    std::atomic<jint> nextFree;          // Free-list link (slot index + 1, 0 terminates)
+    std::atomic<BufferLatency*> latency; // Latency histograms, allocated on the first sample
+    std::atomic<BufferHistory*> history; // Size and memory time series, allocated on the first sample
+    CounterCell* counters;               // kCounterStripes cells, fixed before the slot's chunk is published
+
+    void addCount(CounterKind kind, jlong delta) {
+        jint stripe = currentCounterStripe();
+        CounterCell& cell = counters[stripe];
+        cell.values[kind].fetch_add(delta, std::memory_order_relaxed);
+        BufferGroup* group = cell.group.load(std::memory_order_relaxed);
+        if (group != nullptr) {
+            addToGroupTotals(group, kind, delta, stripe);
+        }
+    }
+
+    // Carries a size or memory change the caller made on this buffer to its group
+    void addToGroups(GroupField field, jlong delta) {
+        jint stripe = currentCounterStripe();
+        BufferGroup* group = counters[stripe].group.load(std::memory_order_relaxed);
+        if (group != nullptr) {
+            addToGroupTotals(group, field, delta, stripe);
+        }
+    }
+
+    // Weight of the calling thread's update: 1 while the buffer is tracked
+    // exactly. In sampled mode it is the sample period for the one call in
+    // period that does the full bookkeeping, scaling its counts so they stay
+    // unbiased, and 0 for the calls that skip it.
+    jint trackingWeight() const {
+        jint period = counters[currentCounterStripe()].samplePeriod.load(std::memory_order_relaxed);
+        if (period <= 1) {
+            return 1;
+        }
+        return drawSample(period) ? period : 0;
+    }
+
+    jint samplePeriod() const {
+        return counters[0].samplePeriod.load(std::memory_order_relaxed);
+    }
+
+    void setSamplePeriod(jint period) {
+        for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+            counters[stripe].samplePeriod.store(period, std::memory_order_relaxed);
+        }
+    }
+
+    jlong count(CounterKind kind) const {
+        jlong total = 0;
+        for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+            total += counters[stripe].values[kind].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void resetCount(CounterKind kind) {
+        jlong total = 0;
+        for (jint stripe = 0; stripe < kCounterStripes; stripe++) {
+            total += counters[stripe].values[kind].exchange(0, std::memory_order_relaxed);
+        }
+        addToGroups(static_cast<GroupField>(kind), -total);
+    }
+};
+
+static_assert(sizeof(BufferMetrics) == kCacheLineSize, "BufferMetrics should fill exactly one cache line");
+
+// Concurrent registry of buffer metrics.
+// Buffers live in a slot array that grows in fixed-size chunks. A buffer ID is a
+// generation-tagged handle: the low 32 bits hold the dense slot index and the
+// high 32 bits the slot generation, so lookups are a bounds check, two array
+// reads and a generation compare. Released slots go onto a lock-free free list
+// and are reused under a new generation, which turns any stale handle into a
+// miss. Chunks are published with a CAS and never released, which lets the
+// record and query paths run without taking any lock.
+class BufferRegistry {
+public:
+    static const jint kSlotsPerChunk = 1024;
+    static const jint kMaxChunks = 1024;
+    static const jint kMaxSlots = kSlotsPerChunk * kMaxChunks;
+
+    BufferRegistry();
+
+    // Claims a slot and returns its buffer handle, or 0 if the registry is full or
+    // its next chunk cannot be allocated
+    jlong create(jint capacity, jlong now);
+
+    // Returns the metrics of a live buffer, or nullptr if the handle is unknown or stale
+    BufferMetrics* find(jlong bufferId) const;
+
+    // Retires a handle and returns its slot to the free list; false if it was not live
+    bool release(jlong bufferId);
+
+    // Releases every live buffer
+    void clear();
+
+    static jint indexOf(jlong bufferId) {
+        return static_cast<jint>(static_cast<uint64_t>(bufferId) & 0xFFFFFFFFu);
+    }
+
+    static uint32_t generationOf(jlong bufferId) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(bufferId) >> 32);
+    }
+
+    static jlong makeHandle(jint index, uint32_t generation) {
+        return static_cast<jlong>((static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(index));
+    }
+
+    // Visits every live buffer in slot order. Slots are walked chunk by chunk as
+    // a flat array, so the walk is sequential and needs no per-slot chunk lookup.
+    template <typename Visitor>
+    void forEach(Visitor visitor) const {
+        jint highWater = nextIndex.load(std::memory_order_acquire);
+        if (highWater > kMaxSlots) {
+            highWater = kMaxSlots;
+        }
+        for (jint chunkStart = 0; chunkStart < highWater; chunkStart += kSlotsPerChunk) {
+            SlotChunk* chunk = chunks[chunkStart / kSlotsPerChunk].load(std::memory_order_acquire);
+            if (chunk == nullptr) {
+                continue;
+            }
+            BufferMetrics* slots = chunk->slots;
+            jint count = highWater - chunkStart < kSlotsPerChunk ? highWater - chunkStart : kSlotsPerChunk;
+            for (jint offset = 0; offset < count; offset++) {
+                uint32_t generation = slots[offset].generation.load(std::memory_order_acquire);
+                if ((generation & 1u) != 0) {
+                    visitor(makeHandle(chunkStart + offset, generation), slots[offset]);
+                }
+            }
+        }
+    }
+
+private:
+    // Slots and their counter cells, in one cache-line aligned allocation
+    struct SlotChunk {
+        BufferMetrics slots[kSlotsPerChunk];
+        CounterCell cells[kSlotsPerChunk * kCounterStripes];
+    };
+
+    BufferMetrics* slotAt(jint index) const;
+    BufferMetrics* ensureChunk(jint chunkIndex);
+    jint popFree();
+    void pushFree(jint index);
+
+    std::atomic<SlotChunk*> chunks[kMaxChunks];
+    std::atomic<jint> nextIndex;
+    std::atomic<uint64_t> freeHead; // ABA tag in the high 32 bits, slot index + 1 in the low 32 bits
 };
 
 // Function declarations
 void initializeBufferTracking();
 jlong createBuffer(jint capacity);
+bool releaseBuffer(jlong bufferId);
 jlong getBufferMemoryUsage(jlong bufferId);
 jint getBufferSize(jlong bufferId);
 void updateBufferMetrics(jlong bufferId, jint size, jlong memoryUsage);
 void recordEmission(jlong bufferId);
 void recordConsumption(jlong bufferId);
-jint getTotalEmissions();
-jint getTotalConsumptions();
-jint getBufferEmissions(jlong bufferId);
-jint getBufferConsumptions(jlong bufferId);
+bool recordEmit(jlong bufferId, jlong entrySize, jint weight = 1);
+jlong recordSkippedEmit(jlong bufferId);
+jint getTrackingWeight(jlong bufferId);
+void recordConsume(jlong bufferId, jlong entrySize, jlong residencyNanos);
+void cancelEmit(jlong bufferId, jlong entrySize);
+jlong getTotalEmissions();
+jlong getTotalConsumptions();
+jlong getBufferEmissions(jlong bufferId);
+jlong getBufferConsumptions(jlong bufferId);
 void clearTracking();
 
 // Extern declaration for global buffer state
-extern std::unordered_map<jlong, BufferMetrics> bufferMetrics;
+extern BufferRegistry bufferMetrics;
 
 #endif /* BUFFER_TRACKING_H */
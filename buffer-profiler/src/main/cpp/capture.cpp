@@ -0,0 +1,502 @@
+#include "capture.h"
+#include "capture_format.h"
+#include "buffer_tracking.h"
+#include "mpmc_queue.h"
+#include "utils.h"
+#include "logging.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const jint kDefaultSnapshotIntervalMillis = 1000;
+const jint kMinSnapshotIntervalMillis = 1;
+const int kWriteIntervalMillis = 10;
+const size_t kEventQueueCapacity = 65536;
+const uint32_t kMaxThreadNameBytes = 256;
+const size_t kMaxRepeatedThreadNames = 1024;
+
+// The repeated names always fit in a fresh chunk, so writing them never starts another
+static_assert(kMaxRepeatedThreadNames * (sizeof(CaptureRecordHeader) + sizeof(CaptureThreadName) + kMaxThreadNameBytes) <=
+                  kCaptureDefaultChunkBytes / 2,
+              "Repeated thread names must fit in a chunk");
+
+std::atomic<bool> capturing(false);
+std::atomic<jlong> queuedDropped(0);
+std::atomic<jlong> ringDroppedAtStart(0); // getDroppedEventCount when the capture started
+
+MpmcQueue<BufferEvent>& eventQueue() {
+    // Never destroyed, so an aggregator drain during unload cannot touch a freed queue
+    static MpmcQueue<BufferEvent>* queue = new MpmcQueue<BufferEvent>(kEventQueueCapacity);
+    return *queue;
+}
+
+// Append-only writer for one capture file; used by the writer thread only
+class CaptureFile {
+public:
+    CaptureFile() : bytesWritten(0), chunkCount(0), eventCount(0), snapshotCount(0), lostEvents(0), fd(-1),
+                    chunkBytes(kCaptureDefaultChunkBytes), chunk(nullptr), failed(false) {}
+
+    bool open(const std::string& path, jint snapshotIntervalMillis) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            LOG_ERROR("Could not create %s: %s", path.c_str(), strerror(errno));
+            return false;
+        }
+
+        CaptureFileHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = kCaptureMagic;
+        header.version = kCaptureVersion;
+        header.chunkBytes = chunkBytes;
+        header.snapshotIntervalMillis = static_cast<uint32_t>(snapshotIntervalMillis);
+        header.pid = static_cast<int64_t>(getpid());
+        header.startTime = getCurrentTimeMs();
+        header.startWallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+            LOG_ERROR("Could not write %s: %s", path.c_str(), strerror(errno));
+            ::close(fd);
+            unlink(path.c_str());
+            fd = -1;
+            return false;
+        }
+        bytesWritten.store(kCaptureDataOffset, std::memory_order_relaxed);
+        return true;
+    }
+
+    void appendEvent(const BufferEvent& event) {
+        CaptureEvent record;
+        record.type = event.type;
+        record.size = event.size;
+        record.capacity = event.capacity;
+        record.reserved = 0;
+        record.bufferId = event.bufferId;
+        record.threadId = event.threadId;
+        record.timestamp = event.timestamp;
+        record.value = event.value;
+        if (append(CAPTURE_RECORD_EVENT, &record, sizeof(record), nullptr, 0, event.timestamp)) {
+            eventCount.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            lostEvents.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Every chunk repeats the most recent kMaxRepeatedThreadNames names, so a
+    // reader can skip earlier chunks without losing the names of active threads
+    void appendThreadName(jlong threadId, const std::string& name) {
+        ThreadName threadName(threadId, name.substr(0, kMaxThreadNameBytes));
+        writeThreadName(threadName);
+        threadNames.push_back(threadName);
+        if (threadNames.size() > kMaxRepeatedThreadNames) {
+            threadNames.pop_front();
+        }
+    }
+
+    // Writes the rows as one snapshot, split into as many records as the chunks require
+    void appendSnapshot(jlong now, const std::vector<CaptureBufferRow>& rows) {
+        CaptureSnapshotHeader header;
+        header.timestamp = now;
+        header.sequence = static_cast<uint32_t>(snapshotCount.load(std::memory_order_relaxed));
+        size_t written = 0;
+        do {
+            uint32_t fit = rowsThatFit();
+            if (fit == 0) {
+                if (!startChunk()) {
+                    return;
+                }
+                fit = rowsThatFit();
+            }
+            size_t remaining = rows.size() - written;
+            header.rowCount = static_cast<uint32_t>(remaining < fit ? remaining : fit);
+            if (!append(CAPTURE_RECORD_SNAPSHOT, &header, sizeof(header),
+                        rows.empty() ? nullptr : &rows[written], header.rowCount * sizeof(CaptureBufferRow), now)) {
+                return;
+            }
+            written += header.rowCount;
+        } while (written < rows.size());
+        snapshotCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Writes the index and footer after the last chunk's records and closes the file
+    void close(jlong droppedEvents) {
+        if (fd < 0) {
+            return;
+        }
+        finishChunk();
+        int64_t indexOffset = kCaptureDataOffset;
+        if (!index.empty()) {
+            const CaptureIndexEntry& last = index.back();
+            indexOffset = last.offset + last.usedBytes;
+        }
+        indexOffset = (indexOffset + 7) & ~static_cast<int64_t>(7);
+
+        CaptureFooter footer;
+        footer.magic = kCaptureFooterMagic;
+        footer.chunkCount = static_cast<uint32_t>(index.size());
+        footer.indexOffset = indexOffset;
+        footer.endTime = getCurrentTimeMs();
+        footer.droppedEvents = droppedEvents;
+
+        size_t indexBytes = index.size() * sizeof(CaptureIndexEntry);
+        bool written = (indexBytes == 0 ||
+                        pwrite(fd, index.data(), indexBytes, indexOffset) == static_cast<ssize_t>(indexBytes)) &&
+                       pwrite(fd, &footer, sizeof(footer), indexOffset + static_cast<int64_t>(indexBytes)) ==
+                           static_cast<ssize_t>(sizeof(footer));
+        int64_t end = indexOffset + static_cast<int64_t>(indexBytes) + static_cast<int64_t>(sizeof(footer));
+        if (!written || ftruncate(fd, static_cast<off_t>(end)) != 0) {
+            LOG_WARN("Could not write the capture index: %s", strerror(errno));
+        } else {
+            bytesWritten.store(end, std::memory_order_relaxed);
+        }
+        ::close(fd);
+        fd = -1;
+    }
+
+    // Read by getCaptureStatus while the writer runs
+    std::atomic<jlong> bytesWritten;
+    std::atomic<jlong> chunkCount;
+    std::atomic<jlong> eventCount;
+    std::atomic<jlong> snapshotCount;
+    std::atomic<jlong> lostEvents;
+
+private:
+    typedef std::pair<jlong, std::string> ThreadName;
+
+    void writeThreadName(const ThreadName& name) {
+        CaptureThreadName record;
+        record.threadId = name.first;
+        record.length = static_cast<uint32_t>(name.second.size());
+        record.reserved = 0;
+        append(CAPTURE_RECORD_THREAD_NAME, &record, sizeof(record), name.second.data(), record.length, 0);
+    }
+
+    uint32_t rowsThatFit() const {
+        if (chunk == nullptr) {
+            return 0;
+        }
+        uint32_t overhead = captureRecordBytes(sizeof(CaptureSnapshotHeader));
+        uint32_t remaining = chunkBytes - chunk->usedBytes;
+        return remaining > overhead ? (remaining - overhead) / sizeof(CaptureBufferRow) : 0;
+    }
+
+    // Copies a record into the current chunk, starting a new chunk if it does not fit.
+    // A time of 0 leaves the chunk's time range alone.
+    bool append(CaptureRecordType type, const void* fixed, size_t fixedBytes, const void* tail, size_t tailBytes,
+                int64_t time) {
+        uint32_t payloadBytes = static_cast<uint32_t>(fixedBytes + tailBytes);
+        uint32_t recordBytes = captureRecordBytes(payloadBytes);
+        if (failed || recordBytes > chunkBytes - sizeof(CaptureChunkHeader)) {
+            return false;
+        }
+        if ((chunk == nullptr || chunkBytes - chunk->usedBytes < recordBytes) && !startChunk()) {
+            return false;
+        }
+
+        char* position = reinterpret_cast<char*>(chunk) + chunk->usedBytes;
+        CaptureRecordHeader header;
+        header.type = static_cast<uint16_t>(type);
+        header.reserved = 0;
+        header.bytes = payloadBytes;
+        memcpy(position, &header, sizeof(header));
+        memcpy(position + sizeof(header), fixed, fixedBytes);
+        if (tailBytes > 0) {
+            memcpy(position + sizeof(header) + fixedBytes, tail, tailBytes);
+        }
+        memset(position + sizeof(header) + payloadBytes, 0, recordBytes - sizeof(header) - payloadBytes);
+
+        // The record is complete before usedBytes covers it, so a crash leaves a valid prefix
+        std::atomic_thread_fence(std::memory_order_release);
+        if (time != 0 && (chunk->firstTime == 0 || time < chunk->firstTime)) {
+            chunk->firstTime = time;
+        }
+        if (time > chunk->lastTime) {
+            chunk->lastTime = time;
+        }
+        chunk->recordCount++;
+        chunk->usedBytes += recordBytes;
+        bytesWritten.fetch_add(recordBytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool startChunk() {
+        finishChunk();
+        uint32_t chunkIndex = static_cast<uint32_t>(index.size());
+        int64_t offset = captureChunkOffset(chunkBytes, chunkIndex);
+
+        // Reserve the blocks up front: touching a mapped page past a full disk raises SIGBUS
+#if defined(__linux__)
+        int reserved = posix_fallocate(fd, static_cast<off_t>(offset), chunkBytes);
+#else
+        int reserved = ftruncate(fd, static_cast<off_t>(offset + chunkBytes)) == 0 ? 0 : errno;
+#endif
+        if (reserved != 0) {
+            LOG_ERROR("Capture stopped growing at chunk %u: %s", chunkIndex, strerror(reserved));
+            failed = true;
+            return false;
+        }
+        void* mapped = mmap(nullptr, chunkBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("Could not map capture chunk %u: %s", chunkIndex, strerror(errno));
+            failed = true;
+            return false;
+        }
+
+        chunk = static_cast<CaptureChunkHeader*>(mapped);
+        memset(chunk, 0, sizeof(CaptureChunkHeader));
+        chunk->index = chunkIndex;
+        chunk->usedBytes = sizeof(CaptureChunkHeader);
+        std::atomic_thread_fence(std::memory_order_release);
+        chunk->magic = kCaptureChunkMagic;
+        chunkCount.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < threadNames.size(); i++) {
+            writeThreadName(threadNames[i]);
+        }
+        return true;
+    }
+
+    void finishChunk() {
+        if (chunk == nullptr) {
+            return;
+        }
+        CaptureIndexEntry entry;
+        entry.offset = captureChunkOffset(chunkBytes, chunk->index);
+        entry.usedBytes = chunk->usedBytes;
+        entry.recordCount = chunk->recordCount;
+        entry.firstTime = chunk->firstTime;
+        entry.lastTime = chunk->lastTime;
+        index.push_back(entry);
+        munmap(chunk, chunkBytes);
+        chunk = nullptr;
+    }
+
+    int fd;
+    uint32_t chunkBytes;
+    CaptureChunkHeader* chunk; // Mapped chunk being filled, nullptr before the first record
+    std::vector<CaptureIndexEntry> index;
+    std::deque<ThreadName> threadNames; // Most recent names, repeated at the start of each chunk
+    bool failed;
+};
+
+struct CaptureState {
+    CaptureState() : file(nullptr), writer(nullptr), stopRequested(false), snapshotIntervalMillis(0), last() {}
+
+    CaptureFile* file;
+    std::string path;
+    std::thread* writer; // Heap-allocated so a running thread never reaches a static destructor
+    bool stopRequested;
+    jint snapshotIntervalMillis;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    CaptureStatus last; // Status of the most recent capture after it stopped
+};
+
+CaptureState& captureState() {
+    static CaptureState* state = new CaptureState();
+    return *state;
+}
+
+// Appends the queued events, preceded by the name of each thread the first time it appears
+void writeEvents(CaptureFile& file, std::unordered_set<jlong>& namedThreads) {
+    MpmcQueue<BufferEvent>& queue = eventQueue();
+    BufferEvent event;
+    while (queue.tryPop(event)) {
+        if (namedThreads.insert(event.threadId).second) {
+            std::string name = getEventThreadName(event.threadId);
+            if (!name.empty()) {
+                file.appendThreadName(event.threadId, name);
+            }
+        }
+        file.appendEvent(event);
+    }
+}
+
+void writeSnapshot(CaptureFile& file, std::vector<CaptureBufferRow>& rows) {
+    rows.clear();
+    bufferMetrics.forEach([&rows](jlong bufferId, const BufferMetrics& metrics) {
+        CaptureBufferRow row;
+        row.bufferId = bufferId;
+        row.memoryUsage = metrics.totalMemoryUsage.load(std::memory_order_relaxed);
+        row.emissions = metrics.count(COUNTER_EMISSIONS);
+        row.consumptions = metrics.count(COUNTER_CONSUMPTIONS);
+        row.suspensions = metrics.count(COUNTER_SUSPENSIONS);
+        row.lastUpdateTime = metrics.lastUpdateTime.load(std::memory_order_relaxed);
+        row.capacity = metrics.capacity.load(std::memory_order_relaxed);
+        row.size = metrics.size.load(std::memory_order_relaxed);
+        rows.push_back(row);
+    });
+    file.appendSnapshot(getCurrentTimeMs(), rows);
+}
+
+void writerLoop(CaptureFile* file, jint snapshotIntervalMillis) {
+    CaptureState& state = captureState();
+    std::unordered_set<jlong> namedThreads;
+    std::vector<CaptureBufferRow> rows;
+    const jlong snapshotInterval = static_cast<jlong>(snapshotIntervalMillis) * 1000000;
+    jlong nextSnapshot = getCurrentTimeMs();
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.stopRequested) {
+        lock.unlock();
+        writeEvents(*file, namedThreads);
+        jlong now = getCurrentTimeMs();
+        if (now >= nextSnapshot) {
+            writeSnapshot(*file, rows);
+            nextSnapshot = now + snapshotInterval;
+        }
+        lock.lock();
+        state.wakeUp.wait_for(lock, std::chrono::milliseconds(kWriteIntervalMillis),
+                              [&state] { return state.stopRequested; });
+    }
+    lock.unlock();
+
+    // The caller flushed the event rings before stopping, so this also covers the last events
+    writeEvents(*file, namedThreads);
+    writeSnapshot(*file, rows);
+}
+
+// Events lost since the capture started: dropped by a full thread ring before the
+// aggregator saw them, by a full capture queue, or by a file that could not grow
+jlong droppedEventsOf(CaptureFile* file) {
+    return getDroppedEventCount() - ringDroppedAtStart.load(std::memory_order_relaxed) +
+           queuedDropped.load(std::memory_order_relaxed) + file->lostEvents.load(std::memory_order_relaxed);
+}
+
+CaptureStatus statusOf(CaptureFile* file, bool active) {
+    CaptureStatus status;
+    status.active = active ? 1 : 0;
+    status.bytesWritten = file->bytesWritten.load(std::memory_order_relaxed);
+    status.chunkCount = file->chunkCount.load(std::memory_order_relaxed);
+    status.eventCount = file->eventCount.load(std::memory_order_relaxed);
+    status.snapshotCount = file->snapshotCount.load(std::memory_order_relaxed);
+    status.droppedEvents = droppedEventsOf(file);
+    return status;
+}
+
+} // namespace
+
+bool startCapture(const std::string& path, jint snapshotIntervalMillis) {
+    CaptureState& state = captureState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.file != nullptr) {
+        return true;
+    }
+    if (path.empty()) {
+        return false;
+    }
+    if (snapshotIntervalMillis <= 0) {
+        snapshotIntervalMillis = kDefaultSnapshotIntervalMillis;
+    } else if (snapshotIntervalMillis < kMinSnapshotIntervalMillis) {
+        snapshotIntervalMillis = kMinSnapshotIntervalMillis;
+    }
+
+    CaptureFile* file = new CaptureFile();
+    if (!file->open(path, snapshotIntervalMillis)) {
+        delete file;
+        return false;
+    }
+
+    // Events left over from an earlier capture belong to it, not to this file
+    BufferEvent stale;
+    while (eventQueue().tryPop(stale)) {
+    }
+    queuedDropped.store(0, std::memory_order_relaxed);
+    ringDroppedAtStart.store(getDroppedEventCount(), std::memory_order_relaxed);
+
+    state.file = file;
+    state.path = path;
+    state.snapshotIntervalMillis = snapshotIntervalMillis;
+    state.stopRequested = false;
+    state.writer = new std::thread(writerLoop, file, snapshotIntervalMillis);
+    capturing.store(true, std::memory_order_release);
+
+    LOG_INFO("Capturing buffer events and snapshots every %d ms to %s", static_cast<int>(snapshotIntervalMillis),
+             path.c_str());
+    return true;
+}
+
+void stopCapture() {
+    CaptureState& state = captureState();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.file == nullptr) {
+            return;
+        }
+    }
+
+    // Hand the events still sitting in the thread rings to the writer before it stops
+    flushBufferEvents();
+    capturing.store(false, std::memory_order_release);
+
+    std::thread* writer;
+    CaptureFile* file;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.file == nullptr) {
+            return;
+        }
+        state.stopRequested = true;
+        writer = state.writer;
+        file = state.file;
+        state.writer = nullptr;
+    }
+    state.wakeUp.notify_all();
+    writer->join();
+    delete writer;
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.last = statusOf(file, false);
+    file->close(state.last.droppedEvents);
+    state.last.bytesWritten = file->bytesWritten.load(std::memory_order_relaxed);
+    LOG_INFO("Stopped capturing to %s (%lld events, %lld snapshots)", state.path.c_str(),
+             static_cast<long long>(state.last.eventCount), static_cast<long long>(state.last.snapshotCount));
+    delete file;
+    state.file = nullptr;
+    state.path.clear();
+}
+
+void captureEvent(const BufferEvent& event) {
+    if (!capturing.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (!eventQueue().tryPush(event)) {
+        queuedDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+CaptureStatus getCaptureStatus() {
+    CaptureState& state = captureState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.file == nullptr) {
+        return state.last;
+    }
+    return statusOf(state.file, true);
+}
+
+std::string getCapturePath() {
+    CaptureState& state = captureState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.path;
+}
+
+void startCaptureFromEnvironment() {
+    const char* path = getenv("BUFFERMONITOR_CAPTURE_PATH");
+    if (path == nullptr || *path == '\0') {
+        return;
+    }
+    const char* interval = getenv("BUFFERMONITOR_CAPTURE_INTERVAL_MS");
+    startCapture(path, interval != nullptr ? static_cast<jint>(atoi(interval)) : 0);
+}
@@ -0,0 +1,45 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <jni.h>
+#include <string>
+#include "event_tracking.h"
+
+// Optional capture of buffer events and periodic snapshots to a file, for
+// analysis after the process is gone (see capture_format.h and
+// tools/capture_replay.cpp). The event aggregator hands every drained event to
+// a bounded queue; a background thread appends the queued events, the names of
+// the threads they came from and, at a fixed interval, a snapshot of every
+// live buffer to a memory-mapped chunk of the file. The record paths never
+// touch the file. clearTracking does not affect a running capture.
+
+struct CaptureStatus {
+    jlong active;
+    jlong bytesWritten;
+    jlong chunkCount;
+    jlong eventCount;
+    jlong snapshotCount;
+    jlong droppedEvents; // Lost to a full thread ring, a writer that fell behind or a file that could not grow
+};
+
+static const jint kCaptureStatusFields = 6;
+
+// Creates the file and starts capturing; returns false if it could not be
+// created. Calling it again while running changes nothing and returns true.
+bool startCapture(const std::string& path, jint snapshotIntervalMillis);
+
+// Writes what is still queued, a final snapshot and the index, then closes the file
+void stopCapture();
+
+// Queues an event drained by the event aggregator; a relaxed load while not capturing
+void captureEvent(const BufferEvent& event);
+
+CaptureStatus getCaptureStatus();
+
+// Path of the file while capturing, empty otherwise
+std::string getCapturePath();
+
+// Starts a capture if BUFFERMONITOR_CAPTURE_PATH is set in the environment
+void startCaptureFromEnvironment();
+
+#endif /* CAPTURE_H */
@@ -0,0 +1,135 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a capture file.
+// A capture keeps buffer events and periodic buffer snapshots after the process
+// is gone. The file is shared by capture.cpp and by tools/capture_replay.cpp,
+// and contains only fixed-width fields in native byte order:
+//
+//   offset 0                        CaptureFileHeader (64 bytes)
+//   kCaptureDataOffset              chunk 0
+//   + i * chunkBytes                chunk i
+//   ...                             CaptureIndexEntry[chunkCount]
+//   end - sizeof(CaptureFooter)     CaptureFooter
+//
+// Every chunk starts with a CaptureChunkHeader followed by records. A record is
+// a CaptureRecordHeader and its payload, padded to 8 bytes. The writer maps one
+// chunk at a time, appends records and only then advances usedBytes, so after a
+// crash each chunk still holds a valid prefix. The index and footer are written
+// when the capture stops; a file without a footer can still be read by walking
+// the chunks in order until one has no magic. Each chunk starts by repeating
+// the most recently named threads (up to 1024), so chunks outside a time window
+// can be skipped without losing the names of the threads still active.
+
+static const uint32_t kCaptureMagic = 0x50434D42;       // "BMCP"
+static const uint32_t kCaptureChunkMagic = 0x4B434D42;  // "BMCK"
+static const uint32_t kCaptureFooterMagic = 0x46434D42; // "BMCF"
+static const uint32_t kCaptureVersion = 1;
+static const int64_t kCaptureDataOffset = 4096;         // Chunks stay page aligned for mmap
+static const uint32_t kCaptureDefaultChunkBytes = 1 << 20;
+
+enum CaptureRecordType {
+    CAPTURE_RECORD_EVENT = 1,       // CaptureEvent
+    CAPTURE_RECORD_SNAPSHOT = 2,    // CaptureSnapshotHeader and rowCount CaptureBufferRow
+    CAPTURE_RECORD_THREAD_NAME = 3  // CaptureThreadName and length bytes of name
+};
+
+struct CaptureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t chunkBytes;
+    uint32_t snapshotIntervalMillis;
+    int64_t pid;
+    int64_t startTime;     // Same clock as the buffer metrics
+    int64_t startWallTime; // Nanoseconds since the Unix epoch at startTime
+    int64_t reserved[3];
+};
+
+struct CaptureChunkHeader {
+    uint32_t magic;
+    uint32_t index;
+    uint32_t usedBytes;   // Including this header; records past it are not valid
+    uint32_t recordCount;
+    int64_t firstTime;    // Earliest record timestamp, 0 while empty
+    int64_t lastTime;     // Latest record timestamp
+    int64_t reserved[4];
+};
+
+struct CaptureRecordHeader {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t bytes;       // Payload bytes, before padding
+};
+
+// One BufferEvent from event_tracking.h
+struct CaptureEvent {
+    int32_t type;
+    int32_t size;
+    int32_t capacity;
+    int32_t reserved;
+    int64_t bufferId;
+    int64_t threadId;
+    int64_t timestamp;
+    int64_t value;
+};
+
+// A snapshot may be split across chunks; the parts share timestamp and sequence
+struct CaptureSnapshotHeader {
+    int64_t timestamp;
+    uint32_t sequence;
+    uint32_t rowCount;
+};
+
+struct CaptureBufferRow {
+    int64_t bufferId;
+    int64_t memoryUsage;
+    int64_t emissions;
+    int64_t consumptions;
+    int64_t suspensions;
+    int64_t lastUpdateTime;
+    int32_t capacity;
+    int32_t size;
+};
+
+struct CaptureThreadName {
+    int64_t threadId;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+struct CaptureIndexEntry {
+    int64_t offset;
+    uint32_t usedBytes;
+    uint32_t recordCount;
+    int64_t firstTime;
+    int64_t lastTime;
+};
+
+struct CaptureFooter {
+    uint32_t magic;
+    uint32_t chunkCount;
+    int64_t indexOffset;
+    int64_t endTime;
+    int64_t droppedEvents; // Events lost before they reached the file
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "CaptureFileHeader layout changed");
+static_assert(sizeof(CaptureChunkHeader) == 64, "CaptureChunkHeader layout changed");
+static_assert(sizeof(CaptureRecordHeader) == 8, "CaptureRecordHeader layout changed");
+static_assert(sizeof(CaptureEvent) == 48, "CaptureEvent layout changed");
+static_assert(sizeof(CaptureBufferRow) == 56, "CaptureBufferRow layout changed");
+static_assert(sizeof(CaptureIndexEntry) == 32, "CaptureIndexEntry layout changed");
+static_assert(sizeof(CaptureFooter) == 32, "CaptureFooter layout changed");
+
+inline uint32_t captureRecordBytes(uint32_t payloadBytes) {
+    return static_cast<uint32_t>(sizeof(CaptureRecordHeader)) + ((payloadBytes + 7u) & ~7u);
+}
+
+inline int64_t captureChunkOffset(uint32_t chunkBytes, uint32_t index) {
+    return kCaptureDataOffset + static_cast<int64_t>(chunkBytes) * index;
+}
+
+#endif /* CAPTURE_FORMAT_H */
@@ -0,0 +1,353 @@
+#include "event_tracking.h"
+#include "capture.h"
+#include "spsc_ring.h"
+#include "utils.h"
+#include "logging.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kRingCapacity = 1024;
+const size_t kHistoryCapacity = static_cast<size_t>(kEventHistoryCapacity);
+const size_t kDrainBatch = 256;
+const int kAggregateIntervalMillis = 10;
+
+// A ring plus the bookkeeping to hand it from an exited thread to a new one.
+// Rings are never freed, so the aggregator can walk the list without locking.
+struct ThreadRing {
+    ThreadRing() : ring(kRingCapacity), next(nullptr), inUse(true), dropped(0) {}
+
+    SpscRing<BufferEvent> ring;
+    ThreadRing* next;
+    std::atomic<bool> inUse;
+    std::atomic<uint64_t> dropped;
+};
+
+std::atomic<ThreadRing*> ringList(nullptr);
+
+// Reuses the ring of an exited thread, or allocates one and publishes it
+ThreadRing* claimRing() {
+    for (ThreadRing* ring = ringList.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+        bool expected = false;
+        if (!ring->inUse.load(std::memory_order_relaxed) &&
+            ring->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return ring;
+        }
+    }
+
+    ThreadRing* ring = new ThreadRing();
+    ThreadRing* head = ringList.load(std::memory_order_relaxed);
+    do {
+        ring->next = head;
+    } while (!ringList.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+    return ring;
+}
+
+jlong nativeThreadId() {
+#if defined(__linux__)
+    return static_cast<jlong>(syscall(SYS_gettid));
+#else
+    return static_cast<jlong>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+// The calling thread's ring and identity; the ring goes back to the pool when the thread exits
+struct ThreadEvents {
+    ThreadEvents() : ring(nullptr), threadId(0), identified(false) {}
+
+    ~ThreadEvents() {
+        if (ring != nullptr) {
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    }
+
+    ThreadRing* ring;
+    jlong threadId;
+    bool identified;
+};
+
+thread_local ThreadEvents currentThread;
+
+class Aggregator {
+public:
+    Aggregator() : history(kHistoryCapacity), historyNext(0), historyCount(0), running(false), stopRequested(false),
+                   worker(nullptr) {
+        for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Single consumer of every ring: callers must hold drainMutex
+    void drainLocked() {
+        Append append(*this);
+        for (ThreadRing* ring = ringList.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+            while (ring->ring.drainBatch(append, kDrainBatch) == kDrainBatch) {
+            }
+        }
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+    }
+
+    jint timeline(jint type, jlong bufferId, jlong sinceTimestamp, BufferEvent* destination, jint maxEvents) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+
+        // Walk back from the most recently drained event. Rings are drained one after
+        // another, so history is only roughly in time order; sort what was selected.
+        jint copied = 0;
+        for (size_t i = 0; i < historyCount && copied < maxEvents; i++) {
+            const BufferEvent& event = history[(historyNext + kHistoryCapacity - 1 - i) % kHistoryCapacity];
+            if (event.timestamp >= sinceTimestamp && (type < 0 || event.type == type) &&
+                (bufferId == 0 || event.bufferId == bufferId)) {
+                destination[copied++] = event;
+            }
+        }
+        std::stable_sort(destination, destination + copied, EarlierEvent());
+        return copied;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+        historyNext = 0;
+        historyCount = 0;
+        for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+        for (ThreadRing* ring = ringList.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+            ring->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (running) {
+            return;
+        }
+        running = true;
+        stopRequested = false;
+        worker = new std::thread(&Aggregator::loop, this);
+    }
+
+    void stop() {
+        std::thread* stopping;
+        {
+            std::lock_guard<std::mutex> lock(controlMutex);
+            if (!running) {
+                return;
+            }
+            stopRequested = true;
+            stopping = worker;
+            worker = nullptr;
+        }
+        wakeUp.notify_all();
+        stopping->join();
+        delete stopping;
+        drain();
+
+        std::lock_guard<std::mutex> lock(controlMutex);
+        running = false;
+    }
+
+    std::atomic<jlong> counts[EVENT_TYPE_COUNT];
+
+private:
+    struct EarlierEvent {
+        bool operator()(const BufferEvent& left, const BufferEvent& right) const {
+            return left.timestamp < right.timestamp;
+        }
+    };
+
+    struct Append {
+        explicit Append(Aggregator& aggregator) : aggregator(aggregator) {}
+        void operator()(const BufferEvent& event) {
+            if (event.type >= 0 && event.type < EVENT_TYPE_COUNT) {
+                aggregator.counts[event.type].fetch_add(1, std::memory_order_relaxed);
+            }
+            captureEvent(event);
+            aggregator.history[aggregator.historyNext] = event;
+            aggregator.historyNext = (aggregator.historyNext + 1) % kHistoryCapacity;
+            if (aggregator.historyCount < kHistoryCapacity) {
+                aggregator.historyCount++;
+            }
+        }
+        Aggregator& aggregator;
+    };
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(controlMutex);
+        while (!stopRequested) {
+            lock.unlock();
+            drain();
+            lock.lock();
+            wakeUp.wait_for(lock, std::chrono::milliseconds(kAggregateIntervalMillis),
+                            [this] { return stopRequested; });
+        }
+    }
+
+    std::mutex drainMutex;
+    std::vector<BufferEvent> history; // Circular, guarded by drainMutex
+    size_t historyNext;
+    size_t historyCount;
+
+    std::mutex controlMutex;
+    std::condition_variable wakeUp;
+    bool running;
+    bool stopRequested;
+    std::thread* worker; // Heap-allocated so a running thread never reaches a static destructor
+};
+
+Aggregator& aggregator() {
+    static Aggregator* instance = new Aggregator();
+    return *instance;
+}
+
+std::mutex threadNamesMutex;
+std::unordered_map<jlong, std::string> threadNames;
+
+void internThreadName(jlong threadId, const std::string& name) {
+    std::lock_guard<std::mutex> lock(threadNamesMutex);
+    threadNames[threadId] = name;
+}
+
+ThreadEvents& events() {
+    ThreadEvents& events = currentThread;
+    if (events.ring == nullptr) {
+        events.ring = claimRing();
+        events.threadId = nativeThreadId();
+    }
+    return events;
+}
+
+} // namespace
+
+void attachEventThread(JNIEnv* env) {
+    if (currentThread.identified) {
+        return;
+    }
+    ThreadEvents& current = events();
+    current.identified = true;
+
+    jclass threadClass = env->FindClass("java/lang/Thread");
+    if (threadClass == nullptr) {
+        env->ExceptionClear();
+        return;
+    }
+    jmethodID currentThreadMethod = env->GetStaticMethodID(threadClass, "currentThread", "()Ljava/lang/Thread;");
+    jmethodID getIdMethod = env->GetMethodID(threadClass, "getId", "()J");
+    jmethodID getNameMethod = env->GetMethodID(threadClass, "getName", "()Ljava/lang/String;");
+    jobject thread = nullptr;
+    if (currentThreadMethod != nullptr && getIdMethod != nullptr && getNameMethod != nullptr) {
+        thread = env->CallStaticObjectMethod(threadClass, currentThreadMethod);
+    }
+    if (thread != nullptr) {
+        jlong threadId = env->CallLongMethod(thread, getIdMethod);
+        jstring name = static_cast<jstring>(env->CallObjectMethod(thread, getNameMethod));
+        if (!env->ExceptionCheck()) {
+            current.threadId = threadId;
+            internThreadName(threadId, jstringToString(env, name));
+        }
+        if (name != nullptr) {
+            env->DeleteLocalRef(name);
+        }
+        env->DeleteLocalRef(thread);
+    }
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+    }
+    env->DeleteLocalRef(threadClass);
+}
+
+void attachEventThread(JNIEnv* env, jlong threadId, jstring threadName) {
+    ThreadEvents& current = events();
+    if (current.identified && current.threadId == threadId) {
+        return;
+    }
+    current.identified = true;
+    current.threadId = threadId;
+    internThreadName(threadId, jstringToString(env, threadName));
+}
+
+void registerEventThread(JNIEnv* env, jlong threadId, jstring threadName) {
+    ThreadEvents& current = events();
+    current.identified = true;
+    current.threadId = threadId;
+    internThreadName(threadId, jstringToString(env, threadName));
+}
+
+void recordBufferEvent(BufferEventType type, jlong bufferId, jint size, jint capacity, jlong value) {
+    ThreadEvents& current = events();
+    BufferEvent event;
+    event.type = type;
+    event.size = size;
+    event.capacity = capacity;
+    event.reserved = 0;
+    event.bufferId = bufferId;
+    event.threadId = current.threadId;
+    event.timestamp = getCurrentTimeMs();
+    event.value = value;
+    if (!current.ring->ring.tryPush(event)) {
+        current.ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void startEventAggregator() {
+    aggregator().start();
+}
+
+void stopEventAggregator() {
+    aggregator().stop();
+}
+
+void flushBufferEvents() {
+    aggregator().drain();
+}
+
+jint getEventTimeline(jint type, jlong bufferId, jlong sinceTimestamp, BufferEvent* destination, jint maxEvents) {
+    if (destination == nullptr || maxEvents <= 0) {
+        return 0;
+    }
+    return aggregator().timeline(type, bufferId, sinceTimestamp, destination, maxEvents);
+}
+
+jlong getEventCount(jint type) {
+    if (type < 0 || type >= EVENT_TYPE_COUNT) {
+        return 0;
+    }
+    aggregator().drain();
+    return aggregator().counts[type].load(std::memory_order_relaxed);
+}
+
+jlong getDroppedEventCount() {
+    jlong dropped = 0;
+    for (ThreadRing* ring = ringList.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+        dropped += static_cast<jlong>(ring->dropped.load(std::memory_order_relaxed));
+    }
+    return dropped;
+}
+
+std::string getEventThreadName(jlong threadId) {
+    std::lock_guard<std::mutex> lock(threadNamesMutex);
+    std::unordered_map<jlong, std::string>::const_iterator it = threadNames.find(threadId);
+    return it != threadNames.end() ? it->second : std::string();
+}
+
+void clearEventTracking() {
+    aggregator().clear();
+    LOG_INFO("Buffer event history cleared");
+}
@@ -0,0 +1,72 @@
+#ifndef EVENT_TRACKING_H
+#define EVENT_TRACKING_H
+
+#include <jni.h>
+#include <string>
+
+// Per-thread buffer event recording.
+// Every thread that records an event gets its own SPSC ring the first time it
+// does so; its Java thread id and name are resolved once at that point and
+// interned. Recording writes one fixed-size record into the calling thread's
+// ring, without locks or allocation; if the ring is full the event is dropped
+// and counted. A background aggregator drains all rings in batches into
+// per-type counters and a bounded event history that can be queried as a
+// timeline.
+
+enum BufferEventType {
+    EVENT_SUSPEND = 0, // A producer found the buffer full and suspends
+    EVENT_RESUME = 1,  // A suspended producer resumed; value holds the suspension in nanoseconds
+    EVENT_TYPE_COUNT = 2
+};
+
+struct BufferEvent {
+    jint type;
+    jint size;       // Buffer size when the event was recorded
+    jint capacity;   // Buffer capacity when the event was recorded
+    jint reserved;
+    jlong bufferId;
+    jlong threadId;  // Java thread id, or the native thread id if the thread was never identified
+    jlong timestamp; // Same clock as the buffer metrics
+    jlong value;
+};
+
+static const jint kEventHistoryCapacity = 16384; // Most recent events kept for the timeline
+
+// Identifies the calling thread from java.lang.Thread the first time it records
+// an event; afterwards a single thread-local check
+void attachEventThread(JNIEnv* env);
+
+// Identifies the calling thread with an id and name the caller already has; the
+// name is only converted the first time
+void attachEventThread(JNIEnv* env, jlong threadId, jstring threadName);
+
+// Registers the calling thread's id and name ahead of its first event, replacing
+// any earlier identity (for example after a rename). Afterwards the record paths
+// need no JNIEnv and no string from the caller.
+void registerEventThread(JNIEnv* env, jlong threadId, jstring threadName);
+
+// Writes an event into the calling thread's ring
+void recordBufferEvent(BufferEventType type, jlong bufferId, jint size, jint capacity, jlong value);
+
+// Starts and stops the aggregator thread; stopping drains what is still queued
+void startEventAggregator();
+void stopEventAggregator();
+
+// Drains every ring now instead of at the next aggregation interval
+void flushBufferEvents();
+
+// Drains every ring, then copies up to maxEvents of the most recent matching
+// events (oldest first) into destination. bufferId 0 matches every buffer.
+// Returns the number of events copied, never more than kEventHistoryCapacity.
+jint getEventTimeline(jint type, jlong bufferId, jlong sinceTimestamp, BufferEvent* destination, jint maxEvents);
+
+// Total events of a type aggregated so far, and events lost to full rings
+jlong getEventCount(jint type);
+jlong getDroppedEventCount();
+
+// Interned name of a thread seen in an event, empty if unknown
+std::string getEventThreadName(jlong threadId);
+
+void clearEventTracking();
+
+#endif /* EVENT_TRACKING_H */
@@ -0,0 +1,222 @@
+#include "gc_tracking.h"
+#include "jvmti_agent.h"
+#include "utils.h"
+#include "logging.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+std::atomic<bool> gcEnabled(false);
+std::atomic<jint> samplingInterval(0);
+
+std::atomic<jlong> collections(0);
+std::atomic<jlong> totalPauseNanos(0);
+std::atomic<jlong> maxPauseNanos(0);
+std::atomic<jlong> lastPauseTime(0);
+std::atomic<jlong> allocationSamples(0);
+std::atomic<jlong> sampledBytes(0);
+std::atomic<jlong> estimatedAllocatedBytes(0);
+std::atomic<jlong> allocatedSinceCollection(0);
+
+// Written by the GC callbacks only, which the VM never runs concurrently
+std::atomic<jlong> pauseStart(0);
+std::atomic<jlong> pauseAllocatedBytes(0);
+std::atomic<jlong> pauseCycleNanos(0);
+std::atomic<jlong> previousPauseEnd(0);
+
+// Readers copy out under the lock and never call into the VM while holding it,
+// so the GC finish callback can only wait for a short memcpy
+std::mutex pausesMutex;
+GcPause pauses[kGcPauseCapacity];
+jint pauseNext = 0;
+jint pauseCount = 0;
+
+std::mutex controlMutex;
+bool callbacksInstalled = false;
+
+void JNICALL onGarbageCollectionStart(jvmtiEnv*) {
+    jlong now = getCurrentTimeMs();
+    jlong previousEnd = previousPauseEnd.load(std::memory_order_relaxed);
+    pauseStart.store(now, std::memory_order_relaxed);
+    pauseAllocatedBytes.store(allocatedSinceCollection.exchange(0, std::memory_order_relaxed),
+                              std::memory_order_relaxed);
+    pauseCycleNanos.store(previousEnd != 0 ? now - previousEnd : 0, std::memory_order_relaxed);
+}
+
+void JNICALL onGarbageCollectionFinish(jvmtiEnv*) {
+    jlong now = getCurrentTimeMs();
+    jlong start = pauseStart.exchange(0, std::memory_order_relaxed);
+    previousPauseEnd.store(now, std::memory_order_relaxed);
+    if (start == 0) {
+        return; // Tracking was enabled in the middle of this pause
+    }
+
+    GcPause pause;
+    pause.start = start;
+    pause.durationNanos = now - start;
+    pause.allocatedBytes = pauseAllocatedBytes.load(std::memory_order_relaxed);
+    pause.cycleNanos = pauseCycleNanos.load(std::memory_order_relaxed);
+
+    collections.fetch_add(1, std::memory_order_relaxed);
+    totalPauseNanos.fetch_add(pause.durationNanos, std::memory_order_relaxed);
+    if (pause.durationNanos > maxPauseNanos.load(std::memory_order_relaxed)) {
+        maxPauseNanos.store(pause.durationNanos, std::memory_order_relaxed);
+    }
+    lastPauseTime.store(start, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(pausesMutex);
+    pauses[pauseNext] = pause;
+    pauseNext = (pauseNext + 1) % kGcPauseCapacity;
+    if (pauseCount < kGcPauseCapacity) {
+        pauseCount++;
+    }
+}
+
+void JNICALL onSampledObjectAlloc(jvmtiEnv*, JNIEnv*, jthread, jobject, jclass, jlong size) {
+    jlong interval = samplingInterval.load(std::memory_order_relaxed);
+    allocationSamples.fetch_add(1, std::memory_order_relaxed);
+    sampledBytes.fetch_add(size, std::memory_order_relaxed);
+    estimatedAllocatedBytes.fetch_add(interval, std::memory_order_relaxed);
+    allocatedSinceCollection.fetch_add(interval, std::memory_order_relaxed);
+}
+
+// Installs all three callbacks once; events are then switched individually.
+// Callers hold controlMutex.
+bool installCallbacks() {
+    if (callbacksInstalled) {
+        return true;
+    }
+    jvmtiEventCallbacks callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.GarbageCollectionStart = onGarbageCollectionStart;
+    callbacks.GarbageCollectionFinish = onGarbageCollectionFinish;
+    callbacks.SampledObjectAlloc = onSampledObjectAlloc;
+    jvmtiError error = setEventCallbacksJvmti(&callbacks);
+    if (error != JVMTI_ERROR_NONE) {
+        LOG_ERROR("Failed to install JVMTI event callbacks: %d", error);
+        return false;
+    }
+    callbacksInstalled = true;
+    return true;
+}
+
+} // namespace
+
+bool setGcTracking(bool enabled) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (!canGenerateGcEventsJvmti() || !installCallbacks()) {
+        return false;
+    }
+    if (enabled == gcEnabled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    // A pause in flight when tracking starts has no start stamp and is skipped
+    pauseStart.store(0, std::memory_order_relaxed);
+    jvmtiError startError = setEventEnabledJvmti(JVMTI_EVENT_GARBAGE_COLLECTION_START, enabled);
+    jvmtiError finishError = setEventEnabledJvmti(JVMTI_EVENT_GARBAGE_COLLECTION_FINISH, enabled);
+    if (startError != JVMTI_ERROR_NONE || finishError != JVMTI_ERROR_NONE) {
+        LOG_ERROR("Failed to %s GC events: %d, %d", enabled ? "enable" : "disable", startError, finishError);
+        setEventEnabledJvmti(JVMTI_EVENT_GARBAGE_COLLECTION_START, false);
+        setEventEnabledJvmti(JVMTI_EVENT_GARBAGE_COLLECTION_FINISH, false);
+        gcEnabled.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    gcEnabled.store(enabled, std::memory_order_relaxed);
+    LOG_INFO("GC tracking %s", enabled ? "enabled" : "disabled");
+    return true;
+}
+
+bool setAllocationSampling(jint intervalBytes) {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    if (!canSampleAllocationsJvmti() || !installCallbacks()) {
+        return false;
+    }
+
+    if (intervalBytes <= 0) {
+        if (samplingInterval.load(std::memory_order_relaxed) != 0) {
+            setEventEnabledJvmti(JVMTI_EVENT_SAMPLED_OBJECT_ALLOC, false);
+            samplingInterval.store(0, std::memory_order_relaxed);
+            LOG_INFO("Allocation sampling disabled");
+        }
+        return true;
+    }
+
+    jvmtiError error = setHeapSamplingIntervalJvmti(intervalBytes);
+    if (error == JVMTI_ERROR_NONE) {
+        // Set before enabling so the first sample is weighted correctly
+        samplingInterval.store(intervalBytes, std::memory_order_relaxed);
+        error = setEventEnabledJvmti(JVMTI_EVENT_SAMPLED_OBJECT_ALLOC, true);
+    }
+    if (error != JVMTI_ERROR_NONE) {
+        LOG_ERROR("Failed to enable allocation sampling: %d", error);
+        setEventEnabledJvmti(JVMTI_EVENT_SAMPLED_OBJECT_ALLOC, false);
+        samplingInterval.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    LOG_INFO("Allocation sampling every %d bytes", intervalBytes);
+    return true;
+}
+
+jint getGcPauses(jlong sinceTimestamp, GcPause* destination, jint maxPauses) {
+    if (destination == nullptr || maxPauses <= 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(pausesMutex);
+    // Pauses are in start order; keep the newest maxPauses after sinceTimestamp
+    jint first = 0;
+    while (first < pauseCount &&
+           pauses[(pauseNext + kGcPauseCapacity - pauseCount + first) % kGcPauseCapacity].start <= sinceTimestamp) {
+        first++;
+    }
+    if (pauseCount - first > maxPauses) {
+        first = pauseCount - maxPauses;
+    }
+    for (jint position = first; position < pauseCount; position++) {
+        destination[position - first] = pauses[(pauseNext + kGcPauseCapacity - pauseCount + position) % kGcPauseCapacity];
+    }
+    return pauseCount - first;
+}
+
+GcStatus getGcStatus() {
+    GcStatus status;
+    status.collections = collections.load(std::memory_order_relaxed);
+    status.totalPauseNanos = totalPauseNanos.load(std::memory_order_relaxed);
+    status.maxPauseNanos = maxPauseNanos.load(std::memory_order_relaxed);
+    status.lastPauseTime = lastPauseTime.load(std::memory_order_relaxed);
+    status.allocationSamples = allocationSamples.load(std::memory_order_relaxed);
+    status.sampledBytes = sampledBytes.load(std::memory_order_relaxed);
+    status.estimatedAllocatedBytes = estimatedAllocatedBytes.load(std::memory_order_relaxed);
+    status.samplingInterval = samplingInterval.load(std::memory_order_relaxed);
+    status.gcTrackingEnabled = gcEnabled.load(std::memory_order_relaxed) ? 1 : 0;
+    return status;
+}
+
+void stopGcTracking() {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (!callbacksInstalled) {
+            return;
+        }
+    }
+    setGcTracking(false);
+    setAllocationSampling(0);
+}
+
+void clearGcTracking() {
+    collections.store(0, std::memory_order_relaxed);
+    totalPauseNanos.store(0, std::memory_order_relaxed);
+    maxPauseNanos.store(0, std::memory_order_relaxed);
+    lastPauseTime.store(0, std::memory_order_relaxed);
+    allocationSamples.store(0, std::memory_order_relaxed);
+    sampledBytes.store(0, std::memory_order_relaxed);
+    estimatedAllocatedBytes.store(0, std::memory_order_relaxed);
+    allocatedSinceCollection.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(pausesMutex);
+    pauseNext = 0;
+    pauseCount = 0;
+}
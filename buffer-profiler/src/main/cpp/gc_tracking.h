@@ -0,0 +1,63 @@
+#ifndef GC_TRACKING_H
+#define GC_TRACKING_H
+
+#include <jni.h>
+
+// GC pauses and allocation rate from JVMTI events.
+// Both are off by default and need the matching JVMTI capability. GC tracking
+// stamps every GarbageCollectionStart/Finish pair with the clock the buffer
+// metrics use, so pauses line up with buffer history and the event timeline.
+// Allocation sampling enables SampledObjectAlloc, which reports about one object
+// per sampling interval of allocated bytes; the allocated volume is estimated as
+// samples * interval. The callbacks only touch atomics and a fixed ring, so they
+// are safe to run inside a pause.
+
+// One collection. allocatedBytes is the estimated allocation between the end of
+// the previous collection and the start of this one, cycleNanos the length of that
+// interval, so allocatedBytes / cycleNanos is the allocation rate that led to it.
+struct GcPause {
+    jlong start;          // Same clock as the buffer metrics
+    jlong durationNanos;
+    jlong allocatedBytes; // 0 while allocation sampling is off
+    jlong cycleNanos;     // 0 for the first collection seen
+};
+
+static const jint kGcPauseFields = 4;
+static const jint kGcPauseCapacity = 1024; // Most recent pauses kept
+
+struct GcStatus {
+    jlong collections;
+    jlong totalPauseNanos;
+    jlong maxPauseNanos;
+    jlong lastPauseTime;
+    jlong allocationSamples;
+    jlong sampledBytes;            // Sum of the sizes of the sampled objects
+    jlong estimatedAllocatedBytes; // Samples weighted by the interval in effect when taken
+    jlong samplingInterval;        // 0 while allocation sampling is off
+    jlong gcTrackingEnabled;
+};
+
+static const jint kGcStatusFields = 9;
+
+// Starts or stops recording GC pauses; false if the VM cannot send GC events
+bool setGcTracking(bool enabled);
+
+// Starts sampling about one allocation per intervalBytes, or stops it when
+// intervalBytes <= 0; false if the VM cannot sample allocations
+bool setAllocationSampling(jint intervalBytes);
+
+// Copies up to maxPauses of the most recent pauses that started after
+// sinceTimestamp, oldest first; returns the number copied, never more than
+// kGcPauseCapacity
+jint getGcPauses(jlong sinceTimestamp, GcPause* destination, jint maxPauses);
+
+GcStatus getGcStatus();
+
+// Disables both event kinds; called before the library is unloaded so no
+// callback can run into unmapped code
+void stopGcTracking();
+
+// Forgets recorded pauses and counters; enabled events stay enabled
+void clearGcTracking();
+
+#endif /* GC_TRACKING_H */
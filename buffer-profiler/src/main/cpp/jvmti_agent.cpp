@@ -1,10 +1,13 @@
 #include "jvmti_agent.h"
-#include <iostream>
+#include "gc_tracking.h"
+#include "logging.h"
 #include <string.h>
 
 // Global JVMTI environment
 static jvmtiEnv* jvmti = nullptr;
 static bool jvmtiInitialized = false;
+static bool gcEventsAvailable = false;
+static bool allocationSamplingAvailable = false;
 
 // Initialize JVMTI environment
 jint initializeJvmti(JavaVM* vm) {
@@ -15,7 +18,7 @@ jint initializeJvmti(JavaVM* vm) {
     // Get JVMTI environment
     jint result = vm->GetEnv((void**)&jvmti, JVMTI_VERSION_1_0);
     if (result != JNI_OK) {
-        std::cerr << "[Native] Failed to get JVMTI environment: " << result << std::endl;
+        LOG_ERROR("Failed to get JVMTI environment: %d", result);
         return result;
     }
 
@@ -26,12 +29,27 @@ jint initializeJvmti(JavaVM* vm) {
 
     jvmtiError error = jvmti->AddCapabilities(&capabilities);
     if (error != JVMTI_ERROR_NONE) {
-        std::cerr << "[Native] Failed to add JVMTI capabilities: " << error << std::endl;
+        LOG_ERROR("Failed to add JVMTI capabilities: %d", error);
         return JNI_ERR;
     }
 
+    // Event capabilities are optional; only ask for those this VM can grant
+    jvmtiCapabilities potential;
+    memset(&potential, 0, sizeof(potential));
+    if (jvmti->GetPotentialCapabilities(&potential) == JVMTI_ERROR_NONE) {
+        memset(&capabilities, 0, sizeof(capabilities));
+        capabilities.can_generate_garbage_collection_events = potential.can_generate_garbage_collection_events;
+        capabilities.can_generate_sampled_object_alloc_events = potential.can_generate_sampled_object_alloc_events;
+        if (jvmti->AddCapabilities(&capabilities) == JVMTI_ERROR_NONE) {
+            gcEventsAvailable = capabilities.can_generate_garbage_collection_events != 0;
+            allocationSamplingAvailable = capabilities.can_generate_sampled_object_alloc_events != 0;
+        }
+    }
+    LOG_INFO("JVMTI GC events %s, allocation sampling %s", gcEventsAvailable ? "available" : "unavailable",
+             allocationSamplingAvailable ? "available" : "unavailable");
+
     jvmtiInitialized = true;
-    std::cout << "[Native] JVMTI initialized successfully" << std::endl;
+    LOG_INFO("JVMTI initialized successfully");
     return JNI_OK;
 }
 
@@ -50,23 +68,147 @@ jlong getObjectSizeJvmti(jobject obj) {
     jvmtiError error = jvmti->GetObjectSize(obj, &size);
 
     if (error != JVMTI_ERROR_NONE) {
-        std::cerr << "[Native] Failed to get object size: " << error << std::endl;
+        LOG_ERROR("Failed to get object size: %d", error);
         return 0;
     }
 
-    std::cout << "[Native] JVMTI measured object size: " << size << " bytes" << std::endl;
     return size;
 }
 
+jlong getObjectTagJvmti(jobject obj) {
+    if (!isJvmtiAvailable() || obj == nullptr) {
+        return 0;
+    }
+
+    jlong tag = 0;
+    if (jvmti->GetTag(obj, &tag) != JVMTI_ERROR_NONE) {
+        return 0;
+    }
+    return tag;
+}
+
+bool setObjectTagJvmti(jobject obj, jlong tag) {
+    if (!isJvmtiAvailable() || obj == nullptr) {
+        return false;
+    }
+
+    jvmtiError error = jvmti->SetTag(obj, tag);
+    if (error != JVMTI_ERROR_NONE) {
+        LOG_ERROR("Failed to tag object: %d", error);
+        return false;
+    }
+    return true;
+}
+
+std::string getClassSignatureJvmti(jclass klass) {
+    if (!isJvmtiAvailable() || klass == nullptr) {
+        return std::string();
+    }
+
+    char* signature = nullptr;
+    jvmtiError error = jvmti->GetClassSignature(klass, &signature, nullptr);
+    if (error != JVMTI_ERROR_NONE || signature == nullptr) {
+        LOG_ERROR("Failed to get class signature: %d", error);
+        return std::string();
+    }
+
+    std::string result(signature);
+    jvmti->Deallocate(reinterpret_cast<unsigned char*>(signature));
+    return result;
+}
+
+jvmtiError followReferencesJvmti(const jvmtiHeapCallbacks* callbacks, const void* userData) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->FollowReferences(0, nullptr, nullptr, callbacks, userData);
+}
+
+jvmtiError iterateThroughHeapJvmti(jint heapFilter, const jvmtiHeapCallbacks* callbacks, const void* userData) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->IterateThroughHeap(heapFilter, nullptr, callbacks, userData);
+}
+
+jvmtiError getStackTraceJvmti(jint maxDepth, jvmtiFrameInfo* frames, jint* count) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->GetStackTrace(nullptr, 0, maxDepth, frames, count);
+}
+
+std::string getMethodNameJvmti(JNIEnv* env, jmethodID method) {
+    if (!isJvmtiAvailable() || method == nullptr) {
+        return std::string();
+    }
+
+    jclass declaringClass = nullptr;
+    if (jvmti->GetMethodDeclaringClass(method, &declaringClass) != JVMTI_ERROR_NONE) {
+        return std::string();
+    }
+    std::string className = getClassSignatureJvmti(declaringClass);
+    env->DeleteLocalRef(declaringClass);
+    char* methodName = nullptr;
+    if (jvmti->GetMethodName(method, &methodName, nullptr, nullptr) != JVMTI_ERROR_NONE) {
+        return std::string();
+    }
+
+    // "Lpkg/Class;" becomes "pkg.Class"
+    if (className.size() >= 2 && className[0] == 'L' && className[className.size() - 1] == ';') {
+        className = className.substr(1, className.size() - 2);
+    }
+    for (size_t i = 0; i < className.size(); i++) {
+        if (className[i] == '/') {
+            className[i] = '.';
+        }
+    }
+
+    std::string result = className + "." + methodName;
+    jvmti->Deallocate(reinterpret_cast<unsigned char*>(methodName));
+    return result;
+}
+
+bool canGenerateGcEventsJvmti() {
+    return isJvmtiAvailable() && gcEventsAvailable;
+}
+
+bool canSampleAllocationsJvmti() {
+    return isJvmtiAvailable() && allocationSamplingAvailable;
+}
+
+jvmtiError setEventCallbacksJvmti(const jvmtiEventCallbacks* callbacks) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->SetEventCallbacks(callbacks, static_cast<jint>(sizeof(*callbacks)));
+}
+
+jvmtiError setEventEnabledJvmti(jvmtiEvent event, bool enabled) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->SetEventNotificationMode(enabled ? JVMTI_ENABLE : JVMTI_DISABLE, event, nullptr);
+}
+
+jvmtiError setHeapSamplingIntervalJvmti(jint intervalBytes) {
+    if (!isJvmtiAvailable()) {
+        return JVMTI_ERROR_NOT_AVAILABLE;
+    }
+    return jvmti->SetHeapSamplingInterval(intervalBytes);
+}
+
 // Agent_OnLoad function - called when the agent is loaded
 JNIEXPORT jint JNICALL Agent_OnLoad(JavaVM* vm, char* options, void* reserved) {
-    std::cout << "[Native] JVMTI Agent loaded" << std::endl;
+    LOG_INFO("JVMTI Agent loaded");
     return initializeJvmti(vm);
 }
 
 // Agent_OnUnload function - called when the agent is unloaded
 JNIEXPORT void JNICALL Agent_OnUnload(JavaVM* vm) {
-    std::cout << "[Native] JVMTI Agent unloaded" << std::endl;
+    LOG_INFO("JVMTI Agent unloaded");
+    stopGcTracking();
     jvmti = nullptr;
     jvmtiInitialized = false;
+    shutdownLogging();
 }
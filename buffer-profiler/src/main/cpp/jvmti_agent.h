@@ -2,6 +2,7 @@
 #define JVMTI_AGENT_H
 
 #include <jvmti.h>
+#include <string>
 
 // Initialize JVMTI environment
 jint initializeJvmti(JavaVM* vm);
@@ -12,4 +13,34 @@ jlong getObjectSizeJvmti(jobject obj);
 // Check if JVMTI is available
 bool isJvmtiAvailable();
 
+// Object tags; 0 means untagged or JVMTI unavailable
+jlong getObjectTagJvmti(jobject obj);
+bool setObjectTagJvmti(jobject obj, jlong tag);
+
+// JVM signature of a class (e.g. "Ljava/lang/String;"), empty on failure
+std::string getClassSignatureJvmti(jclass klass);
+
+// Heap walks over every object reachable from the heap roots, and over every
+// object in the heap filtered by tag; both run on the calling thread, which must
+// be attached to the VM
+jvmtiError followReferencesJvmti(const jvmtiHeapCallbacks* callbacks, const void* userData);
+jvmtiError iterateThroughHeapJvmti(jint heapFilter, const jvmtiHeapCallbacks* callbacks, const void* userData);
+
+// Frames of the calling thread, innermost first; needs no capability
+jvmtiError getStackTraceJvmti(jint maxDepth, jvmtiFrameInfo* frames, jint* count);
+
+// "pkg.Class.method" of a method, empty if the method is no longer valid; env
+// releases the local reference to the declaring class
+std::string getMethodNameJvmti(JNIEnv* env, jmethodID method);
+
+// Optional event capabilities, requested during initialization when the VM offers them
+bool canGenerateGcEventsJvmti();
+bool canSampleAllocationsJvmti();
+
+// Event plumbing. The environment has a single callback table, so every event
+// callback the library uses must be installed by one setEventCallbacksJvmti call.
+jvmtiError setEventCallbacksJvmti(const jvmtiEventCallbacks* callbacks);
+jvmtiError setEventEnabledJvmti(jvmtiEvent event, bool enabled);
+jvmtiError setHeapSamplingIntervalJvmti(jint intervalBytes);
+
 #endif /* JVMTI_AGENT_H */
@@ -0,0 +1,199 @@
+#include "latency_histogram.h"
+#include "buffer_tracking.h"
+#include "event_tracking.h"
+#include "logging.h"
+#include <climits>
+#include <cmath>
+
+namespace {
+
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Returns the latency histograms of a buffer, allocating them on first use.
+// Concurrent first samples race with a CAS and the loser frees its copy.
+BufferLatency* latencyOf(BufferMetrics* metrics) {
+    BufferLatency* latency = metrics->latency.load(std::memory_order_acquire);
+    if (latency != nullptr) {
+        return latency;
+    }
+
+    BufferLatency* fresh = new BufferLatency();
+    if (metrics->latency.compare_exchange_strong(latency, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    delete fresh;
+    return latency;
+}
+
+LatencyKind toLatencyKind(jint kind) {
+    return kind == LATENCY_SUSPENSION ? LATENCY_SUSPENSION : LATENCY_RESIDENCY;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(jlong value) {
+    if (value < kSubBucketCount) {
+        return value < 0 ? 0 : static_cast<int>(value);
+    }
+    int exponent = highestBit(static_cast<uint64_t>(value));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int shift = exponent - kSubBucketBits;
+    int subBucket = static_cast<int>(static_cast<uint64_t>(value) >> shift) - kSubBucketCount;
+    return (shift + 1) * kSubBucketCount + subBucket;
+}
+
+jlong LatencyHistogram::highestEquivalentValue(int index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    int shift = index / kSubBucketCount - 1;
+    jlong subBucket = index % kSubBucketCount;
+    jlong lowest = (kSubBucketCount + subBucket) << shift;
+    return lowest + (static_cast<jlong>(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(jlong value) {
+    if (value < 0) {
+        value = 0;
+    }
+    counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    jlong currentMin = minValue.load(std::memory_order_relaxed);
+    while (value < currentMin && !minValue.compare_exchange_weak(currentMin, value, std::memory_order_relaxed)) {
+    }
+    jlong currentMax = maxValue.load(std::memory_order_relaxed);
+    while (value > currentMax && !maxValue.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < kBucketCount; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    totalCount.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    minValue.store(LLONG_MAX, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+jlong LatencyHistogram::count() const {
+    return static_cast<jlong>(totalCount.load(std::memory_order_relaxed));
+}
+
+jlong LatencyHistogram::valueAtPercentile(double percentile) const {
+    // Sum the buckets rather than trusting totalCount, which may run ahead of them
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        total += counts[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    if (percentile < 0.0) {
+        percentile = 0.0;
+    } else if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    if (target == 0) {
+        target = 1;
+    }
+
+    jlong max = maxValue.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            jlong value = highestEquivalentValue(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+void LatencyHistogram::exportTo(jlong* destination) const {
+    jlong exported = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        jlong bucketCount = static_cast<jlong>(counts[i].load(std::memory_order_relaxed));
+        destination[kExportHeaderLength + i] = bucketCount;
+        exported += bucketCount;
+    }
+
+    jlong min = minValue.load(std::memory_order_relaxed);
+    destination[0] = kExportVersion;
+    destination[1] = kSubBucketBits;
+    destination[2] = kBucketCount;
+    destination[3] = exported;
+    destination[4] = sum.load(std::memory_order_relaxed);
+    destination[5] = exported == 0 || min == LLONG_MAX ? 0 : min;
+    destination[6] = maxValue.load(std::memory_order_relaxed);
+}
+
+// Record a latency sample for a buffer that the caller has already looked up
+void recordLatencySample(BufferMetrics* metrics, LatencyKind kind, jlong nanos) {
+    latencyOf(metrics)->get(kind).record(nanos);
+}
+
+// Record how long a producer was suspended on a full buffer
+void recordSuspensionDuration(jlong bufferId, jlong nanos) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in recordSuspensionDuration", static_cast<long long>(bufferId));
+        return;
+    }
+    recordLatencySample(metrics, LATENCY_SUSPENSION, nanos);
+    recordBufferEvent(EVENT_RESUME, bufferId, metrics->size.load(std::memory_order_relaxed),
+                      metrics->capacity.load(std::memory_order_relaxed), nanos);
+
+    LOG_DEBUG("Buffer %lld producer resumed after %lld ns",
+              static_cast<long long>(bufferId), static_cast<long long>(nanos));
+}
+
+// Get a latency percentile for a specific buffer, 0 if nothing was recorded
+jlong getLatencyPercentile(jlong bufferId, jint kind, double percentile) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in getLatencyPercentile", static_cast<long long>(bufferId));
+        return 0;
+    }
+    BufferLatency* latency = metrics->latency.load(std::memory_order_acquire);
+    if (latency == nullptr) {
+        return 0;
+    }
+    return latency->get(toLatencyKind(kind)).valueAtPercentile(percentile);
+}
+
+bool exportLatencyHistogram(jlong bufferId, jint kind, jlong* destination) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics == nullptr) {
+        LOG_WARN("Warning: Buffer %lld not found in exportLatencyHistogram", static_cast<long long>(bufferId));
+        return false;
+    }
+    BufferLatency* latency = metrics->latency.load(std::memory_order_acquire);
+    if (latency == nullptr) {
+        static const LatencyHistogram empty;
+        empty.exportTo(destination);
+    } else {
+        latency->get(toLatencyKind(kind)).exportTo(destination);
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <jni.h>
+#include <atomic>
+#include <cstdint>
+
+// Log-bucketed latency histogram in the style of HdrHistogram.
+// Values below kSubBucketCount get a bucket each; above that every power of two
+// is split into kSubBucketCount linear sub-buckets, so any recorded value is
+// reported within 1/kSubBucketCount (about 3%) of its true value. Values are in
+// nanoseconds and everything above 2^(kMaxExponent + 1) - 1 (about 4.9 hours)
+// lands in the last bucket. Recording is a handful of relaxed atomic updates,
+// so any number of threads can record into the same histogram.
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 5;
+    static const int kSubBucketCount = 1 << kSubBucketBits;
+    static const int kMaxExponent = 43;
+    static const int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+    // Export layout: a header of kExportHeaderLength values followed by the
+    // kBucketCount bucket counts. Exports with the same version and geometry
+    // can be merged by adding the counts and combining the header fields.
+    static const jlong kExportVersion = 1;
+    static const int kExportHeaderLength = 7; // version, sub-bucket bits, bucket count, count, sum, min, max
+    static const int kExportLength = kExportHeaderLength + kBucketCount;
+
+    LatencyHistogram();
+
+    void record(jlong value);
+    void reset();
+
+    jlong count() const;
+
+    // Highest value equivalent to the given percentile (0-100), or 0 if empty
+    jlong valueAtPercentile(double percentile) const;
+
+    // Writes kExportLength values
+    void exportTo(jlong* destination) const;
+
+    static int bucketIndex(jlong value);
+    static jlong highestEquivalentValue(int index);
+
+private:
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    std::atomic<uint64_t> counts[kBucketCount];
+    std::atomic<uint64_t> totalCount;
+    std::atomic<jlong> sum;
+    std::atomic<jlong> minValue;
+    std::atomic<jlong> maxValue;
+};
+
+enum LatencyKind {
+    LATENCY_RESIDENCY = 0,  // Time an entry spent in the buffer, emit to consume
+    LATENCY_SUSPENSION = 1  // Time a producer spent suspended on a full buffer
+};
+
+// The latency histograms of one buffer, allocated on its first latency sample
+struct BufferLatency {
+    LatencyHistogram residency;
+    LatencyHistogram suspension;
+
+    LatencyHistogram& get(LatencyKind kind) {
+        return kind == LATENCY_SUSPENSION ? suspension : residency;
+    }
+
+    void reset() {
+        residency.reset();
+        suspension.reset();
+    }
+};
+
+struct BufferMetrics;
+
+// Function declarations
+void recordLatencySample(BufferMetrics* metrics, LatencyKind kind, jlong nanos);
+void recordSuspensionDuration(jlong bufferId, jlong nanos);
+jlong getLatencyPercentile(jlong bufferId, jint kind, double percentile);
+// Copies the histogram export into destination (kExportLength values); false if the buffer is unknown
+bool exportLatencyHistogram(jlong bufferId, jint kind, jlong* destination);
+
+#endif /* LATENCY_HISTOGRAM_H */
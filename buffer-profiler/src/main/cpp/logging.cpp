@@ -0,0 +1,180 @@
+#include "logging.h"
+#include "mpmc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const size_t kLogQueueCapacity = 2048;
+const size_t kMaxRecordLength = 248;
+const size_t kWriteBatchBytes = 64 * 1024;
+const char kLogPrefix[] = "[Native] ";
+
+struct LogRecord {
+    int level;
+    unsigned length;
+    char text[kMaxRecordLength];
+};
+
+std::atomic<bool> writerStarted(false);
+std::atomic<bool> writerRunning(false);
+std::atomic<bool> stopRequested(false);
+std::atomic<unsigned long long> droppedRecords(0);
+
+MpmcQueue<LogRecord>& logQueue() {
+    static MpmcQueue<LogRecord> queue(kLogQueueCapacity);
+    return queue;
+}
+
+// Accumulates records per stream and writes each stream with one fwrite per batch
+class BatchWriter {
+public:
+    BatchWriter() : outLength(0), errLength(0) {}
+
+    void append(const LogRecord& record) {
+        bool isError = record.level >= LOG_LEVEL_ERROR;
+        char* buffer = isError ? errBuffer : outBuffer;
+        size_t& length = isError ? errLength : outLength;
+        size_t needed = sizeof(kLogPrefix) - 1 + record.length + 1;
+        if (length + needed > kWriteBatchBytes) {
+            flush();
+        }
+        memcpy(buffer + length, kLogPrefix, sizeof(kLogPrefix) - 1);
+        length += sizeof(kLogPrefix) - 1;
+        memcpy(buffer + length, record.text, record.length);
+        length += record.length;
+        buffer[length++] = '\n';
+    }
+
+    void flush() {
+        if (outLength > 0) {
+            fwrite(outBuffer, 1, outLength, stdout);
+            fflush(stdout);
+            outLength = 0;
+        }
+        if (errLength > 0) {
+            fwrite(errBuffer, 1, errLength, stderr);
+            fflush(stderr);
+            errLength = 0;
+        }
+    }
+
+private:
+    char outBuffer[kWriteBatchBytes];
+    char errBuffer[kWriteBatchBytes];
+    size_t outLength;
+    size_t errLength;
+};
+
+struct AppendTo {
+    explicit AppendTo(BatchWriter& writer) : writer(writer) {}
+    void operator()(const LogRecord& record) const { writer.append(record); }
+    BatchWriter& writer;
+};
+
+// Drains whatever is queued right now; returns the number of records written
+size_t drainQueue(BatchWriter& writer) {
+    size_t drained = 0;
+    while (logQueue().tryPopWith(AppendTo(writer))) {
+        drained++;
+    }
+    writer.flush();
+    return drained;
+}
+
+// Reports records lost to a full ring since the last report
+void reportDropped(unsigned long long& reported) {
+    unsigned long long dropped = droppedRecords.load(std::memory_order_relaxed);
+    if (dropped != reported) {
+        fprintf(stderr, "%s%llu log records dropped, ring full\n", kLogPrefix, dropped - reported);
+        fflush(stderr);
+        reported = dropped;
+    }
+}
+
+void writerLoop() {
+    static BatchWriter writer;
+    unsigned long long reported = 0;
+    while (!stopRequested.load(std::memory_order_acquire)) {
+        size_t drained = drainQueue(writer);
+        reportDropped(reported);
+        if (drained == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    writerRunning.store(false, std::memory_order_release);
+}
+
+struct FormatRecord {
+    FormatRecord(int level, const char* format, va_list* args) : level(level), format(format), args(args) {}
+    void operator()(LogRecord& record) const {
+        va_list copy;
+        va_copy(copy, *args);
+        int written = vsnprintf(record.text, sizeof(record.text), format, copy);
+        va_end(copy);
+        record.level = level;
+        if (written < 0) {
+            record.length = 0;
+        } else if (static_cast<size_t>(written) >= sizeof(record.text)) {
+            record.length = sizeof(record.text) - 1;
+        } else {
+            record.length = static_cast<unsigned>(written);
+        }
+    }
+    int level;
+    const char* format;
+    va_list* args;
+};
+
+} // namespace
+
+void startLogging() {
+    bool expected = false;
+    if (!writerStarted.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        return;
+    }
+    stopRequested.store(false, std::memory_order_release);
+    writerRunning.store(true, std::memory_order_release);
+    std::thread(writerLoop).detach();
+}
+
+void shutdownLogging() {
+    if (!writerStarted.load(std::memory_order_acquire)) {
+        return;
+    }
+    stopRequested.store(true, std::memory_order_release);
+
+    // The writer is detached so process exit never blocks on it; give it a
+    // bounded amount of time to finish its current batch
+    for (int i = 0; i < 100 && writerRunning.load(std::memory_order_acquire); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (!writerRunning.load(std::memory_order_acquire)) {
+        static BatchWriter finalWriter;
+        drainQueue(finalWriter);
+        writerStarted.store(false, std::memory_order_release);
+    }
+}
+
+void logMessage(int level, const char* format, ...) {
+    if (!writerStarted.load(std::memory_order_relaxed)) {
+        startLogging();
+    }
+
+    va_list args;
+    va_start(args, format);
+    bool queued = logQueue().tryPushWith(FormatRecord(level, format, &args));
+    va_end(args);
+
+    if (!queued) {
+        droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+unsigned long long getDroppedLogRecords() {
+    return droppedRecords.load(std::memory_order_relaxed);
+}
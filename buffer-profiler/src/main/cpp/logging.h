@@ -0,0 +1,54 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+// Native logging.
+// Statements below BUFFERMONITOR_LOG_LEVEL are removed at compile time; the
+// arguments of a removed statement are still type-checked but never evaluated.
+// Enabled statements are formatted on the calling thread into a lock-free ring
+// and written out in batches by a background thread, so a log call never
+// blocks on stdout. If the ring is full the record is dropped and counted.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+// Set through the BUFFERMONITOR_LOGGING / BUFFERMONITOR_LOG_LEVEL CMake options
+#ifndef BUFFERMONITOR_LOG_LEVEL
+#define BUFFERMONITOR_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_ENABLED(level) ((level) >= BUFFERMONITOR_LOG_LEVEL && (level) < LOG_LEVEL_OFF)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
+// Formats a record and queues it for the writer thread
+void logMessage(int level, const char* format, ...) LOG_PRINTF_FORMAT(2, 3);
+
+// Starts the writer thread; called once during initialization, safe to call again
+void startLogging();
+
+// Stops the writer thread and writes out everything still queued
+void shutdownLogging();
+
+// Number of records dropped because the ring was full
+unsigned long long getDroppedLogRecords();
+
+#define LOG_AT(level, ...)                   \
+    do {                                     \
+        if (LOG_ENABLED(level)) {            \
+            logMessage(level, __VA_ARGS__);  \
+        }                                    \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif /* LOGGING_H */
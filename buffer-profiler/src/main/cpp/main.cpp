@@ -3,47 +3,106 @@
 #include "buffer_tracking.h"
 #include "memory_tracking.h"
 #include "suspension_tracking.h"
+#include "snapshot.h"
+#include "shm_export.h"
+#include "latency_histogram.h"
+#include "buffer_history.h"
+#include "event_tracking.h"
+#include "retained_size.h"
+#include "gc_tracking.h"
+#include "ring_channel.h"
+#include "buffer_aggregates.h"
+#include "backpressure.h"
+#include "capture.h"
+#include "buffer_groups.h"
+#include "overhead.h"
+#include "metrics_exporter.h"
+#include "suspension_stacks.h"
 #include "utils.h"
-#include <iostream>
+#include "logging.h"
+#include <cstdint>
+#include <cstdlib>
 #include <unordered_map>
 #include <vector>
 #include <mutex>
-#include <sstream>
 
 // Global state
 std::unordered_map<std::string, ClassMemoryInfo> memoryByClass;
+std::mutex memoryByClassMutex;
+
+// Serializes initialization and reset only; the record and query paths are lock-free
 std::mutex stateMutex;
 
+namespace {
+
+// Counters are 64-bit natively; the int getters saturate instead of wrapping
+// negative, and snapshotAll reports the full values
+jint saturateToJint(jlong value) {
+    return value > INT32_MAX ? INT32_MAX : static_cast<jint>(value);
+}
+
+} // namespace
+
+// Flushes queued log records when the class loader that loaded the library is collected
+JNIEXPORT void JNICALL
+JNI_OnUnload(JavaVM* vm, void* reserved) {
+    stopGcTracking();
+    stopSharedMemoryExport();
+    stopEventAggregator();
+    stopCapture();
+    stopOverheadGovernor();
+    stopMetricsExporter();
+    waitForRetainedSizePass();
+    shutdownLogging();
+}
+
 // Initialization function for all native components
 JNIEXPORT jboolean JNICALL
 Java_NativeBufferMonitor_initialize(JNIEnv* env, jclass clazz) {
     std::lock_guard<std::mutex> lock(stateMutex);
-    std::cout << "[Native] Initializing all native components" << std::endl;
+    startLogging();
+    LOG_INFO("Initializing all native components");
 
     // Initialize buffer tracking
     initializeBufferTracking();
-    std::cout << "[Native] Buffer tracking initialized" << std::endl;
+    LOG_INFO("Buffer tracking initialized");
+
+    // Drain per-thread event rings in the background
+    startEventAggregator();
 
     // Initialize memory tracking with JVMTI if possible
     JavaVM* vm;
     env->GetJavaVM(&vm);
     initializeMemoryTrackingWithJvm(vm);
 
+    // Publish to shared memory if requested through the environment
+    startSharedMemoryExportFromEnvironment();
+
+    // Capture events and snapshots to a file if requested through the environment
+    startCaptureFromEnvironment();
+
+    // Serve OpenMetrics if requested through the environment
+    startMetricsExporterFromEnvironment();
+
     // Return whether JVMTI is available for precise tracking
     return isJvmtiAvailable() ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT jlong JNICALL
 Java_NativeBufferMonitor_createBuffer(JNIEnv* env, jclass clazz, jint capacity) {
-    std::lock_guard<std::mutex> lock(stateMutex);
     return createBuffer(capacity);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_releaseBuffer(JNIEnv* env, jclass clazz, jlong bufferId) {
+    return releaseBuffer(bufferId) ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT void JNICALL
 Java_NativeBufferMonitor_updateBufferMetrics(
     JNIEnv* env, jclass clazz, jlong bufferId, jint size, jlong memoryUsage
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
+    OverheadTimer timer(OVERHEAD_UPDATE);
     updateBufferMetrics(bufferId, size, memoryUsage);
 }
 
@@ -52,26 +111,41 @@ Java_NativeBufferMonitor_recordSuspension(
     JNIEnv* env, jclass clazz, jlong threadId, jstring threadName, jlong bufferId,
     jint bufferSize, jint bufferCapacity
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
     recordSuspension(env, threadId, threadName, bufferId, bufferSize, bufferCapacity);
 }
 
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_registerThread(JNIEnv* env, jclass clazz, jlong threadId, jstring threadName) {
+    registerEventThread(env, threadId, threadName);
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_recordBufferSuspension(
+    JNIEnv* env, jclass clazz, jlong bufferId, jint bufferSize, jint bufferCapacity
+) {
+    recordSuspension(bufferId, bufferSize, bufferCapacity);
+}
+
+// Critical variant without env and class, bound instead of the one above by HotSpot
+// JDKs up to 17 when -XX:+CriticalJNINatives is on; later JDKs never look it up
+JNIEXPORT void JNICALL
+JavaCritical_NativeBufferMonitor_recordBufferSuspension(jlong bufferId, jint bufferSize, jint bufferCapacity) {
+    recordSuspension(bufferId, bufferSize, bufferCapacity);
+}
+
 JNIEXPORT jlong JNICALL
 Java_NativeBufferMonitor_getBufferMemoryUsage(JNIEnv* env, jclass clazz, jlong bufferId) {
-    std::lock_guard<std::mutex> lock(stateMutex);
     return getBufferMemoryUsage(bufferId);
 }
 
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getBufferSize(JNIEnv* env, jclass clazz, jlong bufferId) {
-    std::lock_guard<std::mutex> lock(stateMutex);
     jint size = getBufferSize(bufferId);
     return size;
 }
 
 JNIEXPORT jlong JNICALL
 Java_NativeBufferMonitor_getTotalTrackedMemory(JNIEnv* env, jclass clazz) {
-    std::lock_guard<std::mutex> lock(stateMutex);
     return getTotalTrackedMemory();
 }
 
@@ -80,16 +154,212 @@ Java_NativeBufferMonitor_getObjectSize(JNIEnv* env, jclass clazz, jobject obj) {
     return getObjectSize(env, obj);
 }
 
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_setObjectSizeSampling(JNIEnv* env, jclass clazz, jint arraySampleInterval) {
+    setArraySampleInterval(arraySampleInterval);
+}
+
+// Class names in class index order; classes are only ever appended, so the
+// names stay aligned with getClassMemoryStats
+JNIEXPORT jobjectArray JNICALL
+Java_NativeBufferMonitor_getTrackedClassNames(JNIEnv* env, jclass clazz) {
+    std::vector<ClassMemoryInfo> classes = refreshMemoryByClass();
+    jclass stringClass = env->FindClass("java/lang/String");
+    if (stringClass == nullptr) {
+        return nullptr;
+    }
+    jobjectArray result = env->NewObjectArray(static_cast<jsize>(classes.size()), stringClass, nullptr);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < classes.size(); i++) {
+        jstring name = env->NewStringUTF(classes[i].className.c_str());
+        env->SetObjectArrayElement(result, static_cast<jsize>(i), name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// Instance count, total bytes and last update time per class, in class index order
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getClassMemoryStats(JNIEnv* env, jclass clazz) {
+    std::vector<ClassMemoryInfo> classes = refreshMemoryByClass();
+    std::vector<jlong> stats;
+    stats.reserve(classes.size() * 3);
+    for (size_t i = 0; i < classes.size(); i++) {
+        stats.push_back(classes[i].instanceCount);
+        stats.push_back(classes[i].totalMemory);
+        stats.push_back(classes[i].lastUpdateTime);
+    }
+
+    jlongArray result = env->NewLongArray(static_cast<jsize>(stats.size()));
+    if (result != nullptr && !stats.empty()) {
+        env->SetLongArrayRegion(result, 0, static_cast<jsize>(stats.size()), &stats[0]);
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_setRetainedSizeTracking(JNIEnv* env, jclass clazz, jboolean enabled) {
+    setRetainedSizeTracking(enabled == JNI_TRUE);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_startRetainedSizePass(JNIEnv* env, jclass clazz, jint budgetMillis) {
+    JavaVM* vm;
+    if (env->GetJavaVM(&vm) != JNI_OK) {
+        return JNI_FALSE;
+    }
+    return startRetainedSizePass(vm, budgetMillis) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_getRetainedSize(JNIEnv* env, jclass clazz, jlong bufferId) {
+    return getRetainedSize(bufferId);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getRetainedSizeStatus(JNIEnv* env, jclass clazz) {
+    RetainedSizeStatus status = getRetainedSizeStatus();
+    jlong fields[kRetainedSizeStatusFields] = {
+        status.passes, status.lastPassTime, status.lastPassNanos, status.lastPassComplete,
+        status.running, status.totalRetainedBytes, status.totalObjects
+    };
+
+    jlongArray result = env->NewLongArray(kRetainedSizeStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kRetainedSizeStatusFields, fields);
+    }
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_setGcTracking(JNIEnv* env, jclass clazz, jboolean enabled) {
+    return setGcTracking(enabled == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_setAllocationSampling(JNIEnv* env, jclass clazz, jint intervalBytes) {
+    return setAllocationSampling(intervalBytes) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getGcPauses(JNIEnv* env, jclass clazz, jlong sinceTimestamp, jint maxPauses) {
+    if (maxPauses <= 0) {
+        return env->NewLongArray(0);
+    }
+    // The ring never holds more, so a huge request must not size the copy
+    if (maxPauses > kGcPauseCapacity) {
+        maxPauses = kGcPauseCapacity;
+    }
+    std::vector<GcPause> pauses(static_cast<size_t>(maxPauses));
+    jint count = getGcPauses(sinceTimestamp, pauses.data(), maxPauses);
+
+    // Flattened as start, duration, allocated bytes, cycle length per pause
+    std::vector<jlong> flat(static_cast<size_t>(count) * kGcPauseFields);
+    for (jint i = 0; i < count; i++) {
+        jlong* row = &flat[static_cast<size_t>(i) * kGcPauseFields];
+        row[0] = pauses[i].start;
+        row[1] = pauses[i].durationNanos;
+        row[2] = pauses[i].allocatedBytes;
+        row[3] = pauses[i].cycleNanos;
+    }
+
+    jlongArray result = env->NewLongArray(count * kGcPauseFields);
+    if (result != nullptr && count > 0) {
+        env->SetLongArrayRegion(result, 0, count * kGcPauseFields, flat.data());
+    }
+    return result;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getGcStatus(JNIEnv* env, jclass clazz) {
+    GcStatus status = getGcStatus();
+    jlong fields[kGcStatusFields] = {
+        status.collections, status.totalPauseNanos, status.maxPauseNanos, status.lastPauseTime,
+        status.allocationSamples, status.sampledBytes, status.estimatedAllocatedBytes,
+        status.samplingInterval, status.gcTrackingEnabled
+    };
+
+    jlongArray result = env->NewLongArray(kGcStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kGcStatusFields, fields);
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_setBackpressureDetection(
+    JNIEnv* env, jclass clazz, jlong warningNanos, jlong smoothingNanos
+) {
+    setBackpressureDetection(warningNanos, smoothingNanos);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_pollBackpressureAlerts(JNIEnv* env, jclass clazz, jint maxAlerts) {
+    if (maxAlerts <= 0) {
+        return env->NewLongArray(0);
+    }
+    // The queue never holds more, so a huge request must not size the copy
+    if (maxAlerts > kBackpressureAlertCapacity) {
+        maxAlerts = kBackpressureAlertCapacity;
+    }
+    std::vector<BackpressureAlert> alerts(static_cast<size_t>(maxAlerts));
+    jint count = pollBackpressureAlerts(alerts.data(), maxAlerts);
+
+    // Flattened in BackpressureAlert field order
+    std::vector<jlong> flat(static_cast<size_t>(count) * kBackpressureAlertFields);
+    for (jint i = 0; i < count; i++) {
+        jlong* row = &flat[static_cast<size_t>(i) * kBackpressureAlertFields];
+        row[0] = alerts[i].bufferId;
+        row[1] = alerts[i].time;
+        row[2] = alerts[i].kind;
+        row[3] = alerts[i].timeToFullNanos;
+        row[4] = alerts[i].size;
+        row[5] = alerts[i].capacity;
+        row[6] = alerts[i].emitRate;
+        row[7] = alerts[i].consumeRate;
+    }
+
+    jlongArray result = env->NewLongArray(count * kBackpressureAlertFields);
+    if (result != nullptr && count > 0) {
+        env->SetLongArrayRegion(result, 0, count * kBackpressureAlertFields, flat.data());
+    }
+    return result;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getBackpressureStatus(JNIEnv* env, jclass clazz, jlong bufferId) {
+    BackpressureStatus status;
+    if (!getBackpressureStatus(bufferId, status)) {
+        return nullptr;
+    }
+    jlong fields[kBackpressureStatusFields] = {
+        status.emitRate, status.consumeRate, status.timeToFullNanos, status.alerting
+    };
+
+    jlongArray result = env->NewLongArray(kBackpressureStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kBackpressureStatusFields, fields);
+    }
+    return result;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_getDroppedBackpressureAlerts(JNIEnv* env, jclass clazz) {
+    return getDroppedBackpressureAlerts();
+}
+
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getTotalSuspensions(JNIEnv* env, jclass clazz) {
-    return getSuspensionCount();
+    return saturateToJint(getSuspensionCount());
 }
 
 JNIEXPORT void JNICALL
 Java_NativeBufferMonitor_recordEmission(
     JNIEnv* env, jclass clazz, jlong bufferId
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
+    OverheadTimer timer(OVERHEAD_COUNTER);
     recordEmission(bufferId);
 }
 
@@ -97,48 +367,564 @@ JNIEXPORT void JNICALL
 Java_NativeBufferMonitor_recordConsumption(
     JNIEnv* env, jclass clazz, jlong bufferId
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
+    OverheadTimer timer(OVERHEAD_COUNTER);
     recordConsumption(bufferId);
 }
 
+// Measures the value and records the whole emission in one crossing; returns the
+// measured size, or in sampled mode possibly the buffer's estimated entry size
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_onEmit(
+    JNIEnv* env, jclass clazz, jlong bufferId, jobject value
+) {
+    OverheadTimer timer(OVERHEAD_EMIT);
+    attachEventThread(env);
+    jint weight = getTrackingWeight(bufferId);
+    if (weight == 0) {
+        return recordSkippedEmit(bufferId);
+    }
+    jlong entrySize = getObjectSize(env, value);
+    recordEmit(bufferId, entrySize, weight);
+    tagRetainedEntry(bufferId, value);
+    return entrySize;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_onConsume(
+    JNIEnv* env, jclass clazz, jlong bufferId, jlong entrySize, jlong residencyNanos, jobject value
+) {
+    OverheadTimer timer(OVERHEAD_CONSUME);
+    recordConsume(bufferId, entrySize, residencyNanos);
+    untagRetainedEntry(value);
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_cancelEmit(
+    JNIEnv* env, jclass clazz, jlong bufferId, jlong entrySize, jobject value
+) {
+    cancelEmit(bufferId, entrySize);
+    untagRetainedEntry(value);
+}
+
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getTotalEmissions(
     JNIEnv* env, jclass clazz
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return getTotalEmissions();
+    return saturateToJint(getTotalEmissions());
 }
 
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getTotalConsumptions(
     JNIEnv* env, jclass clazz
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return getTotalConsumptions();
+    return saturateToJint(getTotalConsumptions());
 }
 
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getBufferEmissions(
     JNIEnv* env, jclass clazz, jlong bufferId
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return getBufferEmissions(bufferId);
+    return saturateToJint(getBufferEmissions(bufferId));
 }
 
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getBufferConsumptions(
     JNIEnv* env, jclass clazz, jlong bufferId
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return getBufferConsumptions(bufferId);
+    return saturateToJint(getBufferConsumptions(bufferId));
 }
 
 JNIEXPORT jint JNICALL
 Java_NativeBufferMonitor_getBufferSuspensionCount(
     JNIEnv* env, jclass clazz, jlong bufferId
 ) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return getBufferSuspensionCount(bufferId);
+    return saturateToJint(getBufferSuspensionCount(bufferId));
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_recordSuspensionDuration(
+    JNIEnv* env, jclass clazz, jlong bufferId, jlong nanos
+) {
+    attachEventThread(env);
+    recordSuspensionDuration(bufferId, nanos);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getBufferEventTimeline(
+    JNIEnv* env, jclass clazz, jint type, jlong bufferId, jlong sinceTimestamp, jint maxEvents
+) {
+    if (maxEvents <= 0) {
+        return env->NewLongArray(0);
+    }
+    // The history never holds more, so a huge request must not size the copy
+    if (maxEvents > kEventHistoryCapacity) {
+        maxEvents = kEventHistoryCapacity;
+    }
+    std::vector<BufferEvent> events(static_cast<size_t>(maxEvents));
+    jint count = getEventTimeline(type, bufferId, sinceTimestamp, events.data(), maxEvents);
+
+    // Flattened as type, timestamp, thread id, buffer id, size, capacity, value per event
+    const jint fields = 7;
+    std::vector<jlong> flat(static_cast<size_t>(count) * fields);
+    for (jint i = 0; i < count; i++) {
+        const BufferEvent& event = events[i];
+        jlong* row = &flat[static_cast<size_t>(i) * fields];
+        row[0] = event.type;
+        row[1] = event.timestamp;
+        row[2] = event.threadId;
+        row[3] = event.bufferId;
+        row[4] = event.size;
+        row[5] = event.capacity;
+        row[6] = event.value;
+    }
+
+    jlongArray result = env->NewLongArray(count * fields);
+    if (result != nullptr && count > 0) {
+        env->SetLongArrayRegion(result, 0, count * fields, flat.data());
+    }
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_NativeBufferMonitor_getEventThreadName(JNIEnv* env, jclass clazz, jlong threadId) {
+    std::string name = getEventThreadName(threadId);
+    return name.empty() ? nullptr : env->NewStringUTF(name.c_str());
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getEventCounts(JNIEnv* env, jclass clazz) {
+    jlong counts[EVENT_TYPE_COUNT + 1];
+    for (jint type = 0; type < EVENT_TYPE_COUNT; type++) {
+        counts[type] = getEventCount(type);
+    }
+    counts[EVENT_TYPE_COUNT] = getDroppedEventCount();
+
+    jlongArray result = env->NewLongArray(EVENT_TYPE_COUNT + 1);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, EVENT_TYPE_COUNT + 1, counts);
+    }
+    return result;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_getLatencyPercentile(
+    JNIEnv* env, jclass clazz, jlong bufferId, jint kind, jdouble percentile
+) {
+    return getLatencyPercentile(bufferId, kind, percentile);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_exportLatencyHistogram(
+    JNIEnv* env, jclass clazz, jlong bufferId, jint kind
+) {
+    jlong exported[LatencyHistogram::kExportLength];
+    if (!exportLatencyHistogram(bufferId, kind, exported)) {
+        return nullptr;
+    }
+    jlongArray result = env->NewLongArray(LatencyHistogram::kExportLength);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, LatencyHistogram::kExportLength, exported);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_setBufferHistoryEnabled(JNIEnv* env, jclass clazz, jboolean enabled) {
+    setBufferHistoryEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getBufferHistory(
+    JNIEnv* env, jclass clazz, jlong bufferId, jint tier, jlong fromTime, jlong toTime, jint maxPoints
+) {
+    // A tier never holds more, so a huge request must not size the copy
+    jint capacity = BufferHistory::tierCapacity(tier);
+    if (maxPoints > capacity) {
+        maxPoints = capacity;
+    }
+    if (maxPoints <= 0) {
+        return env->NewLongArray(0);
+    }
+    std::vector<HistoryPoint> points(static_cast<size_t>(maxPoints));
+    jint count = getBufferHistory(bufferId, tier, fromTime, toTime, points.data(), maxPoints);
+
+    // Flattened as start, count, min/max/sum size, min/max/sum memory per point
+    std::vector<jlong> flat(static_cast<size_t>(count) * kHistoryPointFields);
+    for (jint i = 0; i < count; i++) {
+        const HistoryPoint& point = points[i];
+        jlong* row = &flat[static_cast<size_t>(i) * kHistoryPointFields];
+        row[0] = point.start;
+        row[1] = point.count;
+        row[2] = point.minSize;
+        row[3] = point.maxSize;
+        row[4] = point.sumSize;
+        row[5] = point.minMemory;
+        row[6] = point.maxMemory;
+        row[7] = point.sumMemory;
+    }
+
+    jlongArray result = env->NewLongArray(count * kHistoryPointFields);
+    if (result != nullptr && count > 0) {
+        env->SetLongArrayRegion(result, 0, count * kHistoryPointFields, flat.data());
+    }
+    return result;
+}
+
+namespace {
+
+RingChannel* toRingChannel(jlong channel) {
+    return reinterpret_cast<RingChannel*>(static_cast<intptr_t>(channel));
+}
+
+} // namespace
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_createRingChannel(JNIEnv* env, jclass clazz, jint capacity) {
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(createRingChannel(capacity)));
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_ringChannelBufferId(JNIEnv* env, jclass clazz, jlong channel) {
+    return channel != 0 ? toRingChannel(channel)->bufferId() : 0;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_ringSendLong(
+    JNIEnv* env, jclass clazz, jlong channel, jlong value, jlong suspendedSince
+) {
+    if (channel == 0) {
+        return kRingClosed;
+    }
+    attachEventThread(env);
+    RingChannel* ring = toRingChannel(channel);
+    jlong result = ring->reserve(suspendedSince);
+    if (result != kRingSent) {
+        return result;
+    }
+
+    RingEntry entry;
+    entry.value = value;
+    entry.enqueuedAt = getCurrentTimeMs();
+    entry.bytes = nullptr;
+    ring->publish(entry, RingChannel::entrySize(entry), suspendedSince);
+    return kRingSent;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_ringSendBytes(
+    JNIEnv* env, jclass clazz, jlong channel, jbyteArray value, jlong suspendedSince
+) {
+    if (channel == 0) {
+        return kRingClosed;
+    }
+    attachEventThread(env);
+    RingChannel* ring = toRingChannel(channel);
+    jlong result = ring->reserve(suspendedSince);
+    if (result != kRingSent) {
+        return result;
+    }
+
+    // Copied only once a slot is held, so a producer retrying on a full channel copies nothing
+    jsize length = env->GetArrayLength(value);
+    jbyte* bytes = static_cast<jbyte*>(malloc(length > 0 ? static_cast<size_t>(length) : 1));
+    if (bytes == nullptr) {
+        LOG_ERROR("Failed to allocate %d bytes for a ring channel entry", length);
+        ring->unreserve();
+        return kRingClosed;
+    }
+    env->GetByteArrayRegion(value, 0, length, bytes);
+
+    RingEntry entry;
+    entry.value = length;
+    entry.enqueuedAt = getCurrentTimeMs();
+    entry.bytes = bytes;
+    ring->publish(entry, RingChannel::entrySize(entry), suspendedSince);
+    return kRingSent;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_ringReceiveLong(JNIEnv* env, jclass clazz, jlong channel, jlongArray result) {
+    RingEntry entry;
+    if (channel == 0 || !toRingChannel(channel)->receive(entry)) {
+        return JNI_FALSE;
+    }
+    env->SetLongArrayRegion(result, 0, 1, &entry.value);
+    return JNI_TRUE;
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_NativeBufferMonitor_ringReceiveBytes(JNIEnv* env, jclass clazz, jlong channel) {
+    RingEntry entry;
+    if (channel == 0 || !toRingChannel(channel)->receive(entry)) {
+        return nullptr;
+    }
+    jsize length = static_cast<jsize>(entry.value);
+    jbyteArray result = env->NewByteArray(length);
+    if (result != nullptr) {
+        env->SetByteArrayRegion(result, 0, length, entry.bytes);
+    }
+    free(entry.bytes);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_closeRingChannel(JNIEnv* env, jclass clazz, jlong channel) {
+    if (channel != 0) {
+        toRingChannel(channel)->close();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_destroyRingChannel(JNIEnv* env, jclass clazz, jlong channel) {
+    destroyRingChannel(toRingChannel(channel));
+}
+
+// Flattened as the aggregate fields, then size, capacity and utilization per fullest buffer
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getBufferAggregates(
+    JNIEnv* env, jclass clazz, jint maxFullest
+) {
+    if (maxFullest < 0) {
+        maxFullest = 0;
+    }
+    std::vector<FullBuffer> fullest(static_cast<size_t>(maxFullest));
+    BufferAggregates aggregates;
+    jint count = aggregateBuffers(aggregates, fullest.data(), maxFullest);
+
+    std::vector<jlong> flat(static_cast<size_t>(kBufferAggregateFields + count * kFullBufferFields));
+    flat[0] = aggregates.bufferCount;
+    flat[1] = aggregates.totalEmissions;
+    flat[2] = aggregates.totalConsumptions;
+    flat[3] = aggregates.totalSuspensions;
+    flat[4] = aggregates.totalMemoryUsage;
+    flat[5] = aggregates.totalSize;
+    flat[6] = aggregates.totalCapacity;
+    flat[7] = aggregates.maxUtilizationPermille;
+    flat[8] = aggregates.fullestBufferId;
+    for (jint i = 0; i < count; i++) {
+        jlong* row = &flat[static_cast<size_t>(kBufferAggregateFields + i * kFullBufferFields)];
+        row[0] = fullest[i].bufferId;
+        row[1] = fullest[i].size;
+        row[2] = fullest[i].capacity;
+        row[3] = fullest[i].utilizationPermille;
+    }
+
+    jint length = static_cast<jint>(flat.size());
+    jlongArray result = env->NewLongArray(length);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, length, flat.data());
+    }
+    return result;
+}
+
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_snapshotAll(
+    JNIEnv* env, jclass clazz, jobject byteBuffer
+) {
+    void* address = env->GetDirectBufferAddress(byteBuffer);
+    jlong capacity = env->GetDirectBufferCapacity(byteBuffer);
+    if (address == nullptr || capacity < 0) {
+        LOG_WARN("Warning: snapshotAll requires a direct ByteBuffer");
+        return 0;
+    }
+    return snapshotAll(address, capacity);
+}
+
+JNIEXPORT jstring JNICALL
+Java_NativeBufferMonitor_startSharedMemoryExport(
+    JNIEnv* env, jclass clazz, jint intervalMillis, jint maxBuffers
+) {
+    if (!startSharedMemoryExport(intervalMillis, maxBuffers)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(getSharedMemoryPath().c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_stopSharedMemoryExport(JNIEnv* env, jclass clazz) {
+    stopSharedMemoryExport();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_startCapture(JNIEnv* env, jclass clazz, jstring path, jint snapshotIntervalMillis) {
+    return startCapture(jstringToString(env, path), snapshotIntervalMillis) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_stopCapture(JNIEnv* env, jclass clazz) {
+    stopCapture();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getCaptureStatus(JNIEnv* env, jclass clazz) {
+    CaptureStatus status = getCaptureStatus();
+    jlong fields[kCaptureStatusFields] = {
+        status.active, status.bytesWritten, status.chunkCount, status.eventCount, status.snapshotCount,
+        status.droppedEvents
+    };
+
+    jlongArray result = env->NewLongArray(kCaptureStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kCaptureStatusFields, fields);
+    }
+    return result;
+}
+
+// Labels are "key=value" strings, outermost group first; null means no labels
+JNIEXPORT jlong JNICALL
+Java_NativeBufferMonitor_createLabeledBuffer(
+    JNIEnv* env, jclass clazz, jint capacity, jstring name, jobjectArray labels
+) {
+    std::vector<std::string> labelStrings;
+    jsize labelCount = labels != nullptr ? env->GetArrayLength(labels) : 0;
+    labelStrings.reserve(labelCount);
+    for (jsize i = 0; i < labelCount; i++) {
+        jstring label = static_cast<jstring>(env->GetObjectArrayElement(labels, i));
+        labelStrings.push_back(jstringToString(env, label));
+        env->DeleteLocalRef(label);
+    }
+    return createLabeledBuffer(capacity, jstringToString(env, name), labelStrings);
+}
+
+JNIEXPORT jstring JNICALL
+Java_NativeBufferMonitor_getBufferName(JNIEnv* env, jclass clazz, jlong bufferId) {
+    std::string name = getBufferName(bufferId);
+    return name.empty() ? nullptr : env->NewStringUTF(name.c_str());
+}
+
+JNIEXPORT jint JNICALL
+Java_NativeBufferMonitor_getBufferGroupOf(JNIEnv* env, jclass clazz, jlong bufferId) {
+    return getBufferGroupOf(bufferId);
+}
+
+JNIEXPORT jint JNICALL
+Java_NativeBufferMonitor_findBufferGroup(JNIEnv* env, jclass clazz, jstring path) {
+    return findBufferGroup(jstringToString(env, path));
+}
+
+// Group paths indexed by group id; groups are only ever appended
+JNIEXPORT jobjectArray JNICALL
+Java_NativeBufferMonitor_getBufferGroupPaths(JNIEnv* env, jclass clazz) {
+    std::vector<std::string> paths = getBufferGroupPaths();
+    jclass stringClass = env->FindClass("java/lang/String");
+    if (stringClass == nullptr) {
+        return nullptr;
+    }
+    jobjectArray result = env->NewObjectArray(static_cast<jsize>(paths.size()), stringClass, nullptr);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < paths.size(); i++) {
+        jstring path = env->NewStringUTF(paths[i].c_str());
+        env->SetObjectArrayElement(result, static_cast<jsize>(i), path);
+        env->DeleteLocalRef(path);
+    }
+    return result;
+}
+
+// Buffer count, capacity, size, memory usage, emissions, consumptions and
+// suspensions of a group and everything below it; null for an unknown group
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getBufferGroupTotals(JNIEnv* env, jclass clazz, jint groupId) {
+    BufferGroupTotals totals;
+    if (!getBufferGroupTotals(groupId, totals)) {
+        return nullptr;
+    }
+    jlong fields[kBufferGroupTotalsFields] = {
+        totals.bufferCount, totals.capacity, totals.size, totals.memoryUsage,
+        totals.emissions, totals.consumptions, totals.suspensions
+    };
+
+    jlongArray result = env->NewLongArray(kBufferGroupTotalsFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kBufferGroupTotalsFields, fields);
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_setOverheadBudget(JNIEnv* env, jclass clazz, jint budgetPpm) {
+    setOverheadBudget(budgetPpm);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getOverheadStatus(JNIEnv* env, jclass clazz) {
+    OverheadStatus status = getOverheadStatus();
+    jlong fields[kOverheadStatusFields] = {
+        status.budgetPpm, status.overheadPpm, status.activeThreads, status.sampledBuffers, status.totalNanos
+    };
+
+    jlongArray result = env->NewLongArray(kOverheadStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kOverheadStatusFields, fields);
+    }
+    return result;
+}
+
+// Estimated calls, estimated total nanoseconds and mean nanoseconds per call, in OverheadOperation order
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getOverheadCosts(JNIEnv* env, jclass clazz) {
+    jlong fields[kOverheadOperations * kOverheadCostFields];
+    for (jint operation = 0; operation < kOverheadOperations; operation++) {
+        OverheadCost cost = getOverheadCost(static_cast<OverheadOperation>(operation));
+        fields[operation * kOverheadCostFields] = cost.calls;
+        fields[operation * kOverheadCostFields + 1] = cost.totalNanos;
+        fields[operation * kOverheadCostFields + 2] = cost.meanNanos;
+    }
+
+    jlongArray result = env->NewLongArray(kOverheadOperations * kOverheadCostFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kOverheadOperations * kOverheadCostFields, fields);
+    }
+    return result;
+}
+
+// 1 while the buffer is tracked exactly, also for unknown buffers
+JNIEXPORT jint JNICALL
+Java_NativeBufferMonitor_getBufferSamplePeriod(JNIEnv* env, jclass clazz, jlong bufferId) {
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    jint period = metrics != nullptr ? metrics->samplePeriod() : 1;
+    return period > 1 ? period : 1;
+}
+
+// Bound address, or null if the socket could not be opened
+JNIEXPORT jstring JNICALL
+Java_NativeBufferMonitor_startMetricsExporter(JNIEnv* env, jclass clazz, jstring address) {
+    std::string bound = startMetricsExporter(jstringToString(env, address));
+    if (bound.empty()) {
+        return nullptr;
+    }
+    return env->NewStringUTF(bound.c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_NativeBufferMonitor_stopMetricsExporter(JNIEnv* env, jclass clazz) {
+    stopMetricsExporter();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_NativeBufferMonitor_setSuspensionStackSampling(JNIEnv* env, jclass clazz, jint sampleRate, jint maxDepth) {
+    return setSuspensionStackSampling(sampleRate, maxDepth) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_NativeBufferMonitor_getSuspensionStackStatus(JNIEnv* env, jclass clazz) {
+    SuspensionStackStatus status = getSuspensionStackStatus();
+    jlong fields[kSuspensionStackStatusFields] = {
+        status.sampleRate, status.samples, status.droppedSamples, status.nodes
+    };
+
+    jlongArray result = env->NewLongArray(kSuspensionStackStatusFields);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, kSuspensionStackStatusFields, fields);
+    }
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_NativeBufferMonitor_getCollapsedSuspensionStacks(JNIEnv* env, jclass clazz, jlong bufferId) {
+    return env->NewStringUTF(getCollapsedSuspensionStacks(env, bufferId).c_str());
 }
 
 JNIEXPORT void JNICALL
@@ -155,5 +941,13 @@ Java_NativeBufferMonitor_clearTracking(
     // Clear suspension events
     clearSuspensionTracking();
 
-    std::cout << "[Native] All tracking data cleared" << std::endl;
+    // Drop the last retained size pass
+    clearRetainedSizes();
+
+    // Forget recorded GC pauses and allocation samples
+    clearGcTracking();
+    clearBackpressure();
+    clearOverhead();
+
+    LOG_INFO("All tracking data cleared");
 }
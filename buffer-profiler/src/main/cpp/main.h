@@ -5,9 +5,13 @@
 
 // JNI method declarations
 extern "C" {
+    // Library lifecycle
+    JNIEXPORT void JNICALL JNI_OnUnload(JavaVM*, void*);
+
     // Initialization method
     JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_initialize(JNIEnv*, jclass);
     JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_createBuffer(JNIEnv*, jclass, jint);
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_releaseBuffer(JNIEnv*, jclass, jlong);
     JNIEXPORT void JNICALL Java_NativeBufferMonitor_updateBufferMetrics(JNIEnv*, jclass, jlong, jint, jlong);
 
     // Memory measurement methods
@@ -15,12 +19,43 @@ extern "C" {
     JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_getBufferMemoryUsage(JNIEnv*, jclass, jlong);
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getBufferSize(JNIEnv*, jclass, jlong);
     JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_getTotalTrackedMemory(JNIEnv*, jclass);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_setObjectSizeSampling(JNIEnv*, jclass, jint);
+    JNIEXPORT jobjectArray JNICALL Java_NativeBufferMonitor_getTrackedClassNames(JNIEnv*, jclass);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getClassMemoryStats(JNIEnv*, jclass);
+
+    // Retained size of buffered entries from a background heap walk
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_setRetainedSizeTracking(JNIEnv*, jclass, jboolean);
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_startRetainedSizePass(JNIEnv*, jclass, jint);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_getRetainedSize(JNIEnv*, jclass, jlong);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getRetainedSizeStatus(JNIEnv*, jclass);
+
+    // GC pauses and sampled allocations from JVMTI events
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_setGcTracking(JNIEnv*, jclass, jboolean);
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_setAllocationSampling(JNIEnv*, jclass, jint);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getGcPauses(JNIEnv*, jclass, jlong, jint);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getGcStatus(JNIEnv*, jclass);
+
+    // Early warning for buffers predicted to fill up
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_setBackpressureDetection(JNIEnv*, jclass, jlong, jlong);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_pollBackpressureAlerts(JNIEnv*, jclass, jint);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getBackpressureStatus(JNIEnv*, jclass, jlong);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_getDroppedBackpressureAlerts(JNIEnv*, jclass);
 
     // Emission and consumption tracking methods
     JNIEXPORT void JNICALL Java_NativeBufferMonitor_recordEmission(JNIEnv*, jclass, jlong);
     JNIEXPORT void JNICALL Java_NativeBufferMonitor_recordConsumption(JNIEnv*, jclass, jlong);
     JNIEXPORT void JNICALL Java_NativeBufferMonitor_recordSuspension(JNIEnv*, jclass, jlong, jstring, jlong, jint, jint);
 
+    // Per-thread registration, after which the record paths take primitives only
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_registerThread(JNIEnv*, jclass, jlong, jstring);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_recordBufferSuspension(JNIEnv*, jclass, jlong, jint, jint);
+    JNIEXPORT void JNICALL JavaCritical_NativeBufferMonitor_recordBufferSuspension(jlong, jint, jint);
+
+    // Fused per-item bookkeeping, one JNI crossing per emitted or consumed item
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_onEmit(JNIEnv*, jclass, jlong, jobject);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_onConsume(JNIEnv*, jclass, jlong, jlong, jlong, jobject);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_cancelEmit(JNIEnv*, jclass, jlong, jlong, jobject);
+
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getTotalEmissions(JNIEnv*, jclass);
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getTotalConsumptions(JNIEnv*, jclass);
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getTotalSuspensions(JNIEnv*, jclass);
@@ -29,6 +64,68 @@ extern "C" {
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getBufferConsumptions(JNIEnv*, jclass, jlong);
     JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getBufferSuspensionCount(JNIEnv*, jclass, jlong);
 
+    // Latency histograms
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_recordSuspensionDuration(JNIEnv*, jclass, jlong, jlong);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_getLatencyPercentile(JNIEnv*, jclass, jlong, jint, jdouble);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_exportLatencyHistogram(JNIEnv*, jclass, jlong, jint);
+
+    // Size and memory time series
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_setBufferHistoryEnabled(JNIEnv*, jclass, jboolean);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getBufferHistory(JNIEnv*, jclass, jlong, jint, jlong, jlong, jint);
+
+    // Suspension timeline from the per-thread event rings
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getBufferEventTimeline(JNIEnv*, jclass, jint, jlong, jlong, jint);
+    JNIEXPORT jstring JNICALL Java_NativeBufferMonitor_getEventThreadName(JNIEnv*, jclass, jlong);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getEventCounts(JNIEnv*, jclass);
+
+    // Native ring-buffer channels that own their buffer's occupancy
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_createRingChannel(JNIEnv*, jclass, jint);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_ringChannelBufferId(JNIEnv*, jclass, jlong);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_ringSendLong(JNIEnv*, jclass, jlong, jlong, jlong);
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_ringSendBytes(JNIEnv*, jclass, jlong, jbyteArray, jlong);
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_ringReceiveLong(JNIEnv*, jclass, jlong, jlongArray);
+    JNIEXPORT jbyteArray JNICALL Java_NativeBufferMonitor_ringReceiveBytes(JNIEnv*, jclass, jlong);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_closeRingChannel(JNIEnv*, jclass, jlong);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_destroyRingChannel(JNIEnv*, jclass, jlong);
+
+    // Totals, maximum utilization and fullest buffers in one pass
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getBufferAggregates(JNIEnv*, jclass, jint);
+
+    // Bulk snapshot of every buffer into a direct ByteBuffer
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_snapshotAll(JNIEnv*, jclass, jobject);
+
+    // Shared-memory export for out-of-process readers
+    JNIEXPORT jstring JNICALL Java_NativeBufferMonitor_startSharedMemoryExport(JNIEnv*, jclass, jint, jint);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_stopSharedMemoryExport(JNIEnv*, jclass);
+
+    // Capture of events and snapshots to a file for offline replay
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_startCapture(JNIEnv*, jclass, jstring, jint);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_stopCapture(JNIEnv*, jclass);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getCaptureStatus(JNIEnv*, jclass);
+
+    // Named, labeled buffers and their hierarchical group totals
+    JNIEXPORT jlong JNICALL Java_NativeBufferMonitor_createLabeledBuffer(JNIEnv*, jclass, jint, jstring, jobjectArray);
+    JNIEXPORT jstring JNICALL Java_NativeBufferMonitor_getBufferName(JNIEnv*, jclass, jlong);
+    JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getBufferGroupOf(JNIEnv*, jclass, jlong);
+    JNIEXPORT jint JNICALL Java_NativeBufferMonitor_findBufferGroup(JNIEnv*, jclass, jstring);
+    JNIEXPORT jobjectArray JNICALL Java_NativeBufferMonitor_getBufferGroupPaths(JNIEnv*, jclass);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getBufferGroupTotals(JNIEnv*, jclass, jint);
+
+    // Self-measured overhead and the budget governor
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_setOverheadBudget(JNIEnv*, jclass, jint);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getOverheadStatus(JNIEnv*, jclass);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getOverheadCosts(JNIEnv*, jclass);
+    JNIEXPORT jint JNICALL Java_NativeBufferMonitor_getBufferSamplePeriod(JNIEnv*, jclass, jlong);
+
+    // OpenMetrics endpoint for scrapers
+    JNIEXPORT jstring JNICALL Java_NativeBufferMonitor_startMetricsExporter(JNIEnv*, jclass, jstring);
+    JNIEXPORT void JNICALL Java_NativeBufferMonitor_stopMetricsExporter(JNIEnv*, jclass);
+
+    // Stack samples at suspension points
+    JNIEXPORT jboolean JNICALL Java_NativeBufferMonitor_setSuspensionStackSampling(JNIEnv*, jclass, jint, jint);
+    JNIEXPORT jlongArray JNICALL Java_NativeBufferMonitor_getSuspensionStackStatus(JNIEnv*, jclass);
+    JNIEXPORT jstring JNICALL Java_NativeBufferMonitor_getCollapsedSuspensionStacks(JNIEnv*, jclass, jlong);
+
     // Reset methods
     JNIEXPORT void JNICALL Java_NativeBufferMonitor_clearTracking(JNIEnv*, jclass);
 }
@@ -1,49 +1,291 @@
 #include "memory_tracking.h"
 #include "buffer_tracking.h"
 #include "utils.h"
-#include <iostream>
-#include <sstream>
+#include "logging.h"
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Tags with this bit mark java.lang.Class objects known to the size cache; the
+// low bits hold the class index. Other tags are left alone.
+const jlong kClassTagBit = static_cast<jlong>(1) << 62;
+const jlong kClassIndexMask = 0xFFFFFFFF;
+const jint kMaxClasses = 4096;
+
+// Size and attribution data of one class. Entries are never removed, and the
+// name and array flag are written before the entry is published.
+struct ClassSizeEntry {
+    std::string name;
+    bool isArray;
+    std::atomic<jlong> instanceSize;  // Shallow size of a non-array instance, 0 until measured
+    std::atomic<uint64_t> seen;       // Array instances seen, drives sampling
+    std::atomic<jlong> sampledBytes;  // Bytes of the measured arrays
+    std::atomic<jlong> sampledCount;  // Number of measured arrays
+    std::atomic<jlong> instanceCount; // Instances attributed to this class
+    std::atomic<jlong> totalMemory;   // Measured or estimated bytes attributed to this class
+    std::atomic<jlong> lastUpdateTime;
+};
+
+ClassSizeEntry classEntries[kMaxClasses];
+std::atomic<jint> classCount(0);
+std::mutex classRegistrationMutex;
+std::atomic<jint> arraySampleInterval(kDefaultArraySampleInterval);
+
+// Weak class refs of threads that exited. A thread-local destructor has no
+// JNIEnv to delete them with, so the next lookup on any thread does.
+struct RetiredClasses {
+    RetiredClasses() : pending(false) {}
+
+    std::mutex mutex;
+    std::vector<jweak> refs;
+    std::atomic<bool> pending;
+};
+
+RetiredClasses& retiredClasses() {
+    // Never destroyed, so a thread exiting during shutdown cannot touch a freed list
+    static RetiredClasses* retired = new RetiredClasses();
+    return *retired;
+}
+
+// Last class seen by this thread; emitters usually send one type in a row.
+// Holds one weak ref, replaced on every class change and retired when the thread exits.
+struct LastClass {
+    LastClass() : klass(nullptr), entry(nullptr) {}
+
+    ~LastClass() {
+        if (klass != nullptr) {
+            RetiredClasses& retired = retiredClasses();
+            std::lock_guard<std::mutex> lock(retired.mutex);
+            retired.refs.push_back(klass);
+            retired.pending.store(true, std::memory_order_release);
+        }
+    }
+
+    void replace(JNIEnv* env, jclass newClass, ClassSizeEntry* newEntry) {
+        if (klass != nullptr) {
+            env->DeleteWeakGlobalRef(klass);
+        }
+        klass = env->NewWeakGlobalRef(newClass);
+        entry = klass != nullptr ? newEntry : nullptr;
+    }
+
+    jweak klass;
+    ClassSizeEntry* entry;
+};
+
+thread_local LastClass lastClass;
+
+void deleteRetiredClasses(JNIEnv* env) {
+    RetiredClasses& retired = retiredClasses();
+    if (!retired.pending.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<jweak> refs;
+    {
+        std::lock_guard<std::mutex> lock(retired.mutex);
+        refs.swap(retired.refs);
+        retired.pending.store(false, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < refs.size(); i++) {
+        env->DeleteWeakGlobalRef(refs[i]);
+    }
+}
+
+// "Ljava/lang/String;" -> "java.lang.String", "[I" -> "int[]"
+std::string toClassName(const std::string& signature) {
+    size_t dimensions = 0;
+    while (dimensions < signature.size() && signature[dimensions] == '[') {
+        dimensions++;
+    }
+
+    std::string name;
+    std::string element = signature.substr(dimensions);
+    if (element.size() > 2 && element[0] == 'L' && element[element.size() - 1] == ';') {
+        name = element.substr(1, element.size() - 2);
+        std::replace(name.begin(), name.end(), '/', '.');
+    } else if (element.size() == 1) {
+        switch (element[0]) {
+            case 'Z': name = "boolean"; break;
+            case 'B': name = "byte"; break;
+            case 'C': name = "char"; break;
+            case 'S': name = "short"; break;
+            case 'I': name = "int"; break;
+            case 'J': name = "long"; break;
+            case 'F': name = "float"; break;
+            case 'D': name = "double"; break;
+            default: name = element; break;
+        }
+    } else {
+        name = element;
+    }
+
+    for (size_t i = 0; i < dimensions; i++) {
+        name += "[]";
+    }
+    return name;
+}
+
+// Finds the entry for a class through its tag, registering the class on first sight
+ClassSizeEntry* classEntryFor(jclass klass) {
+    jlong tag = getObjectTagJvmti(klass);
+    if ((tag & kClassTagBit) != 0) {
+        return &classEntries[tag & kClassIndexMask];
+    }
+
+    std::lock_guard<std::mutex> lock(classRegistrationMutex);
+    // Another thread may have registered the class while we waited
+    tag = getObjectTagJvmti(klass);
+    if ((tag & kClassTagBit) != 0) {
+        return &classEntries[tag & kClassIndexMask];
+    }
+
+    jint index = classCount.load(std::memory_order_relaxed);
+    if (index >= kMaxClasses) {
+        return nullptr;
+    }
+    std::string signature = getClassSignatureJvmti(klass);
+    if (signature.empty()) {
+        return nullptr;
+    }
+
+    ClassSizeEntry* entry = &classEntries[index];
+    entry->name = toClassName(signature);
+    entry->isArray = signature[0] == '[';
+    if (!setObjectTagJvmti(klass, kClassTagBit | index)) {
+        return nullptr;
+    }
+    classCount.store(index + 1, std::memory_order_release);
+
+    LOG_DEBUG("Size cache registered class %s as %d", entry->name.c_str(), index);
+    return entry;
+}
+
+ClassSizeEntry* classEntryForObject(JNIEnv* env, jobject obj) {
+    jclass klass = env->GetObjectClass(obj);
+    if (klass == nullptr) {
+        return nullptr;
+    }
+
+    ClassSizeEntry* entry;
+    if (lastClass.entry != nullptr && env->IsSameObject(lastClass.klass, klass)) {
+        entry = lastClass.entry;
+    } else {
+        deleteRetiredClasses(env);
+        entry = classEntryFor(klass);
+        if (entry != nullptr) {
+            lastClass.replace(env, klass, entry);
+        }
+    }
+    env->DeleteLocalRef(klass);
+    return entry;
+}
+
+// Size of one instance, measuring only when the cache cannot answer
+jlong sizeFromEntry(ClassSizeEntry* entry, jobject obj) {
+    if (!entry->isArray) {
+        jlong size = entry->instanceSize.load(std::memory_order_relaxed);
+        if (size == 0) {
+            size = getObjectSizeJvmti(obj);
+            entry->instanceSize.store(size, std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    jint interval = arraySampleInterval.load(std::memory_order_relaxed);
+    uint64_t seen = entry->seen.fetch_add(1, std::memory_order_relaxed);
+    jlong sampledCount = entry->sampledCount.load(std::memory_order_relaxed);
+    if (interval <= 1 || sampledCount == 0 || seen % static_cast<uint64_t>(interval) == 0) {
+        jlong size = getObjectSizeJvmti(obj);
+        if (size > 0) {
+            entry->sampledBytes.fetch_add(size, std::memory_order_relaxed);
+            entry->sampledCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return size;
+    }
+    return entry->sampledBytes.load(std::memory_order_relaxed) / sampledCount;
+}
+
+} // namespace
 
 void initializeMemoryTrackingWithJvm(JavaVM* vm) {
     jint result = initializeJvmti(vm);
     if (result == JNI_OK) {
-        std::cout << "[Native] Memory monitoring initialized with JVMTI" << std::endl;
+        LOG_INFO("Memory monitoring initialized with JVMTI");
     } else {
-        std::cout << "[Native] Memory monitoring initialization failed" << std::endl;
+        LOG_INFO("Memory monitoring initialization failed");
     }
 }
 
-// Get object size using JVMTI, or return a default value if not available
+// Get object size using JVMTI and the per-class cache, or return 0 if not available
 jlong getObjectSize(JNIEnv* env, jobject obj) {
     if (obj == nullptr) {
         return 0;
     }
 
-    // Try to get size using JVMTI (precise measurement)
-    if (isJvmtiAvailable()) {
-        jlong size = getObjectSizeJvmti(obj);
-        if (size > 0) {
-            return size;
-        }
+    if (!isJvmtiAvailable()) {
+        // No measurement available
+        return 0;
+    }
+
+    ClassSizeEntry* entry = classEntryForObject(env, obj);
+    if (entry == nullptr) {
+        // Class could not be cached; measure directly
+        return getObjectSizeJvmti(obj);
     }
 
-    // If JVMTI is not available or failed, return 0
-    // This indicates that we don't have a valid measurement
-    std::cout << "[Native] JVMTI not available, cannot measure object size" << std::endl;
-    return 0; // No measurement available
+    jlong size = sizeFromEntry(entry, obj);
+    if (size > 0) {
+        entry->instanceCount.fetch_add(1, std::memory_order_relaxed);
+        entry->totalMemory.fetch_add(size, std::memory_order_relaxed);
+        entry->lastUpdateTime.store(getCurrentTimeMs(), std::memory_order_relaxed);
+    }
+    return size;
 }
 
 // Get total memory usage for all tracked objects
 jlong getTotalTrackedMemory() {
     jlong totalMemory = 0;
-    for (const auto& pair : bufferMetrics) {
-        totalMemory += pair.second.totalMemoryUsage;
-    }
+    bufferMetrics.forEach([&totalMemory](jlong, const BufferMetrics& metrics) {
+        totalMemory += metrics.totalMemoryUsage.load(std::memory_order_relaxed);
+    });
     return totalMemory;
 }
 
-// Clear all memory tracking data
+void setArraySampleInterval(jint interval) {
+    arraySampleInterval.store(interval < 1 ? 1 : interval, std::memory_order_relaxed);
+    LOG_INFO("Array size sampling set to 1 in %d", interval < 1 ? 1 : interval);
+}
+
+std::vector<ClassMemoryInfo> refreshMemoryByClass() {
+    jint count = classCount.load(std::memory_order_acquire);
+    std::vector<ClassMemoryInfo> classes;
+    classes.reserve(count);
+
+    std::lock_guard<std::mutex> lock(memoryByClassMutex);
+    for (jint i = 0; i < count; i++) {
+        const ClassSizeEntry& entry = classEntries[i];
+        ClassMemoryInfo info;
+        info.className = entry.name;
+        info.instanceCount = entry.instanceCount.load(std::memory_order_relaxed);
+        info.totalMemory = entry.totalMemory.load(std::memory_order_relaxed);
+        info.lastUpdateTime = entry.lastUpdateTime.load(std::memory_order_relaxed);
+        memoryByClass[info.className] = info;
+        classes.push_back(info);
+    }
+    return classes;
+}
+
+// Clear all memory tracking data; cached sizes are kept since they stay valid
 void clearMemoryTracking() {
+    jint count = classCount.load(std::memory_order_acquire);
+    for (jint i = 0; i < count; i++) {
+        classEntries[i].instanceCount.store(0, std::memory_order_relaxed);
+        classEntries[i].totalMemory.store(0, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(memoryByClassMutex);
     memoryByClass.clear();
 }
@@ -6,6 +6,7 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
 
 // Memory tracking structures
 struct ClassMemoryInfo {
@@ -15,13 +16,25 @@ struct ClassMemoryInfo {
     jlong lastUpdateTime;
 };
 
+// Object sizes are cached per class. A class is identified by a JVMTI tag on
+// its java.lang.Class object, so after the first instance a lookup is a tag
+// read (or a thread-local compare when the same class repeats). Non-array
+// classes have a fixed shallow size, which is measured once. Arrays vary in
+// length, so 1 in N of them is measured and the others are estimated from the
+// mean of the measured ones; N = 1 measures every array.
+static const jint kDefaultArraySampleInterval = 16;
+
 // Function declarations
 void initializeMemoryTrackingWithJvm(JavaVM* vm);
 jlong getObjectSize(JNIEnv* env, jobject obj);
 jlong getTotalTrackedMemory();
+void setArraySampleInterval(jint interval);
+// Rebuilds memoryByClass from the class cache and returns a copy ordered by class index
+std::vector<ClassMemoryInfo> refreshMemoryByClass();
 void clearMemoryTracking();
 
-// Extern declaration for global memory state
+// Extern declaration for global memory state; guarded by memoryByClassMutex
 extern std::unordered_map<std::string, ClassMemoryInfo> memoryByClass;
+extern std::mutex memoryByClassMutex;
 
 #endif /* MEMORY_TRACKING_H */
@@ -0,0 +1,256 @@
+#include "metrics_exporter.h"
+#include "openmetrics_server.h"
+#include "snapshot.h"
+#include "overhead.h"
+#include "buffer_tracking.h"
+#include "logging.h"
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+const jlong kInitialSnapshotBuffers = 256;
+
+struct ExporterState {
+    ExporterState() : listenFd(-1), server(nullptr) {
+        wakeFds[0] = -1;
+        wakeFds[1] = -1;
+    }
+
+    int listenFd;
+    int wakeFds[2];         // Writing to wakeFds[1] stops the server loop
+    std::thread* server;    // Heap-allocated so a running thread never reaches a static destructor
+    std::string address;    // Bound address; a Unix socket file is removed on stop
+    std::mutex mutex;
+};
+
+ExporterState& exporterState() {
+    static ExporterState* state = new ExporterState();
+    return *state;
+}
+
+// Text output that keeps its storage between scrapes
+class TextBuffer {
+public:
+    TextBuffer() : length(0) {}
+
+    void clear() {
+        length = 0;
+    }
+
+    void append(const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 2, 3)))
+#endif
+    {
+        while (true) {
+            size_t room = data.size() - length;
+            va_list arguments;
+            va_start(arguments, format);
+            int written = vsnprintf(room > 0 ? &data[length] : nullptr, room, format, arguments);
+            va_end(arguments);
+            if (written < 0) {
+                return;
+            }
+            if (static_cast<size_t>(written) < room) {
+                length += static_cast<size_t>(written);
+                return;
+            }
+            data.resize(data.size() * 2 > length + written + 1 ? data.size() * 2 : length + written + 1);
+        }
+    }
+
+    const char* bytes() const {
+        return data.empty() ? "" : &data[0];
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    std::vector<char> data;
+    size_t length;
+};
+
+// Snapshot columns, see snapshot.h
+struct SnapshotView {
+    const MetricsSnapshotHeader* header;
+    const int64_t* handles;
+    const int64_t* memoryUsage;
+    const int64_t* emissions;
+    const int64_t* consumptions;
+    const int64_t* suspensions;
+    const int32_t* capacities;
+    const int32_t* sizes;
+};
+
+// Takes a snapshot into storage, growing it until every buffer fits
+SnapshotView takeSnapshot(std::vector<int64_t>& storage) {
+    if (storage.empty()) {
+        storage.resize(static_cast<size_t>((snapshotRequiredBytes(kInitialSnapshotBuffers) + 7) / 8));
+    }
+    while (true) {
+        jlong capacity = static_cast<jlong>(storage.size() * sizeof(int64_t));
+        jlong written = snapshotAll(&storage[0], capacity);
+        if (written >= 0) {
+            break;
+        }
+        // Room for the buffers that did not fit plus some growth
+        storage.resize(static_cast<size_t>((-written * 5 / 4 + 7) / 8));
+    }
+
+    SnapshotView view;
+    const char* base = reinterpret_cast<const char*>(&storage[0]);
+    view.header = reinterpret_cast<const MetricsSnapshotHeader*>(base);
+    jlong stride = view.header->columnStride;
+    view.handles = reinterpret_cast<const int64_t*>(base + sizeof(MetricsSnapshotHeader));
+    view.memoryUsage = view.handles + stride;
+    view.emissions = view.memoryUsage + stride;
+    view.consumptions = view.emissions + stride;
+    view.suspensions = view.consumptions + stride;
+    view.capacities = reinterpret_cast<const int32_t*>(view.suspensions + 2 * stride); // Skips lastUpdateTime
+    view.sizes = view.capacities + stride;
+    return view;
+}
+
+// One metric family with a sample per buffer; counters get the _total suffix
+void renderFamily(TextBuffer& text, const SnapshotView& view, const char* name, const char* type,
+                  const char* unit, const char* help, const int64_t* values64, const int32_t* values32) {
+    bool counter = strcmp(type, "counter") == 0;
+    text.append("# TYPE %s %s\n", name, type);
+    if (unit != nullptr) {
+        text.append("# UNIT %s %s\n", name, unit);
+    }
+    text.append("# HELP %s %s\n", name, help);
+    for (uint32_t row = 0; row < view.header->bufferCount; row++) {
+        long long value = values64 != nullptr ? static_cast<long long>(values64[row])
+                                              : static_cast<long long>(values32[row]);
+        text.append("%s%s{buffer=\"%lld\"} %lld\n", name, counter ? "_total" : "",
+                    static_cast<long long>(view.handles[row]), value);
+    }
+}
+
+void renderMetrics(TextBuffer& text, std::vector<int64_t>& snapshotStorage) {
+    SnapshotView view = takeSnapshot(snapshotStorage);
+    text.clear();
+
+    text.append("# TYPE buffermonitor_buffers gauge\n");
+    text.append("# HELP buffermonitor_buffers Live tracked buffers.\n");
+    text.append("buffermonitor_buffers %u\n", view.header->bufferCount);
+
+    renderFamily(text, view, "buffermonitor_buffer_size", "gauge", nullptr,
+                 "Entries in the buffer, including producers about to suspend.", nullptr, view.sizes);
+    renderFamily(text, view, "buffermonitor_buffer_capacity", "gauge", nullptr,
+                 "Capacity of the buffer.", nullptr, view.capacities);
+    renderFamily(text, view, "buffermonitor_buffer_memory_bytes", "gauge", "bytes",
+                 "Memory of the entries in the buffer.", view.memoryUsage, nullptr);
+    renderFamily(text, view, "buffermonitor_buffer_emissions", "counter", nullptr,
+                 "Items emitted into the buffer.", view.emissions, nullptr);
+    renderFamily(text, view, "buffermonitor_buffer_consumptions", "counter", nullptr,
+                 "Items consumed from the buffer.", view.consumptions, nullptr);
+    renderFamily(text, view, "buffermonitor_buffer_suspensions", "counter", nullptr,
+                 "Producer suspensions on a full buffer.", view.suspensions, nullptr);
+
+    OverheadStatus overhead = getOverheadStatus();
+    text.append("# TYPE buffermonitor_agent_time_seconds counter\n");
+    text.append("# UNIT buffermonitor_agent_time_seconds seconds\n");
+    text.append("# HELP buffermonitor_agent_time_seconds Estimated time spent in the agent's per-item calls.\n");
+    text.append("buffermonitor_agent_time_seconds_total %.9f\n", overhead.totalNanos / 1e9);
+    text.append("# EOF\n");
+}
+
+// Renders a fresh page for every scrape into buffers owned by the server thread
+class ExporterSource : public OpenMetricsSource {
+public:
+    void render(const char*& bytes, size_t& length) {
+        renderMetrics(text, snapshotStorage);
+        bytes = text.bytes();
+        length = text.size();
+    }
+
+private:
+    TextBuffer text;
+    std::vector<int64_t> snapshotStorage;
+};
+
+void serverLoop(int listenFd, int wakeFd) {
+    ExporterSource source;
+    while (serveOpenMetricsClient(listenFd, wakeFd, -1, source)) {
+    }
+}
+
+} // namespace
+
+std::string startMetricsExporter(const std::string& address) {
+    ExporterState& state = exporterState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.server != nullptr) {
+        return state.address;
+    }
+
+    std::string bound;
+    std::string error;
+    int listenFd = openOpenMetricsListener(address, bound, error);
+    if (listenFd < 0) {
+        LOG_ERROR("%s", error.c_str());
+        return std::string();
+    }
+    if (pipe(state.wakeFds) != 0) {
+        LOG_ERROR("Could not create the metrics exporter wake pipe: %s", strerror(errno));
+        closeOpenMetricsListener(listenFd, bound);
+        return std::string();
+    }
+
+    state.listenFd = listenFd;
+    state.address = bound;
+    state.server = new std::thread(serverLoop, listenFd, state.wakeFds[0]);
+
+    LOG_INFO("Serving OpenMetrics at %s/metrics", bound.c_str());
+    return bound;
+}
+
+void stopMetricsExporter() {
+    ExporterState& state = exporterState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.server == nullptr) {
+        return;
+    }
+
+    char wake = 1;
+    while (write(state.wakeFds[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+    state.server->join();
+    delete state.server;
+    state.server = nullptr;
+
+    closeOpenMetricsListener(state.listenFd, state.address);
+    close(state.wakeFds[0]);
+    close(state.wakeFds[1]);
+    LOG_INFO("Stopped serving OpenMetrics at %s", state.address.c_str());
+    state.listenFd = -1;
+    state.wakeFds[0] = -1;
+    state.wakeFds[1] = -1;
+    state.address.clear();
+}
+
+std::string getMetricsExporterAddress() {
+    ExporterState& state = exporterState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.address;
+}
+
+void startMetricsExporterFromEnvironment() {
+    const char* address = getenv("BUFFERMONITOR_METRICS_ADDRESS");
+    if (address == nullptr || *address == '\0') {
+        return;
+    }
+    startMetricsExporter(address);
+}
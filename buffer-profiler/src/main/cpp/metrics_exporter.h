@@ -0,0 +1,32 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <jni.h>
+#include <string>
+
+// Optional OpenMetrics endpoint for scrapers such as Prometheus.
+// A background thread listens on a local TCP port or a Unix socket and answers
+// GET /metrics with every live buffer's size, capacity, memory and counters in
+// the OpenMetrics text format. Each scrape takes the same lock-free snapshot
+// as snapshotAll and renders it into buffers owned by the thread, which only
+// grow when the registry does, so a scrape allocates nothing in steady state
+// and never blocks the record paths. Connections are served one at a time and
+// closed after the response.
+
+// Starts serving on address, which is "unix:<path>", "<host>:<port>" or just a
+// port (bound to 127.0.0.1; port 0 picks a free one). Returns the bound
+// address in the same form, or an empty string if the socket could not be
+// opened. Calling it again while running changes nothing and returns the
+// current address.
+std::string startMetricsExporter(const std::string& address);
+
+// Stops serving and closes the socket; a Unix socket file is removed
+void stopMetricsExporter();
+
+// Bound address while serving, empty otherwise
+std::string getMetricsExporterAddress();
+
+// Starts the exporter if BUFFERMONITOR_METRICS_ADDRESS is set in the environment
+void startMetricsExporterFromEnvironment();
+
+#endif /* METRICS_EXPORTER_H */
@@ -0,0 +1,134 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov's array queue).
+// Each cell carries a sequence number that tells producers and consumers whose
+// turn it is, so both sides need a single CAS on their own cursor. The cursors
+// are padded onto separate cache lines to keep producers and consumers from
+// false sharing. Capacity must be a power of two.
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity)
+        : buffer(new Cell[capacity]), mask(capacity - 1) {
+        enqueue.pos.store(0, std::memory_order_relaxed);
+        dequeue.pos.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < capacity; i++) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue() {
+        delete[] buffer;
+    }
+
+    // Returns false without blocking if the queue is full
+    bool tryPush(const T& value) {
+        return tryPushWith(CopyIn(value));
+    }
+
+    // Returns false without blocking if the queue is empty
+    bool tryPop(T& value) {
+        return tryPopWith(CopyOut(value));
+    }
+
+    // Claims a cell and lets fill(T&) write the element in place, avoiding a copy of large elements
+    template <typename Fill>
+    bool tryPushWith(const Fill& fill) {
+        Cell* cell;
+        size_t pos = enqueue.pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &buffer[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue.pos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Claims the oldest cell and hands it to drain(const T&) before releasing it to producers
+    template <typename Drain>
+    bool tryPopWith(const Drain& drain) {
+        Cell* cell;
+        size_t pos = dequeue.pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &buffer[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue.pos.load(std::memory_order_relaxed);
+            }
+        }
+        drain(const_cast<const T&>(cell->value));
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Approximate number of queued items; exact only when no operation is in flight
+    size_t sizeApprox() const {
+        size_t head = dequeue.pos.load(std::memory_order_acquire);
+        size_t tail = enqueue.pos.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+private:
+    static const size_t kCacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // A cursor on its own cache line, with padding on both sides
+    struct PaddedCursor {
+        char leading[kCacheLineSize];
+        std::atomic<size_t> pos;
+        char trailing[kCacheLineSize - sizeof(std::atomic<size_t>)];
+    };
+
+    struct CopyIn {
+        explicit CopyIn(const T& source) : source(source) {}
+        void operator()(T& target) const { target = source; }
+        const T& source;
+    };
+
+    struct CopyOut {
+        explicit CopyOut(T& target) : target(target) {}
+        void operator()(const T& source) const { target = source; }
+        T& target;
+    };
+
+    MpmcQueue(const MpmcQueue&);
+    MpmcQueue& operator=(const MpmcQueue&);
+
+    Cell* const buffer;
+    const size_t mask;
+    PaddedCursor enqueue;
+    PaddedCursor dequeue;
+};
+
+#endif /* MPMC_QUEUE_H */
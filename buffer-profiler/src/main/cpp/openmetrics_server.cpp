@@ -0,0 +1,216 @@
+#include "openmetrics_server.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char kUnixPrefix[] = "unix:";
+const char kDefaultHost[] = "127.0.0.1";
+const int kListenBacklog = 16;
+const int kRequestTimeoutMillis = 1000;
+const size_t kMaxRequestBytes = 8192;
+
+const char kContentType[] = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL; // A scraper that hangs up must not kill the process with SIGPIPE
+#else
+const int kSendFlags = 0;
+#endif
+
+bool isUnixAddress(const std::string& address) {
+    return address.compare(0, strlen(kUnixPrefix), kUnixPrefix) == 0;
+}
+
+bool sendAll(int fd, const char* bytes, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, bytes, length, kSendFlags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Reads up to the end of the request headers; false on timeout, error or an oversized request
+bool readRequest(int fd, char* request, size_t capacity) {
+    size_t length = 0;
+    while (length + 1 < capacity) {
+        pollfd readable = {fd, POLLIN, 0};
+        if (poll(&readable, 1, kRequestTimeoutMillis) <= 0) {
+            return false;
+        }
+        ssize_t received = recv(fd, request + length, capacity - 1 - length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        length += static_cast<size_t>(received);
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") != nullptr || strstr(request, "\n\n") != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void sendStatus(int fd, const char* status) {
+    char response[256];
+    int length = snprintf(response, sizeof(response),
+                          "HTTP/1.1 %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\nConnection: close\r\n\r\n%s\n",
+                          status, static_cast<unsigned>(strlen(status) + 1), status);
+    sendAll(fd, response, static_cast<size_t>(length));
+}
+
+void serveClient(int fd, OpenMetricsSource& source) {
+    char request[kMaxRequestBytes];
+    if (!readRequest(fd, request, sizeof(request))) {
+        return;
+    }
+
+    // Request line: METHOD SP TARGET SP VERSION
+    if (strncmp(request, "GET ", 4) != 0) {
+        sendStatus(fd, "405 Method Not Allowed");
+        return;
+    }
+    const char* target = request + 4;
+    size_t pathLength = strcspn(target, " ?\r\n");
+    if (pathLength != strlen("/metrics") || strncmp(target, "/metrics", pathLength) != 0) {
+        sendStatus(fd, "404 Not Found");
+        return;
+    }
+
+    const char* bytes = nullptr;
+    size_t length = 0;
+    source.render(bytes, length);
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %llu\r\nConnection: close\r\n\r\n",
+                                kContentType, static_cast<unsigned long long>(length));
+    if (sendAll(fd, header, static_cast<size_t>(headerLength))) {
+        sendAll(fd, bytes, length);
+    }
+}
+
+int openUnixSocket(const std::string& path, std::string& bound, std::string& error) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Unix socket path '" + path + "' is empty or too long";
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::string("Could not create a Unix socket: ") + strerror(errno);
+        return -1;
+    }
+    unlink(path.c_str()); // A socket file left by an earlier process would make bind fail
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, kListenBacklog) != 0) {
+        error = "Could not listen on " + path + ": " + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    bound = kUnixPrefix + path;
+    return fd;
+}
+
+int openTcpSocket(const std::string& hostAndPort, std::string& bound, std::string& error) {
+    std::string host = kDefaultHost;
+    std::string port = hostAndPort;
+    size_t colon = hostAndPort.rfind(':');
+    if (colon != std::string::npos) {
+        if (colon > 0) {
+            host = hostAndPort.substr(0, colon);
+        }
+        port = hostAndPort.substr(colon + 1);
+    }
+    char* end = nullptr;
+    long portNumber = strtol(port.c_str(), &end, 10);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(portNumber));
+    if (port.empty() || *end != '\0' || portNumber < 0 || portNumber > 65535 ||
+        inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        error = "Address '" + hostAndPort + "' is not host:port";
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::string("Could not create a TCP socket: ") + strerror(errno);
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    socklen_t length = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, kListenBacklog) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        error = "Could not listen on " + hostAndPort + ": " + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    bound = host + ":" + std::to_string(static_cast<long long>(ntohs(address.sin_port)));
+    return fd;
+}
+
+} // namespace
+
+int openOpenMetricsListener(const std::string& address, std::string& bound, std::string& error) {
+    if (isUnixAddress(address)) {
+        return openUnixSocket(address.substr(strlen(kUnixPrefix)), bound, error);
+    }
+    return openTcpSocket(address, bound, error);
+}
+
+void closeOpenMetricsListener(int listenFd, const std::string& address) {
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+    if (isUnixAddress(address)) {
+        unlink(address.c_str() + strlen(kUnixPrefix));
+    }
+}
+
+bool serveOpenMetricsClient(int listenFd, int wakeFd, int timeoutMillis, OpenMetricsSource& source) {
+    pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    int ready = poll(fds, wakeFd >= 0 ? 2 : 1, timeoutMillis);
+    if (ready < 0 && errno == EINTR) {
+        return true;
+    }
+    if (ready < 0 || (wakeFd >= 0 && (fds[1].revents & POLLIN) != 0)) {
+        return false;
+    }
+    if ((fds[0].revents & POLLIN) == 0) {
+        return true;
+    }
+    int client = accept(listenFd, nullptr, nullptr);
+    if (client < 0) {
+        return true;
+    }
+#if defined(SO_NOSIGPIPE)
+    int noSigpipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+    serveClient(client, source);
+    close(client);
+    return true;
+}
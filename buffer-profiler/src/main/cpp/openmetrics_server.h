@@ -0,0 +1,37 @@
+#ifndef OPENMETRICS_SERVER_H
+#define OPENMETRICS_SERVER_H
+
+#include <cstddef>
+#include <string>
+
+// Minimal HTTP serving of an OpenMetrics page, shared by the in-process
+// exporter (metrics_exporter.cpp) and the host collector
+// (tools/shm_collector.cpp). It needs neither JNI nor the library, so errors
+// are returned as text for the caller to log. Connections are served one at a
+// time: GET /metrics gets the page, other paths 404 and other methods 405, and
+// every connection is closed after the response.
+
+// Body of a /metrics response, rendered only when a scrape asks for it
+class OpenMetricsSource {
+public:
+    virtual ~OpenMetricsSource() {}
+
+    // Points bytes at the page; it must stay valid until the next call
+    virtual void render(const char*& bytes, size_t& length) = 0;
+};
+
+// Opens a listening socket on "unix:<path>", "<host>:<port>" or just a port
+// (bound to 127.0.0.1; port 0 picks a free one). Returns the socket and sets
+// bound to the bound address in the same form, or returns -1 and sets error.
+// A stale Unix socket file is replaced.
+int openOpenMetricsListener(const std::string& address, std::string& bound, std::string& error);
+
+// Closes a listening socket and removes its socket file if address is a Unix socket
+void closeOpenMetricsListener(int listenFd, const std::string& address);
+
+// Waits up to timeoutMillis (-1 for ever) for a client on listenFd and serves it.
+// A wakeFd >= 0 that becomes readable stops the wait. Returns false once woken or
+// when polling fails, true after serving a client, a timeout or a signal.
+bool serveOpenMetricsClient(int listenFd, int wakeFd, int timeoutMillis, OpenMetricsSource& source);
+
+#endif /* OPENMETRICS_SERVER_H */
@@ -0,0 +1,232 @@
+#include "overhead.h"
+#include "buffer_tracking.h"
+#include "logging.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+const jint kGovernorIntervalMillis = 100;
+const jlong kHotEventsPerSecond = 10000; // Emissions plus consumptions that make a buffer worth sampling
+const jlong kPartsPerMillion = 1000000;
+
+struct alignas(kCacheLineSize) OperationTotals {
+    std::atomic<jlong> timedCalls;
+    std::atomic<jlong> timedNanos;
+};
+
+OperationTotals totals[kOverheadOperations];
+
+// A thread counts itself as active once per governor interval, on its first timed call
+std::atomic<jlong> intervalEpoch(1);
+std::atomic<jlong> intervalThreads(0);
+
+struct GovernorState {
+    GovernorState()
+        : governor(nullptr), stopRequested(false), budgetPpm(0), overheadPpm(0), activeThreads(0),
+          sampledBuffers(0) {}
+
+    std::thread* governor; // Heap-allocated so a running thread never reaches a static destructor
+    bool stopRequested;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::atomic<jlong> budgetPpm;
+    std::atomic<jlong> overheadPpm;
+    std::atomic<jlong> activeThreads;
+    std::atomic<jlong> sampledBuffers;
+};
+
+GovernorState& governorState() {
+    static GovernorState* state = new GovernorState();
+    return *state;
+}
+
+// A timed call also pays for one clock read, which is not agent work; measured
+// once as the smallest gap between back-to-back reads
+jlong clockReadNanos() {
+    static const jlong nanos = [] {
+        jlong smallest = -1;
+        for (jint i = 0; i < 1000; i++) {
+            jlong start = getCurrentTimeMs();
+            jlong gap = getCurrentTimeMs() - start;
+            if (smallest < 0 || gap < smallest) {
+                smallest = gap;
+            }
+        }
+        return smallest;
+    }();
+    return nanos;
+}
+
+jlong timedNanosOf(jint operation) {
+    jlong nanos = totals[operation].timedNanos.load(std::memory_order_relaxed) -
+                  totals[operation].timedCalls.load(std::memory_order_relaxed) * clockReadNanos();
+    return nanos > 0 ? nanos : 0;
+}
+
+jlong totalTimedNanos() {
+    jlong total = 0;
+    for (jint operation = 0; operation < kOverheadOperations; operation++) {
+        total += timedNanosOf(operation);
+    }
+    return total;
+}
+
+// Moves every hot buffer one step towards sampling, or every sampled buffer one
+// step back towards exact tracking. lastEvents holds the event count of each
+// buffer at the previous step and is replaced by the current counts.
+jlong adjustSamplePeriods(bool overBudget, bool underHalfBudget, jlong elapsedNanos,
+                          std::unordered_map<jlong, jlong>& lastEvents) {
+    std::unordered_map<jlong, jlong> events;
+    jlong sampled = 0;
+    bufferMetrics.forEach([&](jlong bufferId, BufferMetrics& metrics) {
+        jlong count = metrics.count(COUNTER_EMISSIONS) + metrics.count(COUNTER_CONSUMPTIONS);
+        events[bufferId] = count;
+        std::unordered_map<jlong, jlong>::const_iterator previous = lastEvents.find(bufferId);
+        jlong delta = previous != lastEvents.end() ? count - previous->second : 0;
+        bool hot = delta * 1000000000LL >= kHotEventsPerSecond * elapsedNanos;
+
+        jint period = metrics.samplePeriod();
+        if (period < 1) {
+            period = 1;
+        }
+        if (overBudget && hot && period < kMaxSamplePeriod) {
+            period *= 2;
+            metrics.setSamplePeriod(period);
+        } else if (underHalfBudget && period > 1) {
+            period /= 2;
+            metrics.setSamplePeriod(period);
+        }
+        if (period > 1) {
+            sampled++;
+        }
+    });
+    lastEvents.swap(events);
+    return sampled;
+}
+
+void governorLoop() {
+    GovernorState& state = governorState();
+    std::unordered_map<jlong, jlong> lastEvents;
+    jlong lastTime = getCurrentTimeMs();
+    jlong lastNanos = totalTimedNanos();
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.stopRequested) {
+        state.wakeUp.wait_for(lock, std::chrono::milliseconds(kGovernorIntervalMillis),
+                              [&state] { return state.stopRequested; });
+        if (state.stopRequested) {
+            break;
+        }
+        lock.unlock();
+
+        jlong now = getCurrentTimeMs();
+        jlong elapsed = now - lastTime;
+        jlong timedNanos = totalTimedNanos();
+        jlong agentNanos = timedNanos - lastNanos; // Negative after clearOverhead
+        jlong threads = intervalThreads.exchange(0, std::memory_order_relaxed);
+        intervalEpoch.fetch_add(1, std::memory_order_relaxed);
+        lastTime = now;
+        lastNanos = timedNanos;
+
+        jlong overheadPpm = 0;
+        if (agentNanos > 0 && threads > 0 && elapsed > 0) {
+            overheadPpm = static_cast<jlong>(static_cast<double>(agentNanos) * kOverheadTimingInterval *
+                                             kPartsPerMillion / (static_cast<double>(elapsed) * threads));
+        }
+        jlong budget = state.budgetPpm.load(std::memory_order_relaxed);
+        jlong sampled = adjustSamplePeriods(overheadPpm > budget, overheadPpm < budget / 2, elapsed, lastEvents);
+        state.overheadPpm.store(overheadPpm, std::memory_order_relaxed);
+        state.activeThreads.store(threads, std::memory_order_relaxed);
+        state.sampledBuffers.store(sampled, std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
+
+} // namespace
+
+void recordOverheadSample(OverheadOperation operation, jlong nanos) {
+    static thread_local jlong seenEpoch = 0;
+    totals[operation].timedCalls.fetch_add(1, std::memory_order_relaxed);
+    totals[operation].timedNanos.fetch_add(nanos, std::memory_order_relaxed);
+
+    jlong epoch = intervalEpoch.load(std::memory_order_relaxed);
+    if (seenEpoch != epoch) {
+        seenEpoch = epoch;
+        intervalThreads.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void setOverheadBudget(jint budgetPpm) {
+    GovernorState& state = governorState();
+    if (budgetPpm <= 0) {
+        stopOverheadGovernor();
+        state.budgetPpm.store(0, std::memory_order_relaxed);
+        bufferMetrics.forEach([](jlong, BufferMetrics& metrics) {
+            metrics.setSamplePeriod(0);
+        });
+        state.sampledBuffers.store(0, std::memory_order_relaxed);
+        state.overheadPpm.store(0, std::memory_order_relaxed);
+        LOG_INFO("Overhead governor disabled, all buffers tracked exactly");
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.budgetPpm.store(budgetPpm, std::memory_order_relaxed);
+    if (state.governor == nullptr) {
+        state.stopRequested = false;
+        state.governor = new std::thread(governorLoop);
+    }
+    LOG_INFO("Overhead budget set to %d ppm of caller time", static_cast<int>(budgetPpm));
+}
+
+void stopOverheadGovernor() {
+    GovernorState& state = governorState();
+    std::thread* governor;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.governor == nullptr) {
+            return;
+        }
+        state.stopRequested = true;
+        governor = state.governor;
+        state.governor = nullptr;
+    }
+    state.wakeUp.notify_all();
+    governor->join();
+    delete governor;
+}
+
+OverheadStatus getOverheadStatus() {
+    GovernorState& state = governorState();
+    OverheadStatus status;
+    status.budgetPpm = state.budgetPpm.load(std::memory_order_relaxed);
+    status.overheadPpm = state.overheadPpm.load(std::memory_order_relaxed);
+    status.activeThreads = state.activeThreads.load(std::memory_order_relaxed);
+    status.sampledBuffers = state.sampledBuffers.load(std::memory_order_relaxed);
+    status.totalNanos = totalTimedNanos() * kOverheadTimingInterval;
+    return status;
+}
+
+OverheadCost getOverheadCost(OverheadOperation operation) {
+    jlong calls = totals[operation].timedCalls.load(std::memory_order_relaxed);
+    jlong nanos = timedNanosOf(operation);
+    OverheadCost cost;
+    cost.calls = calls * kOverheadTimingInterval;
+    cost.totalNanos = nanos * kOverheadTimingInterval;
+    cost.meanNanos = calls > 0 ? nanos / calls : 0;
+    return cost;
+}
+
+void clearOverhead() {
+    for (jint operation = 0; operation < kOverheadOperations; operation++) {
+        totals[operation].timedCalls.store(0, std::memory_order_relaxed);
+        totals[operation].timedNanos.store(0, std::memory_order_relaxed);
+    }
+    governorState().overheadPpm.store(0, std::memory_order_relaxed);
+}
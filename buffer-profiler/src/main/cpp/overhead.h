@@ -0,0 +1,91 @@
+#ifndef OVERHEAD_H
+#define OVERHEAD_H
+
+#include <jni.h>
+#include "utils.h"
+
+// Self-measured cost of the agent and an optional overhead budget.
+// The per-item JNI entry points time one call in kOverheadTimingInterval of
+// each thread with two steady clock reads and extrapolate to all calls, so
+// the measurement itself stays well under a nanosecond per call. Time spent
+// crossing JNI is not included.
+//
+// With a budget set, a governor thread compares the agent time estimated over
+// each interval with the time of the threads that called in during it. While
+// the share is over the budget it doubles the sample period of every hot
+// buffer (see BufferMetrics::trackingWeight): only one call in the period
+// measures the value and records counters, history and latency, scaled by the
+// period, and the others only move size and memory. Once the share drops below
+// half the budget, periods are halved again until the buffers are exact.
+
+enum OverheadOperation {
+    OVERHEAD_EMIT = 0,     // onEmit, including the object size
+    OVERHEAD_CONSUME = 1,  // onConsume
+    OVERHEAD_COUNTER = 2,  // recordEmission and recordConsumption
+    OVERHEAD_UPDATE = 3    // updateBufferMetrics
+};
+
+static const jint kOverheadOperations = 4;
+static const jint kOverheadTimingInterval = 64;
+
+struct OverheadCost {
+    jlong calls;      // Estimated from the timed calls
+    jlong totalNanos; // Estimated
+    jlong meanNanos;
+};
+
+static const jint kOverheadCostFields = 3;
+
+struct OverheadStatus {
+    jlong budgetPpm;      // Parts per million of the calling threads' time, 0 while the governor is off
+    jlong overheadPpm;    // Share measured over the last governor interval
+    jlong activeThreads;  // Threads that made a timed call during that interval
+    jlong sampledBuffers; // Buffers tracked in sampled mode
+    jlong totalNanos;     // Estimated time spent in the agent since the last clear
+};
+
+static const jint kOverheadStatusFields = 5;
+
+void recordOverheadSample(OverheadOperation operation, jlong nanos);
+
+// Times the enclosing scope for one call in kOverheadTimingInterval of the calling thread
+class OverheadTimer {
+public:
+    explicit OverheadTimer(OverheadOperation operation) : operation(operation), start(0) {
+        // Counted per operation, so operations that alternate are all sampled
+        static thread_local jint calls[kOverheadOperations] = {0, 0, 0, 0};
+        if (++calls[operation] == kOverheadTimingInterval) {
+            calls[operation] = 0;
+            start = getCurrentTimeMs();
+        }
+    }
+
+    ~OverheadTimer() {
+        if (start != 0) {
+            recordOverheadSample(operation, getCurrentTimeMs() - start);
+        }
+    }
+
+private:
+    OverheadTimer(const OverheadTimer&);
+    OverheadTimer& operator=(const OverheadTimer&);
+
+    OverheadOperation operation;
+    jlong start;
+};
+
+// Starts the governor with the given budget, or stops it and returns every
+// buffer to exact tracking when budgetPpm <= 0
+void setOverheadBudget(jint budgetPpm);
+
+// Stops the governor thread, leaving the sample periods as they are
+void stopOverheadGovernor();
+
+OverheadStatus getOverheadStatus();
+
+OverheadCost getOverheadCost(OverheadOperation operation);
+
+// Forgets the measured times; the budget stays
+void clearOverhead();
+
+#endif /* OVERHEAD_H */
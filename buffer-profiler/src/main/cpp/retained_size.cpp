@@ -0,0 +1,311 @@
+#include "retained_size.h"
+#include "buffer_tracking.h"
+#include "jvmti_agent.h"
+#include "utils.h"
+#include "logging.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+// Tag layout. Bit 62 belongs to the class size cache in memory_tracking.cpp.
+// Entry and owned tags carry a buffer key in the low 52 bits: the slot index
+// and the low 20 bits of the slot generation, which is enough to tell a
+// released buffer's leftover entries from those of the buffer reusing its slot.
+const jlong kEntryTagBit = static_cast<jlong>(1) << 61;   // An emitted value still in its buffer
+const jlong kOwnedTagBit = static_cast<jlong>(1) << 60;   // Reached from an entry during the current pass
+const jlong kCountedTagBit = static_cast<jlong>(1) << 59; // Entry already counted in the current pass
+const jlong kBufferKeyMask = (static_cast<jlong>(1) << 52) - 1;
+
+// How many reference callbacks run between two looks at the clock
+const uint64_t kBudgetCheckInterval = 1024;
+
+std::atomic<bool> trackingEnabled(false);
+
+jlong bufferKey(jlong bufferIdOrTag) {
+    return bufferIdOrTag & kBufferKeyMask;
+}
+
+struct Retained {
+    Retained() : bytes(0), objects(0) {}
+
+    jlong bytes;
+    jlong objects;
+};
+
+// State of one heap walk; only touched by the JVMTI callbacks on the walking thread
+struct Pass {
+    Pass(jlong deadline, bool removeEntryTags)
+        : deadline(deadline), callbacks(0), aborted(false), removeEntryTags(removeEntryTags) {}
+
+    void count(jlong key, jlong size) {
+        Retained& retained = byBuffer[key];
+        retained.bytes += size;
+        retained.objects++;
+    }
+
+    std::unordered_map<jlong, Retained> byBuffer;
+    jlong deadline;
+    uint64_t callbacks;
+    bool aborted;
+    bool removeEntryTags;
+};
+
+jint JNICALL countReference(jvmtiHeapReferenceKind kind, const jvmtiHeapReferenceInfo* /*info*/,
+                            jlong /*classTag*/, jlong /*referrerClassTag*/, jlong size, jlong* tagPtr,
+                            jlong* referrerTagPtr, jint /*length*/, void* userData) {
+    Pass* pass = static_cast<Pass*>(userData);
+    if (++pass->callbacks % kBudgetCheckInterval == 0 && getCurrentTimeMs() > pass->deadline) {
+        pass->aborted = true;
+        return JVMTI_VISIT_ABORT;
+    }
+
+    jlong tag = *tagPtr;
+    if ((tag & kEntryTagBit) != 0) {
+        if ((tag & kCountedTagBit) == 0) {
+            *tagPtr = tag | kCountedTagBit;
+            pass->count(bufferKey(tag), size);
+        }
+        return JVMTI_VISIT_OBJECTS;
+    }
+
+    // Only instance fields and array elements carry ownership; class, loader and
+    // static references lead to objects shared by the whole application
+    if (tag == 0 && referrerTagPtr != nullptr &&
+        (kind == JVMTI_HEAP_REFERENCE_FIELD || kind == JVMTI_HEAP_REFERENCE_ARRAY_ELEMENT)) {
+        jlong owner = *referrerTagPtr;
+        if ((owner & (kEntryTagBit | kOwnedTagBit)) != 0) {
+            *tagPtr = kOwnedTagBit | bufferKey(owner);
+            pass->count(bufferKey(owner), size);
+        }
+    }
+    return JVMTI_VISIT_OBJECTS;
+}
+
+// Drops the tags a pass added, and the entry tags themselves when tracking stops
+jint JNICALL removePassTags(jlong /*classTag*/, jlong /*size*/, jlong* tagPtr, jint /*length*/, void* userData) {
+    Pass* pass = static_cast<Pass*>(userData);
+    jlong tag = *tagPtr;
+    if ((tag & kOwnedTagBit) != 0) {
+        *tagPtr = 0;
+    } else if ((tag & kEntryTagBit) != 0) {
+        *tagPtr = pass->removeEntryTags ? 0 : tag & ~kCountedTagBit;
+    }
+    return 0;
+}
+
+void removeTags(Pass& pass) {
+    jvmtiHeapCallbacks callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.heap_iteration_callback = removePassTags;
+    jvmtiError error = iterateThroughHeapJvmti(JVMTI_HEAP_FILTER_UNTAGGED, &callbacks, &pass);
+    if (error != JVMTI_ERROR_NONE) {
+        LOG_ERROR("Failed to remove retained size tags: %d", error);
+    }
+}
+
+class RetainedSizeWalker {
+public:
+    RetainedSizeWalker() : running(false), worker(nullptr) {
+        memset(&status, 0, sizeof(status));
+    }
+
+    bool start(JavaVM* vm, jint budgetMillis) {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (running) {
+            return false;
+        }
+        // The previous worker, if any, has finished; reap it before starting another
+        if (worker != nullptr) {
+            worker->join();
+            delete worker;
+        }
+        running = true;
+        worker = new std::thread(&RetainedSizeWalker::run, this, vm, budgetMillis);
+        return true;
+    }
+
+    void wait() {
+        std::thread* finishing;
+        {
+            std::lock_guard<std::mutex> lock(controlMutex);
+            finishing = worker;
+            worker = nullptr;
+        }
+        if (finishing != nullptr) {
+            finishing->join();
+            delete finishing;
+        }
+    }
+
+    jlong retainedSize(jlong bufferId) {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        std::unordered_map<jlong, jlong>::const_iterator it = retained.find(bufferId);
+        return it != retained.end() ? it->second : -1;
+    }
+
+    RetainedSizeStatus currentStatus() {
+        RetainedSizeStatus current;
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            current = status;
+        }
+        std::lock_guard<std::mutex> lock(controlMutex);
+        current.running = running ? 1 : 0;
+        return current;
+    }
+
+    void clear() {
+        wait();
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        retained.clear();
+        memset(&status, 0, sizeof(status));
+    }
+
+private:
+    void run(JavaVM* vm, jint budgetMillis) {
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs args;
+        args.version = JNI_VERSION_1_6;
+        args.name = const_cast<char*>("buffermonitor-heap-walk");
+        args.group = nullptr;
+        if (vm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env), &args) != JNI_OK) {
+            LOG_ERROR("Failed to attach the heap walk thread");
+        } else {
+            walk(budgetMillis);
+            vm->DetachCurrentThread();
+        }
+
+        std::lock_guard<std::mutex> lock(controlMutex);
+        running = false;
+    }
+
+    void walk(jint budgetMillis) {
+        jlong startTime = getCurrentTimeMs();
+        Pass pass(startTime + static_cast<jlong>(budgetMillis) * 1000000, false);
+
+        jvmtiHeapCallbacks callbacks;
+        memset(&callbacks, 0, sizeof(callbacks));
+        callbacks.heap_reference_callback = countReference;
+        jvmtiError error = followReferencesJvmti(&callbacks, &pass);
+        if (error != JVMTI_ERROR_NONE) {
+            LOG_ERROR("Retained size heap walk failed: %d", error);
+        }
+        // Tags must go even after a failed or aborted walk, or the next pass would skip those objects
+        removeTags(pass);
+
+        // Match the counted keys against the buffers that are still live
+        std::unordered_map<jlong, jlong> byHandle;
+        jlong totalBytes = 0;
+        jlong totalObjects = 0;
+        bufferMetrics.forEach([&](jlong bufferId, const BufferMetrics&) {
+            std::unordered_map<jlong, Retained>::const_iterator it = pass.byBuffer.find(bufferKey(bufferId));
+            if (it != pass.byBuffer.end()) {
+                byHandle[bufferId] = it->second.bytes;
+                totalBytes += it->second.bytes;
+                totalObjects += it->second.objects;
+            }
+        });
+
+        jlong endTime = getCurrentTimeMs();
+        bool complete = error == JVMTI_ERROR_NONE && !pass.aborted;
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            retained.swap(byHandle);
+            status.passes++;
+            status.lastPassTime = endTime;
+            status.lastPassNanos = endTime - startTime;
+            status.lastPassComplete = complete ? 1 : 0;
+            status.totalRetainedBytes = totalBytes;
+            status.totalObjects = totalObjects;
+        }
+
+        LOG_INFO("Retained size pass %s: %lld bytes in %lld objects, %lld ms",
+                 complete ? "complete" : "stopped at its time budget",
+                 static_cast<long long>(totalBytes), static_cast<long long>(totalObjects),
+                 static_cast<long long>((endTime - startTime) / 1000000));
+    }
+
+    std::mutex controlMutex;
+    bool running;
+    std::thread* worker; // Heap-allocated so a running thread never reaches a static destructor
+
+    std::mutex resultsMutex;
+    std::unordered_map<jlong, jlong> retained; // Buffer handle -> bytes, from the last pass
+    RetainedSizeStatus status;
+};
+
+RetainedSizeWalker& walker() {
+    static RetainedSizeWalker* instance = new RetainedSizeWalker();
+    return *instance;
+}
+
+} // namespace
+
+void setRetainedSizeTracking(bool enabled) {
+    bool wasEnabled = trackingEnabled.exchange(enabled);
+    if (enabled || !wasEnabled) {
+        LOG_INFO("Retained size tracking %s", enabled ? "enabled" : "disabled");
+        return;
+    }
+
+    walker().wait();
+    if (isJvmtiAvailable()) {
+        Pass pass(0, true);
+        removeTags(pass);
+    }
+    LOG_INFO("Retained size tracking disabled");
+}
+
+bool isRetainedSizeTrackingEnabled() {
+    return trackingEnabled.load(std::memory_order_relaxed);
+}
+
+void tagRetainedEntry(jlong bufferId, jobject value) {
+    if (!trackingEnabled.load(std::memory_order_relaxed) || value == nullptr) {
+        return;
+    }
+    // Leave objects tagged for other purposes, such as classes, alone
+    jlong tag = getObjectTagJvmti(value);
+    if (tag == 0 || (tag & kEntryTagBit) != 0) {
+        setObjectTagJvmti(value, kEntryTagBit | bufferKey(bufferId));
+    }
+}
+
+void untagRetainedEntry(jobject value) {
+    if (!trackingEnabled.load(std::memory_order_relaxed) || value == nullptr) {
+        return;
+    }
+    if ((getObjectTagJvmti(value) & kEntryTagBit) != 0) {
+        setObjectTagJvmti(value, 0);
+    }
+}
+
+bool startRetainedSizePass(JavaVM* vm, jint budgetMillis) {
+    if (!trackingEnabled.load(std::memory_order_relaxed) || !isJvmtiAvailable() || vm == nullptr) {
+        return false;
+    }
+    if (budgetMillis <= 0) {
+        budgetMillis = kDefaultRetainedSizeBudgetMillis;
+    }
+    return walker().start(vm, budgetMillis);
+}
+
+jlong getRetainedSize(jlong bufferId) {
+    return walker().retainedSize(bufferId);
+}
+
+RetainedSizeStatus getRetainedSizeStatus() {
+    return walker().currentStatus();
+}
+
+void waitForRetainedSizePass() {
+    walker().wait();
+}
+
+void clearRetainedSizes() {
+    walker().clear();
+}
@@ -0,0 +1,55 @@
+#ifndef RETAINED_SIZE_H
+#define RETAINED_SIZE_H
+
+#include <jni.h>
+
+// On-demand retained size of buffered entries.
+// While tracking is enabled, every emitted value is tagged through JVMTI with its
+// buffer, and the tag is removed again when the value is consumed. A pass then
+// walks the heap once from the roots on a background thread: each tagged entry is
+// counted for its buffer, and an untagged object reached through a field or array
+// element of an entry (or of an object already counted for a buffer) is tagged
+// and counted for the same buffer. An object is counted only once, for the first
+// buffer that reaches it, so a String's backing array is charged to the buffer
+// holding the String, while objects that are reached first from elsewhere are
+// not. The walk stops when its time budget runs out and the partial result is
+// kept and marked as incomplete. Nothing in the pass runs on the emit path.
+
+struct RetainedSizeStatus {
+    jlong passes;             // Passes finished, complete or not
+    jlong lastPassTime;       // When the last pass finished, same clock as the buffer metrics
+    jlong lastPassNanos;      // Duration of the last pass, including removing its tags
+    jlong lastPassComplete;   // 1 if the last pass walked the whole heap, 0 if it ran out of time
+    jlong running;            // 1 while a pass is in progress
+    jlong totalRetainedBytes; // Sum over all buffers in the last pass
+    jlong totalObjects;       // Objects counted in the last pass
+};
+
+static const jint kRetainedSizeStatusFields = 7;
+static const jint kDefaultRetainedSizeBudgetMillis = 500;
+
+// Starts or stops tagging emitted values. Stopping waits for a running pass and
+// removes every entry tag.
+void setRetainedSizeTracking(bool enabled);
+bool isRetainedSizeTrackingEnabled();
+
+// Emit and consume hooks; no-ops while tracking is disabled
+void tagRetainedEntry(jlong bufferId, jobject value);
+void untagRetainedEntry(jobject value);
+
+// Starts a pass on a background thread attached to vm. Returns false if tracking
+// is disabled, JVMTI is unavailable or a pass is already running.
+bool startRetainedSizePass(JavaVM* vm, jint budgetMillis);
+
+// Bytes retained by a buffer in the last pass, -1 if the pass did not see it
+jlong getRetainedSize(jlong bufferId);
+
+RetainedSizeStatus getRetainedSizeStatus();
+
+// Blocks until a running pass has finished; passes are bounded by their budget
+void waitForRetainedSizePass();
+
+// Waits for a running pass and drops its results
+void clearRetainedSizes();
+
+#endif /* RETAINED_SIZE_H */
@@ -0,0 +1,140 @@
+#include "ring_channel.h"
+#include "buffer_tracking.h"
+#include "buffer_history.h"
+#include "event_tracking.h"
+#include "backpressure.h"
+#include "latency_histogram.h"
+#include "suspension_stacks.h"
+#include "utils.h"
+#include "logging.h"
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+size_t queueCapacityFor(jint capacity) {
+    size_t size = 2;
+    while (size < static_cast<size_t>(capacity)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // namespace
+
+RingChannel::RingChannel(jlong bufferId, jint capacity)
+    : queue(queueCapacityFor(capacity)), id(bufferId), capacity(capacity), closed(false) {}
+
+RingChannel::~RingChannel() {
+    RingEntry entry;
+    while (queue.tryPop(entry)) {
+        free(entry.bytes);
+    }
+}
+
+jlong RingChannel::reserve(jlong suspendedSince) {
+    if (closed.load(std::memory_order_acquire)) {
+        return kRingClosed;
+    }
+    BufferMetrics* metrics = bufferMetrics.find(id);
+    if (metrics == nullptr) {
+        return kRingUntracked;
+    }
+
+    jint size = metrics->size.load(std::memory_order_relaxed);
+    while (true) {
+        if (size >= capacity) {
+            if (suspendedSince == 0) {
+                metrics->addCount(COUNTER_SUSPENSIONS, 1);
+                recordBufferEvent(EVENT_SUSPEND, id, size, capacity, 0);
+                sampleSuspensionStack(id);
+                suspendedSince = getCurrentTimeMs();
+            }
+            return suspendedSince;
+        }
+        if (metrics->size.compare_exchange_weak(size, size + 1, std::memory_order_acq_rel)) {
+            metrics->addToGroups(GROUP_SIZE, 1);
+            return kRingSent;
+        }
+    }
+}
+
+void RingChannel::unreserve() {
+    BufferMetrics* metrics = bufferMetrics.find(id);
+    if (metrics != nullptr) {
+        metrics->size.fetch_sub(1, std::memory_order_release);
+        metrics->addToGroups(GROUP_SIZE, -1);
+    }
+}
+
+void RingChannel::publish(const RingEntry& entry, jlong entrySize, jlong suspendedSince) {
+    BufferMetrics* metrics = bufferMetrics.find(id);
+    if (metrics != nullptr) {
+        // Account before the entry becomes visible, so a consumer never releases memory not yet added
+        metrics->addCount(COUNTER_EMISSIONS, 1);
+        jlong memoryUsage = metrics->totalMemoryUsage.fetch_add(entrySize, std::memory_order_relaxed) + entrySize;
+        metrics->addToGroups(GROUP_MEMORY, entrySize);
+        metrics->lastUpdateTime.store(entry.enqueuedAt, std::memory_order_relaxed);
+        recordHistorySample(metrics, entry.enqueuedAt, metrics->size.load(std::memory_order_relaxed), memoryUsage);
+        observeBackpressure(id, metrics, entry.enqueuedAt);
+        if (suspendedSince > 0) {
+            recordSuspensionDuration(id, entry.enqueuedAt - suspendedSince);
+        }
+    }
+
+    // The reservation guarantees a free cell, but a consumer that claimed it may
+    // not have handed it back yet
+    while (!queue.tryPush(entry)) {
+        std::this_thread::yield();
+    }
+}
+
+bool RingChannel::receive(RingEntry& entry) {
+    if (!queue.tryPop(entry)) {
+        return false;
+    }
+
+    BufferMetrics* metrics = bufferMetrics.find(id);
+    if (metrics != nullptr) {
+        jlong now = getCurrentTimeMs();
+        jlong entrySize = RingChannel::entrySize(entry);
+        metrics->addCount(COUNTER_CONSUMPTIONS, 1);
+        // The slot is released only after its cell is free again, which keeps publish from spinning long
+        jint previousSize = metrics->size.fetch_sub(1, std::memory_order_release);
+        jlong memoryUsage = metrics->totalMemoryUsage.fetch_sub(entrySize, std::memory_order_relaxed) - entrySize;
+        metrics->addToGroups(GROUP_SIZE, -1);
+        metrics->addToGroups(GROUP_MEMORY, -entrySize);
+        metrics->lastUpdateTime.store(now, std::memory_order_relaxed);
+        recordHistorySample(metrics, now, previousSize - 1, memoryUsage);
+        observeBackpressure(id, metrics, now);
+        recordLatencySample(metrics, LATENCY_RESIDENCY, now - entry.enqueuedAt);
+    }
+    return true;
+}
+
+void RingChannel::close() {
+    if (!closed.exchange(true, std::memory_order_acq_rel)) {
+        releaseBuffer(id);
+        LOG_DEBUG("Closed ring channel for buffer %lld", static_cast<long long>(id));
+    }
+}
+
+RingChannel* createRingChannel(jint capacity) {
+    // The queue is allocated up front, so an unbounded capacity could throw bad_alloc through JNI
+    if (capacity <= 0 || capacity > kMaxRingCapacity) {
+        return nullptr;
+    }
+    jlong bufferId = createBuffer(capacity);
+    if (bufferId == 0) {
+        return nullptr;
+    }
+    return new RingChannel(bufferId, capacity);
+}
+
+void destroyRingChannel(RingChannel* channel) {
+    if (channel == nullptr) {
+        return;
+    }
+    channel->close();
+    delete channel;
+}
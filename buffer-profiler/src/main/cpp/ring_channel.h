@@ -0,0 +1,82 @@
+#ifndef RING_CHANNEL_H
+#define RING_CHANNEL_H
+
+#include <jni.h>
+#include <atomic>
+#include "mpmc_queue.h"
+
+// Bounded native channel whose occupancy is the buffer's own metrics.
+// Entries live in an MpmcQueue sized to the next power of two; the logical
+// capacity is enforced by reserving a slot with a CAS on BufferMetrics::size,
+// so size, memory, counters, suspensions and residency are updated by the
+// operation itself instead of being mirrored from a JVM-side channel.
+// Payloads are a primitive (stored as its 64-bit pattern) or a copy of a byte
+// array; an entry's memory is its payload size in native memory.
+//
+// A channel is addressed by its pointer. Closing rejects further sends and
+// releases the buffer, but queued entries can still be received; the memory
+// is freed by destroyRingChannel once the JVM side can no longer reach it.
+// clearTracking releases every buffer, ring buffers included; a send to a
+// channel whose buffer is gone reports kRingUntracked rather than kRingClosed,
+// and queued entries can still be received.
+
+// Results of a send besides a full-channel timestamp, which is always positive
+static const jlong kRingSent = 0;
+static const jlong kRingClosed = -1;
+static const jlong kRingUntracked = -2; // Buffer released by clearTracking
+static const jint kMaxRingCapacity = 1 << 20; // Queue of about 32 MiB
+
+struct RingEntry {
+    jlong value;      // Primitive payload bits, or the byte length of bytes
+    jlong enqueuedAt; // Same clock as the buffer metrics
+    jbyte* bytes;     // Owned copy of a byte array payload, nullptr for primitives
+};
+
+class RingChannel {
+public:
+    RingChannel(jlong bufferId, jint capacity);
+    ~RingChannel();
+
+    // Claims a slot. Returns kRingSent once a slot is reserved, kRingClosed,
+    // kRingUntracked, or the time the channel was found full. A first attempt (suspendedSince 0)
+    // that finds it full counts a suspension; a retry passes that timestamp back.
+    jlong reserve(jlong suspendedSince);
+
+    // Gives a reserved slot back, e.g. when copying the payload failed
+    void unreserve();
+
+    // Publishes an entry into a reserved slot; a retry that got through records
+    // how long the producer was suspended
+    void publish(const RingEntry& entry, jlong entrySize, jlong suspendedSince);
+
+    // Takes the oldest entry; false if the channel is empty. The caller owns entry.bytes.
+    bool receive(RingEntry& entry);
+
+    void close();
+
+    jlong bufferId() const {
+        return id;
+    }
+
+    static jlong entrySize(const RingEntry& entry) {
+        return entry.bytes != nullptr ? entry.value : static_cast<jlong>(sizeof(jlong));
+    }
+
+private:
+    RingChannel(const RingChannel&);
+    RingChannel& operator=(const RingChannel&);
+
+    MpmcQueue<RingEntry> queue;
+    const jlong id;
+    const jint capacity;
+    std::atomic<bool> closed;
+};
+
+// Creates a channel together with its buffer; nullptr if the capacity is not in
+// 1..kMaxRingCapacity or the registry is full
+RingChannel* createRingChannel(jint capacity);
+
+// Frees a closed or abandoned channel and any entries still queued
+void destroyRingChannel(RingChannel* channel);
+
+#endif /* RING_CHANNEL_H */
@@ -0,0 +1,223 @@
+#include "shm_export.h"
+#include "shm_layout.h"
+#include "buffer_tracking.h"
+#include "utils.h"
+#include "logging.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const jint kDefaultMaxBuffers = 4096;
+const jint kMinIntervalMillis = 1;
+
+struct ExportState {
+    ExportState() : header(nullptr), mappedBytes(0), publisher(nullptr), stopRequested(false) {}
+
+    ShmSegmentHeader* header;
+    size_t mappedBytes;
+    std::string path;
+    std::thread* publisher; // Heap-allocated so a running thread never reaches a static destructor
+    bool stopRequested;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+};
+
+ExportState& exportState() {
+    static ExportState* state = new ExportState();
+    return *state;
+}
+
+// Copies the registry into the segment. `published` remembers which handle
+// each slot held last time so that slots of released buffers get cleared.
+void publish(ShmSegmentHeader* header, std::vector<jlong>& published) {
+    ShmBufferSlot* slots = shmSlots(header);
+    uint32_t slotCount = header->slotCount;
+    std::vector<bool> seen(slotCount, false);
+    ShmTotals totals;
+    memset(&totals, 0, sizeof(totals));
+
+    bufferMetrics.forEach([&](jlong bufferId, const BufferMetrics& metrics) {
+        ShmBufferRecord record;
+        record.handle = bufferId;
+        record.memoryUsage = metrics.totalMemoryUsage.load(std::memory_order_relaxed);
+        record.lastUpdateTime = metrics.lastUpdateTime.load(std::memory_order_relaxed);
+        record.capacity = metrics.capacity.load(std::memory_order_relaxed);
+        record.size = metrics.size.load(std::memory_order_relaxed);
+        record.emissions = metrics.count(COUNTER_EMISSIONS);
+        record.consumptions = metrics.count(COUNTER_CONSUMPTIONS);
+        record.suspensions = metrics.count(COUNTER_SUSPENSIONS);
+
+        totals.totalEmissions += record.emissions;
+        totals.totalConsumptions += record.consumptions;
+        totals.totalSuspensions += record.suspensions;
+        totals.totalMemoryUsage += record.memoryUsage;
+        totals.liveBuffers++;
+
+        uint32_t index = static_cast<uint32_t>(BufferRegistry::indexOf(bufferId));
+        if (index >= slotCount) {
+            totals.overflowBuffers++;
+            return;
+        }
+        writeShmSlot(slots[index], record);
+        published[index] = bufferId;
+        seen[index] = true;
+    });
+
+    ShmBufferRecord empty;
+    memset(&empty, 0, sizeof(empty));
+    for (uint32_t index = 0; index < slotCount; index++) {
+        if (published[index] != 0 && !seen[index]) {
+            writeShmSlot(slots[index], empty);
+            published[index] = 0;
+        }
+    }
+
+    beginShmWrite(header->sequence);
+    header->publishTime.store(getCurrentTimeMs(), std::memory_order_relaxed);
+    header->totalEmissions.store(totals.totalEmissions, std::memory_order_relaxed);
+    header->totalConsumptions.store(totals.totalConsumptions, std::memory_order_relaxed);
+    header->totalSuspensions.store(totals.totalSuspensions, std::memory_order_relaxed);
+    header->totalMemoryUsage.store(totals.totalMemoryUsage, std::memory_order_relaxed);
+    header->liveBuffers.store(totals.liveBuffers, std::memory_order_relaxed);
+    header->overflowBuffers.store(totals.overflowBuffers, std::memory_order_relaxed);
+    endShmWrite(header->sequence);
+}
+
+void publisherLoop(ShmSegmentHeader* header) {
+    ExportState& state = exportState();
+    std::vector<jlong> published(header->slotCount, 0);
+    std::chrono::milliseconds interval(header->intervalMillis);
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.stopRequested) {
+        lock.unlock();
+        publish(header, published);
+        lock.lock();
+        state.wakeUp.wait_for(lock, interval, [&state] { return state.stopRequested; });
+    }
+}
+
+// Creates and maps the segment file; returns nullptr on failure
+ShmSegmentHeader* createSegment(const std::string& path, uint32_t slotCount, size_t bytes) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Could not create %s: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        LOG_ERROR("Could not size %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("Could not map %s: %s", path.c_str(), strerror(errno));
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    // The file starts zeroed, so every slot is empty and every sequence is even
+    ShmSegmentHeader* header = static_cast<ShmSegmentHeader*>(mapped);
+    header->version = kShmVersion;
+    header->slotCount = slotCount;
+    header->slotSize = sizeof(ShmBufferSlot);
+    header->pid = static_cast<int64_t>(getpid());
+    header->active.store(1, std::memory_order_relaxed);
+    return header;
+}
+
+} // namespace
+
+bool startSharedMemoryExport(jint intervalMillis, jint maxBuffers) {
+    ExportState& state = exportState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.header != nullptr) {
+        return true;
+    }
+
+    if (intervalMillis < kMinIntervalMillis) {
+        intervalMillis = kMinIntervalMillis;
+    }
+    if (maxBuffers <= 0) {
+        maxBuffers = kDefaultMaxBuffers;
+    } else if (maxBuffers > BufferRegistry::kMaxSlots) {
+        maxBuffers = BufferRegistry::kMaxSlots;
+    }
+
+    uint32_t slotCount = static_cast<uint32_t>(maxBuffers);
+    size_t bytes = shmSegmentBytes(slotCount);
+    std::string path = kShmPathPrefix + std::to_string(static_cast<long long>(getpid()));
+    ShmSegmentHeader* header = createSegment(path, slotCount, bytes);
+    if (header == nullptr) {
+        return false;
+    }
+    header->intervalMillis = intervalMillis;
+
+    // Readers check the magic last, so they never see a half-initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kShmMagic;
+
+    state.header = header;
+    state.mappedBytes = bytes;
+    state.path = path;
+    state.stopRequested = false;
+    state.publisher = new std::thread(publisherLoop, header);
+
+    LOG_INFO("Publishing metrics for up to %u buffers to %s every %d ms", slotCount, path.c_str(),
+             static_cast<int>(intervalMillis));
+    return true;
+}
+
+void stopSharedMemoryExport() {
+    ExportState& state = exportState();
+    std::thread* publisher;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.header == nullptr) {
+            return;
+        }
+        state.stopRequested = true;
+        publisher = state.publisher;
+        state.publisher = nullptr;
+    }
+    state.wakeUp.notify_all();
+    publisher->join();
+    delete publisher;
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.header->active.store(0, std::memory_order_release);
+    unlink(state.path.c_str());
+    munmap(state.header, state.mappedBytes);
+    LOG_INFO("Stopped publishing metrics to %s", state.path.c_str());
+    state.header = nullptr;
+    state.mappedBytes = 0;
+    state.path.clear();
+}
+
+std::string getSharedMemoryPath() {
+    ExportState& state = exportState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.path;
+}
+
+void startSharedMemoryExportFromEnvironment() {
+    const char* interval = getenv("BUFFERMONITOR_SHM_INTERVAL_MS");
+    if (interval == nullptr || *interval == '\0') {
+        return;
+    }
+    const char* maxBuffers = getenv("BUFFERMONITOR_SHM_MAX_BUFFERS");
+    startSharedMemoryExport(static_cast<jint>(atoi(interval)),
+                            maxBuffers != nullptr ? static_cast<jint>(atoi(maxBuffers)) : 0);
+}
@@ -0,0 +1,25 @@
+#ifndef SHM_EXPORT_H
+#define SHM_EXPORT_H
+
+#include <jni.h>
+#include <string>
+
+// Optional export of the buffer metrics to a shared-memory segment.
+// A background thread copies every live buffer into /dev/shm/buffermonitor-<pid>
+// at a fixed interval, using the layout in shm_layout.h. The record paths never
+// touch the segment, so exporting adds no work to the profiled threads.
+
+// Creates the segment and starts publishing; returns false if it could not be
+// created. Calling it again while running changes nothing and returns true.
+bool startSharedMemoryExport(jint intervalMillis, jint maxBuffers);
+
+// Stops publishing and removes the segment
+void stopSharedMemoryExport();
+
+// Path of the segment while exporting, empty otherwise
+std::string getSharedMemoryPath();
+
+// Starts the export if BUFFERMONITOR_SHM_INTERVAL_MS is set in the environment
+void startSharedMemoryExportFromEnvironment();
+
+#endif /* SHM_EXPORT_H */
@@ -0,0 +1,175 @@
+#ifndef SHM_LAYOUT_H
+#define SHM_LAYOUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the shared-memory metrics segment.
+// The library publishes its metrics into /dev/shm/buffermonitor-<pid> so that
+// tools outside the JVM can sample them without JNI. The file is shared by the
+// library and by tools/shm_reader.cpp, and contains only fixed-width fields in
+// native byte order:
+//
+//   offset 0     ShmSegmentHeader (128 bytes)
+//   offset 128   ShmBufferSlot[slotCount] (64 bytes each)
+//
+// Slot i describes the buffer whose registry index (the low 32 bits of its
+// handle) is i; a slot whose handle is 0 is empty. Buffers whose index is at or
+// past slotCount are not exported and are counted in overflowBuffers.
+//
+// The header totals and every slot are guarded by their own seqlock. The single
+// writer makes the sequence odd, updates the fields and makes it even again.
+// A reader loads the sequence, copies the fields, and retries if the sequence
+// was odd or has changed since; see readShmSlot and readShmTotals.
+
+static const uint32_t kShmMagic = 0x48534D42; // "BMSH"
+static const uint32_t kShmVersion = 2; // 2: 64-bit per-buffer counters
+static const char kShmPathPrefix[] = "/dev/shm/buffermonitor-";
+
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error "The shared-memory segment needs lock-free 32 and 64-bit atomics"
+#endif
+
+struct ShmSegmentHeader {
+    // Written once before the segment is published
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    int64_t pid;
+    int64_t intervalMillis;
+
+    // Guarded by sequence
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> publishTime;       // Time of the last publish, same clock as lastUpdateTime
+    std::atomic<int64_t> totalEmissions;
+    std::atomic<int64_t> totalConsumptions;
+    std::atomic<int64_t> totalSuspensions;
+    std::atomic<int64_t> totalMemoryUsage;
+    std::atomic<uint32_t> liveBuffers;
+    std::atomic<uint32_t> overflowBuffers;
+
+    // Cleared when the library stops publishing and is about to remove the segment
+    std::atomic<uint32_t> active;
+    uint32_t reserved[9];
+};
+
+struct ShmBufferSlot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> handle;
+    std::atomic<int64_t> memoryUsage;
+    std::atomic<int64_t> lastUpdateTime;
+    std::atomic<int32_t> capacity;
+    std::atomic<int32_t> size;
+    std::atomic<int64_t> emissions;
+    std::atomic<int64_t> consumptions;
+    std::atomic<int64_t> suspensions;
+};
+
+// Plain copies of the guarded fields, as seen by a reader
+struct ShmTotals {
+    int64_t publishTime;
+    int64_t totalEmissions;
+    int64_t totalConsumptions;
+    int64_t totalSuspensions;
+    int64_t totalMemoryUsage;
+    uint32_t liveBuffers;
+    uint32_t overflowBuffers;
+};
+
+struct ShmBufferRecord {
+    int64_t handle;
+    int64_t memoryUsage;
+    int64_t lastUpdateTime;
+    int32_t capacity;
+    int32_t size;
+    int64_t emissions;
+    int64_t consumptions;
+    int64_t suspensions;
+};
+
+static_assert(sizeof(ShmSegmentHeader) == 128, "ShmSegmentHeader layout changed");
+static_assert(sizeof(ShmBufferSlot) == 64, "ShmBufferSlot layout changed");
+
+inline size_t shmSegmentBytes(uint32_t slotCount) {
+    return sizeof(ShmSegmentHeader) + static_cast<size_t>(slotCount) * sizeof(ShmBufferSlot);
+}
+
+inline ShmBufferSlot* shmSlots(ShmSegmentHeader* header) {
+    return reinterpret_cast<ShmBufferSlot*>(reinterpret_cast<char*>(header) + sizeof(ShmSegmentHeader));
+}
+
+inline const ShmBufferSlot* shmSlots(const ShmSegmentHeader* header) {
+    return reinterpret_cast<const ShmBufferSlot*>(reinterpret_cast<const char*>(header) + sizeof(ShmSegmentHeader));
+}
+
+// Writer side: opens and closes a seqlock section. Only one thread may write.
+inline void beginShmWrite(std::atomic<uint64_t>& sequence) {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void endShmWrite(std::atomic<uint64_t>& sequence) {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+inline void writeShmSlot(ShmBufferSlot& slot, const ShmBufferRecord& record) {
+    beginShmWrite(slot.sequence);
+    slot.handle.store(record.handle, std::memory_order_relaxed);
+    slot.memoryUsage.store(record.memoryUsage, std::memory_order_relaxed);
+    slot.lastUpdateTime.store(record.lastUpdateTime, std::memory_order_relaxed);
+    slot.capacity.store(record.capacity, std::memory_order_relaxed);
+    slot.size.store(record.size, std::memory_order_relaxed);
+    slot.emissions.store(record.emissions, std::memory_order_relaxed);
+    slot.consumptions.store(record.consumptions, std::memory_order_relaxed);
+    slot.suspensions.store(record.suspensions, std::memory_order_relaxed);
+    endShmWrite(slot.sequence);
+}
+
+// Reader side: copies a consistent view of a slot; false if the writer kept it
+// busy for maxAttempts tries
+inline bool readShmSlot(const ShmBufferSlot& slot, ShmBufferRecord& record, int maxAttempts = 64) {
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if ((before & 1u) != 0) {
+            continue;
+        }
+        record.handle = slot.handle.load(std::memory_order_relaxed);
+        record.memoryUsage = slot.memoryUsage.load(std::memory_order_relaxed);
+        record.lastUpdateTime = slot.lastUpdateTime.load(std::memory_order_relaxed);
+        record.capacity = slot.capacity.load(std::memory_order_relaxed);
+        record.size = slot.size.load(std::memory_order_relaxed);
+        record.emissions = slot.emissions.load(std::memory_order_relaxed);
+        record.consumptions = slot.consumptions.load(std::memory_order_relaxed);
+        record.suspensions = slot.suspensions.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool readShmTotals(const ShmSegmentHeader& header, ShmTotals& totals, int maxAttempts = 64) {
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+        uint64_t before = header.sequence.load(std::memory_order_acquire);
+        if ((before & 1u) != 0) {
+            continue;
+        }
+        totals.publishTime = header.publishTime.load(std::memory_order_relaxed);
+        totals.totalEmissions = header.totalEmissions.load(std::memory_order_relaxed);
+        totals.totalConsumptions = header.totalConsumptions.load(std::memory_order_relaxed);
+        totals.totalSuspensions = header.totalSuspensions.load(std::memory_order_relaxed);
+        totals.totalMemoryUsage = header.totalMemoryUsage.load(std::memory_order_relaxed);
+        totals.liveBuffers = header.liveBuffers.load(std::memory_order_relaxed);
+        totals.overflowBuffers = header.overflowBuffers.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* SHM_LAYOUT_H */
@@ -0,0 +1,70 @@
+#include "snapshot.h"
+#include "buffer_tracking.h"
+#include "utils.h"
+#include "logging.h"
+#include <cstring>
+
+jlong snapshotRequiredBytes(jlong bufferCount) {
+    return static_cast<jlong>(sizeof(MetricsSnapshotHeader)) + bufferCount * kSnapshotRowBytes;
+}
+
+jlong snapshotAll(void* destination, jlong capacity) {
+    if (destination == nullptr || capacity < static_cast<jlong>(sizeof(MetricsSnapshotHeader))) {
+        return -snapshotRequiredBytes(0);
+    }
+
+    char* base = static_cast<char*>(destination);
+    jlong columnStride = (capacity - static_cast<jlong>(sizeof(MetricsSnapshotHeader))) / kSnapshotRowBytes;
+    if (columnStride > BufferRegistry::kMaxSlots) {
+        columnStride = BufferRegistry::kMaxSlots;
+    }
+
+    int64_t* handles = reinterpret_cast<int64_t*>(base + sizeof(MetricsSnapshotHeader));
+    int64_t* memoryUsage = handles + columnStride;
+    int64_t* emissions = memoryUsage + columnStride;
+    int64_t* consumptions = emissions + columnStride;
+    int64_t* suspensions = consumptions + columnStride;
+    int64_t* lastUpdateTimes = suspensions + columnStride;
+    int32_t* capacities = reinterpret_cast<int32_t*>(lastUpdateTimes + columnStride);
+    int32_t* sizes = capacities + columnStride;
+
+    MetricsSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kSnapshotMagic;
+    header.version = kSnapshotVersion;
+    header.timestamp = getCurrentTimeMs();
+
+    // Totals are summed from exactly the rows that are written, so they always agree
+    jlong liveBuffers = 0;
+    bufferMetrics.forEach([&](jlong bufferId, const BufferMetrics& metrics) {
+        jlong row = liveBuffers++;
+        if (row >= columnStride) {
+            return;
+        }
+        handles[row] = bufferId;
+        memoryUsage[row] = metrics.totalMemoryUsage.load(std::memory_order_relaxed);
+        emissions[row] = metrics.count(COUNTER_EMISSIONS);
+        consumptions[row] = metrics.count(COUNTER_CONSUMPTIONS);
+        suspensions[row] = metrics.count(COUNTER_SUSPENSIONS);
+        lastUpdateTimes[row] = metrics.lastUpdateTime.load(std::memory_order_relaxed);
+        capacities[row] = metrics.capacity.load(std::memory_order_relaxed);
+        sizes[row] = metrics.size.load(std::memory_order_relaxed);
+
+        header.totalEmissions += emissions[row];
+        header.totalConsumptions += consumptions[row];
+        header.totalSuspensions += suspensions[row];
+        header.totalMemoryUsage += memoryUsage[row];
+        header.totalSize += sizes[row];
+    });
+
+    if (liveBuffers > columnStride) {
+        LOG_DEBUG("Snapshot buffer too small for %lld buffers", static_cast<long long>(liveBuffers));
+        return -snapshotRequiredBytes(liveBuffers);
+    }
+
+    header.bufferCount = static_cast<uint32_t>(liveBuffers);
+    header.columnStride = static_cast<uint32_t>(columnStride);
+    memcpy(base, &header, sizeof(header));
+
+    return snapshotRequiredBytes(columnStride);
+}
@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <jni.h>
+#include <cstdint>
+
+// Packed, versioned snapshot of every live buffer plus global totals.
+// Fields are written in native byte order. A snapshot is a fixed 64-byte header
+// followed by one column per field (struct of arrays). Every column has room
+// for columnStride rows, where columnStride is derived from the size of the
+// caller's buffer, so the layout can be filled in a single pass:
+//
+//   offset 0                    MetricsSnapshotHeader
+//   headerSize                  int64 handle[columnStride]
+//   + 1 * 8 * columnStride      int64 memoryUsage[columnStride]
+//   + 2 * 8 * columnStride      int64 emissions[columnStride]
+//   + 3 * 8 * columnStride      int64 consumptions[columnStride]
+//   + 4 * 8 * columnStride      int64 suspensions[columnStride]
+//   + 5 * 8 * columnStride      int64 lastUpdateTime[columnStride]
+//   + 6 * 8 * columnStride      int32 capacity[columnStride]
+//   + 6 * 8 * columnStride
+//     + 4 * columnStride        int32 size[columnStride]
+//
+// Only the first bufferCount rows of each column are valid.
+
+static const uint32_t kSnapshotMagic = 0x53534D42; // "BMSS"
+static const uint32_t kSnapshotVersion = 1;
+static const jlong kSnapshotRowBytes = 6 * 8 + 2 * 4;
+
+struct MetricsSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bufferCount;
+    uint32_t columnStride;
+    int64_t timestamp;
+    int64_t totalEmissions;
+    int64_t totalConsumptions;
+    int64_t totalSuspensions;
+    int64_t totalMemoryUsage;
+    int64_t totalSize;
+};
+
+// Bytes needed to hold a snapshot of the given number of buffers
+jlong snapshotRequiredBytes(jlong bufferCount);
+
+// Fills the destination with a snapshot of every live buffer in one pass over
+// the registry. Returns the number of bytes written, or the negated number of
+// bytes required if the destination is too small.
+jlong snapshotAll(void* destination, jlong capacity);
+
+#endif /* SNAPSHOT_H */
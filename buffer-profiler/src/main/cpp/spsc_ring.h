@@ -0,0 +1,92 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded wait-free single-producer/single-consumer ring.
+// The producer owns the tail and the consumer owns the head; each side reads
+// the other's cursor only when its cached copy says the ring looks full or
+// empty, so in the common case a push or pop touches no shared cache line
+// besides the element itself. Capacity must be a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : buffer(new T[capacity]), mask(capacity - 1) {
+        producer.tail.store(0, std::memory_order_relaxed);
+        producer.cachedHead = 0;
+        consumer.head.store(0, std::memory_order_relaxed);
+        consumer.cachedTail = 0;
+    }
+
+    ~SpscRing() {
+        delete[] buffer;
+    }
+
+    // Producer side; returns false without blocking if the ring is full
+    bool tryPush(const T& value) {
+        size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (tail - producer.cachedHead > mask) {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+            if (tail - producer.cachedHead > mask) {
+                return false;
+            }
+        }
+        buffer[tail & mask] = value;
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; pops up to maxItems elements into drain(const T&) and
+    // releases them to the producer in one store. Returns the number popped.
+    template <typename Drain>
+    size_t drainBatch(Drain& drain, size_t maxItems) {
+        size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (consumer.cachedTail == head) {
+            consumer.cachedTail = producer.tail.load(std::memory_order_acquire);
+            if (consumer.cachedTail == head) {
+                return 0;
+            }
+        }
+        size_t available = consumer.cachedTail - head;
+        size_t count = available < maxItems ? available : maxItems;
+        for (size_t i = 0; i < count; i++) {
+            drain(const_cast<const T&>(buffer[(head + i) & mask]));
+        }
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    static const size_t kCacheLineSize = 64;
+
+    // Each side's cursor and its cached view of the other side share a cache line
+    struct ProducerSide {
+        char leading[kCacheLineSize];
+        std::atomic<size_t> tail;
+        size_t cachedHead;
+        char trailing[kCacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    };
+
+    struct ConsumerSide {
+        char leading[kCacheLineSize];
+        std::atomic<size_t> head;
+        size_t cachedTail;
+        char trailing[kCacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    };
+
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+    T* const buffer;
+    const size_t mask;
+    ProducerSide producer;
+    ConsumerSide consumer;
+};
+
+#endif /* SPSC_RING_H */
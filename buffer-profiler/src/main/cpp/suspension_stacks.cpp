@@ -0,0 +1,273 @@
+#include "suspension_stacks.h"
+#include "buffer_groups.h"
+#include "jvmti_agent.h"
+#include "logging.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const jint kRootNode = -1;
+const jint kTableSlots = kMaxSuspensionStackNodes * 2; // At most half full, so probing always ends
+const jint kEmptySlot = -1;
+
+struct StackNode {
+    // Written once before the node is published
+    jint parent;   // kRootNode for a site node
+    uint64_t key;  // Hash of the site label under the root, jmethodID below
+
+    std::atomic<jlong> samples; // Sampled stacks that end at this node
+};
+
+struct StackTrie {
+    StackTrie() : nodeCount(0) {
+        for (jint slot = 0; slot < kTableSlots; slot++) {
+            slots[slot].store(kEmptySlot, std::memory_order_relaxed);
+        }
+    }
+
+    StackNode nodes[kMaxSuspensionStackNodes];
+    std::atomic<jint> slots[kTableSlots]; // Open addressing over node indexes
+    std::atomic<jint> nodeCount;
+    std::mutex insertMutex;               // Serializes adding nodes; lookups take no lock
+    std::unordered_map<jint, std::string> siteLabels; // Label of every site node, guarded by insertMutex
+};
+
+// Allocated by the first setSuspensionStackSampling call and never freed
+std::atomic<StackTrie*> stackTrie(nullptr);
+std::mutex samplingMutex;
+
+std::atomic<jint> sampleRate(0);
+std::atomic<jint> maxDepth(kDefaultSuspensionStackDepth);
+std::atomic<jlong> sampledStacks(0);
+std::atomic<jlong> droppedStacks(0);
+
+// FNV-1a of a site label
+uint64_t labelHash(const std::string& label) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < label.size(); i++) {
+        hash = (hash ^ static_cast<unsigned char>(label[i])) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+uint64_t nodeHash(jint parent, uint64_t key) {
+    // splitmix64 finalizer over both parts
+    uint64_t hash = key ^ (static_cast<uint64_t>(static_cast<uint32_t>(parent)) * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// Index of the node for (parent, key); with insert, adds it if missing.
+// Returns -1 if the node is missing, or the trie is full.
+jint probeNode(StackTrie& trie, jint parent, uint64_t key, bool insert) {
+    jint slot = static_cast<jint>(nodeHash(parent, key) & static_cast<uint64_t>(kTableSlots - 1));
+    while (true) {
+        jint index = trie.slots[slot].load(std::memory_order_acquire);
+        if (index == kEmptySlot) {
+            if (!insert) {
+                return -1;
+            }
+            jint count = trie.nodeCount.load(std::memory_order_relaxed);
+            if (count >= kMaxSuspensionStackNodes) {
+                return -1;
+            }
+            StackNode& node = trie.nodes[count];
+            node.parent = parent;
+            node.key = key;
+            node.samples.store(0, std::memory_order_relaxed);
+            trie.nodeCount.store(count + 1, std::memory_order_release);
+            trie.slots[slot].store(count, std::memory_order_release);
+            return count;
+        }
+        const StackNode& node = trie.nodes[index];
+        if (node.parent == parent && node.key == key) {
+            return index;
+        }
+        slot = (slot + 1) & (kTableSlots - 1);
+    }
+}
+
+jint internNode(StackTrie& trie, jint parent, uint64_t key) {
+    jint node = probeNode(trie, parent, key, false);
+    if (node >= 0) {
+        return node;
+    }
+    std::lock_guard<std::mutex> lock(trie.insertMutex);
+    return probeNode(trie, parent, key, true);
+}
+
+// Frame names must not break the collapsed format
+std::string collapsedFrame(std::string name) {
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] == ';' || name[i] == ' ' || name[i] == '\n') {
+            name[i] = '_';
+        }
+    }
+    return name;
+}
+
+// Outermost frame of a buffer's stacks; stable across buffers with the same name or group
+std::string siteLabel(jlong bufferId) {
+    std::string name = getBufferName(bufferId);
+    if (!name.empty()) {
+        return collapsedFrame("buffer:" + name);
+    }
+    std::string path = getBufferGroupPath(getBufferGroupOf(bufferId));
+    if (!path.empty()) {
+        return collapsedFrame("group:" + path);
+    }
+    return "buffer:unnamed";
+}
+
+// Site node of a label, added with its label if missing
+jint internSite(StackTrie& trie, const std::string& label) {
+    uint64_t key = labelHash(label);
+    jint node = probeNode(trie, kRootNode, key, false);
+    if (node >= 0) {
+        return node;
+    }
+    std::lock_guard<std::mutex> lock(trie.insertMutex);
+    node = probeNode(trie, kRootNode, key, true);
+    if (node >= 0) {
+        trie.siteLabels[node] = label;
+    }
+    return node;
+}
+
+} // namespace
+
+bool setSuspensionStackSampling(jint rate, jint depth) {
+    std::lock_guard<std::mutex> lock(samplingMutex);
+    if (rate <= 0) {
+        sampleRate.store(0, std::memory_order_relaxed);
+        LOG_INFO("Suspension stack sampling disabled");
+        return true;
+    }
+    if (!isJvmtiAvailable()) {
+        LOG_WARN("Warning: Suspension stack sampling needs JVMTI");
+        return false;
+    }
+
+    if (stackTrie.load(std::memory_order_relaxed) == nullptr) {
+        stackTrie.store(new StackTrie(), std::memory_order_release);
+    }
+    if (depth <= 0) {
+        depth = kDefaultSuspensionStackDepth;
+    }
+    maxDepth.store(depth < kMaxSuspensionStackDepth ? depth : kMaxSuspensionStackDepth, std::memory_order_relaxed);
+    sampleRate.store(rate, std::memory_order_release);
+    LOG_INFO("Sampling the stack of one suspension in %d, up to %d frames", static_cast<int>(rate),
+             static_cast<int>(maxDepth.load(std::memory_order_relaxed)));
+    return true;
+}
+
+void sampleSuspensionStack(jlong bufferId) {
+    jint rate = sampleRate.load(std::memory_order_acquire);
+    if (rate <= 0) {
+        return;
+    }
+    static thread_local jint untilSample = 0;
+    if (--untilSample > 0) {
+        return;
+    }
+    untilSample = rate;
+
+    StackTrie* trie = stackTrie.load(std::memory_order_acquire);
+    static thread_local jvmtiFrameInfo frames[kMaxSuspensionStackDepth];
+    jint count = 0;
+    if (trie == nullptr ||
+        getStackTraceJvmti(maxDepth.load(std::memory_order_relaxed), frames, &count) != JVMTI_ERROR_NONE) {
+        droppedStacks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // GetStackTrace returns the innermost frame first; the trie runs from the site outwards in
+    jint node = internSite(*trie, siteLabel(bufferId));
+    for (jint frame = count - 1; frame >= 0 && node >= 0; frame--) {
+        node = internNode(*trie, node, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frames[frame].method)));
+    }
+    if (node < 0) {
+        droppedStacks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    trie->nodes[node].samples.fetch_add(1, std::memory_order_relaxed);
+    sampledStacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+SuspensionStackStatus getSuspensionStackStatus() {
+    StackTrie* trie = stackTrie.load(std::memory_order_acquire);
+    SuspensionStackStatus status;
+    status.sampleRate = sampleRate.load(std::memory_order_relaxed);
+    status.samples = sampledStacks.load(std::memory_order_relaxed);
+    status.droppedSamples = droppedStacks.load(std::memory_order_relaxed);
+    status.nodes = trie != nullptr ? trie->nodeCount.load(std::memory_order_acquire) : 0;
+    return status;
+}
+
+std::string getCollapsedSuspensionStacks(JNIEnv* env, jlong bufferId) {
+    StackTrie* trie = stackTrie.load(std::memory_order_acquire);
+    if (trie == nullptr) {
+        return std::string();
+    }
+
+    std::unordered_map<jint, std::string> sites;
+    {
+        std::lock_guard<std::mutex> lock(trie->insertMutex);
+        sites = trie->siteLabels;
+    }
+    uint64_t siteKey = bufferId != 0 ? labelHash(siteLabel(bufferId)) : 0;
+
+    // Names are resolved once per export; the trie only holds method IDs
+    std::unordered_map<uint64_t, std::string> names;
+    std::vector<jint> path;
+    std::string collapsed;
+    jint count = trie->nodeCount.load(std::memory_order_acquire);
+    for (jint index = 0; index < count; index++) {
+        jlong samples = trie->nodes[index].samples.load(std::memory_order_relaxed);
+        if (samples == 0) {
+            continue;
+        }
+
+        path.clear();
+        for (jint node = index; node != kRootNode; node = trie->nodes[node].parent) {
+            path.push_back(node);
+        }
+        std::unordered_map<jint, std::string>::const_iterator site = sites.find(path.back());
+        if (site == sites.end() || (bufferId != 0 && trie->nodes[path.back()].key != siteKey)) {
+            continue; // Site added after the labels were copied, or filtered out
+        }
+
+        collapsed += site->second;
+        for (size_t i = path.size() - 1; i-- > 0;) {
+            uint64_t method = trie->nodes[path[i]].key;
+            std::unordered_map<uint64_t, std::string>::iterator name = names.find(method);
+            if (name == names.end()) {
+                std::string resolved = getMethodNameJvmti(env, reinterpret_cast<jmethodID>(static_cast<uintptr_t>(method)));
+                name = names.insert(std::make_pair(method, resolved.empty() ? "[unknown]" : collapsedFrame(resolved))).first;
+            }
+            collapsed += ";";
+            collapsed += name->second;
+        }
+        collapsed += " ";
+        collapsed += std::to_string(static_cast<long long>(samples));
+        collapsed += "\n";
+    }
+    return collapsed;
+}
+
+void clearSuspensionStacks() {
+    StackTrie* trie = stackTrie.load(std::memory_order_acquire);
+    if (trie != nullptr) {
+        jint count = trie->nodeCount.load(std::memory_order_acquire);
+        for (jint index = 0; index < count; index++) {
+            trie->nodes[index].samples.store(0, std::memory_order_relaxed);
+        }
+    }
+    sampledStacks.store(0, std::memory_order_relaxed);
+    droppedStacks.store(0, std::memory_order_relaxed);
+}
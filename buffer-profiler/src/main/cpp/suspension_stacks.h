@@ -0,0 +1,56 @@
+#ifndef SUSPENSION_STACKS_H
+#define SUSPENSION_STACKS_H
+
+#include <jni.h>
+#include <string>
+
+// Optional stack sampling at suspension points, for backpressure flame graphs.
+// While enabled, one suspension in sampleRate of each thread takes the caller's
+// stack with JVMTI GetStackTrace and adds it to a trie of frames. Every node is
+// hash-consed by (parent node, key), so each distinct path is stored once and
+// a repeated stack only bumps the count of its last node. The first level under
+// the root is the suspended buffer's site: its name, else its group path, else
+// one shared "unnamed" site. Buffers that are created and released again under
+// the same name share their nodes, so buffer churn does not grow the trie. The
+// levels below are method IDs, outermost first.
+//
+// Memory is bounded: the trie holds at most kMaxSuspensionStackNodes nodes in
+// arrays allocated when sampling is first enabled (about 1 MiB). A stack that
+// needs a node once the trie is full is counted in droppedSamples instead.
+// Lookups of known paths take no lock; only adding a node does. Method names
+// are resolved when the stacks are exported, never on the suspension path.
+
+static const jint kMaxSuspensionStackNodes = 32768;
+static const jint kMaxSuspensionStackDepth = 256;
+static const jint kDefaultSuspensionStackDepth = 64;
+
+struct SuspensionStackStatus {
+    jlong sampleRate;     // One suspension in this many per thread, 0 while off
+    jlong samples;        // Stacks counted in the trie
+    jlong droppedSamples; // Stacks lost to a full trie or a failed GetStackTrace
+    jlong nodes;          // Interned nodes, buffers included
+};
+
+static const jint kSuspensionStackStatusFields = 4;
+
+// Samples one suspension in sampleRate per thread, keeping up to maxDepth
+// innermost frames (kDefaultSuspensionStackDepth if <= 0); sampleRate <= 0
+// turns sampling off. Returns false if JVMTI is not available.
+bool setSuspensionStackSampling(jint sampleRate, jint maxDepth);
+
+// Called wherever a suspension is counted; a relaxed load while sampling is off
+void sampleSuspensionStack(jlong bufferId);
+
+SuspensionStackStatus getSuspensionStackStatus();
+
+// Collapsed stacks of the site of one live buffer, or of all sites for 0: one
+// line per distinct stack, "<site>;outer.Frame.method;...;inner.Frame.method count"
+// with the site written "buffer:<name>", "group:<path>" or "buffer:unnamed",
+// as read by flamegraph.pl and speedscope. Methods of unloaded classes show as
+// "[unknown]".
+std::string getCollapsedSuspensionStacks(JNIEnv* env, jlong bufferId);
+
+// Zeroes the counts; interned nodes are kept for the stacks that come back
+void clearSuspensionStacks();
+
+#endif /* SUSPENSION_STACKS_H */
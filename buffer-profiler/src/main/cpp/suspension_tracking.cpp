@@ -1,50 +1,53 @@
 #include "suspension_tracking.h"
 #include "buffer_tracking.h"
+#include "event_tracking.h"
+#include "suspension_stacks.h"
 #include "utils.h"
-#include <iostream>
-#include <sstream>
+#include "logging.h"
 #include <chrono>
 
-// Global variables
-std::mutex suspensionMutex;
+// Record a suspension event for a specific buffer on the calling thread
+void recordSuspension(jlong bufferId, jint bufferSize, jint bufferCapacity) {
+    // Increment the suspension counter in BufferMetrics
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics != nullptr) {
+        metrics->addCount(COUNTER_SUSPENSIONS, 1);
+    }
 
-// Record a suspension event for a specific buffer and thread
-void recordSuspension(JNIEnv* env, jlong threadId, jstring threadName, jlong bufferId, jint bufferSize, jint bufferCapacity) {
-    std::lock_guard<std::mutex> lock(suspensionMutex);
+    // A single write into the thread's own ring, tagged with its registered id
+    recordBufferEvent(EVENT_SUSPEND, bufferId, bufferSize, bufferCapacity, 0);
 
-    // Convert jstring to std::string for logging
-    std::string threadNameStr = jstringToString(env, threadName);
+    // Where the producer suspended, when stack sampling is on
+    sampleSuspensionStack(bufferId);
 
-    // Increment the suspension counter in BufferMetrics
-    auto it = bufferMetrics.find(bufferId);
-    if (it != bufferMetrics.end()) {
-        it->second.totalSuspensions++;
-    }
+    LOG_DEBUG("Suspended due to buffer %lld full (%d/%d)",
+              static_cast<long long>(bufferId), bufferSize, bufferCapacity);
+}
 
-    std::cout << "[Native] Thread " << threadNameStr
-              << " suspended due to buffer full (" << bufferSize << "/" << bufferCapacity << ")" << std::endl;
+// Record a suspension event for a specific buffer and thread
+void recordSuspension(JNIEnv* env, jlong threadId, jstring threadName, jlong bufferId, jint bufferSize, jint bufferCapacity) {
+    // The thread name is interned the first time this thread reports; after that
+    // only the id is compared
+    attachEventThread(env, threadId, threadName);
+    recordSuspension(bufferId, bufferSize, bufferCapacity);
 }
 
 // Get the total number of suspension events across all buffers
-jint getSuspensionCount() {
-    std::lock_guard<std::mutex> lock(suspensionMutex);
-
-    // Sum up totalSuspensions from all BufferMetrics objects
-    jint total = 0;
-    for (const auto& pair : bufferMetrics) {
-        total += pair.second.totalSuspensions;
-    }
+jlong getSuspensionCount() {
+    // Sum up the suspension counters of all BufferMetrics objects
+    jlong total = 0;
+    bufferMetrics.forEach([&total](jlong, const BufferMetrics& metrics) {
+        total += metrics.count(COUNTER_SUSPENSIONS);
+    });
     return total;
 }
 
 // Get the number of suspension events for a specific buffer
-jint getBufferSuspensionCount(jlong bufferId) {
-    std::lock_guard<std::mutex> lock(suspensionMutex);
-
+jlong getBufferSuspensionCount(jlong bufferId) {
     // Use the counter from BufferMetrics instead of iterating through the vector
-    auto it = bufferMetrics.find(bufferId);
-    if (it != bufferMetrics.end()) {
-        return it->second.totalSuspensions;
+    BufferMetrics* metrics = bufferMetrics.find(bufferId);
+    if (metrics != nullptr) {
+        return metrics->count(COUNTER_SUSPENSIONS);
     }
 
     return 0;
@@ -52,12 +55,12 @@ jint getBufferSuspensionCount(jlong bufferId) {
 
 // Clear all suspension tracking data
 void clearSuspensionTracking() {
-    std::lock_guard<std::mutex> lock(suspensionMutex);
-
-    // Reset the totalSuspensions counters in all BufferMetrics objects
-    for (auto& pair : bufferMetrics) {
-        pair.second.totalSuspensions = 0;
-    }
+    // Reset the suspension counters in all BufferMetrics objects
+    bufferMetrics.forEach([](jlong, BufferMetrics& metrics) {
+        metrics.resetCount(COUNTER_SUSPENSIONS);
+    });
+    clearEventTracking();
+    clearSuspensionStacks();
 
-    std::cout << "[Native] Suspension tracking data cleared" << std::endl;
+    LOG_INFO("Suspension tracking data cleared");
 }
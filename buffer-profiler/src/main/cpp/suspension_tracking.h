@@ -3,15 +3,14 @@
 
 #include <jni.h>
 #include <string>
-#include <mutex>
 
 // Function declarations
+// Records a suspension for the calling thread as registered with registerEventThread;
+// primitives only, so nothing is converted or allocated per event
+void recordSuspension(jlong bufferId, jint bufferSize, jint bufferCapacity);
 void recordSuspension(JNIEnv* env, jlong threadId, jstring threadName, jlong bufferId, jint bufferSize, jint bufferCapacity);
-jint getSuspensionCount();
-jint getBufferSuspensionCount(jlong bufferId);
+jlong getSuspensionCount();
+jlong getBufferSuspensionCount(jlong bufferId);
 void clearSuspensionTracking();
 
-// Extern declaration for global suspension state
-extern std::mutex suspensionMutex;
-
 #endif /* SUSPENSION_TRACKING_H */
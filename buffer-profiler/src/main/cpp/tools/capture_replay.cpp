@@ -0,0 +1,378 @@
+// Replays a capture file written by the buffer monitor.
+//
+// Usage: bufferprof-replay <capture file> [--buffer ID] [--from MS] [--to MS] [--events]
+//
+// --from and --to are milliseconds since the capture started. The file is
+// mapped read-only and scanned sequentially; with an index footer, chunks
+// outside the time window are skipped without being touched. A capture whose
+// process died before writing the footer is read by walking its chunks.
+//
+// For every buffer in the window the tool prints the emission, consumption and
+// suspension deltas between the first and last snapshot, so the counters come
+// from one source and agree with each other, then peak size, utilization and
+// memory. Suspension durations and per-thread suspensions can only come from
+// the events, which may have been dropped, and are printed as such. --events
+// also prints every matching event.
+
+#include "capture_format.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Event types from event_tracking.h
+const int32_t kEventSuspend = 0;
+const int32_t kEventResume = 1;
+
+struct Options {
+    Options() : path(nullptr), bufferId(0), from(0), to(std::numeric_limits<int64_t>::max()), events(false) {}
+
+    const char* path;
+    int64_t bufferId;  // 0 for every buffer
+    int64_t from;      // Nanoseconds since the capture started
+    int64_t to;
+    bool events;
+};
+
+struct MappedFile {
+    MappedFile() : data(nullptr), bytes(0) {}
+
+    const char* data;
+    size_t bytes;
+};
+
+struct BufferStats {
+    BufferStats() : snapshots(0), peakSize(0), peakMemory(0), capacity(0), suspendEvents(0), resumes(0),
+                    suspendedNanos(0), maxSuspendedNanos(0) {
+        memset(&first, 0, sizeof(first));
+        memset(&last, 0, sizeof(last));
+    }
+
+    CaptureBufferRow first;
+    CaptureBufferRow last;
+    int64_t snapshots;
+    int32_t peakSize;
+    int64_t peakMemory;
+    int32_t capacity;
+    int64_t suspendEvents;
+    int64_t resumes;
+    int64_t suspendedNanos;
+    int64_t maxSuspendedNanos;
+    std::vector<int64_t> durations;
+};
+
+struct Replay {
+    Replay() : startTime(0), firstTime(0), lastTime(0), events(0), snapshots(0), lastSequence(UINT32_MAX),
+               chunksRead(0), chunksSkipped(0) {}
+
+    int64_t startTime;
+    int64_t firstTime;
+    int64_t lastTime;
+    int64_t events;
+    int64_t snapshots;
+    uint32_t lastSequence;
+    int64_t chunksRead;
+    int64_t chunksSkipped;
+    std::map<int64_t, BufferStats> buffers;
+    std::map<int64_t, std::string> threadNames;
+    std::map<int64_t, int64_t> suspensionsByThread;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argument, "--buffer") == 0 && hasValue) {
+            options.bufferId = strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argument, "--from") == 0 && hasValue) {
+            options.from = strtoll(argv[++i], nullptr, 10) * 1000000;
+        } else if (strcmp(argument, "--to") == 0 && hasValue) {
+            options.to = strtoll(argv[++i], nullptr, 10) * 1000000;
+        } else if (strcmp(argument, "--events") == 0) {
+            options.events = true;
+        } else if (argument[0] != '-' && options.path == nullptr) {
+            options.path = argument;
+        } else {
+            return false;
+        }
+    }
+    return options.path != nullptr;
+}
+
+bool mapFile(const char* path, MappedFile& file) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(CaptureFileHeader)) {
+        fprintf(stderr, "%s is not a capture file\n", path);
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    // The scan is sequential; let the kernel read ahead aggressively
+    madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    file.data = static_cast<const char*>(mapped);
+    file.bytes = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+// Chunks from the index footer, or found by walking the file if there is none
+std::vector<CaptureIndexEntry> findChunks(const MappedFile& file, const CaptureFileHeader& header, bool& indexed) {
+    std::vector<CaptureIndexEntry> chunks;
+    indexed = false;
+    if (file.bytes >= sizeof(CaptureFooter)) {
+        CaptureFooter footer;
+        memcpy(&footer, file.data + file.bytes - sizeof(footer), sizeof(footer));
+        size_t indexBytes = static_cast<size_t>(footer.chunkCount) * sizeof(CaptureIndexEntry);
+        if (footer.magic == kCaptureFooterMagic && footer.indexOffset >= 0 &&
+            static_cast<size_t>(footer.indexOffset) + indexBytes + sizeof(footer) <= file.bytes) {
+            chunks.resize(footer.chunkCount);
+            if (indexBytes > 0) {
+                memcpy(chunks.data(), file.data + footer.indexOffset, indexBytes);
+            }
+            indexed = true;
+            return chunks;
+        }
+    }
+
+    for (uint32_t index = 0;; index++) {
+        int64_t offset = captureChunkOffset(header.chunkBytes, index);
+        if (static_cast<size_t>(offset) + sizeof(CaptureChunkHeader) > file.bytes) {
+            break;
+        }
+        CaptureChunkHeader chunk;
+        memcpy(&chunk, file.data + offset, sizeof(chunk));
+        if (chunk.magic != kCaptureChunkMagic || chunk.index != index) {
+            break;
+        }
+        CaptureIndexEntry entry;
+        entry.offset = offset;
+        entry.usedBytes = chunk.usedBytes;
+        entry.recordCount = chunk.recordCount;
+        entry.firstTime = chunk.firstTime;
+        entry.lastTime = chunk.lastTime;
+        chunks.push_back(entry);
+    }
+    return chunks;
+}
+
+std::string threadLabel(const Replay& replay, int64_t threadId) {
+    std::map<int64_t, std::string>::const_iterator it = replay.threadNames.find(threadId);
+    char id[32];
+    snprintf(id, sizeof(id), "%" PRId64, threadId);
+    return it != replay.threadNames.end() ? it->second + " (" + id + ")" : std::string(id);
+}
+
+void noteTime(Replay& replay, int64_t time) {
+    if (replay.firstTime == 0 || time < replay.firstTime) {
+        replay.firstTime = time;
+    }
+    if (time > replay.lastTime) {
+        replay.lastTime = time;
+    }
+}
+
+void replayEvent(const CaptureEvent& event, const Options& options, Replay& replay) {
+    if (options.bufferId != 0 && event.bufferId != options.bufferId) {
+        return;
+    }
+    noteTime(replay, event.timestamp);
+    replay.events++;
+    BufferStats& stats = replay.buffers[event.bufferId];
+    if (event.type == kEventSuspend) {
+        stats.suspendEvents++;
+        replay.suspensionsByThread[event.threadId]++;
+    } else if (event.type == kEventResume) {
+        stats.resumes++;
+        stats.suspendedNanos += event.value;
+        stats.maxSuspendedNanos = std::max(stats.maxSuspendedNanos, event.value);
+        stats.durations.push_back(event.value);
+    }
+
+    if (options.events) {
+        printf("+%.3fms buffer=%" PRId64 " %s size=%d/%d thread=%s", (event.timestamp - replay.startTime) / 1e6,
+               event.bufferId, event.type == kEventSuspend ? "SUSPEND" : "RESUME", event.size, event.capacity,
+               threadLabel(replay, event.threadId).c_str());
+        if (event.type == kEventResume) {
+            printf(" suspended=%" PRId64 "ns", event.value);
+        }
+        printf("\n");
+    }
+}
+
+void replaySnapshot(const CaptureSnapshotHeader& header, const CaptureBufferRow* rows, const Options& options,
+                    Replay& replay) {
+    noteTime(replay, header.timestamp);
+    if (header.sequence != replay.lastSequence) {
+        replay.snapshots++;
+        replay.lastSequence = header.sequence;
+    }
+    for (uint32_t i = 0; i < header.rowCount; i++) {
+        CaptureBufferRow row;
+        memcpy(&row, &rows[i], sizeof(row));
+        if (options.bufferId != 0 && row.bufferId != options.bufferId) {
+            continue;
+        }
+        BufferStats& stats = replay.buffers[row.bufferId];
+        if (stats.snapshots == 0) {
+            stats.first = row;
+        }
+        stats.last = row;
+        stats.snapshots++;
+        stats.peakSize = std::max(stats.peakSize, row.size);
+        stats.peakMemory = std::max(stats.peakMemory, row.memoryUsage);
+        stats.capacity = row.capacity;
+    }
+}
+
+// Walks the records of one chunk, stopping at the first one that does not fit
+void replayChunk(const MappedFile& file, const CaptureIndexEntry& chunk, int64_t from, int64_t to,
+                 const Options& options, Replay& replay) {
+    size_t end = static_cast<size_t>(chunk.offset) + chunk.usedBytes;
+    if (end > file.bytes) {
+        end = file.bytes;
+    }
+    size_t position = static_cast<size_t>(chunk.offset) + sizeof(CaptureChunkHeader);
+    while (position + sizeof(CaptureRecordHeader) <= end) {
+        CaptureRecordHeader record;
+        memcpy(&record, file.data + position, sizeof(record));
+        size_t recordBytes = captureRecordBytes(record.bytes);
+        if (position + recordBytes > end) {
+            break;
+        }
+        const char* payload = file.data + position + sizeof(record);
+        position += recordBytes;
+
+        if (record.type == CAPTURE_RECORD_EVENT && record.bytes >= sizeof(CaptureEvent)) {
+            CaptureEvent event;
+            memcpy(&event, payload, sizeof(event));
+            if (event.timestamp >= from && event.timestamp <= to) {
+                replayEvent(event, options, replay);
+            }
+        } else if (record.type == CAPTURE_RECORD_SNAPSHOT && record.bytes >= sizeof(CaptureSnapshotHeader)) {
+            CaptureSnapshotHeader header;
+            memcpy(&header, payload, sizeof(header));
+            size_t rowBytes = static_cast<size_t>(header.rowCount) * sizeof(CaptureBufferRow);
+            if (sizeof(header) + rowBytes <= record.bytes && header.timestamp >= from && header.timestamp <= to) {
+                replaySnapshot(header, reinterpret_cast<const CaptureBufferRow*>(payload + sizeof(header)), options,
+                               replay);
+            }
+        } else if (record.type == CAPTURE_RECORD_THREAD_NAME && record.bytes >= sizeof(CaptureThreadName)) {
+            CaptureThreadName name;
+            memcpy(&name, payload, sizeof(name));
+            if (sizeof(name) + name.length <= record.bytes) {
+                replay.threadNames[name.threadId] = std::string(payload + sizeof(name), name.length);
+            }
+        }
+    }
+}
+
+int64_t percentile(std::vector<int64_t>& values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void printSummary(const CaptureFileHeader& header, bool indexed, Replay& replay) {
+    printf("pid=%" PRId64 " chunks=%" PRId64 " skipped=%" PRId64 " index=%s\n", header.pid, replay.chunksRead,
+           replay.chunksSkipped, indexed ? "footer" : "scanned");
+    if (replay.firstTime == 0) {
+        printf("no records in the selected window\n");
+        return;
+    }
+    printf("window=+%.3fms..+%.3fms snapshots=%" PRId64 " events=%" PRId64 " buffers=%zu\n",
+           (replay.firstTime - header.startTime) / 1e6, (replay.lastTime - header.startTime) / 1e6,
+           replay.snapshots, replay.events, replay.buffers.size());
+
+    for (std::map<int64_t, BufferStats>::iterator it = replay.buffers.begin(); it != replay.buffers.end(); ++it) {
+        BufferStats& stats = it->second;
+        int64_t utilization = stats.capacity > 0 ? static_cast<int64_t>(stats.peakSize) * 1000 / stats.capacity : 0;
+        printf("  buffer=%" PRId64 " emissions=%" PRId64 " consumptions=%" PRId64 " suspensions=%" PRId64
+               " peakSize=%d/%d peakUtilization=%" PRId64 "%% peakMemory=%" PRId64 "\n",
+               it->first, stats.last.emissions - stats.first.emissions,
+               stats.last.consumptions - stats.first.consumptions, stats.last.suspensions - stats.first.suspensions,
+               stats.peakSize, stats.capacity, utilization / 10, stats.peakMemory);
+        if (stats.suspendEvents > 0 || stats.resumes > 0) {
+            printf("    events suspends=%" PRId64 " resumes=%" PRId64, stats.suspendEvents, stats.resumes);
+            if (stats.resumes > 0) {
+                printf(" suspended total=%" PRId64 "ns max=%" PRId64 "ns p50=%" PRId64 "ns p99=%" PRId64 "ns",
+                       stats.suspendedNanos, stats.maxSuspendedNanos, percentile(stats.durations, 0.5),
+                       percentile(stats.durations, 0.99));
+            }
+            printf("\n");
+        }
+    }
+    for (std::map<int64_t, int64_t>::const_iterator it = replay.suspensionsByThread.begin();
+         it != replay.suspensionsByThread.end(); ++it) {
+        printf("  thread=%s suspendEvents=%" PRId64 "\n", threadLabel(replay, it->first).c_str(), it->second);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s <capture file> [--buffer ID] [--from MS] [--to MS] [--events]\n", argv[0]);
+        return 2;
+    }
+
+    MappedFile file;
+    if (!mapFile(options.path, file)) {
+        return 1;
+    }
+    CaptureFileHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if (header.magic != kCaptureMagic || header.version != kCaptureVersion || header.chunkBytes == 0) {
+        fprintf(stderr, "%s has an unsupported layout\n", options.path);
+        munmap(const_cast<char*>(file.data), file.bytes);
+        return 1;
+    }
+
+    bool indexed;
+    std::vector<CaptureIndexEntry> chunks = findChunks(file, header, indexed);
+    int64_t from = header.startTime + options.from;
+    int64_t to = options.to == std::numeric_limits<int64_t>::max() ? options.to : header.startTime + options.to;
+
+    Replay replay;
+    replay.startTime = header.startTime;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const CaptureIndexEntry& chunk = chunks[i];
+        // Every chunk repeats the recent thread names, so chunks outside the window are not needed
+        bool outside = chunk.firstTime != 0 && (chunk.firstTime > to || chunk.lastTime < from);
+        if (outside) {
+            replay.chunksSkipped++;
+            continue;
+        }
+        replay.chunksRead++;
+        replayChunk(file, chunk, from, to, options, replay);
+    }
+
+    printSummary(header, indexed, replay);
+    munmap(const_cast<char*>(file.data), file.bytes);
+    return 0;
+}
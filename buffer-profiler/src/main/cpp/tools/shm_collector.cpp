@@ -0,0 +1,493 @@
+// Aggregates the shared-memory metrics segments of every buffer monitor on the host.
+//
+// Usage: buffermonitor-collector [--listen ADDRESS] [--interval MS] [--once]
+//
+// Each JVM that exports to shared memory (see shm_layout.h) publishes its own
+// /dev/shm/buffermonitor-<pid> segment from a background thread, so collecting
+// costs the profiled processes nothing. Every interval (default 1000 ms) the
+// collector scans /dev/shm for segments, maps new ones read-only, drops the
+// ones whose process exited or stopped publishing, and merges the rest into
+// one host view: per-process totals, host totals and a histogram of buffer
+// utilization summed over every buffer on the host.
+//
+// Host counters are accumulated from per-process deltas, so they keep growing
+// when a process exits or clears its tracking. The view is rendered once per
+// interval in the OpenMetrics text format and served at GET /metrics on
+// ADDRESS ("host:port", default 127.0.0.1:9465, or "unix:<path>"). --once
+// collects twice, one interval apart, prints the view and exits.
+
+#include "shm_layout.h"
+#include "openmetrics_server.h"
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kDefaultAddress[] = "127.0.0.1:9465";
+
+// Upper bounds of the utilization buckets; the last bucket is +Inf, since the
+// size includes producers about to suspend and can exceed the capacity
+const double kUtilizationBounds[] = {0.1, 0.25, 0.5, 0.75, 0.9, 1.0};
+const int kUtilizationBuckets = sizeof(kUtilizationBounds) / sizeof(kUtilizationBounds[0]) + 1;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+struct Options {
+    Options() : address(kDefaultAddress), intervalMillis(1000), once(false) {}
+
+    std::string address;
+    long intervalMillis;
+    bool once;
+};
+
+struct Totals {
+    Totals() : emissions(0), consumptions(0), suspensions(0) {}
+
+    int64_t emissions;
+    int64_t consumptions;
+    int64_t suspensions;
+};
+
+struct Process {
+    Process() : header(nullptr), bytes(0), inode(0), liveBuffers(0), overflowBuffers(0), memoryUsage(0),
+                size(0), capacity(0), seen(false) {
+        memset(utilization, 0, sizeof(utilization));
+    }
+
+    const ShmSegmentHeader* header;
+    size_t bytes;
+    ino_t inode;
+
+    // From the last merge
+    Totals last;
+    uint32_t liveBuffers;
+    uint32_t overflowBuffers;
+    int64_t memoryUsage;
+    int64_t size;
+    int64_t capacity;
+    int64_t utilization[kUtilizationBuckets];
+    bool seen; // Found by the current scan
+};
+
+struct HostView {
+    HostView() : processes(0), buffers(0), overflowBuffers(0), memoryUsage(0), size(0), capacity(0),
+                 utilizationSum(0), mergeNanos(0), exitedProcesses(0) {
+        memset(utilization, 0, sizeof(utilization));
+    }
+
+    Totals totals; // Grows by every process's deltas, never decreases
+    int64_t processes;
+    int64_t buffers;
+    int64_t overflowBuffers;
+    int64_t memoryUsage;
+    int64_t size;
+    int64_t capacity;
+    int64_t utilization[kUtilizationBuckets];
+    double utilizationSum;
+    int64_t mergeNanos;      // Time of the last scan and merge
+    int64_t exitedProcesses;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argument, "--listen") == 0 && hasValue) {
+            options.address = argv[++i];
+        } else if (strcmp(argument, "--interval") == 0 && hasValue) {
+            options.intervalMillis = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argument, "--once") == 0) {
+            options.once = true;
+        } else {
+            return false;
+        }
+    }
+    if (options.intervalMillis < 1) {
+        options.intervalMillis = 1;
+    }
+    return true;
+}
+
+bool processAlive(int64_t pid) {
+    return !(kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH);
+}
+
+bool mapSegment(const std::string& path, Process& process) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false; // Removed since the scan
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmSegmentHeader)) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    const ShmSegmentHeader* header = static_cast<const ShmSegmentHeader*>(mapped);
+    bool valid = header->magic == kShmMagic
+        && header->version == kShmVersion
+        && header->slotSize == sizeof(ShmBufferSlot)
+        && shmSegmentBytes(header->slotCount) <= static_cast<size_t>(info.st_size);
+    if (!valid) {
+        // Reported once per segment, since the scan finds it again every interval
+        static std::set<ino_t> reported;
+        if (reported.insert(info.st_ino).second) {
+            fprintf(stderr, "%s has an unsupported layout (version %u, expected %u), skipping it\n", path.c_str(),
+                    header->version, kShmVersion);
+        }
+        munmap(mapped, static_cast<size_t>(info.st_size));
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    process.header = header;
+    process.bytes = static_cast<size_t>(info.st_size);
+    process.inode = info.st_ino;
+    return true;
+}
+
+void unmapSegment(Process& process) {
+    if (process.header != nullptr) {
+        munmap(const_cast<ShmSegmentHeader*>(process.header), process.bytes);
+        process.header = nullptr;
+    }
+}
+
+// Maps the segments that appeared since the last scan and marks the ones still present
+void scanSegments(std::map<int64_t, Process>& processes) {
+    std::string prefix = kShmPathPrefix;
+    std::string directory = prefix.substr(0, prefix.rfind('/'));
+    std::string namePrefix = prefix.substr(prefix.rfind('/') + 1);
+
+    for (std::map<int64_t, Process>::iterator it = processes.begin(); it != processes.end(); ++it) {
+        it->second.seen = false;
+    }
+    DIR* entries = opendir(directory.c_str());
+    if (entries == nullptr) {
+        return;
+    }
+    while (dirent* entry = readdir(entries)) {
+        if (strncmp(entry->d_name, namePrefix.c_str(), namePrefix.size()) != 0) {
+            continue;
+        }
+        char* end = nullptr;
+        int64_t pid = strtoll(entry->d_name + namePrefix.size(), &end, 10);
+        if (pid <= 0 || *end != '\0' || !processAlive(pid)) {
+            continue; // Not a segment, or left behind by a process that crashed
+        }
+
+        std::string path = directory + "/" + entry->d_name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            continue;
+        }
+        Process& process = processes[pid];
+        if (process.header != nullptr && process.inode != info.st_ino) {
+            unmapSegment(process); // Export was restarted with a new segment
+        }
+        if (process.header == nullptr && !mapSegment(path, process)) {
+            continue;
+        }
+        process.seen = true;
+    }
+    closedir(entries);
+}
+
+int utilizationBucket(int32_t size, int32_t capacity) {
+    double utilization = static_cast<double>(size) / capacity;
+    for (int bucket = 0; bucket + 1 < kUtilizationBuckets; bucket++) {
+        if (utilization <= kUtilizationBounds[bucket]) {
+            return bucket;
+        }
+    }
+    return kUtilizationBuckets - 1;
+}
+
+// Reads one process's segment; false if it is gone or no longer published
+bool readProcess(Process& process, Totals& delta, double& utilizationSum) {
+    const ShmSegmentHeader* header = process.header;
+    ShmTotals totals;
+    if (!process.seen || header->active.load(std::memory_order_acquire) == 0 || !processAlive(header->pid) ||
+        !readShmTotals(*header, totals)) {
+        return false;
+    }
+
+    // A total that went down was cleared, so everything since counts as new
+    Totals current;
+    current.emissions = totals.totalEmissions;
+    current.consumptions = totals.totalConsumptions;
+    current.suspensions = totals.totalSuspensions;
+    delta.emissions = current.emissions >= process.last.emissions ? current.emissions - process.last.emissions
+                                                                  : current.emissions;
+    delta.consumptions = current.consumptions >= process.last.consumptions
+                             ? current.consumptions - process.last.consumptions : current.consumptions;
+    delta.suspensions = current.suspensions >= process.last.suspensions
+                            ? current.suspensions - process.last.suspensions : current.suspensions;
+    process.last = current;
+    process.liveBuffers = totals.liveBuffers;
+    process.overflowBuffers = totals.overflowBuffers;
+    process.memoryUsage = totals.totalMemoryUsage;
+
+    process.size = 0;
+    process.capacity = 0;
+    memset(process.utilization, 0, sizeof(process.utilization));
+    const ShmBufferSlot* slots = shmSlots(header);
+    for (uint32_t index = 0; index < header->slotCount; index++) {
+        ShmBufferRecord record;
+        if (!readShmSlot(slots[index], record) || record.handle == 0 || record.capacity <= 0) {
+            continue;
+        }
+        process.size += record.size;
+        process.capacity += record.capacity;
+        process.utilization[utilizationBucket(record.size, record.capacity)]++;
+        utilizationSum += static_cast<double>(record.size) / record.capacity;
+    }
+    return true;
+}
+
+void collect(std::map<int64_t, Process>& processes, HostView& view) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    scanSegments(processes);
+
+    view.processes = 0;
+    view.buffers = 0;
+    view.overflowBuffers = 0;
+    view.memoryUsage = 0;
+    view.size = 0;
+    view.capacity = 0;
+    view.utilizationSum = 0;
+    memset(view.utilization, 0, sizeof(view.utilization));
+
+    std::map<int64_t, Process>::iterator it = processes.begin();
+    while (it != processes.end()) {
+        Process& process = it->second;
+        Totals delta;
+        if (!readProcess(process, delta, view.utilizationSum)) {
+            if (process.header != nullptr) {
+                view.exitedProcesses++;
+            }
+            unmapSegment(process);
+            processes.erase(it++);
+            continue;
+        }
+        view.totals.emissions += delta.emissions;
+        view.totals.consumptions += delta.consumptions;
+        view.totals.suspensions += delta.suspensions;
+        view.processes++;
+        view.buffers += process.liveBuffers;
+        view.overflowBuffers += process.overflowBuffers;
+        view.memoryUsage += process.memoryUsage;
+        view.size += process.size;
+        view.capacity += process.capacity;
+        for (int bucket = 0; bucket < kUtilizationBuckets; bucket++) {
+            view.utilization[bucket] += process.utilization[bucket];
+        }
+        ++it;
+    }
+
+    view.mergeNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Appends one formatted line; the string keeps its capacity between renders
+void appendLine(std::string& text, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+void appendLine(std::string& text, const char* format, ...) {
+    char line[512];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+    if (length > 0) {
+        text.append(line, static_cast<size_t>(length) < sizeof(line) ? static_cast<size_t>(length) : sizeof(line) - 1);
+    }
+}
+
+void appendFamily(std::string& text, const char* name, const char* type, const char* unit, const char* help) {
+    appendLine(text, "# TYPE %s %s\n", name, type);
+    if (unit != nullptr) {
+        appendLine(text, "# UNIT %s %s\n", name, unit);
+    }
+    appendLine(text, "# HELP %s %s\n", name, help);
+}
+
+void render(const std::map<int64_t, Process>& processes, const HostView& view, std::string& text) {
+    text.clear();
+    typedef std::map<int64_t, Process>::const_iterator Iterator;
+
+    appendFamily(text, "buffermonitor_host_processes", "gauge", nullptr, "Processes publishing buffer metrics.");
+    appendLine(text, "buffermonitor_host_processes %" PRId64 "\n", view.processes);
+    appendFamily(text, "buffermonitor_host_exited_processes", "counter", nullptr,
+                 "Processes that exited or stopped publishing.");
+    appendLine(text, "buffermonitor_host_exited_processes_total %" PRId64 "\n", view.exitedProcesses);
+    appendFamily(text, "buffermonitor_host_buffers", "gauge", nullptr, "Live buffers over every process.");
+    appendLine(text, "buffermonitor_host_buffers %" PRId64 "\n", view.buffers);
+    appendFamily(text, "buffermonitor_host_unexported_buffers", "gauge", nullptr,
+                 "Buffers past the slots of their process's segment.");
+    appendLine(text, "buffermonitor_host_unexported_buffers %" PRId64 "\n", view.overflowBuffers);
+    appendFamily(text, "buffermonitor_host_size", "gauge", nullptr, "Entries in every exported buffer.");
+    appendLine(text, "buffermonitor_host_size %" PRId64 "\n", view.size);
+    appendFamily(text, "buffermonitor_host_capacity", "gauge", nullptr, "Capacity of every exported buffer.");
+    appendLine(text, "buffermonitor_host_capacity %" PRId64 "\n", view.capacity);
+    appendFamily(text, "buffermonitor_host_memory_bytes", "gauge", "bytes", "Memory of the entries in every buffer.");
+    appendLine(text, "buffermonitor_host_memory_bytes %" PRId64 "\n", view.memoryUsage);
+    appendFamily(text, "buffermonitor_host_emissions", "counter", nullptr, "Items emitted over every process.");
+    appendLine(text, "buffermonitor_host_emissions_total %" PRId64 "\n", view.totals.emissions);
+    appendFamily(text, "buffermonitor_host_consumptions", "counter", nullptr, "Items consumed over every process.");
+    appendLine(text, "buffermonitor_host_consumptions_total %" PRId64 "\n", view.totals.consumptions);
+    appendFamily(text, "buffermonitor_host_suspensions", "counter", nullptr,
+                 "Producer suspensions over every process.");
+    appendLine(text, "buffermonitor_host_suspensions_total %" PRId64 "\n", view.totals.suspensions);
+
+    appendFamily(text, "buffermonitor_host_buffer_utilization", "gaugehistogram", nullptr,
+                 "Size over capacity of every exported buffer.");
+    int64_t cumulative = 0;
+    for (int bucket = 0; bucket < kUtilizationBuckets; bucket++) {
+        cumulative += view.utilization[bucket];
+        if (bucket + 1 < kUtilizationBuckets) {
+            appendLine(text, "buffermonitor_host_buffer_utilization_bucket{le=\"%g\"} %" PRId64 "\n",
+                       kUtilizationBounds[bucket], cumulative);
+        } else {
+            appendLine(text, "buffermonitor_host_buffer_utilization_bucket{le=\"+Inf\"} %" PRId64 "\n", cumulative);
+        }
+    }
+    appendLine(text, "buffermonitor_host_buffer_utilization_gcount %" PRId64 "\n", cumulative);
+    appendLine(text, "buffermonitor_host_buffer_utilization_gsum %.6f\n", view.utilizationSum);
+
+    appendFamily(text, "buffermonitor_process_buffers", "gauge", nullptr, "Live buffers of the process.");
+    for (Iterator it = processes.begin(); it != processes.end(); ++it) {
+        appendLine(text, "buffermonitor_process_buffers{pid=\"%" PRId64 "\"} %u\n", it->first, it->second.liveBuffers);
+    }
+    appendFamily(text, "buffermonitor_process_memory_bytes", "gauge", "bytes",
+                 "Memory of the entries in the process's buffers.");
+    for (Iterator it = processes.begin(); it != processes.end(); ++it) {
+        appendLine(text, "buffermonitor_process_memory_bytes{pid=\"%" PRId64 "\"} %" PRId64 "\n", it->first,
+                   it->second.memoryUsage);
+    }
+    appendFamily(text, "buffermonitor_process_emissions", "counter", nullptr, "Items emitted in the process.");
+    for (Iterator it = processes.begin(); it != processes.end(); ++it) {
+        appendLine(text, "buffermonitor_process_emissions_total{pid=\"%" PRId64 "\"} %" PRId64 "\n", it->first,
+                   it->second.last.emissions);
+    }
+    appendFamily(text, "buffermonitor_process_consumptions", "counter", nullptr, "Items consumed in the process.");
+    for (Iterator it = processes.begin(); it != processes.end(); ++it) {
+        appendLine(text, "buffermonitor_process_consumptions_total{pid=\"%" PRId64 "\"} %" PRId64 "\n", it->first,
+                   it->second.last.consumptions);
+    }
+    appendFamily(text, "buffermonitor_process_suspensions", "counter", nullptr,
+                 "Producer suspensions in the process.");
+    for (Iterator it = processes.begin(); it != processes.end(); ++it) {
+        appendLine(text, "buffermonitor_process_suspensions_total{pid=\"%" PRId64 "\"} %" PRId64 "\n", it->first,
+                   it->second.last.suspensions);
+    }
+
+    appendFamily(text, "buffermonitor_collector_merge_seconds", "gauge", "seconds",
+                 "Time of the last scan and merge.");
+    appendLine(text, "buffermonitor_collector_merge_seconds %.9f\n", view.mergeNanos / 1e9);
+    text.append("# EOF\n");
+}
+
+// Serves the view rendered at the last collection
+class CollectorSource : public OpenMetricsSource {
+public:
+    explicit CollectorSource(const std::string& text) : text(text) {}
+
+    void render(const char*& bytes, size_t& length) {
+        bytes = text.data();
+        length = text.size();
+    }
+
+private:
+    const std::string& text;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s [--listen ADDRESS] [--interval MS] [--once]\n", argv[0]);
+        return 2;
+    }
+
+    std::map<int64_t, Process> processes;
+    HostView view;
+    std::string text;
+    std::chrono::milliseconds interval(options.intervalMillis);
+
+    if (options.once) {
+        // The first pass sets the baseline, so the host counters cover one interval
+        collect(processes, view);
+        view.totals = Totals();
+        std::this_thread::sleep_for(interval);
+        collect(processes, view);
+        render(processes, view, text);
+        fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+
+    std::string bound;
+    std::string error;
+    int listenFd = openOpenMetricsListener(options.address, bound, error);
+    if (listenFd < 0) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    fprintf(stderr, "Serving the host view at %s/metrics every %ld ms\n", bound.c_str(), options.intervalMillis);
+
+    CollectorSource source(text);
+    std::chrono::steady_clock::time_point nextCollect = std::chrono::steady_clock::now();
+    while (!stopRequested) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= nextCollect) {
+            collect(processes, view);
+            render(processes, view, text);
+            nextCollect += interval;
+            if (nextCollect < now) {
+                nextCollect = now + interval; // Skip the intervals missed while suspended
+            }
+            continue;
+        }
+        int timeout = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(nextCollect - now).count()) + 1;
+        serveOpenMetricsClient(listenFd, -1, timeout, source);
+    }
+
+    closeOpenMetricsListener(listenFd, bound);
+    for (std::map<int64_t, Process>::iterator it = processes.begin(); it != processes.end(); ++it) {
+        unmapSegment(it->second);
+    }
+    return 0;
+}
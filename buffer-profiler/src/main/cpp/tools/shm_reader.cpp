@@ -0,0 +1,134 @@
+// Samples the shared-memory metrics segment of a running buffer monitor.
+//
+// Usage: buffermonitor-shm-reader <pid | segment path> [interval ms] [samples]
+//
+// The reader only maps the segment read-only and never talks to the JVM, so it
+// can sample at high frequency without any effect on the profiled process.
+// With no sample count it runs until the segment goes away.
+
+#include "shm_layout.h"
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct MappedSegment {
+    MappedSegment() : header(nullptr), bytes(0) {}
+
+    const ShmSegmentHeader* header;
+    size_t bytes;
+};
+
+std::string segmentPath(const char* argument) {
+    if (strchr(argument, '/') != nullptr) {
+        return argument;
+    }
+    return std::string(kShmPathPrefix) + argument;
+}
+
+bool openSegment(const std::string& path, MappedSegment& segment) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmSegmentHeader)) {
+        fprintf(stderr, "%s is not a buffer monitor segment\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    const ShmSegmentHeader* header = static_cast<const ShmSegmentHeader*>(mapped);
+    bool valid = header->magic == kShmMagic
+        && header->version == kShmVersion
+        && header->slotSize == sizeof(ShmBufferSlot)
+        && shmSegmentBytes(header->slotCount) <= static_cast<size_t>(info.st_size);
+    if (!valid) {
+        fprintf(stderr, "%s has an unsupported layout\n", path.c_str());
+        munmap(mapped, static_cast<size_t>(info.st_size));
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    segment.header = header;
+    segment.bytes = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void printSample(const ShmSegmentHeader* header) {
+    ShmTotals totals;
+    if (!readShmTotals(*header, totals)) {
+        fprintf(stderr, "Totals busy, skipping sample\n");
+        return;
+    }
+    printf("time=%" PRId64 " buffers=%u overflow=%u emissions=%" PRId64 " consumptions=%" PRId64
+           " suspensions=%" PRId64 " memory=%" PRId64 "\n",
+           totals.publishTime, totals.liveBuffers, totals.overflowBuffers, totals.totalEmissions,
+           totals.totalConsumptions, totals.totalSuspensions, totals.totalMemoryUsage);
+
+    const ShmBufferSlot* slots = shmSlots(header);
+    for (uint32_t index = 0; index < header->slotCount; index++) {
+        ShmBufferRecord record;
+        if (!readShmSlot(slots[index], record) || record.handle == 0) {
+            continue;
+        }
+        printf("  buffer=%" PRId64 " size=%d/%d memory=%" PRId64 " emissions=%" PRId64 " consumptions=%" PRId64
+               " suspensions=%" PRId64 " updated=%" PRId64 "\n",
+               record.handle, record.size, record.capacity, record.memoryUsage, record.emissions,
+               record.consumptions, record.suspensions, record.lastUpdateTime);
+    }
+    fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <pid | segment path> [interval ms] [samples]\n", argv[0]);
+        return 2;
+    }
+    long intervalMillis = argc > 2 ? strtol(argv[2], nullptr, 10) : 1000;
+    long samples = argc > 3 ? strtol(argv[3], nullptr, 10) : 0;
+    if (intervalMillis < 1) {
+        intervalMillis = 1;
+    }
+
+    MappedSegment segment;
+    if (!openSegment(segmentPath(argv[1]), segment)) {
+        return 1;
+    }
+
+    for (long sample = 0; samples <= 0 || sample < samples; sample++) {
+        if (segment.header->active.load(std::memory_order_acquire) == 0) {
+            fprintf(stderr, "Segment is no longer published\n");
+            break;
+        }
+        if (kill(static_cast<pid_t>(segment.header->pid), 0) != 0 && errno == ESRCH) {
+            fprintf(stderr, "Process %" PRId64 " has exited\n", segment.header->pid);
+            break;
+        }
+        printSample(segment.header);
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMillis));
+    }
+
+    munmap(const_cast<ShmSegmentHeader*>(segment.header), segment.bytes);
+    return 0;
+}
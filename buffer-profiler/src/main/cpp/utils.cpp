@@ -1,5 +1,7 @@
 #include "utils.h"
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
 
 // Helper function to convert Java string to C++ string
 std::string jstringToString(JNIEnv* env, jstring jStr) {
@@ -14,3 +16,27 @@ std::string jstringToString(JNIEnv* env, jstring jStr) {
 jlong getCurrentTimeMs() {
     return std::chrono::steady_clock::now().time_since_epoch().count();
 }
+
+namespace {
+
+const uintptr_t kAlignment = 64;
+
+} // namespace
+
+// The block start is stored just in front of the aligned address
+void* allocateCacheAligned(size_t bytes) {
+    void* block = malloc(bytes + kAlignment + sizeof(void*));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    uintptr_t address = reinterpret_cast<uintptr_t>(block) + sizeof(void*);
+    uintptr_t aligned = (address + kAlignment - 1) & ~(kAlignment - 1);
+    reinterpret_cast<void**>(aligned)[-1] = block;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void freeCacheAligned(void* pointer) {
+    if (pointer != nullptr) {
+        free(reinterpret_cast<void**>(pointer)[-1]);
+    }
+}
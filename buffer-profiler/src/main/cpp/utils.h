@@ -2,11 +2,16 @@
 #define UTILS_H
 
 #include <jni.h>
+#include <cstddef>
 #include <string>
 
 // Utility function declarations
 std::string jstringToString(JNIEnv* env, jstring jStr);
 // Returns current time in nanoseconds for high precision
 jlong getCurrentTimeMs();
+// Allocates memory starting on a cache-line boundary (operator new only guarantees
+// fundamental alignment before C++17); release it with freeCacheAligned
+void* allocateCacheAligned(size_t bytes);
+void freeCacheAligned(void* pointer);
 
 #endif /* UTILS_H */
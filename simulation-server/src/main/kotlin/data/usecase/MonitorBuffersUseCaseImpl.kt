@@ -17,78 +17,32 @@ class MonitorBuffersUseCaseImpl(
     private val numberFormat = NumberFormat.getNumberInstance()
 
     override suspend fun invoke(
-        stringBuffer: Buffer<String>,
-        byteArrayBuffer: Buffer<ByteArray>,
-        intBuffer: Buffer<Int>,
+        buffers: List<Buffer<*>>,
         batchInfo: BatchInfo?
     ): BufferStats? {
         try {
-            val totalBufferSize = stringBuffer.getCurrentSize() + byteArrayBuffer.getCurrentSize() + intBuffer.getCurrentSize()
-            val totalMemory = bufferMonitorRepository.getTotalTrackedMemory()
-            val memoryPerItem = if (totalBufferSize > 0) totalMemory / totalBufferSize else 0
-
-            // Calculate memory utilization based on buffer fullness
-            val bufferCapacity = stringBuffer.capacity + byteArrayBuffer.capacity + intBuffer.capacity
-            val bufferUtilizationPct = ((totalBufferSize.toDouble() / bufferCapacity) * 100).toInt().coerceIn(0, 100)
-
-            // Calculate per-buffer statistics
-            val stringSize = stringBuffer.getCurrentSize()
-            val stringCapacity = stringBuffer.capacity
-            val stringUtilizationPct = ((stringSize.toDouble() / stringCapacity) * 100).toInt().coerceIn(0, 100)
-            val stringStatus = when {
-                stringSize >= stringCapacity -> BufferStatusData.CRITICAL
-                stringUtilizationPct > 70 -> BufferStatusData.WARNING
-                else -> BufferStatusData.NORMAL
-            }
-
-            val byteArraySize = byteArrayBuffer.getCurrentSize()
-            val byteArrayCapacity = byteArrayBuffer.capacity
-            val byteArrayUtilizationPct = ((byteArraySize.toDouble() / byteArrayCapacity) * 100).toInt().coerceIn(0, 100)
-            val byteArrayStatus = when {
-                byteArraySize >= byteArrayCapacity -> BufferStatusData.CRITICAL
-                byteArrayUtilizationPct > 70 -> BufferStatusData.WARNING
-                else -> BufferStatusData.NORMAL
-            }
-
-            val intSize = intBuffer.getCurrentSize()
-            val intCapacity = intBuffer.capacity
-            val intUtilizationPct = ((intSize.toDouble() / intCapacity) * 100).toInt().coerceIn(0, 100)
-            val intStatus = when {
-                intSize >= intCapacity -> BufferStatusData.CRITICAL
-                intUtilizationPct > 70 -> BufferStatusData.WARNING
-                else -> BufferStatusData.NORMAL
+            // One native call returns every buffer's metrics for the per-buffer rows
+            val snapshot = bufferMonitorRepository.snapshotAll()
+            val bufferTypeStats = buffers.associate { buffer ->
+                val name = bufferMonitorRepository.getBufferName(buffer.getId()) ?: buffer.getId().toString()
+                name to bufferTypeStats(buffer, snapshot)
             }
 
-            // Create per-buffer stats objects using data models
-            val stringStatsData = BufferTypeStatsData(
-                bufferSize = stringSize,
-                bufferCapacity = stringCapacity,
-                utilizationPct = stringUtilizationPct,
-                emissions = stringBuffer.getEmissions(),
-                consumptions = stringBuffer.getConsumptions(),
-                suspensions = stringBuffer.getSuspensions(),
-                status = stringStatus
-            )
+            // Registry-wide totals from one native pass, whatever groups the buffers are in
+            val totals = bufferMonitorRepository.getBufferAggregates(0)
 
-            val byteArrayStatsData = BufferTypeStatsData(
-                bufferSize = byteArraySize,
-                bufferCapacity = byteArrayCapacity,
-                utilizationPct = byteArrayUtilizationPct,
-                emissions = byteArrayBuffer.getEmissions(),
-                consumptions = byteArrayBuffer.getConsumptions(),
-                suspensions = byteArrayBuffer.getSuspensions(),
-                status = byteArrayStatus
-            )
+            // Producers suspended in send() are already counted natively, so clamp to the capacity
+            val bufferCapacity = totals.totalCapacity.toInt()
+            val totalBufferSize = totals.totalSize.toInt().coerceIn(0, bufferCapacity)
+            val totalMemory = totals.totalMemoryUsage
+            val memoryPerItem = if (totalBufferSize > 0) totalMemory / totalBufferSize else 0
 
-            val intStatsData = BufferTypeStatsData(
-                bufferSize = intSize,
-                bufferCapacity = intCapacity,
-                utilizationPct = intUtilizationPct,
-                emissions = intBuffer.getEmissions(),
-                consumptions = intBuffer.getConsumptions(),
-                suspensions = intBuffer.getSuspensions(),
-                status = intStatus
-            )
+            // Calculate memory utilization based on buffer fullness
+            val bufferUtilizationPct = if (bufferCapacity > 0) {
+                ((totalBufferSize.toDouble() / bufferCapacity) * 100).toInt().coerceIn(0, 100)
+            } else {
+                0
+            }
 
             // Convert BatchInfo to BatchInfoData if available
             val batchInfoData = batchInfo?.let {
@@ -102,10 +56,10 @@ class MonitorBuffersUseCaseImpl(
             val bufferStatsData = BufferStatsData(
                 bufferSize = totalBufferSize,
                 bufferCapacity = bufferCapacity,
-                totalEmissions = bufferMonitorRepository.getTotalEmissions(),
-                totalConsumptions = bufferMonitorRepository.getTotalConsumptions(),
-                suspensions = bufferMonitorRepository.getTotalSuspensions(),
-                waitingItems = bufferMonitorRepository.getTotalEmissions() - bufferMonitorRepository.getTotalConsumptions(),
+                totalEmissions = totals.totalEmissions.toInt(),
+                totalConsumptions = totals.totalConsumptions.toInt(),
+                suspensions = totals.totalSuspensions.toInt(),
+                waitingItems = (totals.totalEmissions - totals.totalConsumptions).toInt(),
                 memoryUsage = totalMemory,
                 memoryPerItem = memoryPerItem,
                 memoryUtilizationPct = bufferUtilizationPct,
@@ -115,16 +69,12 @@ class MonitorBuffersUseCaseImpl(
                     bufferUtilizationPct > 70 -> BufferStatusData.WARNING
                     else -> BufferStatusData.NORMAL
                 },
-                buffers = mapOf(
-                    "string" to stringStatsData,
-                    "bytearray" to byteArrayStatsData,
-                    "int" to intStatsData
-                ),
+                buffers = bufferTypeStats,
                 lastUpdate = System.currentTimeMillis(),
                 batchInfo = batchInfoData
             )
 
-            logBufferStats(totalBufferSize, stringBuffer, byteArrayBuffer, intBuffer, totalMemory, memoryPerItem)
+            logBufferStats(bufferStatsData, totalMemory, memoryPerItem)
 
             // Convert data model to domain entity manually
             return BufferStats(
@@ -167,23 +117,46 @@ class MonitorBuffersUseCaseImpl(
         }
     }
 
+    /**
+     * Builds the per-buffer statistics from the buffer's row in the snapshot.
+     */
+    private fun bufferTypeStats(buffer: Buffer<*>, snapshot: BufferMetricsSnapshot): BufferTypeStatsData {
+        val row = snapshot.indexOf(buffer.getId())
+        val capacity = buffer.capacity
+        val size = if (row >= 0) snapshot.sizes[row].coerceIn(0, capacity) else 0
+        val utilizationPct = ((size.toDouble() / capacity) * 100).toInt().coerceIn(0, 100)
+        val predictedFull = bufferMonitorRepository.getBackpressureStatus(buffer.getId())?.alerting == true
+
+        return BufferTypeStatsData(
+            bufferSize = size,
+            bufferCapacity = capacity,
+            utilizationPct = utilizationPct,
+            emissions = if (row >= 0) snapshot.emissions[row].toInt() else 0,
+            consumptions = if (row >= 0) snapshot.consumptions[row].toInt() else 0,
+            suspensions = if (row >= 0) snapshot.suspensions[row].toInt() else 0,
+            status = when {
+                size >= capacity -> BufferStatusData.CRITICAL
+                utilizationPct > 70 || predictedFull -> BufferStatusData.WARNING
+                else -> BufferStatusData.NORMAL
+            }
+        )
+    }
+
     private fun logBufferStats(
-        totalBufferSize: Int,
-        stringBuffer: Buffer<String>,
-        byteArrayBuffer: Buffer<ByteArray>,
-        intBuffer: Buffer<Int>,
+        stats: BufferStatsData,
         totalMemory: Long,
         memoryPerItem: Long
     ) {
+        val bufferLines = stats.buffers.entries.joinToString("\n") { (name, buffer) ->
+            "$name Buffer: ${buffer.bufferSize}/${buffer.bufferCapacity}"
+        }
         logger.info("""
-            === BUFFER STATS ===
-            Total Buffer Size: $totalBufferSize/${stringBuffer.capacity + byteArrayBuffer.capacity + intBuffer.capacity}
-            String Buffer: ${stringBuffer.getCurrentSize()}/${stringBuffer.capacity}
-            ByteArray Buffer: ${byteArrayBuffer.getCurrentSize()}/${byteArrayBuffer.capacity}
-            Int Buffer: ${intBuffer.getCurrentSize()}/${intBuffer.capacity}
-            Memory: ${numberFormat.format(totalMemory)} bytes (${totalMemory / 1024} KB)
-            Memory Per Item: ${numberFormat.format(memoryPerItem)} bytes
-            Emitted: ${bufferMonitorRepository.getTotalEmissions()}, Consumed: ${bufferMonitorRepository.getTotalConsumptions()}, Suspensions: ${bufferMonitorRepository.getTotalSuspensions()}
-        """.trimIndent())
+            |=== BUFFER STATS ===
+            |Total Buffer Size: ${stats.bufferSize}/${stats.bufferCapacity}
+            |$bufferLines
+            |Memory: ${numberFormat.format(totalMemory)} bytes (${totalMemory / 1024} KB)
+            |Memory Per Item: ${numberFormat.format(memoryPerItem)} bytes
+            |Emitted: ${stats.totalEmissions}, Consumed: ${stats.totalConsumptions}, Suspensions: ${stats.suspensions}
+        """.trimMargin())
     }
 }
@@ -26,15 +26,20 @@ class RunDemoUseCaseImpl(
 ) : RunDemoUseCase {
     private val logger = LoggerFactory.getLogger(RunDemoUseCaseImpl::class.java)
 
+    private companion object {
+        const val BACKPRESSURE_WARNING_NANOS = 1_000_000_000L
+
+        // Every batch reuses one group: groups are never freed, and clearTracking zeroes it between batches
+        val BATCH_LABELS = mapOf("demo" to "simulation", "stage" to "batch")
+    }
+
     private fun CoroutineScope.createVisualizer(
-        stringBuffer: Buffer<String>,
-        byteArrayBuffer: Buffer<ByteArray>,
-        intBuffer: Buffer<Int>,
+        buffers: List<Buffer<*>>,
         config: BufferDemoConfig,
         batchInfo: BatchInfo? = null
     ): Job = launch {
         while (isActive) {
-            val stats = monitorBuffersUseCase(stringBuffer, byteArrayBuffer, intBuffer, batchInfo)
+            val stats = monitorBuffersUseCase(buffers, batchInfo)
             visualizeBuffersUseCase(stats)
             delay(config.updateIntervalMs.milliseconds)
         }
@@ -59,15 +64,15 @@ class RunDemoUseCaseImpl(
         logger.info("Starting batch $currentBatch with config: $batchConfig")
 
         // Create buffers for this batch
-        val stringBuffer = createBufferUseCase<String>(batchConfig.bufferCapacity)
-        val byteArrayBuffer = createBufferUseCase<ByteArray>(batchConfig.bufferCapacity)
-        val intBuffer = createBufferUseCase<Int>(batchConfig.bufferCapacity)
+        val stringBuffer = createBufferUseCase<String>(batchConfig.bufferCapacity, "string", BATCH_LABELS)
+        val byteArrayBuffer = createBufferUseCase<ByteArray>(batchConfig.bufferCapacity, "bytearray", BATCH_LABELS)
+        val intBuffer = createBufferUseCase<Int>(batchConfig.bufferCapacity, "int", BATCH_LABELS)
 
         // Create batch info
         val batchInfo = BatchInfo(currentBatch, completedBatches, batchConfig)
 
         // Create visualization job with batch info
-        val visualizer = createVisualizer(stringBuffer, byteArrayBuffer, intBuffer, batchConfig, batchInfo)
+        val visualizer = createVisualizer(listOf(stringBuffer, byteArrayBuffer, intBuffer), batchConfig, batchInfo)
 
         // Create producers using the generic producer function
         val stringProducer = createProducer(
@@ -140,6 +145,8 @@ class RunDemoUseCaseImpl(
 
     override suspend fun invoke(port: Int) = coroutineScope {
         visualizeBuffersUseCase.start()
+        // Lets the monitor flag a buffer as WARNING while it is still filling, before producers suspend
+        bufferMonitor.setBackpressureDetection(BACKPRESSURE_WARNING_NANOS)
         var completedBatches = 0
         var currentBatch = 1
 
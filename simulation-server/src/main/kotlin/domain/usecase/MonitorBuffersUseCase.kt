@@ -5,10 +5,12 @@ import domain.entity.Buffer
 import domain.entity.BufferStats
 
 interface MonitorBuffersUseCase {
+    /**
+     * Builds the statistics of [buffers], each reported under its name. The totals cover
+     * every tracked buffer, grouped or not, and come from one native aggregation pass.
+     */
     suspend operator fun invoke(
-        stringBuffer: Buffer<String>,
-        byteArrayBuffer: Buffer<ByteArray>,
-        intBuffer: Buffer<Int>,
+        buffers: List<Buffer<*>>,
         batchInfo: BatchInfo? = null
     ): BufferStats?
 }
@@ -27,6 +27,10 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
     private val logger: Logger = LoggerFactory.getLogger(BufferWebSocketServer::class.java)
     private val sessions = mutableSetOf<DefaultWebSocketSession>()
 
+    // Sessions that asked for binary delta frames; a subset of sessions
+    private val binarySessions = mutableSetOf<DefaultWebSocketSession>()
+    private val frameEncoder = MetricsFrameEncoder()
+
     // JSON configuration for serialization
     private val json = Json {
         // Use compact format for network efficiency
@@ -51,6 +55,10 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
 
         // WebSocket paths
         private const val STATS_WEBSOCKET_PATH = "/stats"
+
+        // Clients connecting with ?format=binary get MetricsFrameEncoder frames instead of JSON
+        private const val FORMAT_PARAMETER = "format"
+        private const val BINARY_FORMAT = "binary"
     }
 
     override fun start() {
@@ -64,6 +72,11 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
                 staticResources("/", STATIC_RESOURCES_PATH)
                 webSocket(STATS_WEBSOCKET_PATH) {
                     sessions.add(this)
+                    if (call.request.queryParameters[FORMAT_PARAMETER] == BINARY_FORMAT) {
+                        binarySessions.add(this)
+                        // The new client has no frame to apply deltas to yet
+                        frameEncoder.requestKeyframe()
+                    }
                     try {
                         // Send active session count to all clients
                         broadcastSessionCount()
@@ -79,6 +92,7 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
                         logger.error("WebSocket error", e)
                     } finally {
                         sessions.remove(this)
+                        binarySessions.remove(this)
                         logger.debug("Client disconnected. Active sessions: ${sessions.size}")
                         // Update session count for remaining clients
                         broadcastSessionCount()
@@ -108,18 +122,30 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
     }
 
     /**
-     * Send updated buffer statistics to all connected WebSocket clients
+     * Send updated buffer statistics to all connected WebSocket clients.
+     * Each format is encoded at most once per update and the same bytes are sent
+     * to every session using it: binary delta frames to sessions that asked for
+     * them, JSON text to the rest.
      * @param stats The current buffer statistics to broadcast
      */
     override suspend fun sendUpdate(stats: BufferStats?) {
-        if (sessions.isEmpty() && stats == null) return
+        if (sessions.isEmpty()) return
 
-        val serializedStats = if (stats != null) json.encodeToString(BufferStats.serializer(), stats) else "null"
+        val binaryFrame = if (binarySessions.isNotEmpty()) frameEncoder.encode(stats) else null
+        val serializedStats = if (sessions.size > binarySessions.size) {
+            if (stats != null) json.encodeToString(BufferStats.serializer(), stats) else "null"
+        } else {
+            null
+        }
 
         val failedSessions = mutableSetOf<DefaultWebSocketSession>()
         sessions.forEach { session ->
             try {
-                session.send(Frame.Text(serializedStats))
+                if (session in binarySessions) {
+                    binaryFrame?.let { session.send(Frame.Binary(true, it)) }
+                } else {
+                    serializedStats?.let { session.send(Frame.Text(it)) }
+                }
             } catch (e: Exception) {
                 logger.error("Failed to send update to client", e)
                 failedSessions.add(session)
@@ -127,6 +153,7 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
         }
 
         sessions.removeAll(failedSessions)
+        binarySessions.removeAll(failedSessions)
     }
 
     /**
@@ -148,5 +175,6 @@ class BufferWebSocketServer(private val port: Int) : BufferStatsBroadcast {
         }
 
         sessions.removeAll(failedSessions)
+        binarySessions.removeAll(failedSessions)
     }
 }
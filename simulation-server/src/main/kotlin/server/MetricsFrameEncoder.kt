@@ -0,0 +1,198 @@
+package server
+
+import domain.entity.BufferStats
+import domain.entity.BufferTypeStats
+
+/**
+ * Encodes [BufferStats] as compact binary WebSocket frames.
+ *
+ * Every value in a stats update is an integer, so a frame is a flat list of
+ * fields, each sent as the zigzag varint delta against the previous frame.
+ * A dirty bitmap in front of the global fields and in front of each buffer's
+ * fields marks which of them changed; unchanged fields take no bytes at all.
+ *
+ * Frame layout (varints are unsigned LEB128, deltas are zigzag encoded):
+ * ```
+ * u8      version (1)
+ * u8      flags: 1 = keyframe, 2 = no stats
+ * varint  sequence number
+ * -- keyframes only --
+ * varint  global field count, varint per-buffer field count
+ * varint  buffer count, then per buffer: varint name length, UTF-8 name
+ * -- every frame with stats --
+ * varint  global dirty bitmap, then one delta per set bit
+ * per buffer, in keyframe order: varint dirty bitmap, then one delta per set bit
+ * ```
+ * A keyframe is encoded against all-zero previous values, so it is decoded
+ * exactly like a delta frame. Buffer names and field counts only appear in
+ * keyframes; a change in the buffer set forces one. A client drops frames
+ * until its first keyframe, which the server requests whenever one joins.
+ *
+ * Not thread-safe: the broadcaster encodes one frame per tick and fans the
+ * same bytes out to every binary session.
+ */
+class MetricsFrameEncoder {
+    companion object {
+        const val VERSION = 1
+        const val FLAG_KEYFRAME = 1
+        const val FLAG_EMPTY = 2
+
+        // Field order is part of the wire format; append only
+        const val GLOBAL_FIELDS = 19
+        const val BUFFER_FIELDS = 7
+
+        private const val INITIAL_CAPACITY = 256
+    }
+
+    private var previousGlobal = LongArray(GLOBAL_FIELDS)
+    private var currentGlobal = LongArray(GLOBAL_FIELDS)
+    private var bufferNames: List<String> = emptyList()
+    private var previousBuffers = Array(0) { LongArray(BUFFER_FIELDS) }
+    private var currentBuffers = Array(0) { LongArray(BUFFER_FIELDS) }
+    private var sequence = 0L
+    private var needsKeyframe = true
+
+    private var output = ByteArray(INITIAL_CAPACITY)
+    private var length = 0
+
+    /**
+     * Makes the next frame a keyframe, e.g. because a client joined and has no
+     * previous frame to apply deltas to.
+     */
+    fun requestKeyframe() {
+        needsKeyframe = true
+    }
+
+    /**
+     * Encodes [stats] against the previous frame and returns the frame bytes.
+     * A null [stats] produces an empty frame, and the frame after it is a keyframe.
+     */
+    fun encode(stats: BufferStats?): ByteArray {
+        length = 0
+        sequence++
+
+        if (stats == null) {
+            writeByte(VERSION)
+            writeByte(FLAG_EMPTY)
+            writeVarint(sequence)
+            needsKeyframe = true
+            return output.copyOf(length)
+        }
+
+        val names = stats.buffers.keys.toList()
+        if (names != bufferNames) {
+            bufferNames = names
+            previousBuffers = Array(names.size) { LongArray(BUFFER_FIELDS) }
+            currentBuffers = Array(names.size) { LongArray(BUFFER_FIELDS) }
+            needsKeyframe = true
+        }
+        val keyframe = needsKeyframe
+        needsKeyframe = false
+        if (keyframe) {
+            previousGlobal.fill(0L)
+            previousBuffers.forEach { it.fill(0L) }
+        }
+
+        fillGlobal(stats, currentGlobal)
+        names.forEachIndexed { index, name -> fillBuffer(stats.buffers.getValue(name), currentBuffers[index]) }
+
+        writeByte(VERSION)
+        writeByte(if (keyframe) FLAG_KEYFRAME else 0)
+        writeVarint(sequence)
+        if (keyframe) {
+            writeVarint(GLOBAL_FIELDS.toLong())
+            writeVarint(BUFFER_FIELDS.toLong())
+            writeVarint(names.size.toLong())
+            names.forEach { name ->
+                val bytes = name.encodeToByteArray()
+                writeVarint(bytes.size.toLong())
+                writeBytes(bytes)
+            }
+        }
+        writeDeltas(previousGlobal, currentGlobal)
+        for (index in names.indices) {
+            writeDeltas(previousBuffers[index], currentBuffers[index])
+        }
+
+        // The values just sent become the base of the next frame
+        previousGlobal = currentGlobal.also { currentGlobal = previousGlobal }
+        previousBuffers = currentBuffers.also { currentBuffers = previousBuffers }
+        return output.copyOf(length)
+    }
+
+    private fun fillGlobal(stats: BufferStats, fields: LongArray) {
+        val batch = stats.batchInfo
+        fields[0] = stats.bufferSize.toLong()
+        fields[1] = stats.bufferCapacity.toLong()
+        fields[2] = stats.totalEmissions.toLong()
+        fields[3] = stats.totalConsumptions.toLong()
+        fields[4] = stats.suspensions.toLong()
+        fields[5] = stats.waitingItems.toLong()
+        fields[6] = stats.memoryUsage
+        fields[7] = stats.memoryPerItem
+        fields[8] = stats.memoryUtilizationPct.toLong()
+        fields[9] = stats.utilizationPct.toLong()
+        fields[10] = stats.status.ordinal.toLong()
+        fields[11] = stats.lastUpdate
+        fields[12] = if (batch != null) 1L else 0L
+        fields[13] = batch?.currentBatch?.toLong() ?: 0L
+        fields[14] = batch?.completedBatches?.toLong() ?: 0L
+        fields[15] = batch?.batchConfig?.bufferCapacity?.toLong() ?: 0L
+        fields[16] = batch?.batchConfig?.updateIntervalMs ?: 0L
+        fields[17] = batch?.batchConfig?.producerItems?.toLong() ?: 0L
+        fields[18] = batch?.batchConfig?.emptyBufferPollDelayMs ?: 0L
+    }
+
+    private fun fillBuffer(stats: BufferTypeStats, fields: LongArray) {
+        fields[0] = stats.bufferSize.toLong()
+        fields[1] = stats.bufferCapacity.toLong()
+        fields[2] = stats.utilizationPct.toLong()
+        fields[3] = stats.emissions.toLong()
+        fields[4] = stats.consumptions.toLong()
+        fields[5] = stats.suspensions.toLong()
+        fields[6] = stats.status.ordinal.toLong()
+    }
+
+    private fun writeDeltas(previous: LongArray, current: LongArray) {
+        var dirty = 0L
+        for (field in current.indices) {
+            if (current[field] != previous[field]) {
+                dirty = dirty or (1L shl field)
+            }
+        }
+        writeVarint(dirty)
+        for (field in current.indices) {
+            if (current[field] != previous[field]) {
+                val delta = current[field] - previous[field]
+                writeVarint((delta shl 1) xor (delta shr 63))
+            }
+        }
+    }
+
+    private fun writeVarint(value: Long) {
+        ensureCapacity(10)
+        var remaining = value
+        while (remaining and 0x7FL.inv() != 0L) {
+            output[length++] = ((remaining and 0x7FL) or 0x80L).toByte()
+            remaining = remaining ushr 7
+        }
+        output[length++] = remaining.toByte()
+    }
+
+    private fun writeByte(value: Int) {
+        ensureCapacity(1)
+        output[length++] = value.toByte()
+    }
+
+    private fun writeBytes(bytes: ByteArray) {
+        ensureCapacity(bytes.size)
+        bytes.copyInto(output, length)
+        length += bytes.size
+    }
+
+    private fun ensureCapacity(extra: Int) {
+        if (length + extra > output.size) {
+            output = output.copyOf(maxOf(output.size * 2, length + extra))
+        }
+    }
+}